@@ -0,0 +1,352 @@
+#include "BVH.h"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+namespace
+{
+	// 광선이 상자에 들어가는 거리. 지나지 않으면 FLT_MAX.
+	float intersectRay(const AABB& bounds, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance)
+	{
+		const glm::vec3 t0 = (bounds.min - origin) * inverseDirection;
+		const glm::vec3 t1 = (bounds.max - origin) * inverseDirection;
+		const glm::vec3 tNear = glm::min(t0, t1);
+		const glm::vec3 tFar = glm::max(t0, t1);
+		const float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.f));
+		const float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+		return enter <= exit ? enter : FLT_MAX;
+	}
+
+	float distanceToBox(const AABB& bounds, const glm::vec3& point)
+	{
+		const glm::vec3 outside = glm::max(glm::max(bounds.min - point, point - bounds.max), glm::vec3(0.f));
+		return glm::length(outside);
+	}
+}
+
+uint32_t BVH::Split::binOf(const glm::vec3& centroid) const
+{
+	const uint32_t bin = static_cast<uint32_t>((centroid[axis] - centroidMin) * binScale);
+	return std::min(bin, BinCount - 1);
+}
+
+void BVH::build(const std::vector<AABB>& inPrimitiveBounds)
+{
+	primitiveBounds = inPrimitiveBounds;
+	nodes.clear();
+	builtTreeArea = 0.f;
+
+	const uint32_t primitiveCount = static_cast<uint32_t>(primitiveBounds.size());
+	if (primitiveCount == 0)
+	{
+		primitiveIndices.clear();
+		centroids.clear();
+		return;
+	}
+
+	primitiveIndices.resize(primitiveCount);
+	std::iota(primitiveIndices.begin(), primitiveIndices.end(), 0u);
+	centroids.resize(primitiveCount);
+	for (uint32_t i = 0; i < primitiveCount; i++)
+	{
+		centroids[i] = primitiveBounds[i].center();
+	}
+
+	// 노드는 많아야 2N - 1 개다. 미리 잡아 두어 subdivide 도중 참조가 무효가 되지 않게 한다.
+	nodes.reserve(primitiveCount * 2);
+	Node root;
+	root.first = 0;
+	root.count = primitiveCount;
+	updateNodeBounds(root);
+	nodes.push_back(root);
+
+	// (노드, 깊이)
+	std::vector<std::pair<uint32_t, uint32_t>> pending;
+	pending.push_back({ 0, 0 });
+	while (!pending.empty())
+	{
+		const std::pair<uint32_t, uint32_t> next = pending.back();
+		pending.pop_back();
+		subdivide(next.first, next.second, pending);
+	}
+
+	builtTreeArea = computeTreeArea();
+}
+
+void BVH::clear()
+{
+	nodes.clear();
+	primitiveIndices.clear();
+	primitiveBounds.clear();
+	centroids.clear();
+	builtTreeArea = 0.f;
+}
+
+void BVH::updateNodeBounds(Node& node) const
+{
+	node.bounds = AABB{};
+	for (uint32_t i = node.first; i < node.first + node.count; i++)
+	{
+		node.bounds.grow(primitiveBounds[primitiveIndices[i]]);
+	}
+}
+
+bool BVH::findSplit(const Node& node, Split& outSplit) const
+{
+	AABB centroidBounds;
+	for (uint32_t i = node.first; i < node.first + node.count; i++)
+	{
+		centroidBounds.grow(centroids[primitiveIndices[i]]);
+	}
+
+	// 잎으로 두면 프리미티브를 모두 검사하고, 나누면 노드 하나를 더 지나 양쪽을 검사한다.
+	const float leafCost = static_cast<float>(node.count) * node.bounds.surfaceArea();
+	float bestCost = leafCost - node.bounds.surfaceArea();
+	bool found = false;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		const float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+		if (extent <= 0.f)
+		{
+			continue;
+		}
+
+		Split split;
+		split.axis = axis;
+		split.centroidMin = centroidBounds.min[axis];
+		split.binScale = BinCount / extent;
+
+		std::array<AABB, BinCount> binBounds;
+		std::array<uint32_t, BinCount> binCounts{};
+		for (uint32_t i = node.first; i < node.first + node.count; i++)
+		{
+			const uint32_t primitive = primitiveIndices[i];
+			const uint32_t bin = split.binOf(centroids[primitive]);
+			binBounds[bin].grow(primitiveBounds[primitive]);
+			binCounts[bin]++;
+		}
+
+		// 오른쪽에서부터 누적한 면적과 개수
+		std::array<float, BinCount - 1> rightAreas;
+		std::array<uint32_t, BinCount - 1> rightCounts;
+		AABB rightBounds;
+		uint32_t rightCount = 0;
+		for (uint32_t bin = BinCount - 1; bin > 0; bin--)
+		{
+			rightBounds.grow(binBounds[bin]);
+			rightCount += binCounts[bin];
+			rightAreas[bin - 1] = rightCount > 0 ? rightBounds.surfaceArea() : 0.f;
+			rightCounts[bin - 1] = rightCount;
+		}
+
+		AABB leftBounds;
+		uint32_t leftCount = 0;
+		for (uint32_t bin = 0; bin < BinCount - 1; bin++)
+		{
+			leftBounds.grow(binBounds[bin]);
+			leftCount += binCounts[bin];
+			if (leftCount == 0 || rightCounts[bin] == 0)
+			{
+				continue;
+			}
+
+			const float cost = leftCount * leftBounds.surfaceArea() + rightCounts[bin] * rightAreas[bin];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				split.lastLeftBin = bin;
+				outSplit = split;
+				found = true;
+			}
+		}
+	}
+	return found;
+}
+
+void BVH::subdivide(uint32_t nodeIndex, uint32_t depth, std::vector<std::pair<uint32_t, uint32_t>>& pending)
+{
+	const Node node = nodes[nodeIndex];
+	if (node.count <= MaxLeafSize || depth >= MaxDepth)
+	{
+		return;
+	}
+
+	Split split;
+	if (!findSplit(node, split))
+	{
+		return;
+	}
+
+	const auto begin = primitiveIndices.begin() + node.first;
+	const auto middle = std::partition(begin, begin + node.count,
+		[&](uint32_t primitive) { return split.binOf(centroids[primitive]) <= split.lastLeftBin; });
+	const uint32_t leftCount = static_cast<uint32_t>(middle - begin);
+	if (leftCount == 0 || leftCount == node.count)
+	{
+		return;
+	}
+
+	const uint32_t leftIndex = static_cast<uint32_t>(nodes.size());
+	Node left;
+	left.first = node.first;
+	left.count = leftCount;
+	updateNodeBounds(left);
+	Node right;
+	right.first = node.first + leftCount;
+	right.count = node.count - leftCount;
+	updateNodeBounds(right);
+	nodes.push_back(left);
+	nodes.push_back(right);
+
+	nodes[nodeIndex].first = leftIndex;
+	nodes[nodeIndex].count = 0;
+
+	pending.push_back({ leftIndex, depth + 1 });
+	pending.push_back({ leftIndex + 1, depth + 1 });
+}
+
+void BVH::refit()
+{
+	for (size_t i = nodes.size(); i-- > 0;)
+	{
+		Node& node = nodes[i];
+		if (node.isLeaf())
+		{
+			updateNodeBounds(node);
+		}
+		else
+		{
+			node.bounds = nodes[node.first].bounds;
+			node.bounds.grow(nodes[node.first + 1].bounds);
+		}
+	}
+}
+
+float BVH::computeTreeArea() const
+{
+	float area = 0.f;
+	for (const Node& node : nodes)
+	{
+		if (!node.isLeaf())
+		{
+			area += node.bounds.surfaceArea();
+		}
+	}
+	return area;
+}
+
+bool BVH::needsRebuild(float maxGrowth) const
+{
+	return !nodes.empty() && computeTreeArea() > builtTreeArea * maxGrowth;
+}
+
+bool BVH::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& outHit) const
+{
+	outHit = RayHit{};
+	if (nodes.empty())
+	{
+		return false;
+	}
+
+	const glm::vec3 inverseDirection = 1.f / direction;
+	float closest = maxDistance;
+
+	uint32_t stack[MaxDepth + 2];
+	uint32_t stackSize = 0;
+	if (intersectRay(nodes[0].bounds, origin, inverseDirection, closest) != FLT_MAX)
+	{
+		stack[stackSize++] = 0;
+	}
+
+	while (stackSize > 0)
+	{
+		const Node& node = nodes[stack[--stackSize]];
+		if (node.isLeaf())
+		{
+			for (uint32_t i = node.first; i < node.first + node.count; i++)
+			{
+				const uint32_t primitive = primitiveIndices[i];
+				const float distance = intersectRay(primitiveBounds[primitive], origin, inverseDirection, closest);
+				if (distance != FLT_MAX && distance < outHit.distance)
+				{
+					closest = distance;
+					outHit.primitive = primitive;
+					outHit.distance = distance;
+				}
+			}
+			continue;
+		}
+
+		// 가까운 자식을 먼저 꺼내도록 먼 쪽을 먼저 넣는다.
+		uint32_t nearChild = node.first;
+		uint32_t farChild = node.first + 1;
+		float nearDistance = intersectRay(nodes[nearChild].bounds, origin, inverseDirection, closest);
+		float farDistance = intersectRay(nodes[farChild].bounds, origin, inverseDirection, closest);
+		if (farDistance < nearDistance)
+		{
+			std::swap(nearChild, farChild);
+			std::swap(nearDistance, farDistance);
+		}
+		if (farDistance != FLT_MAX)
+		{
+			stack[stackSize++] = farChild;
+		}
+		if (nearDistance != FLT_MAX)
+		{
+			stack[stackSize++] = nearChild;
+		}
+	}
+	return outHit.primitive != UINT32_MAX;
+}
+
+bool BVH::findNearest(const glm::vec3& point, float maxDistance, RayHit& outHit) const
+{
+	outHit = RayHit{};
+	if (nodes.empty())
+	{
+		return false;
+	}
+
+	float closest = maxDistance;
+
+	uint32_t stack[MaxDepth + 2];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const Node& node = nodes[stack[--stackSize]];
+		if (distanceToBox(node.bounds, point) > closest)
+		{
+			continue;
+		}
+
+		if (node.isLeaf())
+		{
+			for (uint32_t i = node.first; i < node.first + node.count; i++)
+			{
+				const uint32_t primitive = primitiveIndices[i];
+				const float distance = distanceToBox(primitiveBounds[primitive], point);
+				if (distance <= closest && distance < outHit.distance)
+				{
+					closest = distance;
+					outHit.primitive = primitive;
+					outHit.distance = distance;
+				}
+			}
+			continue;
+		}
+
+		uint32_t nearChild = node.first;
+		uint32_t farChild = node.first + 1;
+		if (distanceToBox(nodes[farChild].bounds, point) < distanceToBox(nodes[nearChild].bounds, point))
+		{
+			std::swap(nearChild, farChild);
+		}
+		stack[stackSize++] = farChild;
+		stack[stackSize++] = nearChild;
+	}
+	return outHit.primitive != UINT32_MAX;
+}
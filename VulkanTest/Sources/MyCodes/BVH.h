@@ -0,0 +1,224 @@
+#pragma once
+
+#include "Frustum.h"
+
+#include <cfloat>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+
+struct AABB
+{
+	glm::vec3 min = glm::vec3(FLT_MAX);
+	glm::vec3 max = glm::vec3(-FLT_MAX);
+
+	void grow(const glm::vec3& point)
+	{
+		min = glm::min(min, point);
+		max = glm::max(max, point);
+	}
+
+	void grow(const AABB& other)
+	{
+		min = glm::min(min, other.min);
+		max = glm::max(max, other.max);
+	}
+
+	glm::vec3 center() const { return (min + max) * 0.5f; }
+	glm::vec3 extents() const { return (max - min) * 0.5f; }
+
+	float surfaceArea() const
+	{
+		const glm::vec3 size = max - min;
+		return 2.f * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	// 회전된 상자를 감싸는 축 정렬 상자를 만든다. 반지름은 |M| * extents 이다.
+	static AABB fromTransformedBox(const glm::vec3& localCenter, const glm::vec3& localExtents, const glm::mat4& transform)
+	{
+		const glm::vec3 center = glm::vec3(transform * glm::vec4(localCenter, 1.f));
+		const glm::mat3 absolute(glm::abs(glm::vec3(transform[0])), glm::abs(glm::vec3(transform[1])), glm::abs(glm::vec3(transform[2])));
+		const glm::vec3 extents = absolute * localExtents;
+		return { center - extents, center + extents };
+	}
+};
+
+/**
+ * 프리미티브 AABB 위에 SAH 로 만든 BVH.
+ *
+ * 노드는 배열 하나에 담고, 자식 두 개는 항상 나란히 부모보다 뒤에 놓는다. 그래서 refit 은 배열을 뒤에서부터 한번 훑으면 된다.
+ * 프리미티브 개수가 바뀌면 build 를 다시 부르고, 위치만 바뀌면 updatePrimitive 후 refit 한다.
+ * refit 만 계속하면 트리 품질이 떨어지므로 needsRebuild 가 참이 되면 다시 만든다.
+ */
+class BVH
+{
+public:
+	static constexpr uint32_t MaxLeafSize = 4;
+	static constexpr uint32_t BinCount = 8;
+
+	struct Node
+	{
+		AABB bounds;
+		// count 가 0 이면 내부 노드이고 first 는 왼쪽 자식, first + 1 은 오른쪽 자식이다.
+		// 아니면 잎이고 [first, first + count) 가 primitiveIndices 의 구간이다.
+		uint32_t first = 0;
+		uint32_t count = 0;
+
+		bool isLeaf() const { return count != 0; }
+	};
+
+	struct RayHit
+	{
+		uint32_t primitive = UINT32_MAX;
+		float distance = FLT_MAX;
+	};
+
+	void build(const std::vector<AABB>& inPrimitiveBounds);
+	void clear();
+
+	void updatePrimitive(uint32_t primitive, const AABB& bounds) { primitiveBounds[primitive] = bounds; }
+	void refit();
+	// refit 으로 내부 노드 표면적의 합이 만들 때보다 이만큼 커지면 다시 만드는 편이 낫다.
+	bool needsRebuild(float maxGrowth = 2.f) const;
+
+	bool empty() const { return nodes.empty(); }
+	uint32_t getPrimitiveCount() const { return static_cast<uint32_t>(primitiveBounds.size()); }
+	uint32_t getNodeCount() const { return static_cast<uint32_t>(nodes.size()); }
+	const AABB& getPrimitiveBounds(uint32_t primitive) const { return primitiveBounds[primitive]; }
+
+	// 프러스텀과 겹치는 프리미티브마다 visit(primitive) 를 부른다. 노드가 통째로 안에 있으면 그 아래는 검사하지 않는다.
+	template<typename Visitor>
+	void queryFrustum(const Frustum& frustum, Visitor&& visit) const;
+
+	// 광선이 AABB 를 처음 지나는 가장 가까운 프리미티브를 찾는다. direction 은 정규화되어 있어야 한다.
+	bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& outHit) const;
+	// point 에서 AABB 까지 거리가 가장 짧은 프리미티브를 찾는다. AABB 안에 있으면 거리는 0 이다.
+	bool findNearest(const glm::vec3& point, float maxDistance, RayHit& outHit) const;
+
+private:
+	enum class Containment { Outside, Intersecting, Inside };
+
+	static Containment classify(const Frustum& frustum, const AABB& bounds);
+
+	// 중심점을 BinCount 칸으로 나눠 칸 경계에서 자른다.
+	struct Split
+	{
+		int axis = 0;
+		uint32_t lastLeftBin = 0;
+		float centroidMin = 0.f;
+		float binScale = 0.f;
+
+		uint32_t binOf(const glm::vec3& centroid) const;
+	};
+
+	// 깊이가 이보다 깊어지면 프리미티브가 많아도 잎으로 둔다. 탐색 스택 크기를 넘지 않게 한다.
+	static constexpr uint32_t MaxDepth = 48;
+
+	void updateNodeBounds(Node& node) const;
+	void subdivide(uint32_t nodeIndex, uint32_t depth, std::vector<std::pair<uint32_t, uint32_t>>& pending);
+	// SAH 비용이 가장 작은 분할을 찾는다. 나누지 않는 편이 싸면 false.
+	bool findSplit(const Node& node, Split& outSplit) const;
+	// 내부 노드 표면적의 합. 트리 품질을 가늠하는 데 쓴다.
+	float computeTreeArea() const;
+
+	template<typename Visitor>
+	void visitSubtree(uint32_t nodeIndex, Visitor& visit) const;
+
+	std::vector<Node> nodes;
+	std::vector<uint32_t> primitiveIndices;
+	std::vector<AABB> primitiveBounds;
+	std::vector<glm::vec3> centroids;
+	float builtTreeArea = 0.f;
+};
+
+inline BVH::Containment BVH::classify(const Frustum& frustum, const AABB& bounds)
+{
+	const glm::vec3 center = bounds.center();
+	const glm::vec3 extents = bounds.extents();
+
+	Containment result = Containment::Inside;
+	for (const glm::vec4& plane : frustum.planes)
+	{
+		const float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+		const float radius = glm::dot(glm::abs(glm::vec3(plane)), extents);
+		if (distance + radius < 0.f)
+		{
+			return Containment::Outside;
+		}
+		if (distance - radius < 0.f)
+		{
+			result = Containment::Intersecting;
+		}
+	}
+	return result;
+}
+
+template<typename Visitor>
+void BVH::visitSubtree(uint32_t nodeIndex, Visitor& visit) const
+{
+	uint32_t stack[MaxDepth + 2];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = nodeIndex;
+
+	while (stackSize > 0)
+	{
+		const Node& node = nodes[stack[--stackSize]];
+		if (node.isLeaf())
+		{
+			for (uint32_t i = node.first; i < node.first + node.count; i++)
+			{
+				visit(primitiveIndices[i]);
+			}
+			continue;
+		}
+		stack[stackSize++] = node.first;
+		stack[stackSize++] = node.first + 1;
+	}
+}
+
+template<typename Visitor>
+void BVH::queryFrustum(const Frustum& frustum, Visitor&& visit) const
+{
+	if (nodes.empty())
+	{
+		return;
+	}
+
+	// 트리 깊이는 MaxDepth 를 넘지 않는다.
+	uint32_t stack[MaxDepth + 2];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const uint32_t nodeIndex = stack[--stackSize];
+		const Node& node = nodes[nodeIndex];
+
+		const Containment containment = classify(frustum, node.bounds);
+		if (containment == Containment::Outside)
+		{
+			continue;
+		}
+		if (containment == Containment::Inside)
+		{
+			visitSubtree(nodeIndex, visit);
+			continue;
+		}
+
+		if (node.isLeaf())
+		{
+			for (uint32_t i = node.first; i < node.first + node.count; i++)
+			{
+				const uint32_t primitive = primitiveIndices[i];
+				if (classify(frustum, primitiveBounds[primitive]) != Containment::Outside)
+				{
+					visit(primitive);
+				}
+			}
+			continue;
+		}
+		stack[stackSize++] = node.first;
+		stack[stackSize++] = node.first + 1;
+	}
+}
@@ -1,2 +1,69 @@
 #include "Buffer.h"
 
+#include <stdexcept>
+
+void StorageBuffer::Create(VkDevice device, const VkPhysicalDeviceMemoryProperties& memoryProperties, VkDeviceSize inSize, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties)
+{
+	size = inSize;
+
+	VkBufferCreateInfo bufferInfo{};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = size;
+	bufferInfo.usage = usage;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	if (vkCreateBuffer(device, &bufferInfo, nullptr, &Buffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create storage buffer!");
+	}
+
+	VkMemoryRequirements memRequirements;
+	vkGetBufferMemoryRequirements(device, Buffer, &memRequirements);
+
+	uint32_t memoryTypeIndex = UINT32_MAX;
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+	{
+		if ((memRequirements.memoryTypeBits & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+		{
+			memoryTypeIndex = i;
+			break;
+		}
+	}
+	if (memoryTypeIndex == UINT32_MAX)
+	{
+		throw std::runtime_error("failed to find suitable memory type!");
+	}
+
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = memRequirements.size;
+	allocInfo.memoryTypeIndex = memoryTypeIndex;
+	if (vkAllocateMemory(device, &allocInfo, nullptr, &BufferMemory) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to allocate storage buffer memory!");
+	}
+	vkBindBufferMemory(device, Buffer, BufferMemory, 0);
+
+	if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+	{
+		vkMapMemory(device, BufferMemory, 0, size, 0, &mapped);
+	}
+}
+
+void StorageBuffer::Destroy(VkDevice device)
+{
+	if (Buffer == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	if (mapped)
+	{
+		vkUnmapMemory(device, BufferMemory);
+		mapped = nullptr;
+	}
+	vkDestroyBuffer(device, Buffer, nullptr);
+	vkFreeMemory(device, BufferMemory, nullptr);
+	Buffer = VK_NULL_HANDLE;
+	BufferMemory = VK_NULL_HANDLE;
+	size = 0;
+}
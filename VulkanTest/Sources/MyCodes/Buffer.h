@@ -43,4 +43,16 @@ struct GPUMeshBuffers
 		vertexBuffer.Destroy(device);
 		indexBuffer.Destroy(device);
 	}
-};
\ No newline at end of file
+};
+
+// 셰이더가 읽고 쓰는 버퍼. 호스트에서 보이는 메모리면 만들 때 매핑해 두고 Destroy 할 때까지 유지한다.
+struct StorageBuffer
+{
+	VkBuffer Buffer = VK_NULL_HANDLE;
+	VkDeviceMemory BufferMemory = VK_NULL_HANDLE;
+	VkDeviceSize size = 0;
+	void* mapped = nullptr;
+
+	void Create(VkDevice device, const VkPhysicalDeviceMemoryProperties& memoryProperties, VkDeviceSize inSize, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
+	void Destroy(VkDevice device);
+};
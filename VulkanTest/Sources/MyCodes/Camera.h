@@ -6,6 +6,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <string>
 #include <sstream>
+#include <cstdio>
 
 // Defines several possible options for camera movement. Used as abstraction to stay away from window-system specific input methods
 enum Camera_Movement {
@@ -146,15 +147,24 @@ public:
 			MovementSpeed = 10.0f;
 	}
 
-	std::string ToString()
+	// 임시 문자열 없이 out 뒤에 이어 쓴다. 매 프레임 부르는 곳에서 쓴다.
+	void AppendTo(std::string& out) const
 	{
-		std::ostringstream oss;
-		oss << "Position (" << Position.x << "," << Position.y << "," << Position.z << ")\n";
-		oss << "Front (" << Front.x << ", " << Front.y << ", " << Front.z << ")\n";
-		oss << "Up (" << Up.x << ", " << Up.y << ", " << Up.z << ")\n";
-		oss << "Right (" << Right.x << ", " << Right.y << ", " << Right.z << ")\n";
+		char buffer[256];
+		const int length = std::snprintf(buffer, sizeof(buffer),
+			"Position (%g,%g,%g)\nFront (%g, %g, %g)\nUp (%g, %g, %g)\nRight (%g, %g, %g)\n",
+			Position.x, Position.y, Position.z, Front.x, Front.y, Front.z, Up.x, Up.y, Up.z, Right.x, Right.y, Right.z);
+		if (length > 0)
+		{
+			out.append(buffer, static_cast<size_t>(length) < sizeof(buffer) ? length : sizeof(buffer) - 1);
+		}
+	}
 
-		return oss.str();
+	std::string ToString()
+	{
+		std::string result;
+		AppendTo(result);
+		return result;
 	}
 
 private:
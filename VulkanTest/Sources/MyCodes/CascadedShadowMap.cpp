@@ -0,0 +1,569 @@
+#include "CascadedShadowMap.h"
+#include "VulkanTutorialExtension.h"
+#include "FrustumCulling.h"
+#include "GPUMarker.h"
+#include "vk_descriptor.h"
+#include "vk_initializers.h"
+#include "vk_resource_utils.h"
+#include "vk_log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cmath>
+#include <cstring>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+bool CascadedShadowMap::enabled = true;
+float CascadedShadowMap::splitLambda = 0.75f;
+float CascadedShadowMap::shadowDistance = 60.f;
+int CascadedShadowMap::firstCachedCascade = 2;
+float CascadedShadowMap::cacheMargin = 1.25f;
+float CascadedShadowMap::depthBiasConstant = 1.25f;
+float CascadedShadowMap::depthBiasSlope = 1.75f;
+float CascadedShadowMap::normalOffset = 1.5f;
+bool CascadedShadowMap::showCascades = false;
+
+namespace
+{
+	// shaders/ShadowDepth.vert 의 ShadowPushConstants 와 같다.
+	struct ShadowPushConstants
+	{
+		glm::mat4 lightViewProjection;
+		glm::mat4 model;
+	};
+
+	VkFormat findShadowMapFormat(VkPhysicalDevice physicalDevice)
+	{
+		// PCF 를 하드웨어 비교 필터로 하므로 선형 필터도 되어야 한다.
+		const VkFormatFeatureFlags features = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+		for (VkFormat format : { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D16_UNORM })
+		{
+			VkFormatProperties properties;
+			vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+			if ((properties.optimalTilingFeatures & features) == features)
+			{
+				return format;
+			}
+		}
+		throw std::runtime_error("failed to find shadow map depth format!");
+	}
+}
+
+void CascadedShadowMap::createDescriptorSetLayout(VkDevice inDevice)
+{
+	setLayoutDevice = inDevice;
+
+	std::vector<VkDescriptorSetLayoutBinding> bindings;
+	vk::desc::createDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, bindings);
+	vk::desc::createDescriptorSetLayoutBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, bindings);
+	setLayout = vk::desc::createDescriptorSetLayout(inDevice, bindings);
+}
+
+void CascadedShadowMap::initialize(VulkanTutorialExtension* inEngine, VkPhysicalDevice physicalDevice, uint32_t imageCount)
+{
+	// 스왑체인을 다시 만들 때도 불린다. 그림자 맵은 화면 크기와 상관없으므로 그대로 쓴다.
+	if (!isInitialized())
+	{
+		engine = inEngine;
+		device = engine->getDevicePtr();
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+		depthFormat = findShadowMapFormat(physicalDevice);
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		timestampsSupported = properties.limits.timestampComputeAndGraphics == VK_TRUE;
+		timestampPeriod = properties.limits.timestampPeriod;
+
+		createRenderPass();
+		createPipeline();
+		createShadowMap();
+	}
+
+	if (frames.size() == imageCount)
+	{
+		return;
+	}
+	destroyFrames();
+
+	std::vector<VkDescriptorPoolSize> sizes =
+	{
+		vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, imageCount),
+		vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, imageCount)
+	};
+	VkDescriptorPoolCreateInfo poolInfo = vkb::initializers::descriptor_pool_create_info(sizes, imageCount);
+	VK_CHECK_RESULT(vkCreateDescriptorPool(*device, &poolInfo, nullptr, &descriptorPool));
+
+	if (timestampsSupported)
+	{
+		VkQueryPoolCreateInfo queryPoolInfo{};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = imageCount * CascadeCount * 2;
+		VK_CHECK_RESULT(vkCreateQueryPool(*device, &queryPoolInfo, nullptr, &queryPool));
+	}
+
+	const VkMemoryPropertyFlags hostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	VkDescriptorImageInfo shadowMapInfo = vkb::initializers::descriptor_image_info(sampler, shadowMap->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+	frames.resize(imageCount);
+	for (FrameResources& frame : frames)
+	{
+		frame.params.Create(*device, memoryProperties, sizeof(GPUShadowParams), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, hostVisible);
+		std::memset(frame.params.mapped, 0, sizeof(GPUShadowParams));
+
+		VkDescriptorSetAllocateInfo allocInfo = vkb::initializers::descriptor_set_allocate_info(descriptorPool, &setLayout, 1);
+		VK_CHECK_RESULT(vkAllocateDescriptorSets(*device, &allocInfo, &frame.set));
+
+		VkDescriptorBufferInfo paramsInfo{ frame.params.Buffer, 0, VK_WHOLE_SIZE };
+		std::vector<VkWriteDescriptorSet> writes =
+		{
+			vkb::initializers::write_descriptor_set(frame.set, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &paramsInfo),
+			vkb::initializers::write_descriptor_set(frame.set, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, &shadowMapInfo)
+		};
+		vkUpdateDescriptorSets(*device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+	}
+
+	// 새 셋은 아무것도 그리지 않은 상태로 시작하므로 캐시도 처음부터 채운다.
+	invalidate();
+
+	LOG(Log, "Cascaded shadow map : {} cascades of {}x{}, timestamps {}", CascadeCount, Resolution, Resolution, timestampsSupported ? "on" : "off");
+}
+
+void CascadedShadowMap::createRenderPass()
+{
+	// 캐스케이드마다 따로 지우고 그린다. 다 그린 뒤에는 라이팅 패스가 읽는 레이아웃으로 둔다.
+	VkAttachmentDescription depthAttachment{};
+	depthAttachment.format = depthFormat;
+	depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	depthAttachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkAttachmentReference depthRef{ 0, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+
+	VkSubpassDescription subpass{};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.pDepthStencilAttachment = &depthRef;
+
+	// 지난번 라이팅 패스가 다 읽은 뒤에 지우고, 이번 라이팅 패스는 다 쓴 뒤에 읽는다.
+	std::array<VkSubpassDependency, 2> dependencies{};
+	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[0].dstSubpass = 0;
+	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	dependencies[0].srcAccessMask = 0;
+	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+	dependencies[1].srcSubpass = 0;
+	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	VkRenderPassCreateInfo renderPassInfo = vkb::initializers::render_pass_create_info();
+	renderPassInfo.attachmentCount = 1;
+	renderPassInfo.pAttachments = &depthAttachment;
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+	renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+	renderPassInfo.pDependencies = dependencies.data();
+	VK_CHECK_RESULT(vkCreateRenderPass(*device, &renderPassInfo, nullptr, &renderPass));
+}
+
+void CascadedShadowMap::createPipeline()
+{
+	VkPushConstantRange pushConstantRange = vkb::initializers::push_constant_range(VK_SHADER_STAGE_VERTEX_BIT, sizeof(ShadowPushConstants), 0);
+	VkPipelineLayoutCreateInfo layoutInfo = vkb::initializers::pipeline_layout_create_info(nullptr, 0);
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &pushConstantRange;
+	VK_CHECK_RESULT(vkCreatePipelineLayout(*device, &layoutInfo, nullptr, &pipelineLayout));
+
+	// 위치 전용 스트림만 읽는다.
+	std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+	VertexOnlyPos::getBindingDescriptions(bindingDescriptions);
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+	VertexOnlyPos::getAttributeDescriptions(attributeDescriptions);
+	VkPipelineVertexInputStateCreateInfo vertexInputState = vkb::initializers::pipeline_vertex_input_state_create_info();
+	vertexInputState.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
+	vertexInputState.pVertexBindingDescriptions = bindingDescriptions.data();
+	vertexInputState.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+	vertexInputState.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+	// 지오메트리 패스와 같이 뒷면을 버린다. 깊이 바이어스는 UI 에서 바꾸므로 동적으로 둔다.
+	VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = vkb::initializers::pipeline_input_assembly_state_create_info(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, 0, VK_FALSE);
+	VkPipelineRasterizationStateCreateInfo rasterizationState = vkb::initializers::pipeline_rasterization_state_create_info(VK_POLYGON_MODE_FILL, VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE, 0);
+	rasterizationState.depthBiasEnable = VK_TRUE;
+	VkPipelineMultisampleStateCreateInfo multisampleState = vkb::initializers::pipeline_multisample_state_create_info(VK_SAMPLE_COUNT_1_BIT, 0);
+	VkPipelineViewportStateCreateInfo viewportState = vkb::initializers::pipeline_viewport_state_create_info(1, 1, 0);
+	std::vector<VkDynamicState> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR, VK_DYNAMIC_STATE_DEPTH_BIAS };
+	VkPipelineDynamicStateCreateInfo dynamicState = vkb::initializers::pipeline_dynamic_state_create_info(dynamicStates);
+	VkPipelineDepthStencilStateCreateInfo depthStencilState = vkb::initializers::pipeline_depth_stencil_state_create_info(VK_TRUE, VK_TRUE, VK_COMPARE_OP_LESS_OR_EQUAL);
+	VkPipelineColorBlendStateCreateInfo colorBlendState = vkb::initializers::pipeline_color_blend_state_create_info(0, nullptr);
+
+	// 색 출력이 없으므로 프래그먼트 셰이더도 없다.
+	VkShaderModule vertexShader = Utils::loadShader("shaders/ShadowDepthvert.spv", *device);
+	VkPipelineShaderStageCreateInfo shaderStage{};
+	shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStage.stage = VK_SHADER_STAGE_VERTEX_BIT;
+	shaderStage.module = vertexShader;
+	shaderStage.pName = "main";
+
+	VkGraphicsPipelineCreateInfo pipelineInfo = vkb::initializers::pipeline_create_info(pipelineLayout, renderPass);
+	pipelineInfo.stageCount = 1;
+	pipelineInfo.pStages = &shaderStage;
+	pipelineInfo.pVertexInputState = &vertexInputState;
+	pipelineInfo.pInputAssemblyState = &inputAssemblyState;
+	pipelineInfo.pRasterizationState = &rasterizationState;
+	pipelineInfo.pMultisampleState = &multisampleState;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pDepthStencilState = &depthStencilState;
+	pipelineInfo.pColorBlendState = &colorBlendState;
+	pipelineInfo.pDynamicState = &dynamicState;
+	VK_CHECK_RESULT(vkCreateGraphicsPipelines(*device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline));
+
+	vkDestroyShaderModule(*device, vertexShader, nullptr);
+}
+
+void CascadedShadowMap::createShadowMap()
+{
+	shadowMap = engine->createImage(Resolution, Resolution, 1, VK_SAMPLE_COUNT_1_BIT, depthFormat, VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, "CascadedShadowMap", CascadeCount);
+
+	VkImageViewCreateInfo viewInfo = vkb::initializers::image_view_create_info();
+	viewInfo.image = shadowMap->image;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+	viewInfo.format = depthFormat;
+	viewInfo.subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, CascadeCount };
+	VK_CHECK_RESULT(vkCreateImageView(*device, &viewInfo, nullptr, &shadowMap->imageView));
+
+	for (uint32_t cascade = 0; cascade < CascadeCount; cascade++)
+	{
+		layerViews[cascade] = engine->createImageView(shadowMap->image, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1, cascade);
+
+		VkFramebufferCreateInfo framebufferInfo = vkb::initializers::framebuffer_create_info();
+		framebufferInfo.renderPass = renderPass;
+		framebufferInfo.attachmentCount = 1;
+		framebufferInfo.pAttachments = &layerViews[cascade];
+		framebufferInfo.width = Resolution;
+		framebufferInfo.height = Resolution;
+		framebufferInfo.layers = 1;
+		VK_CHECK_RESULT(vkCreateFramebuffer(*device, &framebufferInfo, nullptr, &framebuffers[cascade]));
+	}
+
+	// 그리기 전에도 라이팅 패스가 샘플링하므로 읽기 레이아웃으로 옮겨 둔다. 그림자가 꺼져 있으면 셰이더가 읽지 않는다.
+	VkCommandBuffer commandBuffer = engine->beginSingleTimeCommands();
+	VkImageMemoryBarrier barrier = vkb::initializers::image_memory_barrier();
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barrier.image = shadowMap->image;
+	barrier.subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, CascadeCount };
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	engine->endSingleTimeCommands(commandBuffer);
+
+	// 맵 밖은 빛을 받는 것으로 본다.
+	VkSamplerCreateInfo samplerInfo = vkb::initializers::sampler_create_info();
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+	samplerInfo.compareEnable = VK_TRUE;
+	samplerInfo.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+	samplerInfo.maxLod = 1.f;
+	samplerInfo.maxAnisotropy = 1.f;
+	VK_CHECK_RESULT(vkCreateSampler(*device, &samplerInfo, nullptr, &sampler));
+}
+
+void CascadedShadowMap::destroyFrames()
+{
+	for (FrameResources& frame : frames)
+	{
+		frame.params.Destroy(*device);
+	}
+	frames.clear();
+
+	if (descriptorPool != VK_NULL_HANDLE)
+	{
+		vkDestroyDescriptorPool(*device, descriptorPool, nullptr);
+		descriptorPool = VK_NULL_HANDLE;
+	}
+	if (queryPool != VK_NULL_HANDLE)
+	{
+		vkDestroyQueryPool(*device, queryPool, nullptr);
+		queryPool = VK_NULL_HANDLE;
+	}
+}
+
+void CascadedShadowMap::cleanup()
+{
+	if (isInitialized())
+	{
+		destroyFrames();
+		for (uint32_t cascade = 0; cascade < CascadeCount; cascade++)
+		{
+			vkDestroyFramebuffer(*device, framebuffers[cascade], nullptr);
+			vkDestroyImageView(*device, layerViews[cascade], nullptr);
+			framebuffers[cascade] = VK_NULL_HANDLE;
+			layerViews[cascade] = VK_NULL_HANDLE;
+		}
+		shadowMap.reset();
+		vkDestroySampler(*device, sampler, nullptr);
+		vkDestroyPipeline(*device, pipeline, nullptr);
+		vkDestroyPipelineLayout(*device, pipelineLayout, nullptr);
+		vkDestroyRenderPass(*device, renderPass, nullptr);
+		sampler = VK_NULL_HANDLE;
+		pipeline = VK_NULL_HANDLE;
+		pipelineLayout = VK_NULL_HANDLE;
+		renderPass = VK_NULL_HANDLE;
+	}
+
+	vkDestroyDescriptorSetLayout(setLayoutDevice, setLayout, nullptr);
+	setLayout = VK_NULL_HANDLE;
+}
+
+void CascadedShadowMap::invalidate()
+{
+	for (Cascade& cascade : cascades)
+	{
+		cascade.valid = false;
+	}
+}
+
+void CascadedShadowMap::fitCascade(Cascade& cascade, const glm::mat4& lightView, const glm::vec3& center, float radius) const
+{
+	// 반지름을 올림해 부동소수 오차로 텍셀 크기가 흔들리지 않게 한다.
+	radius = std::ceil(radius * 16.f) / 16.f;
+	const float texelSize = 2.f * radius / Resolution;
+
+	// 중심을 빛 공간 텍셀 격자에 맞춘다. 카메라가 움직여도 래스터화되는 텍셀 위치가 그대로라 가장자리가 떨리지 않는다.
+	glm::vec3 lightSpaceCenter = glm::vec3(lightView * glm::vec4(center, 1.f));
+	lightSpaceCenter.x = std::floor(lightSpaceCenter.x / texelSize) * texelSize;
+	lightSpaceCenter.y = std::floor(lightSpaceCenter.y / texelSize) * texelSize;
+
+	// 빛 공간은 -z 를 본다.
+	const float nearDepth = -lightSpaceCenter.z - radius - CasterDepthExtension;
+	const float farDepth = -lightSpaceCenter.z + radius;
+	glm::mat4 projection = glm::ortho(lightSpaceCenter.x - radius, lightSpaceCenter.x + radius,
+		lightSpaceCenter.y - radius, lightSpaceCenter.y + radius, nearDepth, farDepth);
+	// 카메라 투영과 같이 y 를 뒤집어 감는 방향을 맞춘다.
+	projection[1][1] *= -1;
+
+	cascade.viewProjection = projection * lightView;
+	cascade.center = glm::vec3(glm::inverse(lightView) * glm::vec4(lightSpaceCenter, 1.f));
+	cascade.radius = radius;
+	cascade.texelSize = texelSize;
+	cascade.valid = true;
+}
+
+void CascadedShadowMap::readTimestamps(FrameResources& frame, uint32_t imageIndex)
+{
+	if (queryPool == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	// 이 이미지의 펜스를 기다렸으므로 결과가 있다. 없으면 지난 값을 그대로 둔다.
+	for (uint32_t cascade = 0; cascade < CascadeCount; cascade++)
+	{
+		if ((frame.timedMask & (1u << cascade)) == 0)
+		{
+			continue;
+		}
+
+		uint64_t ticks[2] = {};
+		const uint32_t query = (imageIndex * CascadeCount + cascade) * 2;
+		if (vkGetQueryPoolResults(*device, queryPool, query, 2, sizeof(ticks), ticks, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+		{
+			stats.cascades[cascade].gpuMilliseconds = static_cast<float>(static_cast<double>(ticks[1] - ticks[0]) * timestampPeriod / 1000000.0);
+		}
+	}
+	frame.timedMask = 0;
+}
+
+void CascadedShadowMap::update(uint32_t imageIndex, bool active, const glm::vec3& lightDirection, const glm::mat4& view, float fovY, float aspect,
+	float nearPlane, float farPlane, const FrameVector<RenderObject>& casters, bool sceneChanged)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	FrameResources& frame = frames[imageIndex];
+	readTimestamps(frame, imageIndex);
+
+	renderMask = 0;
+	for (CascadeStats& cascadeStats : stats.cascades)
+	{
+		cascadeStats.rendered = false;
+	}
+
+	GPUShadowParams& params = *static_cast<GPUShadowParams*>(frame.params.mapped);
+	// 방향이 0 벡터면 빛 공간을 만들 수 없으므로 끈다.
+	if (!active || !enabled || glm::length(lightDirection) < 0.0001f)
+	{
+		params.flags = glm::uvec4(0);
+		stats.casterCandidates = 0;
+		invalidate();
+		return;
+	}
+
+	// 빛 방향이나 그림자 맵에 영향을 주는 설정, 장면이 바뀌면 캐시한 캐스케이드도 다시 그린다.
+	const glm::vec3 lightDir = glm::normalize(lightDirection);
+	const std::array<float, 6> settings = { splitLambda, shadowDistance, cacheMargin, depthBiasConstant, depthBiasSlope, static_cast<float>(firstCachedCascade) };
+	if (sceneChanged || lightDir != cachedLightDirection || settings != cachedSettings)
+	{
+		invalidate();
+	}
+	cachedLightDirection = lightDir;
+	cachedSettings = settings;
+
+	// 빛 공간은 원점에서 빛 방향을 보는 회전만 둔다. 텍셀 격자가 카메라 위치와 상관없이 고정된다.
+	const glm::vec3 up = std::abs(lightDir.y) > 0.99f ? glm::vec3(0.f, 0.f, 1.f) : glm::vec3(0.f, 1.f, 0.f);
+	const glm::mat4 lightView = glm::lookAt(glm::vec3(0.f), lightDir, up);
+	const glm::mat4 inverseView = glm::inverse(view);
+	const float maxDistance = std::max(std::min(farPlane, shadowDistance), nearPlane * 2.f);
+	const float tanHalfFov = std::tan(fovY * 0.5f);
+
+	stats.casterCandidates = static_cast<uint32_t>(casters.size());
+	stats.frames++;
+
+	float splitNear = nearPlane;
+	for (uint32_t c = 0; c < CascadeCount; c++)
+	{
+		// practical split : 로그 분할이 가까운 쪽 해상도를, 균등 분할이 먼 쪽 범위를 맡는다.
+		const float ratio = static_cast<float>(c + 1) / CascadeCount;
+		const float logSplit = nearPlane * std::pow(maxDistance / nearPlane, ratio);
+		const float uniformSplit = nearPlane + (maxDistance - nearPlane) * ratio;
+		const float splitFar = glm::mix(uniformSplit, logSplit, splitLambda);
+
+		// 조각 프러스텀을 감싸는 구. 중심은 시선 위에 있고 반지름은 카메라 회전과 상관없다.
+		const float centerDepth = 0.5f * (splitNear + splitFar);
+		const glm::vec3 center = glm::vec3(inverseView * glm::vec4(0.f, 0.f, -centerDepth, 1.f));
+		float radius = 0.f;
+		for (float depth : { splitNear, splitFar })
+		{
+			const float halfHeight = depth * tanHalfFov;
+			radius = std::max(radius, glm::length(glm::vec3(halfHeight * aspect, halfHeight, depth - centerDepth)));
+		}
+
+		Cascade& cascade = cascades[c];
+		CascadeStats& cascadeStats = stats.cascades[c];
+		cascadeStats.splitFar = splitFar;
+		cascadeStats.cacheable = static_cast<int>(c) >= firstCachedCascade;
+
+		const bool cached = cascadeStats.cacheable && cascade.valid && glm::length(center - cascade.center) + radius <= cascade.radius;
+		if (!cached)
+		{
+			fitCascade(cascade, lightView, center, cascadeStats.cacheable ? radius * cacheMargin : radius);
+
+			FrameVector<RenderObject>& draws = cascadeDraws[c];
+			draws = FrameVector<RenderObject>(casters.begin(), casters.end(), FrameAllocator::get().allocator<RenderObject>());
+			const FrustumCulling::Stats cullStats = FrustumCulling::cullDrawList(draws, Frustum::fromViewProjection(cascade.viewProjection));
+			cascadeStats.casters = static_cast<uint32_t>(draws.size());
+			cascadeStats.culled = cullStats.culled;
+			cascadeStats.rendered = true;
+			cascadeStats.renderCount++;
+			renderMask |= 1u << c;
+		}
+
+		params.lightViewProjection[c] = cascade.viewProjection;
+		params.splitDepths[c] = splitFar;
+		params.texelSizes[c] = cascade.texelSize;
+		splitNear = splitFar;
+	}
+
+	params.flags = glm::uvec4(1, showCascades ? 1 : 0, 0, 0);
+	params.bias = glm::vec4(normalOffset, 0.f, 0.f, 0.f);
+
+	stats.cpuMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void CascadedShadowMap::record(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+{
+	FrameResources& frame = frames[imageIndex];
+	frame.timedMask = 0;
+	if (renderMask == 0)
+	{
+		return;
+	}
+
+	GPUMarker Marker(commandBuffer, "Cascaded Shadow Map");
+
+	VkViewport viewport = vkb::initializers::viewport(static_cast<float>(Resolution), static_cast<float>(Resolution), 0.f, 1.f);
+	VkRect2D scissor = vkb::initializers::rect2D(Resolution, Resolution, 0, 0);
+
+	for (uint32_t c = 0; c < CascadeCount; c++)
+	{
+		if ((renderMask & (1u << c)) == 0)
+		{
+			continue;
+		}
+
+		const uint32_t query = (imageIndex * CascadeCount + c) * 2;
+		if (queryPool != VK_NULL_HANDLE)
+		{
+			vkCmdResetQueryPool(commandBuffer, queryPool, query, 2);
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, query);
+		}
+
+		VkClearValue clearValue{};
+		clearValue.depthStencil = { 1.f, 0 };
+		VkRenderPassBeginInfo renderPassInfo = vkb::initializers::render_pass_begin_info();
+		renderPassInfo.renderPass = renderPass;
+		renderPassInfo.framebuffer = framebuffers[c];
+		renderPassInfo.renderArea.offset = { 0, 0 };
+		renderPassInfo.renderArea.extent = { Resolution, Resolution };
+		renderPassInfo.clearValueCount = 1;
+		renderPassInfo.pClearValues = &clearValue;
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+		vkCmdSetDepthBias(commandBuffer, depthBiasConstant, 0.f, depthBiasSlope);
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, offsetof(ShadowPushConstants, lightViewProjection), sizeof(glm::mat4), &cascades[c].viewProjection);
+
+		// 같은 메시가 이어지면 버퍼를 다시 바인딩하지 않는다.
+		VkBuffer boundPositions = VK_NULL_HANDLE;
+		VkBuffer boundIndices = VK_NULL_HANDLE;
+		for (const RenderObject& draw : cascadeDraws[c])
+		{
+			if (draw.positionBuffer == VK_NULL_HANDLE)
+			{
+				continue;
+			}
+			if (draw.positionBuffer != boundPositions)
+			{
+				VkDeviceSize offset = 0;
+				vkCmdBindVertexBuffers(commandBuffer, 0, 1, &draw.positionBuffer, &offset);
+				boundPositions = draw.positionBuffer;
+			}
+			if (draw.indexBuffer != boundIndices)
+			{
+				vkCmdBindIndexBuffer(commandBuffer, draw.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+				boundIndices = draw.indexBuffer;
+			}
+			vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, offsetof(ShadowPushConstants, model), sizeof(glm::mat4), &draw.transform);
+			vkCmdDrawIndexed(commandBuffer, draw.indexCount, 1, draw.firstIndex, 0, 0);
+		}
+
+		vkCmdEndRenderPass(commandBuffer);
+
+		if (queryPool != VK_NULL_HANDLE)
+		{
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, query + 1);
+			frame.timedMask |= 1u << c;
+		}
+	}
+}
+
+void CascadedShadowMap::bind(VkCommandBuffer commandBuffer, VkPipelineLayout layout, uint32_t setIndex, uint32_t imageIndex) const
+{
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, setIndex, 1, &frames[imageIndex].set, 0, nullptr);
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "vk_types.h"
+#include "vk_engine.h"
+#include "Buffer.h"
+
+#include <array>
+#include <vector>
+
+class VulkanTutorialExtension;
+
+// shaders/shadow.glsl 의 ShadowParams 와 배치가 같아야 한다. (std140)
+struct GPUShadowParams
+{
+	glm::mat4 lightViewProjection[4];
+	glm::vec4 splitDepths;		// 캐스케이드마다 뷰 공간 far 거리
+	glm::vec4 texelSizes;		// 캐스케이드마다 월드 단위 텍셀 크기
+	glm::uvec4 flags;			// x 가 0 이면 그림자를 쓰지 않는다. y 가 1 이면 캐스케이드마다 색을 입힌다
+	glm::vec4 bias;				// x 노멀 방향으로 미는 거리(텍셀 단위)
+};
+
+/**
+ * 방향광의 캐스케이드 그림자 맵.
+ *
+ * 카메라 프러스텀을 near 에서 shadowDistance 까지 practical split(로그와 균등 분할을 splitLambda 로 섞는다)으로 나누고,
+ * 조각마다 감싸는 구를 빛 방향 직교 투영으로 그린다. 구의 반지름은 카메라 회전과 상관없고 중심은 빛 공간 텍셀 격자에 맞추므로
+ * 카메라가 움직여도 그림자 가장자리가 떨리지 않는다. 깊이만 쓰는 패스는 MeshAsset 의 위치 전용 스트림을 읽는다.
+ *
+ * firstCachedCascade 부터의 먼 캐스케이드는 cacheMargin 만큼 큰 구로 그려 두고, 조각 구가 그 안에 있는 동안은 다시 그리지 않는다.
+ * 빛 방향, 설정, 장면(인스턴스 이동이나 모델 로드/언로드)이 바뀌면 모두 다시 그린다. 가까운 캐스케이드는 매 프레임 그린다.
+ *
+ * 드리우는 물체 목록이 매 프레임 바뀌므로 매 프레임 녹화할 때만 켜진다. 라이팅 패스(Pbr.frag)는 setIndex 번 셋의
+ * 파라미터와 그림자 맵 배열을 읽는다. 파라미터는 스왑체인 이미지마다 두므로 꺼져 있어도 셋은 항상 바인딩한다.
+ */
+class CascadedShadowMap
+{
+public:
+	static constexpr uint32_t CascadeCount = 4;
+	static constexpr uint32_t Resolution = 2048;
+	// 조각 구 앞쪽(빛 쪽)에 있어 화면에 보이지 않는 물체도 그림자를 드리우도록 near 를 이만큼 빛 쪽으로 늘린다.
+	static constexpr float CasterDepthExtension = 50.f;
+
+	static bool enabled;
+	static float splitLambda;
+	static float shadowDistance;
+	// 이 번호부터 캐시한다. CascadeCount 면 모두 매 프레임 그린다.
+	static int firstCachedCascade;
+	static float cacheMargin;
+	static float depthBiasConstant;
+	static float depthBiasSlope;
+	static float normalOffset;
+	static bool showCascades;
+
+	struct CascadeStats
+	{
+		float splitFar = 0.f;
+		uint32_t casters = 0;		// 라이트 프러스텀 안에 든 드로우
+		uint32_t culled = 0;
+		bool cacheable = false;
+		bool rendered = false;		// 이번 프레임에 다시 그렸는지
+		uint32_t renderCount = 0;	// 켠 뒤로 다시 그린 횟수
+		float gpuMilliseconds = 0.f;	// 마지막으로 그렸을 때 걸린 GPU 시간
+	};
+
+	struct Stats
+	{
+		std::array<CascadeStats, CascadeCount> cascades;
+		uint32_t casterCandidates = 0;
+		uint32_t frames = 0;
+		float cpuMilliseconds = 0.f;
+	};
+
+	// 라이팅 파이프라인 레이아웃보다 먼저 있어야 하므로 initialize 와 따로 만든다.
+	void createDescriptorSetLayout(VkDevice device);
+	VkDescriptorSetLayout getDescriptorSetLayout() const { return setLayout; }
+
+	// 그림자 맵과 파이프라인을 한번 만들고, 이미지 수가 바뀌면 파라미터 버퍼와 셋을 다시 만든다.
+	void initialize(VulkanTutorialExtension* inEngine, VkPhysicalDevice physicalDevice, uint32_t imageCount);
+	void cleanup();
+
+	// 지난번 이 이미지로 잰 GPU 시간을 읽고, 캐스케이드를 맞추고 다시 그릴 캐스케이드를 고른다.
+	// 쿼리를 기다리지 않고 읽으므로 이 이미지를 쓴 프레임이 끝난 뒤(preDrawFrame)에 불러야 한다.
+	// casters 는 카메라 컬링 전의 불투명 드로우이고 record 까지 살아 있어야 한다. active 가 아니면 그림자를 끄고 캐시를 버린다.
+	void update(uint32_t imageIndex, bool active, const glm::vec3& lightDirection, const glm::mat4& view, float fovY, float aspect,
+		float nearPlane, float farPlane, const FrameVector<RenderObject>& casters, bool sceneChanged);
+	// update 에서 고른 캐스케이드만 그린다. 렌더 패스 밖에서 라이팅 패스보다 먼저 부른다.
+	void record(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+	void bind(VkCommandBuffer commandBuffer, VkPipelineLayout layout, uint32_t setIndex, uint32_t imageIndex) const;
+
+	// 다음 update 에서 캐시한 캐스케이드까지 모두 다시 그린다.
+	void invalidate();
+
+	const Stats& getStats() const { return stats; }
+	bool isInitialized() const { return pipeline != VK_NULL_HANDLE; }
+
+private:
+	struct Cascade
+	{
+		glm::mat4 viewProjection{ 1.f };
+		// 그려 둔 영역을 감싸는 월드 공간 구. 조각 구가 이 안에 있으면 다시 그리지 않아도 된다.
+		glm::vec3 center{ 0.f };
+		float radius = 0.f;
+		float texelSize = 0.f;
+		bool valid = false;
+	};
+
+	struct FrameResources
+	{
+		StorageBuffer params;		// GPUShadowParams, 유니폼 버퍼
+		VkDescriptorSet set = VK_NULL_HANDLE;
+		// 이 이미지에 타임스탬프를 기록한 캐스케이드
+		uint32_t timedMask = 0;
+	};
+
+	void createRenderPass();
+	void createPipeline();
+	void createShadowMap();
+	void destroyFrames();
+	// 중심과 반지름으로 캐스케이드의 직교 투영을 만든다. 반지름은 올림하고 중심은 텍셀 격자에 맞춘다.
+	void fitCascade(Cascade& cascade, const glm::mat4& lightView, const glm::vec3& center, float radius) const;
+	void readTimestamps(FrameResources& frame, uint32_t imageIndex);
+
+	VulkanTutorialExtension* engine = nullptr;
+	DevicePtr device;
+	VkPhysicalDeviceMemoryProperties memoryProperties{};
+	VkDevice setLayoutDevice = VK_NULL_HANDLE;
+	VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+
+	VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+	VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+	VkRenderPass renderPass = VK_NULL_HANDLE;
+	VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+	VkPipeline pipeline = VK_NULL_HANDLE;
+
+	// 캐스케이드가 레이어 하나씩 쓰는 깊이 배열. imageView 는 배열 전체를 비교 샘플링하는 뷰다.
+	std::shared_ptr<AllocatedImage> shadowMap;
+	std::array<VkImageView, CascadeCount> layerViews{};
+	std::array<VkFramebuffer, CascadeCount> framebuffers{};
+	VkSampler sampler = VK_NULL_HANDLE;
+
+	// 스왑체인 이미지마다 캐스케이드당 시작, 끝 두 개
+	VkQueryPool queryPool = VK_NULL_HANDLE;
+	bool timestampsSupported = false;
+	float timestampPeriod = 1.f;
+
+	std::vector<FrameResources> frames;
+	std::array<Cascade, CascadeCount> cascades;
+	// update 에서 고르고 record 가 그린다. 드로우는 프레임 arena 에 있다.
+	std::array<FrameVector<RenderObject>, CascadeCount> cascadeDraws;
+	uint32_t renderMask = 0;
+
+	// 바뀌면 캐시를 버린다.
+	glm::vec3 cachedLightDirection{ 0.f };
+	std::array<float, 6> cachedSettings{};
+
+	Stats stats;
+};
@@ -0,0 +1,231 @@
+#include "ClusteredLighting.h"
+#include "VulkanTutorialExtension.h"
+#include "vk_descriptor.h"
+#include "vk_initializers.h"
+#include "vk_resource_utils.h"
+#include "vk_log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+bool ClusteredLighting::enabled = true;
+float ClusteredLighting::attenuationCutoff = 0.01f;
+int ClusteredLighting::testLightCount = 0;
+bool ClusteredLighting::animateTestLights = true;
+
+namespace
+{
+	constexpr uint32_t ClusteringGroupSize = 64;
+
+	// shaders/LightClustering.comp 의 ClusterStats 와 같다.
+	struct GPUClusterStats
+	{
+		uint32_t occupiedClusters;
+		uint32_t assignedLights;
+		uint32_t maxLightsPerCluster;
+		uint32_t overflowedClusters;
+	};
+}
+
+void ClusteredLighting::createDescriptorSetLayout(VkDevice inDevice)
+{
+	setLayoutDevice = inDevice;
+
+	// 컴퓨트 패스와 라이팅 패스가 같은 셋을 쓴다. 통계 버퍼는 컴퓨트에서만 쓴다.
+	// 라이트 볼륨은 버텍스 셰이더에서 라이트 위치와 반지름을 읽는다.
+	const VkShaderStageFlags stages = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+	std::vector<VkDescriptorSetLayoutBinding> bindings;
+	vk::desc::createDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, stages, bindings);
+	vk::desc::createDescriptorSetLayoutBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages | VK_SHADER_STAGE_VERTEX_BIT, bindings);
+	vk::desc::createDescriptorSetLayoutBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages, bindings);
+	vk::desc::createDescriptorSetLayoutBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, bindings);
+	setLayout = vk::desc::createDescriptorSetLayout(inDevice, bindings);
+}
+
+void ClusteredLighting::initialize(VulkanTutorialExtension* engine, VkPhysicalDevice physicalDevice, uint32_t inImageCount)
+{
+	// 스왑체인을 다시 만들 때도 불린다. 버퍼 크기는 화면 크기와 상관없으므로 이미지 수가 같으면 그대로 쓴다.
+	if (!isInitialized())
+	{
+		device = engine->getDevicePtr();
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+		VkPipelineLayoutCreateInfo layoutInfo = vkb::initializers::pipeline_layout_create_info(&setLayout, 1);
+		VK_CHECK_RESULT(vkCreatePipelineLayout(*device, &layoutInfo, nullptr, &pipelineLayout));
+
+		VkShaderModule computeShader = Utils::loadShader("shaders/LightClusteringcomp.spv", *device);
+		VkComputePipelineCreateInfo pipelineInfo = vkb::initializers::compute_pipeline_create_info(pipelineLayout);
+		pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		pipelineInfo.stage.module = computeShader;
+		pipelineInfo.stage.pName = "main";
+		VK_CHECK_RESULT(vkCreateComputePipelines(*device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline));
+		vkDestroyShaderModule(*device, computeShader, nullptr);
+	}
+
+	if (frames.size() == inImageCount)
+	{
+		return;
+	}
+	destroyFrames();
+
+	std::vector<VkDescriptorPoolSize> sizes =
+	{
+		vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, inImageCount),
+		vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * inImageCount)
+	};
+	VkDescriptorPoolCreateInfo poolInfo = vkb::initializers::descriptor_pool_create_info(sizes, inImageCount);
+	VK_CHECK_RESULT(vkCreateDescriptorPool(*device, &poolInfo, nullptr, &descriptorPool));
+
+	const VkMemoryPropertyFlags hostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	const VkDeviceSize clusterBufferSize = sizeof(uint32_t) * ClusterCount * (1 + MaxLightsPerCluster);
+
+	frames.resize(inImageCount);
+	for (FrameResources& frame : frames)
+	{
+		frame.params.Create(*device, memoryProperties, sizeof(GPUClusterParams), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, hostVisible);
+		frame.lights.Create(*device, memoryProperties, sizeof(GPUClusterLight) * MaxLights, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible);
+		frame.clusters.Create(*device, memoryProperties, clusterBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		frame.stats.Create(*device, memoryProperties, sizeof(GPUClusterStats), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible);
+		std::memset(frame.params.mapped, 0, sizeof(GPUClusterParams));
+		std::memset(frame.stats.mapped, 0, sizeof(GPUClusterStats));
+
+		VkDescriptorSetAllocateInfo allocInfo = vkb::initializers::descriptor_set_allocate_info(descriptorPool, &setLayout, 1);
+		VK_CHECK_RESULT(vkAllocateDescriptorSets(*device, &allocInfo, &frame.set));
+
+		VkDescriptorBufferInfo paramsInfo{ frame.params.Buffer, 0, VK_WHOLE_SIZE };
+		VkDescriptorBufferInfo lightsInfo{ frame.lights.Buffer, 0, VK_WHOLE_SIZE };
+		VkDescriptorBufferInfo clustersInfo{ frame.clusters.Buffer, 0, VK_WHOLE_SIZE };
+		VkDescriptorBufferInfo statsInfo{ frame.stats.Buffer, 0, VK_WHOLE_SIZE };
+		std::vector<VkWriteDescriptorSet> writes =
+		{
+			vkb::initializers::write_descriptor_set(frame.set, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &paramsInfo),
+			vkb::initializers::write_descriptor_set(frame.set, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, &lightsInfo),
+			vkb::initializers::write_descriptor_set(frame.set, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2, &clustersInfo),
+			vkb::initializers::write_descriptor_set(frame.set, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3, &statsInfo)
+		};
+		vkUpdateDescriptorSets(*device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+	}
+
+	LOG(Log, "Clustered lighting : {}x{}x{} clusters, {} lights max, {} KB cluster lists x {} images",
+		GridX, GridY, GridZ, MaxLights, clusterBufferSize / 1024, inImageCount);
+}
+
+void ClusteredLighting::destroyFrames()
+{
+	for (FrameResources& frame : frames)
+	{
+		frame.params.Destroy(*device);
+		frame.lights.Destroy(*device);
+		frame.clusters.Destroy(*device);
+		frame.stats.Destroy(*device);
+	}
+	frames.clear();
+
+	if (descriptorPool != VK_NULL_HANDLE)
+	{
+		vkDestroyDescriptorPool(*device, descriptorPool, nullptr);
+		descriptorPool = VK_NULL_HANDLE;
+	}
+}
+
+void ClusteredLighting::cleanup()
+{
+	if (isInitialized())
+	{
+		destroyFrames();
+		vkDestroyPipeline(*device, pipeline, nullptr);
+		vkDestroyPipelineLayout(*device, pipelineLayout, nullptr);
+		pipeline = VK_NULL_HANDLE;
+		pipelineLayout = VK_NULL_HANDLE;
+	}
+
+	vkDestroyDescriptorSetLayout(setLayoutDevice, setLayout, nullptr);
+	setLayout = VK_NULL_HANDLE;
+}
+
+void ClusteredLighting::update(uint32_t imageIndex, const glm::mat4& view, const glm::mat4& projection, VkExtent2D extent, float nearPlane, float farPlane,
+	const std::vector<GPUClusterLight>& lights, bool lightVolumes)
+{
+	FrameResources& frame = frames[imageIndex];
+
+	// 지난번 이 이미지를 그릴 때 센 값이다.
+	GPUClusterStats* stats = static_cast<GPUClusterStats*>(frame.stats.mapped);
+	lastStats.lights = frame.lightCount;
+	lastStats.occupiedClusters = stats->occupiedClusters;
+	lastStats.assignedLights = stats->assignedLights;
+	lastStats.maxLightsPerCluster = stats->maxLightsPerCluster;
+	lastStats.overflowedClusters = stats->overflowedClusters;
+	std::memset(stats, 0, sizeof(GPUClusterStats));
+
+	frame.lightCount = std::min(static_cast<uint32_t>(lights.size()), MaxLights);
+	if (frame.lightCount > 0)
+	{
+		std::memcpy(frame.lights.mapped, lights.data(), sizeof(GPUClusterLight) * frame.lightCount);
+	}
+
+	GPUClusterParams& params = *static_cast<GPUClusterParams*>(frame.params.mapped);
+	params.view = view;
+	params.inverseProjection = glm::inverse(projection);
+	params.gridSize = glm::uvec4(GridX, GridY, GridZ, frame.lightCount);
+	params.screen = glm::vec4(static_cast<float>(extent.width), static_cast<float>(extent.height), nearPlane, farPlane);
+	params.flags = glm::uvec4(enabled && !lightVolumes ? 1 : 0, MaxLightsPerCluster, lightVolumes ? 1 : 0, 0);
+}
+
+void ClusteredLighting::recordClustering(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+{
+	const FrameResources& frame = frames[imageIndex];
+
+	// 지난번 라이팅 패스가 목록을 다 읽은 뒤에 덮어쓴다.
+	VkMemoryBarrier readBarrier = vkb::initializers::memory_barrier();
+	readBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	readBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 1, &readBarrier, 0, nullptr, 0, nullptr);
+
+	// 클러스터를 쓰지 않아도 디스패치는 기록해 둔다. 셰이더가 flags 를 보고 바로 돌아가므로 켜고 끌 때 다시 녹화하지 않아도 된다.
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &frame.set, 0, nullptr);
+	vkCmdDispatch(commandBuffer, (ClusterCount + ClusteringGroupSize - 1) / ClusteringGroupSize, 1, 1);
+
+	VkMemoryBarrier writeBarrier = vkb::initializers::memory_barrier();
+	writeBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	writeBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		0, 1, &writeBarrier, 0, nullptr, 0, nullptr);
+}
+
+void ClusteredLighting::bind(VkCommandBuffer commandBuffer, VkPipelineLayout layout, uint32_t setIndex, uint32_t imageIndex) const
+{
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, setIndex, 1, &frames[imageIndex].set, 0, nullptr);
+}
+
+GPUClusterLight ClusteredLighting::makeLight(const glm::vec3& position, const glm::vec3& color, float intensity)
+{
+	const glm::vec3 radiance = color * intensity;
+	const float peak = std::max({ radiance.r, radiance.g, radiance.b });
+	const float radius = std::sqrt(std::max(peak, 0.f) / attenuationCutoff);
+	return { glm::vec4(position, radius), glm::vec4(radiance, 0.f) };
+}
+
+void ClusteredLighting::appendTestLights(std::vector<GPUClusterLight>& lights, uint32_t count, float time)
+{
+	// 매번 같은 시드로 뽑아 라이트 수를 바꿔도 앞쪽 라이트는 그대로다.
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const glm::vec3 base(unit(random) * 30.f - 15.f, unit(random) * 4.f - 1.f, unit(random) * 30.f - 15.f);
+		const glm::vec3 color(0.2f + 0.8f * unit(random), 0.2f + 0.8f * unit(random), 0.2f + 0.8f * unit(random));
+		const float phase = unit(random) * 6.2831853f;
+
+		glm::vec3 position = base;
+		if (animateTestLights)
+		{
+			position.y += std::sin(time + phase) * 0.5f;
+		}
+		lights.push_back(makeLight(position, color, 0.05f));
+	}
+}
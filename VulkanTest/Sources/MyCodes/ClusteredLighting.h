@@ -0,0 +1,117 @@
+#pragma once
+
+#include "vk_types.h"
+#include "Buffer.h"
+
+#include <vector>
+
+class VulkanTutorialExtension;
+
+// shaders/clustered_lighting.glsl 의 ClusterLight 와 배치가 같아야 한다. (std430)
+struct GPUClusterLight
+{
+	glm::vec4 positionRadius;	// 월드 위치, w 는 빛이 닿는 반지름
+	glm::vec4 color;			// rgb 세기를 곱한 색, w 는 PointShadowAtlas 슬롯 + 1 (0 이면 그림자 없음)
+};
+static_assert(sizeof(GPUClusterLight) == 32, "GPUClusterLight must match ClusterLight in clustered_lighting.glsl");
+
+// shaders/clustered_lighting.glsl 의 ClusterParams 와 배치가 같아야 한다. (std140)
+struct GPUClusterParams
+{
+	glm::mat4 view;
+	glm::mat4 inverseProjection;
+	glm::uvec4 gridSize;		// xyz 클러스터 수, w 라이트 수
+	glm::vec4 screen;			// 너비, 높이, near, far
+	glm::uvec4 flags;			// x 가 0 이면 클러스터를 쓰지 않고 모든 라이트를 계산한다. y 클러스터당 최대 라이트 수, z 가 1 이면 라이트 볼륨이 계산한다
+};
+
+/**
+ * 포인트 라이트를 스토리지 버퍼에 담고, 컴퓨트 패스에서 화면을 뷰 공간 froxel 격자로 나눠 클러스터마다 닿는 라이트 목록을 만든다.
+ *
+ * 깊이 방향은 near 에서 far 까지 지수로 나눈다. 클러스터 경계는 카메라만으로 정해지므로 깊이 버퍼를 기다리지 않고
+ * 지오메트리 패스보다 먼저 기록한다. 라이팅 패스(Pbr.frag)는 픽셀이 든 클러스터의 라이트만 계산하므로
+ * 프레임 시간이 전체 라이트 수가 아니라 픽셀에 닿는 라이트 수를 따라간다.
+ *
+ * 라이트와 파라미터는 호스트에서 매 프레임 채운다. 버퍼는 스왑체인 이미지마다 두므로 한번 녹화해 둔 커맨드 버퍼도
+ * 다시 녹화하지 않고 새 라이트를 쓴다. 클러스터 슬롯은 고정 크기라 넘치는 라이트는 버리고 통계에 센다.
+ */
+class ClusteredLighting
+{
+public:
+	static constexpr uint32_t GridX = 16;
+	static constexpr uint32_t GridY = 9;
+	static constexpr uint32_t GridZ = 24;
+	static constexpr uint32_t ClusterCount = GridX * GridY * GridZ;
+	static constexpr uint32_t MaxLights = 4096;
+	static constexpr uint32_t MaxLightsPerCluster = 128;
+
+	static bool enabled;
+	// 밝기가 이 값 아래로 떨어지는 거리를 라이트 반지름으로 쓴다.
+	static float attenuationCutoff;
+	// 밀도를 보려고 장면에 뿌리는 작은 라이트 수
+	static int testLightCount;
+	static bool animateTestLights;
+
+	struct Stats
+	{
+		uint32_t lights = 0;
+		uint32_t occupiedClusters = 0;		// 라이트가 하나라도 닿은 클러스터
+		uint32_t assignedLights = 0;		// 모든 클러스터 목록 길이의 합
+		uint32_t maxLightsPerCluster = 0;
+		uint32_t overflowedClusters = 0;	// MaxLightsPerCluster 를 넘어 라이트를 버린 클러스터
+	};
+
+	// 라이팅 파이프라인 레이아웃보다 먼저 있어야 하므로 initialize 와 따로 만든다. 스왑체인을 다시 만들어도 그대로 쓴다.
+	void createDescriptorSetLayout(VkDevice device);
+	VkDescriptorSetLayout getDescriptorSetLayout() const { return setLayout; }
+
+	// 스왑체인 이미지마다 버퍼와 셋을 만든다. 이미 만들었으면 이미지 수가 바뀐 경우에만 다시 만든다.
+	void initialize(VulkanTutorialExtension* engine, VkPhysicalDevice physicalDevice, uint32_t inImageCount);
+	void cleanup();
+
+	// 지난번 통계를 읽고, 파라미터와 라이트를 채운다. 넘치는 라이트는 버린다.
+	// 이미지마다 매핑해 둔 버퍼에 바로 쓰므로 preDrawFrame 처럼 그 이미지의 프레임이 끝난 뒤에만 부른다.
+	// lightVolumes 면 LightVolumes 가 라이트를 계산하므로 라이팅 패스는 포인트 라이트를 건너뛰고 클러스터도 만들지 않는다.
+	void update(uint32_t imageIndex, const glm::mat4& view, const glm::mat4& projection, VkExtent2D extent, float nearPlane, float farPlane,
+		const std::vector<GPUClusterLight>& lights, bool lightVolumes);
+	// 클러스터마다 라이트 목록을 만든다. 렌더 패스 밖에서 부르고, 라이팅 패스 프래그먼트 셰이더가 결과를 읽는다.
+	void recordClustering(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+	// 라이팅 파이프라인의 setIndex 번 셋으로 바인딩한다.
+	void bind(VkCommandBuffer commandBuffer, VkPipelineLayout layout, uint32_t setIndex, uint32_t imageIndex) const;
+
+	// 세기에 맞춰 반지름을 구한다. 1/d^2 감쇠가 attenuationCutoff 가 되는 거리다.
+	static GPUClusterLight makeLight(const glm::vec3& position, const glm::vec3& color, float intensity);
+	// 시드로 정해지는 작은 라이트를 만든다. 애니메이션을 켜면 time 에 따라 위아래로 움직인다.
+	static void appendTestLights(std::vector<GPUClusterLight>& lights, uint32_t count, float time);
+
+	const Stats& getLastStats() const { return lastStats; }
+	// update 로 이 이미지에 채운 라이트 수
+	uint32_t getLightCount(uint32_t imageIndex) const { return frames[imageIndex].lightCount; }
+	bool isInitialized() const { return pipeline != VK_NULL_HANDLE; }
+
+private:
+	struct FrameResources
+	{
+		StorageBuffer params;		// GPUClusterParams, 유니폼 버퍼
+		StorageBuffer lights;		// GPUClusterLight * MaxLights
+		StorageBuffer clusters;		// 클러스터마다 (1 + MaxLightsPerCluster) 개의 uint. 첫 값이 라이트 수
+		StorageBuffer stats;		// Stats 에서 lights 를 뺀 값, 셰이더가 atomic 으로 센다
+		VkDescriptorSet set = VK_NULL_HANDLE;
+		uint32_t lightCount = 0;
+	};
+
+	void destroyFrames();
+
+	DevicePtr device;
+	VkPhysicalDeviceMemoryProperties memoryProperties{};
+	// 셋 레이아웃은 initialize 보다 먼저 만들어지므로 장치를 따로 들고 있는다.
+	VkDevice setLayoutDevice = VK_NULL_HANDLE;
+
+	VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+	VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+	VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+	VkPipeline pipeline = VK_NULL_HANDLE;
+
+	std::vector<FrameResources> frames;
+	Stats lastStats;
+};
@@ -1,3 +1,186 @@
 #include "DeferredDeletionQueue.h"
 
-DeferredDeletionQueue* DeferredDeletionQueue::instance = nullptr;
\ No newline at end of file
+DeferredDeletionQueue* DeferredDeletionQueue::instance = nullptr;
+
+namespace
+{
+    template<typename HandleType>
+    uint64_t toHandleValue(HandleType handle)
+    {
+        return (uint64_t)handle;
+    }
+
+    template<typename HandleType>
+    HandleType fromHandleValue(uint64_t value)
+    {
+        return (HandleType)value;
+    }
+}
+
+DeferredDeletionQueue::~DeferredDeletionQueue()
+{
+    flushAll();
+}
+
+void DeferredDeletionQueue::initialize(DevicePtr inDevice, uint32_t framesInFlight)
+{
+    // 스왑체인을 다시 만들 때도 불린다. 버킷을 새로 만들면 쌓여 있던 리소스가 새고 pendingBytes 가 맞지 않게 된다.
+    if (isInitialized())
+    {
+        return;
+    }
+
+    device = inDevice;
+    bucketCount = framesInFlight;
+    buckets = std::make_unique<Bucket[]>(bucketCount);
+    currentBucket.store(0, std::memory_order_release);
+}
+
+void DeferredDeletionQueue::enqueue(Entry* entry)
+{
+    assert(buckets && "DeferredDeletionQueue::initialize() must be called before push");
+
+    pendingBytes.fetch_add(entry->bytes, std::memory_order_relaxed);
+    pendingCount.fetch_add(1, std::memory_order_relaxed);
+
+    // 다른 스레드가 동시에 넣어도 되도록 CAS 로 리스트 앞에 붙인다.
+    Bucket& bucket = buckets[currentBucket.load(std::memory_order_acquire)];
+    entry->next = bucket.head.load(std::memory_order_relaxed);
+    while (!bucket.head.compare_exchange_weak(entry->next, entry, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+}
+
+void DeferredDeletionQueue::beginFrame(uint32_t frameIndex)
+{
+    const uint32_t bucketIndex = frameIndex % bucketCount;
+
+    // 이 슬롯의 펜스가 끝났으므로, 이 슬롯이 현재 버킷이었던 동안 들어온 리소스는 더 이상 GPU 가 쓰지 않는다.
+    Entry* list = buckets[bucketIndex].head.exchange(nullptr, std::memory_order_acquire);
+    currentBucket.store(bucketIndex, std::memory_order_release);
+
+    uint64_t freedBytes = 0;
+    lastFreedCount = destroyList(list, freedBytes);
+    lastFreedBytes = freedBytes;
+}
+
+void DeferredDeletionQueue::flushAll()
+{
+    // LoadedGLTF 처럼 소멸하면서 풀 해제를 다시 넣는 리소스가 있으므로 모든 버킷이 빌 때까지 반복한다.
+    bool destroyedAny = true;
+    while (destroyedAny)
+    {
+        destroyedAny = false;
+        for (uint32_t i = 0; i < bucketCount; i++)
+        {
+            uint64_t freedBytes = 0;
+            destroyedAny |= destroyList(buckets[i].head.exchange(nullptr, std::memory_order_acquire), freedBytes) > 0;
+        }
+    }
+}
+
+uint64_t DeferredDeletionQueue::destroyList(Entry* entry, uint64_t& outBytes)
+{
+    uint64_t count = 0;
+    while (entry)
+    {
+        switch (entry->type)
+        {
+        case EntryType::Shared:
+            entry->resource.reset();
+            break;
+        case EntryType::Buffer:
+            vkDestroyBuffer(*device, fromHandleValue<VkBuffer>(entry->handle), nullptr);
+            break;
+        case EntryType::Image:
+            vkDestroyImage(*device, fromHandleValue<VkImage>(entry->handle), nullptr);
+            break;
+        case EntryType::ImageView:
+            vkDestroyImageView(*device, fromHandleValue<VkImageView>(entry->handle), nullptr);
+            break;
+        case EntryType::Memory:
+            vkFreeMemory(*device, fromHandleValue<VkDeviceMemory>(entry->handle), nullptr);
+            break;
+        case EntryType::DescriptorPool:
+            vkDestroyDescriptorPool(*device, fromHandleValue<VkDescriptorPool>(entry->handle), nullptr);
+            break;
+        case EntryType::CommandPool:
+            vkDestroyCommandPool(*device, fromHandleValue<VkCommandPool>(entry->handle), nullptr);
+            break;
+        case EntryType::Callback:
+            entry->callback();
+            break;
+        }
+
+        outBytes += entry->bytes;
+        count++;
+
+        pendingBytes.fetch_sub(entry->bytes, std::memory_order_relaxed);
+        pendingCount.fetch_sub(1, std::memory_order_relaxed);
+
+        Entry* next = entry->next;
+        delete entry;
+        entry = next;
+    }
+    return count;
+}
+
+void DeferredDeletionQueue::pushBuffer(VkBuffer buffer, VkDeviceSize bytes)
+{
+    Entry* entry = new Entry();
+    entry->type = EntryType::Buffer;
+    entry->handle = toHandleValue(buffer);
+    entry->bytes = bytes;
+    enqueue(entry);
+}
+
+void DeferredDeletionQueue::pushImage(VkImage image, VkDeviceSize bytes)
+{
+    Entry* entry = new Entry();
+    entry->type = EntryType::Image;
+    entry->handle = toHandleValue(image);
+    entry->bytes = bytes;
+    enqueue(entry);
+}
+
+void DeferredDeletionQueue::pushImageView(VkImageView imageView)
+{
+    Entry* entry = new Entry();
+    entry->type = EntryType::ImageView;
+    entry->handle = toHandleValue(imageView);
+    enqueue(entry);
+}
+
+void DeferredDeletionQueue::pushMemory(VkDeviceMemory memory, VkDeviceSize bytes)
+{
+    Entry* entry = new Entry();
+    entry->type = EntryType::Memory;
+    entry->handle = toHandleValue(memory);
+    entry->bytes = bytes;
+    enqueue(entry);
+}
+
+void DeferredDeletionQueue::pushDescriptorPool(VkDescriptorPool pool)
+{
+    Entry* entry = new Entry();
+    entry->type = EntryType::DescriptorPool;
+    entry->handle = toHandleValue(pool);
+    enqueue(entry);
+}
+
+void DeferredDeletionQueue::pushCommandPool(VkCommandPool pool)
+{
+    Entry* entry = new Entry();
+    entry->type = EntryType::CommandPool;
+    entry->handle = toHandleValue(pool);
+    enqueue(entry);
+}
+
+void DeferredDeletionQueue::pushCallback(std::function<void()> callback, VkDeviceSize bytes)
+{
+    Entry* entry = new Entry();
+    entry->type = EntryType::Callback;
+    entry->callback = std::move(callback);
+    entry->bytes = bytes;
+    enqueue(entry);
+}
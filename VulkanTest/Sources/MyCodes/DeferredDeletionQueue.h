@@ -1,29 +1,64 @@
 #pragma once
-#include <vector>
-#include <memory>
-#include <utility>
-#include <algorithm>
-
-struct ResourceBase {
-    virtual ~ResourceBase() = default;
-};
+#include "vk_types.h"
 
-template<typename T>
-struct Resource : public ResourceBase {
-    std::shared_ptr<T> ptr;
-    explicit Resource(std::shared_ptr<T> p) : ptr(std::move(p)) {}
-    ~Resource() override = default;
-};
+#include <memory>
+#include <atomic>
+#include <cassert>
+#include <functional>
 
+/**
+ * GPU 가 아직 사용중일 수 있는 리소스를 프레임 펜스가 끝날 때까지 보관했다가 지우는 큐.
+ *
+ * 프레임 슬롯(MAX_FRAMES_IN_FLIGHT)마다 버킷이 하나씩 있고, push 는 현재 프레임 슬롯의 버킷에 들어간다.
+ * 같은 슬롯의 펜스를 다시 기다린 직후(beginFrame) 그 버킷을 통째로 비운다.
+ * 버킷 하나를 비우는 비용은 그 버킷에 들어간 개수에만 비례하고, 전체 목록을 훑지 않는다.
+ *
+ * push 는 lock-free 로 여러 스레드에서 호출할 수 있다. beginFrame, flushAll 은 메인 스레드에서만 호출한다.
+ */
 class DeferredDeletionQueue {
+public:
+    enum class EntryType : uint8_t {
+        Shared,
+        Buffer,
+        Image,
+        ImageView,
+        Memory,
+        DescriptorPool,
+        CommandPool,
+        Callback,
+    };
+
 private:
-    std::vector<std::pair<std::unique_ptr<ResourceBase>, uint64_t>> resourcesToDelete;
-    uint64_t currentFrame = 0;
+    struct Entry {
+        EntryType type;
+        uint64_t handle = 0;            // Vulkan 핸들 (non-dispatchable 은 64비트)
+        VkDeviceSize bytes = 0;
+        std::shared_ptr<void> resource; // EntryType::Shared 일 때만 사용
+        std::function<void()> callback; // EntryType::Callback 일 때만 사용
+        Entry* next = nullptr;
+    };
+
+    struct Bucket {
+        std::atomic<Entry*> head{ nullptr };
+    };
+
+    DevicePtr device;
+    std::unique_ptr<Bucket[]> buckets;
+    uint32_t bucketCount = 0;
+    std::atomic<uint32_t> currentBucket{ 0 };
+
+    std::atomic<uint64_t> pendingBytes{ 0 };
+    std::atomic<uint64_t> pendingCount{ 0 };
+    uint64_t lastFreedBytes = 0;
+    uint64_t lastFreedCount = 0;
 
     static DeferredDeletionQueue* instance;
 
     DeferredDeletionQueue() = default;
 
+    void enqueue(Entry* entry);
+    uint64_t destroyList(Entry* entry, uint64_t& outBytes);
+
 public:
     static DeferredDeletionQueue& get() {
         if (instance == nullptr) {
@@ -37,17 +72,39 @@ public:
         instance = nullptr;
     }
 
+    ~DeferredDeletionQueue();
+
+    // 프레임 슬롯 수만큼 버킷을 만든다. 디바이스 생성 이후, 첫 push 이전에 호출한다.
+    // 이미 버킷이 있으면 해제 대기 중인 리소스를 잃지 않도록 아무것도 하지 않는다.
+    void initialize(DevicePtr inDevice, uint32_t framesInFlight);
+    bool isInitialized() const { return buckets != nullptr; }
+
+    // frameIndex 슬롯의 펜스를 기다린 직후에 호출한다. 그 슬롯이 마지막으로 제출됐을 때까지 쌓인 리소스를 지운다.
+    void beginFrame(uint32_t frameIndex);
+
+    // vkDeviceWaitIdle 이후 종료 시점에 남은 것을 모두 지운다. 지우는 도중에 새로 들어온 것도 함께 지운다.
+    void flushAll();
+
     template<typename T>
-    void pushResource(std::shared_ptr<T> resource) {
-        auto wrapper = std::make_unique<Resource<T>>(std::move(resource));
-        resourcesToDelete.push_back({ std::move(wrapper), currentFrame + 3 });
+    void pushResource(std::shared_ptr<T> resource, VkDeviceSize bytes = 0) {
+        Entry* entry = new Entry();
+        entry->type = EntryType::Shared;
+        entry->resource = std::move(resource);
+        entry->bytes = bytes;
+        enqueue(entry);
     }
 
-    void update() {
-        currentFrame++;
-        resourcesToDelete.erase(
-            std::remove_if(resourcesToDelete.begin(), resourcesToDelete.end(),
-                [this](const auto& pair) { return pair.second <= currentFrame; }),
-            resourcesToDelete.end());
-    }
-};
\ No newline at end of file
+    void pushBuffer(VkBuffer buffer, VkDeviceSize bytes = 0);
+    void pushImage(VkImage image, VkDeviceSize bytes = 0);
+    void pushImageView(VkImageView imageView);
+    void pushMemory(VkDeviceMemory memory, VkDeviceSize bytes);
+    void pushDescriptorPool(VkDescriptorPool pool);
+    void pushCommandPool(VkCommandPool pool);
+    // Vulkan 핸들 하나로 끝나지 않는 해제(힙 할당 반환, 풀 슬롯 제거 등)에 쓴다. 메인 스레드에서 불린다.
+    void pushCallback(std::function<void()> callback, VkDeviceSize bytes = 0);
+
+    uint64_t getPendingBytes() const { return pendingBytes.load(std::memory_order_relaxed); }
+    uint64_t getPendingCount() const { return pendingCount.load(std::memory_order_relaxed); }
+    uint64_t getLastFreedBytes() const { return lastFreedBytes; }
+    uint64_t getLastFreedCount() const { return lastFreedCount; }
+};
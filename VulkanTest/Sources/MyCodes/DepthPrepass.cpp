@@ -0,0 +1,314 @@
+#include "DepthPrepass.h"
+#include "VulkanTutorialExtension.h"
+#include "GPUMarker.h"
+#include "vk_initializers.h"
+#include "vk_resource_utils.h"
+#include "vk_log.h"
+
+#include <array>
+
+bool DepthPrepass::enabled = false;
+
+void DepthPrepass::initialize(VulkanTutorialExtension* inEngine, uint32_t frameCount, VkFormat depthFormat, VkDescriptorSetLayout globalSetLayout)
+{
+	if (isInitialized())
+	{
+		return;
+	}
+
+	engine = inEngine;
+	device = engine->getDevicePtr();
+
+	createRenderPass(depthFormat);
+	createPipelines(globalSetLayout);
+
+	// 지오메트리 패스의 프래그먼트 셰이더 실행 수만 센다.
+	if (engine->getOptionalDeviceFeatures().pipelineStatisticsQuery)
+	{
+		VkQueryPoolCreateInfo queryPoolInfo{};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+		queryPoolInfo.queryCount = frameCount;
+		queryPoolInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+		VK_CHECK_RESULT(vkCreateQueryPool(*device, &queryPoolInfo, nullptr, &queryPool));
+	}
+	pendingMeasurements.assign(frameCount, Measurement::None);
+
+	LOG(Log, "Depth prepass : pipeline statistics {}", queryPool != VK_NULL_HANDLE ? "on" : "off");
+}
+
+void DepthPrepass::createRenderPass(VkFormat depthFormat)
+{
+	// 지오메트리 패스의 깊이, 스텐실과 같이 지운다. 지오메트리 패스는 geometry.depthLoadRenderPass 로 불러온다.
+	VkAttachmentDescription depthAttachment{};
+	depthAttachment.format = depthFormat;
+	depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference depthRef{ 0, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+
+	VkSubpassDescription subpass{};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.pDepthStencilAttachment = &depthRef;
+
+	// 지난 프레임 라이팅, 포워드 패스가 깊이를 다 읽은 뒤에 지우고, 지오메트리 패스는 다 쓴 깊이로 테스트한다.
+	std::array<VkSubpassDependency, 2> dependencies{};
+	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[0].dstSubpass = 0;
+	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+	dependencies[1].srcSubpass = 0;
+	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[1].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+	VkRenderPassCreateInfo renderPassInfo = vkb::initializers::render_pass_create_info();
+	renderPassInfo.attachmentCount = 1;
+	renderPassInfo.pAttachments = &depthAttachment;
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+	renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+	renderPassInfo.pDependencies = dependencies.data();
+	VK_CHECK_RESULT(vkCreateRenderPass(*device, &renderPassInfo, nullptr, &renderPass));
+}
+
+void DepthPrepass::createPipelines(VkDescriptorSetLayout globalSetLayout)
+{
+	// 머티리얼 파이프라인과 같이 set 0 의 장면 데이터와 push constant 의 모델 행렬을 읽는다.
+	VkPushConstantRange pushConstantRange = vkb::initializers::push_constant_range(VK_SHADER_STAGE_VERTEX_BIT, sizeof(GPUDrawPushConstants), 0);
+	VkPipelineLayoutCreateInfo layoutInfo = vkb::initializers::pipeline_layout_create_info(&globalSetLayout, 1);
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &pushConstantRange;
+	VK_CHECK_RESULT(vkCreatePipelineLayout(*device, &layoutInfo, nullptr, &pipelineLayout));
+
+	// 위치 전용 스트림만 읽는다.
+	std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+	VertexOnlyPos::getBindingDescriptions(bindingDescriptions);
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+	VertexOnlyPos::getAttributeDescriptions(attributeDescriptions);
+	VkPipelineVertexInputStateCreateInfo vertexInputState = vkb::initializers::pipeline_vertex_input_state_create_info();
+	vertexInputState.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
+	vertexInputState.pVertexBindingDescriptions = bindingDescriptions.data();
+	vertexInputState.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+	vertexInputState.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+	// 컬링과 깊이 테스트는 지오메트리 패스와 같다. 스텐실은 지오메트리 패스가 남긴다.
+	VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = vkb::initializers::pipeline_input_assembly_state_create_info(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, 0, VK_FALSE);
+	VkPipelineRasterizationStateCreateInfo rasterizationState = vkb::initializers::pipeline_rasterization_state_create_info(VK_POLYGON_MODE_FILL, VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE, 0);
+	VkPipelineMultisampleStateCreateInfo multisampleState = vkb::initializers::pipeline_multisample_state_create_info(VK_SAMPLE_COUNT_1_BIT, 0);
+	VkPipelineViewportStateCreateInfo viewportState = vkb::initializers::pipeline_viewport_state_create_info(1, 1, 0);
+	std::vector<VkDynamicState> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	VkPipelineDynamicStateCreateInfo dynamicState = vkb::initializers::pipeline_dynamic_state_create_info(dynamicStates);
+	VkPipelineDepthStencilStateCreateInfo depthStencilState = vkb::initializers::pipeline_depth_stencil_state_create_info(VK_TRUE, VK_TRUE, VK_COMPARE_OP_LESS_OR_EQUAL);
+	VkPipelineColorBlendStateCreateInfo colorBlendState = vkb::initializers::pipeline_color_blend_state_create_info(0, nullptr);
+
+	// 색 출력이 없으므로 프래그먼트 셰이더도 없다.
+	VkShaderModule vertexShader = Utils::loadShader("shaders/DepthPrepassvert.spv", *device);
+	VkPipelineShaderStageCreateInfo shaderStage{};
+	shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStage.stage = VK_SHADER_STAGE_VERTEX_BIT;
+	shaderStage.module = vertexShader;
+	shaderStage.pName = "main";
+
+	VkGraphicsPipelineCreateInfo pipelineInfo = vkb::initializers::pipeline_create_info(pipelineLayout, renderPass);
+	pipelineInfo.stageCount = 1;
+	pipelineInfo.pStages = &shaderStage;
+	pipelineInfo.pVertexInputState = &vertexInputState;
+	pipelineInfo.pInputAssemblyState = &inputAssemblyState;
+	pipelineInfo.pRasterizationState = &rasterizationState;
+	pipelineInfo.pMultisampleState = &multisampleState;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pDepthStencilState = &depthStencilState;
+	pipelineInfo.pColorBlendState = &colorBlendState;
+	pipelineInfo.pDynamicState = &dynamicState;
+	VK_CHECK_RESULT(vkCreateGraphicsPipelines(*device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline));
+
+	vkDestroyShaderModule(*device, vertexShader, nullptr);
+
+	// 위치 뒤에 binding 1 의 인스턴스 행렬을 붙인다.
+	Instance::getBindingDescriptions(bindingDescriptions);
+	Instance::getAttributeDescriptions(attributeDescriptions, static_cast<uint32_t>(attributeDescriptions.size()));
+	vertexInputState.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
+	vertexInputState.pVertexBindingDescriptions = bindingDescriptions.data();
+	vertexInputState.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+	vertexInputState.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+	vertexShader = Utils::loadShader("shaders/DepthPrepassInstancedvert.spv", *device);
+	shaderStage.module = vertexShader;
+	VK_CHECK_RESULT(vkCreateGraphicsPipelines(*device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &instancedPipeline));
+
+	vkDestroyShaderModule(*device, vertexShader, nullptr);
+}
+
+void DepthPrepass::createFramebuffer(VkExtent2D extent, VkImageView depthView)
+{
+	if (framebuffer != VK_NULL_HANDLE)
+	{
+		vkDestroyFramebuffer(*device, framebuffer, nullptr);
+	}
+
+	VkFramebufferCreateInfo framebufferInfo = vkb::initializers::framebuffer_create_info();
+	framebufferInfo.renderPass = renderPass;
+	framebufferInfo.attachmentCount = 1;
+	framebufferInfo.pAttachments = &depthView;
+	framebufferInfo.width = extent.width;
+	framebufferInfo.height = extent.height;
+	framebufferInfo.layers = 1;
+	VK_CHECK_RESULT(vkCreateFramebuffer(*device, &framebufferInfo, nullptr, &framebuffer));
+}
+
+void DepthPrepass::cleanup()
+{
+	if (!isInitialized())
+	{
+		return;
+	}
+
+	if (queryPool != VK_NULL_HANDLE)
+	{
+		vkDestroyQueryPool(*device, queryPool, nullptr);
+		queryPool = VK_NULL_HANDLE;
+	}
+	vkDestroyFramebuffer(*device, framebuffer, nullptr);
+	vkDestroyPipeline(*device, pipeline, nullptr);
+	vkDestroyPipeline(*device, instancedPipeline, nullptr);
+	vkDestroyPipelineLayout(*device, pipelineLayout, nullptr);
+	vkDestroyRenderPass(*device, renderPass, nullptr);
+	framebuffer = VK_NULL_HANDLE;
+	pipeline = VK_NULL_HANDLE;
+	instancedPipeline = VK_NULL_HANDLE;
+	pipelineLayout = VK_NULL_HANDLE;
+	renderPass = VK_NULL_HANDLE;
+	pendingMeasurements.clear();
+}
+
+void DepthPrepass::record(VkCommandBuffer commandBuffer, const FrameVector<RenderObject>& draws, VkBuffer instanceBuffer, VkDescriptorSet globalSet, VkExtent2D renderExtent)
+{
+	GPUMarker Marker(commandBuffer, "Depth Prepass");
+
+	VkClearValue clearValue{};
+	clearValue.depthStencil = { 1.f, 0 };
+	VkRenderPassBeginInfo renderPassInfo = vkb::initializers::render_pass_begin_info();
+	renderPassInfo.renderPass = renderPass;
+	renderPassInfo.framebuffer = framebuffer;
+	renderPassInfo.renderArea.offset = { 0, 0 };
+	renderPassInfo.renderArea.extent = renderExtent;
+	renderPassInfo.clearValueCount = 1;
+	renderPassInfo.pClearValues = &clearValue;
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+	VkViewport viewport = vkb::initializers::viewport(static_cast<float>(renderExtent.width), static_cast<float>(renderExtent.height), 0.f, 1.f);
+	VkRect2D scissor = vkb::initializers::rect2D(renderExtent.width, renderExtent.height, 0, 0);
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+	// 두 파이프라인이 레이아웃을 같이 쓰므로 셋은 한번만 바인딩한다.
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &globalSet, 0, nullptr);
+
+	// 드로우는 머티리얼 순으로 정렬되어 있어 같은 메시가 이어지기 쉽다. 바뀔 때만 다시 바인딩한다.
+	VkPipeline boundPipeline = VK_NULL_HANDLE;
+	VkBuffer boundPositions = VK_NULL_HANDLE;
+	VkBuffer boundIndices = VK_NULL_HANDLE;
+	bool instanceBufferBound = false;
+
+	stats.draws = 0;
+	stats.skipped = 0;
+	for (const RenderObject& draw : draws)
+	{
+		const bool instanced = draw.instanceCount > 1;
+		if (draw.positionBuffer == VK_NULL_HANDLE || (instanced && instanceBuffer == VK_NULL_HANDLE))
+		{
+			stats.skipped++;
+			continue;
+		}
+
+		const VkPipeline drawPipeline = instanced ? instancedPipeline : pipeline;
+		if (drawPipeline != boundPipeline)
+		{
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, drawPipeline);
+			boundPipeline = drawPipeline;
+		}
+		if (draw.positionBuffer != boundPositions)
+		{
+			VkDeviceSize offset = 0;
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, &draw.positionBuffer, &offset);
+			boundPositions = draw.positionBuffer;
+		}
+		if (draw.indexBuffer != boundIndices)
+		{
+			vkCmdBindIndexBuffer(commandBuffer, draw.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+			boundIndices = draw.indexBuffer;
+		}
+
+		if (instanced)
+		{
+			if (!instanceBufferBound)
+			{
+				VkDeviceSize offset = 0;
+				vkCmdBindVertexBuffers(commandBuffer, 1, 1, &instanceBuffer, &offset);
+				instanceBufferBound = true;
+			}
+			vkCmdDrawIndexed(commandBuffer, draw.indexCount, draw.instanceCount, draw.firstIndex, 0, draw.firstInstance);
+		}
+		else
+		{
+			GPUDrawPushConstants pushConstants;
+			pushConstants.model = draw.transform;
+			vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(GPUDrawPushConstants), &pushConstants);
+			vkCmdDrawIndexed(commandBuffer, draw.indexCount, 1, draw.firstIndex, 0, 0);
+		}
+		stats.draws++;
+	}
+
+	vkCmdEndRenderPass(commandBuffer);
+}
+
+void DepthPrepass::readStatistics(uint32_t frameIndex)
+{
+	const Measurement measurement = pendingMeasurements[frameIndex];
+	pendingMeasurements[frameIndex] = Measurement::None;
+	if (queryPool == VK_NULL_HANDLE || measurement == Measurement::None)
+	{
+		return;
+	}
+
+	// 이 슬롯의 펜스를 기다렸으므로 결과가 있다. 없으면 이번 측정은 버린다.
+	uint64_t invocations = 0;
+	if (vkGetQueryPoolResults(*device, queryPool, frameIndex, 1, sizeof(invocations), &invocations, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+	{
+		return;
+	}
+	(measurement == Measurement::WithPrepass ? stats.invocationsWithPrepass : stats.invocationsWithoutPrepass) = invocations;
+}
+
+void DepthPrepass::beginStatistics(VkCommandBuffer commandBuffer, uint32_t frameIndex, bool withPrepass)
+{
+	if (queryPool == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	vkCmdResetQueryPool(commandBuffer, queryPool, frameIndex, 1);
+	vkCmdBeginQuery(commandBuffer, queryPool, frameIndex, 0);
+	pendingMeasurements[frameIndex] = withPrepass ? Measurement::WithPrepass : Measurement::WithoutPrepass;
+}
+
+void DepthPrepass::endStatistics(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+	if (queryPool == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	vkCmdEndQuery(commandBuffer, queryPool, frameIndex);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "vk_types.h"
+#include "FrameAllocator.h"
+
+#include <vector>
+
+class VulkanTutorialExtension;
+struct RenderObject;
+
+/**
+ * 지오메트리 패스보다 먼저 불투명 드로우의 깊이만 그리는 깊이 프리패스.
+ *
+ * 위치 전용 스트림과 프래그먼트 셰이더 없는 파이프라인으로 깊이를 채우고, 스텐실은 지우기만 한다. 지오메트리 패스는 그 깊이를
+ * 불러와 EQUAL 로 테스트하고 깊이를 쓰지 않는 머티리얼 변형(MaterialPipeline::depthEqual)으로 그리므로, G-buffer 셰이더는
+ * 픽셀마다 맨 앞 면에서만 돈다. 라이팅 패스가 읽는 스텐실은 그 변형들이 쓴다. 두 패스의 깊이가 같도록 버텍스 셰이더는 같은 식과 invariant gl_Position 을 쓴다.
+ * 위치 전용 스트림이 없는 드로우는 프리패스에서 빠지고, 지오메트리 패스에서 원래 파이프라인으로 그린다.
+ *
+ * 장치가 pipelineStatisticsQuery 를 지원하면 프레임 슬롯마다 지오메트리 패스의 프래그먼트 셰이더 실행 수를 재고,
+ * 프리패스를 켜고 잰 마지막 값과 끄고 잰 마지막 값을 남긴다. 쿼리는 프레임 슬롯마다 두므로 매 프레임 녹화할 때만 잰다.
+ * secondary 커맨드 버퍼로 그릴 때는 쿼리를 물려줘야 하므로 inheritedQueries 도 있어야 잰다.
+ */
+class DepthPrepass
+{
+public:
+	static bool enabled;
+
+	struct Stats
+	{
+		uint32_t draws = 0;			// 마지막 프리패스가 그린 드로우
+		uint32_t skipped = 0;		// 위치 전용 스트림이 없어 빠진 드로우
+		// 지오메트리 패스의 프래그먼트 셰이더 실행 수. 0 이면 아직 재지 않았다.
+		uint64_t invocationsWithPrepass = 0;
+		uint64_t invocationsWithoutPrepass = 0;
+	};
+
+	// 렌더 패스, 파이프라인, 쿼리 풀을 한번 만든다. 깊이 프레임버퍼는 createFramebuffer 가 만든다.
+	void initialize(VulkanTutorialExtension* inEngine, uint32_t frameCount, VkFormat depthFormat, VkDescriptorSetLayout globalSetLayout);
+	void cleanup();
+
+	// 깊이 버퍼에 붙인 프레임버퍼를 다시 만든다. 스왑체인을 다시 만들 때마다 불러야 한다.
+	void createFramebuffer(VkExtent2D extent, VkImageView depthView);
+
+	// 깊이와 스텐실을 지우고 draws 의 깊이를 그린다. 끝나면 깊이는 DEPTH_STENCIL_ATTACHMENT_OPTIMAL 이다.
+	// 인스턴싱 드로우는 instanceBuffer 의 모델 행렬을 binding 1 로 읽는다.
+	void record(VkCommandBuffer commandBuffer, const FrameVector<RenderObject>& draws, VkBuffer instanceBuffer, VkDescriptorSet globalSet, VkExtent2D renderExtent);
+
+	// 이 프레임 슬롯의 펜스를 기다린 뒤에 부른다. 지난번 잰 프래그먼트 셰이더 실행 수를 읽는다.
+	void readStatistics(uint32_t frameIndex);
+	// 지오메트리 패스를 렌더 패스 밖에서 감싼다. withPrepass 는 이번 지오메트리 패스가 프리패스 깊이를 쓰는지다.
+	void beginStatistics(VkCommandBuffer commandBuffer, uint32_t frameIndex, bool withPrepass);
+	void endStatistics(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+
+	bool isStatisticsSupported() const { return queryPool != VK_NULL_HANDLE; }
+	const Stats& getStats() const { return stats; }
+	bool isInitialized() const { return pipeline != VK_NULL_HANDLE; }
+
+private:
+	enum class Measurement : uint8_t
+	{
+		None,
+		WithoutPrepass,
+		WithPrepass,
+	};
+
+	void createRenderPass(VkFormat depthFormat);
+	void createPipelines(VkDescriptorSetLayout globalSetLayout);
+
+	VulkanTutorialExtension* engine = nullptr;
+	DevicePtr device;
+
+	VkRenderPass renderPass = VK_NULL_HANDLE;
+	VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	// binding 1 의 Instance 행렬을 읽는 변형
+	VkPipeline instancedPipeline = VK_NULL_HANDLE;
+	VkFramebuffer framebuffer = VK_NULL_HANDLE;
+
+	// 프레임 슬롯마다 FRAGMENT_SHADER_INVOCATIONS 쿼리 하나
+	VkQueryPool queryPool = VK_NULL_HANDLE;
+	// 프레임 슬롯마다 결과를 기다리는 측정
+	std::vector<Measurement> pendingMeasurements;
+
+	Stats stats;
+};
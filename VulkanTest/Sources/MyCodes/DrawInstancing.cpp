@@ -0,0 +1,113 @@
+#include "DrawInstancing.h"
+#include "GPUResourcePools.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace
+{
+	struct MergeEntry
+	{
+		uint64_t key;
+		uint32_t index;
+	};
+
+	uint64_t hashCombine(uint64_t seed, uint64_t value)
+	{
+		return seed ^ (std::hash<uint64_t>()(value) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+	}
+
+	uint64_t makeMergeKey(const RenderObject& draw)
+	{
+		uint64_t key = hashCombine(0, (uint64_t)draw.vertexBuffer);
+		key = hashCombine(key, (uint64_t)draw.indexBuffer);
+		key = hashCombine(key, (static_cast<uint64_t>(draw.firstIndex) << 32) | draw.indexCount);
+		key = hashCombine(key, (static_cast<uint64_t>(draw.material.generation) << 32) | draw.material.index);
+		return key;
+	}
+
+	// 해시가 같아도 실제로 같은 서피스인지 다시 비교한다.
+	bool canMerge(const RenderObject& a, const RenderObject& b)
+	{
+		return a.vertexBuffer == b.vertexBuffer
+			&& a.indexBuffer == b.indexBuffer
+			&& a.firstIndex == b.firstIndex
+			&& a.indexCount == b.indexCount
+			&& a.material == b.material;
+	}
+}
+
+namespace DrawInstancing
+{
+	Stats mergeInstances(FrameVector<RenderObject>& draws, FrameVector<Instance>& outInstances)
+	{
+		Stats stats;
+		stats.sourceDraws = static_cast<uint32_t>(draws.size());
+		stats.mergedDraws = stats.sourceDraws;
+		if (draws.size() < 2)
+		{
+			return stats;
+		}
+
+		GPUResourcePools& pools = GPUResourcePools::get();
+
+		// 합칠 수 없는 드로우는 그대로 두고, 나머지만 키로 정렬해 같은 서피스를 붙인다.
+		FrameVector<RenderObject> merged(draws.get_allocator());
+		merged.reserve(draws.size());
+
+		FrameVector<MergeEntry> entries(draws.get_allocator());
+		entries.reserve(draws.size());
+		for (uint32_t i = 0; i < draws.size(); i++)
+		{
+			const MaterialInstance* material = pools.materials.get(draws[i].material);
+			if (!material || !material->pipeline->instanced)
+			{
+				merged.push_back(draws[i]);
+				continue;
+			}
+			entries.push_back({ makeMergeKey(draws[i]), i });
+		}
+
+		// 인덱스까지 비교해 결과가 매 프레임 같게 한다.
+		std::sort(entries.begin(), entries.end(), [](const MergeEntry& a, const MergeEntry& b)
+		{
+			return a.key != b.key ? a.key < b.key : a.index < b.index;
+		});
+
+		for (size_t first = 0; first < entries.size();)
+		{
+			const RenderObject& head = draws[entries[first].index];
+
+			size_t end = first + 1;
+			while (end < entries.size() && entries[end].key == entries[first].key && canMerge(head, draws[entries[end].index]))
+			{
+				end++;
+			}
+
+			if (end - first == 1)
+			{
+				merged.push_back(head);
+			}
+			else
+			{
+				RenderObject instanced = head;
+				instanced.firstInstance = static_cast<uint32_t>(outInstances.size());
+				instanced.instanceCount = static_cast<uint32_t>(end - first);
+				for (size_t e = first; e < end; e++)
+				{
+					outInstances.push_back({ draws[entries[e].index].transform });
+				}
+				merged.push_back(instanced);
+
+				stats.instancedDraws++;
+				stats.instances += instanced.instanceCount;
+			}
+
+			first = end;
+		}
+
+		stats.mergedDraws = static_cast<uint32_t>(merged.size());
+		draws = std::move(merged);
+		return stats;
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "vk_engine.h"
+
+/**
+ * 메시/서피스/머티리얼이 모두 같은 드로우를 인스턴스 드로우 하나로 합친다.
+ *
+ * 같은 LoadedGLTF 를 sceneInstances 에 여러 번 넣으면 서피스마다 인스턴스 수만큼 RenderObject 가 생기는데,
+ * 이를 하나로 묶고 모델 행렬은 binding 1 의 Instance 버퍼로 넘긴다.
+ * 파이프라인에 instanced 변형이 있는 머티리얼만 합친다. 반투명은 뒤에서 앞으로 그려야 하므로 넘기지 않는다.
+ *
+ * 정렬보다 먼저 불러야 한다. 인스턴스 배치가 카메라와 무관하게 드로우 목록 순서로만 정해지므로,
+ * 한번 녹화해 두는 커맨드 버퍼도 장면이 바뀌기 전까지 같은 배치를 가리킨다.
+ */
+namespace DrawInstancing
+{
+	struct Stats
+	{
+		uint32_t sourceDraws = 0;
+		uint32_t mergedDraws = 0;	// 합친 뒤의 드로우 수 (인스턴스 드로우 포함)
+		uint32_t instancedDraws = 0;
+		uint32_t instances = 0;		// 인스턴스 드로우에 들어간 행렬 수
+	};
+
+	// 합친 드로우의 행렬을 outInstances 뒤에 붙인다.
+	Stats mergeInstances(FrameVector<RenderObject>& draws, FrameVector<Instance>& outInstances);
+}
@@ -0,0 +1,127 @@
+#include "DrawSorting.h"
+#include "GPUResourcePools.h"
+
+#include <array>
+#include <cstring>
+
+namespace
+{
+	struct SortEntry
+	{
+		uint64_t key;
+		uint32_t index;
+	};
+
+	// 64비트 핸들(포인터)을 bits 비트로 접는다. 하위 비트는 정렬 때문에 비어 있는 경우가 많아 상위 비트와 섞는다.
+	uint64_t foldHandle(uint64_t value, uint32_t bits)
+	{
+		value ^= value >> 32;
+		value ^= value >> 16;
+		value ^= value >> 8;
+		return value & ((1ull << bits) - 1);
+	}
+
+	// 양수 float 은 비트 순서와 크기 순서가 같다.
+	uint32_t depthToBits(float depth)
+	{
+		depth = depth > 0.f ? depth : 0.f;
+		uint32_t bits;
+		std::memcpy(&bits, &depth, sizeof(bits));
+		return bits;
+	}
+
+	void radixSort(FrameVector<SortEntry>& entries)
+	{
+		FrameVector<SortEntry> scratch(entries.size(), SortEntry{}, entries.get_allocator());
+
+		for (uint32_t shift = 0; shift < 64; shift += 8)
+		{
+			std::array<uint32_t, 256> counts{};
+			for (const SortEntry& entry : entries)
+			{
+				counts[(entry.key >> shift) & 0xFF]++;
+			}
+
+			// 이 바이트가 모두 같으면 순서가 바뀌지 않으므로 건너뛴다. (키의 빈 비트 구간)
+			if (counts[(entries[0].key >> shift) & 0xFF] == entries.size())
+			{
+				continue;
+			}
+
+			uint32_t offset = 0;
+			for (uint32_t& count : counts)
+			{
+				const uint32_t bucketSize = count;
+				count = offset;
+				offset += bucketSize;
+			}
+
+			for (const SortEntry& entry : entries)
+			{
+				scratch[counts[(entry.key >> shift) & 0xFF]++] = entry;
+			}
+			entries.swap(scratch);
+		}
+	}
+}
+
+namespace DrawSorting
+{
+	uint64_t makeSortKey(Pass pass, const RenderObject& draw, const MaterialInstance& material, float viewDepth)
+	{
+		const uint64_t passBits = static_cast<uint64_t>(pass) << 62;
+		const uint64_t pipelineBits = foldHandle((uint64_t)material.pipeline->pipeline, 12);
+		const uint64_t materialBits = draw.material.index & 0xFFFF;
+		const uint32_t depthBits = depthToBits(viewDepth);
+
+		if (pass == Pass::Opaque)
+		{
+			const uint64_t meshBits = foldHandle((uint64_t)draw.vertexBuffer, 12);
+			return passBits | (pipelineBits << 50) | (materialBits << 34) | (meshBits << 22) | ((depthBits >> 9) & 0x3FFFFF);
+		}
+
+		// 멀수록 작은 키가 되도록 뒤집는다.
+		const uint64_t invertedDepth = (~depthBits >> 1) & 0x3FFFFFFF;
+		return passBits | (invertedDepth << 32) | (pipelineBits << 20) | (materialBits << 4);
+	}
+
+	void sortDrawList(FrameVector<RenderObject>& draws, Pass pass, const glm::vec3& viewPos, const glm::vec3& viewDir)
+	{
+		if (draws.size() < 2)
+		{
+			return;
+		}
+
+		GPUResourcePools& pools = GPUResourcePools::get();
+
+		FrameVector<SortEntry> entries(draws.get_allocator());
+		entries.reserve(draws.size());
+		for (uint32_t i = 0; i < draws.size(); i++)
+		{
+			RenderObject& draw = draws[i];
+			const MaterialInstance* material = pools.materials.get(draw.material);
+
+			// 머티리얼이 없어진 드로우는 녹화할 때 건너뛰므로 맨 뒤로 보낸다.
+			if (!material)
+			{
+				draw.sortKey = UINT64_MAX;
+			}
+			else
+			{
+				const float viewDepth = glm::dot(glm::vec3(draw.transform[3]) - viewPos, viewDir);
+				draw.sortKey = makeSortKey(pass, draw, *material, viewDepth);
+			}
+			entries.push_back({ draw.sortKey, i });
+		}
+
+		radixSort(entries);
+
+		FrameVector<RenderObject> sorted(draws.get_allocator());
+		sorted.reserve(draws.size());
+		for (const SortEntry& entry : entries)
+		{
+			sorted.push_back(draws[entry.index]);
+		}
+		draws = std::move(sorted);
+	}
+}
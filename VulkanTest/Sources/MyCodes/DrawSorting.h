@@ -0,0 +1,28 @@
+#pragma once
+
+#include "vk_engine.h"
+
+/**
+ * RenderObject 의 64비트 정렬 키를 만들고 그 순서로 드로우 목록을 정렬한다.
+ *
+ * 불투명 : pass(2) | pipeline(12) | material(16) | mesh(12) | 앞에서 뒤로 깊이(22)
+ *   상태 변경이 비싼 것부터 묶어서 연속된 드로우가 같은 파이프라인/머티리얼/버퍼를 쓰게 한다.
+ * 반투명 : pass(2) | 뒤에서 앞으로 깊이(30) | pipeline(12) | material(16)
+ *   블렌딩 결과가 맞도록 깊이가 먼저다. WeightedBlendedOIT 로 합성할 때는 순서가 상관없으므로 불투명 키로 정렬한다.
+ *
+ * pipeline 과 mesh 는 핸들을 접어서 만든 값이라 겹칠 수 있다. 겹쳐도 묶음이 조금 덜 될 뿐이고,
+ * 바인딩을 건너뛸지는 녹화할 때 실제 핸들로 비교하므로 결과는 틀리지 않는다.
+ */
+namespace DrawSorting
+{
+	enum class Pass : uint8_t
+	{
+		Opaque = 0,
+		Translucent = 1
+	};
+
+	uint64_t makeSortKey(Pass pass, const RenderObject& draw, const MaterialInstance& material, float viewDepth);
+
+	// sortKey 를 채우고 8비트씩 LSD radix sort 한다. 임시 버퍼는 프레임 arena 에서 받는다.
+	void sortDrawList(FrameVector<RenderObject>& draws, Pass pass, const glm::vec3& viewPos, const glm::vec3& viewDir);
+}
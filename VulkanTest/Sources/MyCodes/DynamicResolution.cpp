@@ -0,0 +1,392 @@
+#include "DynamicResolution.h"
+#include "VulkanTutorialExtension.h"
+#include "GPUMarker.h"
+#include "vk_descriptor.h"
+#include "vk_initializers.h"
+#include "vk_resource_utils.h"
+#include "vk_log.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+bool DynamicResolution::enabled = false;
+bool DynamicResolution::adaptive = true;
+float DynamicResolution::targetMilliseconds = 14.f;
+float DynamicResolution::minScale = 0.5f;
+float DynamicResolution::maxScale = 1.f;
+float DynamicResolution::fixedScale = 0.75f;
+float DynamicResolution::sharpness = 0.25f;
+
+namespace
+{
+	// shaders/Upscale.frag 의 UpscaleParams 와 같다.
+	struct UpscalePushConstants
+	{
+		glm::vec4 region;		// xy 내부 해상도, zw sceneColor 크기의 역수
+		glm::vec4 settings;		// x 샤프닝 세기
+	};
+}
+
+void DynamicResolution::initialize(VulkanTutorialExtension* inEngine, VkPhysicalDevice physicalDevice, uint32_t frameCount)
+{
+	// 스왑체인을 다시 만들 때도 불린다. 화면 크기와 상관없는 것만 여기서 만든다.
+	if (isInitialized())
+	{
+		return;
+	}
+
+	engine = inEngine;
+	device = engine->getDevicePtr();
+
+	std::vector<VkDescriptorSetLayoutBinding> bindings;
+	vk::desc::createDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, bindings);
+	setLayout = vk::desc::createDescriptorSetLayout(*device, bindings);
+
+	std::vector<VkDescriptorPoolSize> sizes = { vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1) };
+	VkDescriptorPoolCreateInfo poolInfo = vkb::initializers::descriptor_pool_create_info(sizes, 1);
+	VK_CHECK_RESULT(vkCreateDescriptorPool(*device, &poolInfo, nullptr, &descriptorPool));
+	VkDescriptorSetAllocateInfo allocInfo = vkb::initializers::descriptor_set_allocate_info(descriptorPool, &setLayout, 1);
+	VK_CHECK_RESULT(vkAllocateDescriptorSets(*device, &allocInfo, &set));
+
+	VkPushConstantRange pushConstantRange = vkb::initializers::push_constant_range(VK_SHADER_STAGE_FRAGMENT_BIT, sizeof(UpscalePushConstants), 0);
+	VkPipelineLayoutCreateInfo layoutInfo = vkb::initializers::pipeline_layout_create_info(&setLayout, 1);
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &pushConstantRange;
+	VK_CHECK_RESULT(vkCreatePipelineLayout(*device, &layoutInfo, nullptr, &pipelineLayout));
+
+	// 업스케일 필터가 바이리니어 샘플로 가중치를 나눠 가지므로 선형 필터여야 한다. 가장자리 밖은 탭 좌표를 직접 자른다.
+	VkSamplerCreateInfo samplerInfo = vkb::initializers::sampler_create_info();
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.maxLod = 1.f;
+	samplerInfo.maxAnisotropy = 1.f;
+	VK_CHECK_RESULT(vkCreateSampler(*device, &samplerInfo, nullptr, &sampler));
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	timestampPeriod = properties.limits.timestampPeriod;
+	if (properties.limits.timestampComputeAndGraphics == VK_TRUE)
+	{
+		VkQueryPoolCreateInfo queryPoolInfo{};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = frameCount * 2;
+		VK_CHECK_RESULT(vkCreateQueryPool(*device, &queryPoolInfo, nullptr, &queryPool));
+	}
+	timedScales.assign(frameCount, 0.f);
+
+	LOG(Log, "Dynamic resolution : timestamps {}", queryPool != VK_NULL_HANDLE ? "on" : "off (fixed scale only)");
+}
+
+void DynamicResolution::createTargets(VkExtent2D extent, VkFormat format, const std::vector<VkImageView>& swapchainViews)
+{
+	destroyTargets();
+	targetExtent = extent;
+
+	// 라이팅, 포워드 패스의 렌더 패스가 스왑체인 포맷으로 만들어지므로 같은 포맷으로 둔다.
+	sceneColor = engine->createImage(extent.width, extent.height, 1, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, "SceneColor");
+	sceneColor->imageView = engine->createImageView(sceneColor->image, format, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+
+	VkDescriptorImageInfo sceneColorInfo = vkb::initializers::descriptor_image_info(sampler, sceneColor->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	VkWriteDescriptorSet write = vkb::initializers::write_descriptor_set(set, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 0, &sceneColorInfo);
+	vkUpdateDescriptorSets(*device, 1, &write, 0, nullptr);
+
+	createRenderPass(format);
+	createPipeline();
+
+	framebuffers.resize(swapchainViews.size());
+	for (size_t i = 0; i < swapchainViews.size(); i++)
+	{
+		VkFramebufferCreateInfo framebufferInfo = vkb::initializers::framebuffer_create_info();
+		framebufferInfo.renderPass = renderPass;
+		framebufferInfo.attachmentCount = 1;
+		framebufferInfo.pAttachments = &swapchainViews[i];
+		framebufferInfo.width = extent.width;
+		framebufferInfo.height = extent.height;
+		framebufferInfo.layers = 1;
+		VK_CHECK_RESULT(vkCreateFramebuffer(*device, &framebufferInfo, nullptr, &framebuffers[i]));
+	}
+
+	// 크기가 바뀌었으면 지난 평균은 맞지 않는다.
+	resetHistory();
+
+	LOG(Log, "Dynamic resolution : {}x{} scene color, scale {} ~ {}", extent.width, extent.height, minScale, maxScale);
+}
+
+void DynamicResolution::createRenderPass(VkFormat format)
+{
+	// 화면 전체를 덮어쓰므로 이전 내용은 버린다. ImGui 패스가 이어서 그리므로 COLOR_ATTACHMENT_OPTIMAL 로 둔다.
+	VkAttachmentDescription colorAttachment{};
+	colorAttachment.format = format;
+	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference colorRef{ 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+
+	VkSubpassDescription subpass{};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &colorRef;
+
+	// 스왑체인 이미지를 얻는 세마포어가 COLOR_ATTACHMENT_OUTPUT 에서 기다리므로 레이아웃 전환도 그 뒤에 한다.
+	VkSubpassDependency dependency{};
+	dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependency.dstSubpass = 0;
+	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependency.srcAccessMask = 0;
+	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+	VkRenderPassCreateInfo renderPassInfo = vkb::initializers::render_pass_create_info();
+	renderPassInfo.attachmentCount = 1;
+	renderPassInfo.pAttachments = &colorAttachment;
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+	renderPassInfo.dependencyCount = 1;
+	renderPassInfo.pDependencies = &dependency;
+	VK_CHECK_RESULT(vkCreateRenderPass(*device, &renderPassInfo, nullptr, &renderPass));
+}
+
+void DynamicResolution::createPipeline()
+{
+	// 화면을 덮는 삼각형 하나. 라이팅 패스의 버텍스 셰이더를 그대로 쓴다.
+	VkPipelineVertexInputStateCreateInfo vertexInputState = vkb::initializers::pipeline_vertex_input_state_create_info();
+	VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = vkb::initializers::pipeline_input_assembly_state_create_info(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, 0, VK_FALSE);
+	VkPipelineRasterizationStateCreateInfo rasterizationState = vkb::initializers::pipeline_rasterization_state_create_info(VK_POLYGON_MODE_FILL, VK_CULL_MODE_NONE, VK_FRONT_FACE_COUNTER_CLOCKWISE, 0);
+	VkPipelineMultisampleStateCreateInfo multisampleState = vkb::initializers::pipeline_multisample_state_create_info(VK_SAMPLE_COUNT_1_BIT, 0);
+	VkPipelineViewportStateCreateInfo viewportState = vkb::initializers::pipeline_viewport_state_create_info(1, 1, 0);
+	std::vector<VkDynamicState> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	VkPipelineDynamicStateCreateInfo dynamicState = vkb::initializers::pipeline_dynamic_state_create_info(dynamicStates);
+	VkPipelineDepthStencilStateCreateInfo depthStencilState = vkb::initializers::pipeline_depth_stencil_state_create_info(VK_FALSE, VK_FALSE, VK_COMPARE_OP_ALWAYS);
+	VkPipelineColorBlendAttachmentState blendAttachmentState = vkb::initializers::pipeline_color_blend_attachment_state(0xf, VK_FALSE);
+	VkPipelineColorBlendStateCreateInfo colorBlendState = vkb::initializers::pipeline_color_blend_state_create_info(1, &blendAttachmentState);
+
+	VkShaderModule vertexShader = Utils::loadShader("shaders/LightingPassvert.spv", *device);
+	VkShaderModule fragmentShader = Utils::loadShader("shaders/Upscalefrag.spv", *device);
+	std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages{};
+	shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	shaderStages[0].module = vertexShader;
+	shaderStages[0].pName = "main";
+	shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	shaderStages[1].module = fragmentShader;
+	shaderStages[1].pName = "main";
+
+	VkGraphicsPipelineCreateInfo pipelineInfo = vkb::initializers::pipeline_create_info(pipelineLayout, renderPass);
+	pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+	pipelineInfo.pStages = shaderStages.data();
+	pipelineInfo.pVertexInputState = &vertexInputState;
+	pipelineInfo.pInputAssemblyState = &inputAssemblyState;
+	pipelineInfo.pRasterizationState = &rasterizationState;
+	pipelineInfo.pMultisampleState = &multisampleState;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pDepthStencilState = &depthStencilState;
+	pipelineInfo.pColorBlendState = &colorBlendState;
+	pipelineInfo.pDynamicState = &dynamicState;
+	VK_CHECK_RESULT(vkCreateGraphicsPipelines(*device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline));
+
+	vkDestroyShaderModule(*device, vertexShader, nullptr);
+	vkDestroyShaderModule(*device, fragmentShader, nullptr);
+}
+
+void DynamicResolution::destroyTargets()
+{
+	if (!hasTargets())
+	{
+		return;
+	}
+
+	for (VkFramebuffer framebuffer : framebuffers)
+	{
+		vkDestroyFramebuffer(*device, framebuffer, nullptr);
+	}
+	framebuffers.clear();
+	vkDestroyPipeline(*device, pipeline, nullptr);
+	vkDestroyRenderPass(*device, renderPass, nullptr);
+	pipeline = VK_NULL_HANDLE;
+	renderPass = VK_NULL_HANDLE;
+	sceneColor.reset();
+}
+
+void DynamicResolution::cleanup()
+{
+	if (!isInitialized())
+	{
+		return;
+	}
+
+	destroyTargets();
+	if (queryPool != VK_NULL_HANDLE)
+	{
+		vkDestroyQueryPool(*device, queryPool, nullptr);
+		queryPool = VK_NULL_HANDLE;
+	}
+	vkDestroySampler(*device, sampler, nullptr);
+	vkDestroyPipelineLayout(*device, pipelineLayout, nullptr);
+	vkDestroyDescriptorPool(*device, descriptorPool, nullptr);
+	vkDestroyDescriptorSetLayout(*device, setLayout, nullptr);
+	sampler = VK_NULL_HANDLE;
+	pipelineLayout = VK_NULL_HANDLE;
+	descriptorPool = VK_NULL_HANDLE;
+	setLayout = VK_NULL_HANDLE;
+	set = VK_NULL_HANDLE;
+}
+
+void DynamicResolution::resetHistory()
+{
+	samples = 0;
+	stats.smoothedMilliseconds = 0.f;
+	std::fill(timedScales.begin(), timedScales.end(), 0.f);
+}
+
+void DynamicResolution::readTimestamps(uint32_t frameIndex)
+{
+	const float timedScale = timedScales[frameIndex];
+	timedScales[frameIndex] = 0.f;
+	if (queryPool == VK_NULL_HANDLE || timedScale == 0.f)
+	{
+		return;
+	}
+
+	// 이 슬롯의 펜스를 기다렸으므로 결과가 있다. 없으면 이번 측정은 버린다.
+	uint64_t ticks[2] = {};
+	if (vkGetQueryPoolResults(*device, queryPool, frameIndex * 2, 2, sizeof(ticks), ticks, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+	{
+		return;
+	}
+	stats.gpuMilliseconds = static_cast<float>(static_cast<double>(ticks[1] - ticks[0]) * timestampPeriod / 1000000.0);
+
+	// 배율을 바꾸기 전에 녹화한 프레임은 평균에 넣지 않는다.
+	if (timedScale != stats.scale)
+	{
+		return;
+	}
+	stats.smoothedMilliseconds = samples == 0 ? stats.gpuMilliseconds : glm::mix(stats.smoothedMilliseconds, stats.gpuMilliseconds, 0.2f);
+	samples++;
+}
+
+VkExtent2D DynamicResolution::update(uint32_t frameIndex, bool active, VkExtent2D maxExtent)
+{
+	if (!active)
+	{
+		if (stats.scale != 1.f)
+		{
+			stats.scale = 1.f;
+			resetHistory();
+		}
+		stats.renderExtent = maxExtent;
+		return maxExtent;
+	}
+
+	readTimestamps(frameIndex);
+
+	const float lowest = std::clamp(std::min(minScale, maxScale), 0.25f, 1.f);
+	const float highest = std::clamp(std::max(minScale, maxScale), 0.25f, 1.f);
+	float scale = stats.scale;
+	if (!adaptive || queryPool == VK_NULL_HANDLE)
+	{
+		scale = std::clamp(fixedScale, 0.25f, 1.f);
+	}
+	else if (samples >= MinSamples && stats.smoothedMilliseconds > 0.f)
+	{
+		// 그리는 픽셀 수가 배율의 제곱이므로 시간 비의 제곱근만큼 옮긴다. 한번에 반만 옮겨 흔들리지 않게 한다.
+		const float ratio = targetMilliseconds / stats.smoothedMilliseconds;
+		if (ratio < 1.f - Deadband || ratio > 1.f + Deadband)
+		{
+			const float desired = stats.scale * std::sqrt(ratio);
+			scale = stats.scale + std::clamp((desired - stats.scale) * 0.5f, -MaxStep, MaxStep);
+		}
+	}
+	scale = std::clamp(scale, lowest, highest);
+
+	// 아주 작은 변화는 무시한다. 바꾸면 새 배율로 다시 평균을 낸다.
+	if (std::abs(scale - stats.scale) > 0.005f)
+	{
+		stats.scale = scale;
+		stats.scaleChanges++;
+		resetHistory();
+	}
+
+	stats.renderExtent.width = std::clamp(static_cast<uint32_t>(std::lround(maxExtent.width * stats.scale)), 1u, maxExtent.width);
+	stats.renderExtent.height = std::clamp(static_cast<uint32_t>(std::lround(maxExtent.height * stats.scale)), 1u, maxExtent.height);
+	return stats.renderExtent;
+}
+
+void DynamicResolution::recordBeginTimestamp(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+	if (queryPool == VK_NULL_HANDLE)
+	{
+		return;
+	}
+	vkCmdResetQueryPool(commandBuffer, queryPool, frameIndex * 2, 2);
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, frameIndex * 2);
+}
+
+void DynamicResolution::recordEndTimestamp(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+	if (queryPool == VK_NULL_HANDLE)
+	{
+		return;
+	}
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, frameIndex * 2 + 1);
+	timedScales[frameIndex] = stats.scale;
+}
+
+void DynamicResolution::recordUpscale(VkCommandBuffer commandBuffer, uint32_t imageIndex, VkExtent2D renderExtent)
+{
+	GPUMarker Marker(commandBuffer, "Upscale");
+
+	// 라이팅, 포워드 패스가 다 쓴 뒤에 읽는다.
+	VkImageMemoryBarrier barrier = vkb::initializers::image_memory_barrier();
+	barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barrier.image = sceneColor->image;
+	barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+	barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	VkRenderPassBeginInfo renderPassInfo = vkb::initializers::render_pass_begin_info();
+	renderPassInfo.renderPass = renderPass;
+	renderPassInfo.framebuffer = framebuffers[imageIndex];
+	renderPassInfo.renderArea.offset = { 0, 0 };
+	renderPassInfo.renderArea.extent = targetExtent;
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+	VkViewport viewport = vkb::initializers::viewport(static_cast<float>(targetExtent.width), static_cast<float>(targetExtent.height), 0.f, 1.f);
+	VkRect2D scissor = vkb::initializers::rect2D(targetExtent.width, targetExtent.height, 0, 0);
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+	// 같은 크기면 필터가 텍셀을 그대로 옮기므로 샤프닝은 줄였을 때만 한다.
+	UpscalePushConstants pushConstants;
+	pushConstants.region = glm::vec4(renderExtent.width, renderExtent.height, 1.f / targetExtent.width, 1.f / targetExtent.height);
+	const bool scaled = renderExtent.width != targetExtent.width || renderExtent.height != targetExtent.height;
+	pushConstants.settings = glm::vec4(scaled ? sharpness : 0.f, 0.f, 0.f, 0.f);
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &set, 0, nullptr);
+	vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(UpscalePushConstants), &pushConstants);
+	vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+
+	vkCmdEndRenderPass(commandBuffer);
+
+	// 다음 프레임의 라이팅 패스가 덮어쓰기 전에 다 읽어야 한다.
+	barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
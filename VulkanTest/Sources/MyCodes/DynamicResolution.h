@@ -0,0 +1,102 @@
+#pragma once
+
+#include "vk_types.h"
+
+#include <vector>
+
+class VulkanTutorialExtension;
+
+/**
+ * 측정한 GPU 프레임 시간에 맞춰 지오메트리, 라이팅, 포워드 패스의 내부 해상도를 바꾸고 스왑체인으로 업스케일한다.
+ *
+ * 렌더 타겟(G-buffer, 깊이, 라이트 누적, 장면 색)은 스왑체인 크기로 한번 만들고, 패스들은 그 왼쪽 위 renderExtent 만큼만
+ * 그린다. 그래서 배율을 바꿔도 아무것도 다시 만들지 않는다. 장면 색은 스왑체인 대신 sceneColor 에 그리고, 마지막에
+ * Catmull-Rom 필터(바이리니어 5 번)로 스왑체인을 채운다. 내부 해상도가 낮을 때는 주변 텍셀 범위 안에서 샤프닝을 더한다.
+ *
+ * GPU 시간은 프레임 커맨드 버퍼의 처음과 업스케일 끝에 찍은 타임스탬프로 잰다. 프레임 슬롯의 펜스를 기다린 뒤에 읽고,
+ * 지금 배율로 그린 프레임만 평균에 넣는다. 평균이 목표에서 deadband 이상 벗어나면 픽셀 수가 시간에 비례한다고 보고
+ * 배율을 반쯤 옮긴다. 한번 녹화한 커맨드 버퍼는 내부 해상도를 따라갈 수 없으므로 매 프레임 녹화할 때만 배율을 바꾼다.
+ */
+class DynamicResolution
+{
+public:
+	// 평균을 새로 시작한 뒤 이만큼 모여야 배율을 바꾼다.
+	static constexpr uint32_t MinSamples = 4;
+	// 목표 시간과 이 비율 안이면 그대로 둔다.
+	static constexpr float Deadband = 0.05f;
+	// 한번에 바꾸는 배율의 최대 폭
+	static constexpr float MaxStep = 0.1f;
+
+	// 켜고 끄면 스왑체인을 다시 만들 때 sceneColor 를 만들거나 버린다.
+	static bool enabled;
+	// 끄면 fixedScale 로 고정한다.
+	static bool adaptive;
+	static float targetMilliseconds;
+	static float minScale;
+	static float maxScale;
+	static float fixedScale;
+	static float sharpness;
+
+	struct Stats
+	{
+		float scale = 1.f;
+		VkExtent2D renderExtent{};
+		float gpuMilliseconds = 0.f;		// 마지막으로 읽은 프레임
+		float smoothedMilliseconds = 0.f;	// 지금 배율의 평균
+		uint32_t scaleChanges = 0;
+	};
+
+	// 파이프라인 레이아웃, 샘플러, 타임스탬프 쿼리를 한번 만든다. frameCount 는 프레임 슬롯 수다.
+	void initialize(VulkanTutorialExtension* inEngine, VkPhysicalDevice physicalDevice, uint32_t frameCount);
+	// 스왑체인 크기의 sceneColor 와 업스케일 렌더 패스, 파이프라인, 스왑체인 이미지별 프레임버퍼를 만든다.
+	// 장면 색 프레임버퍼가 sceneColor 를 가리켜야 하므로 그보다 먼저 부른다.
+	void createTargets(VkExtent2D extent, VkFormat format, const std::vector<VkImageView>& swapchainViews);
+	void destroyTargets();
+	void cleanup();
+
+	// 이 프레임 슬롯의 펜스를 기다린 뒤에 부른다. 지난번 GPU 시간을 읽고 이번 프레임 내부 해상도를 돌려준다.
+	// active 가 아니면 배율을 1 로 되돌리고 maxExtent 를 돌려준다.
+	VkExtent2D update(uint32_t frameIndex, bool active, VkExtent2D maxExtent);
+	// 프레임 커맨드 버퍼를 녹화할 때만 처음과 끝에 부른다.
+	void recordBeginTimestamp(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+	void recordEndTimestamp(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+	// sceneColor 의 왼쪽 위 renderExtent 를 스왑체인 이미지에 늘려 그린다. sceneColor 는 COLOR_ATTACHMENT_OPTIMAL 이어야 하고
+	// 끝나면 되돌린다. 스왑체인 이미지는 COLOR_ATTACHMENT_OPTIMAL 로 남는다.
+	void recordUpscale(VkCommandBuffer commandBuffer, uint32_t imageIndex, VkExtent2D renderExtent);
+
+	bool hasTargets() const { return sceneColor != nullptr; }
+	const std::shared_ptr<AllocatedImage>& getSceneColor() const { return sceneColor; }
+	const Stats& getStats() const { return stats; }
+	bool isInitialized() const { return pipelineLayout != VK_NULL_HANDLE; }
+
+private:
+	void createRenderPass(VkFormat format);
+	void createPipeline();
+	void readTimestamps(uint32_t frameIndex);
+	void resetHistory();
+
+	VulkanTutorialExtension* engine = nullptr;
+	DevicePtr device;
+
+	VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+	VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+	VkDescriptorSet set = VK_NULL_HANDLE;
+	VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+	VkSampler sampler = VK_NULL_HANDLE;
+
+	// 스왑체인을 다시 만들 때마다 다시 만든다.
+	VkRenderPass renderPass = VK_NULL_HANDLE;
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	std::vector<VkFramebuffer> framebuffers;
+	std::shared_ptr<AllocatedImage> sceneColor;
+	VkExtent2D targetExtent{};
+
+	// 프레임 슬롯마다 시작, 끝 두 개
+	VkQueryPool queryPool = VK_NULL_HANDLE;
+	float timestampPeriod = 1.f;
+	// 슬롯에 타임스탬프를 찍었을 때의 배율. 0 이면 찍지 않았다.
+	std::vector<float> timedScales;
+
+	uint32_t samples = 0;
+	Stats stats;
+};
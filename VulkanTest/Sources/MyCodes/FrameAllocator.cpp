@@ -0,0 +1,189 @@
+#include "FrameAllocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if TRACK_HEAP_ALLOCATIONS
+namespace
+{
+	std::atomic<uint64_t> heapAllocationCount{ 0 };
+}
+
+void* operator new(size_t size)
+{
+	heapAllocationCount.fetch_add(1, std::memory_order_relaxed);
+	if (void* pointer = std::malloc(size == 0 ? 1 : size))
+	{
+		return pointer;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+	std::free(pointer);
+}
+#endif
+
+namespace
+{
+	size_t alignUp(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+FrameArena::FrameArena(size_t inBlockSize)
+	: blockSize(inBlockSize)
+{
+	addBlock(blockSize);
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment)
+{
+	while (true)
+	{
+		Block& block = blocks[blockIndex];
+		const uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+		const size_t alignedOffset = alignUp(base + offset, alignment) - base;
+		if (alignedOffset + size <= block.size)
+		{
+			usedBytes += alignedOffset + size - offset;
+			offset = alignedOffset + size;
+			return block.data.get() + alignedOffset;
+		}
+
+		// 다음 블록으로 넘어간다. 들어갈 블록이 없으면 새로 만든다.
+		blockIndex++;
+		offset = 0;
+		if (blockIndex == blocks.size() || blocks[blockIndex].size < size + alignment)
+		{
+			addBlock(size + alignment);
+			blockIndex = blocks.size() - 1;
+		}
+	}
+}
+
+void FrameArena::reset()
+{
+	if (blocks.size() > 1)
+	{
+		const size_t totalSize = getCapacity();
+		blocks.clear();
+		addBlock(totalSize);
+	}
+
+	blockIndex = 0;
+	offset = 0;
+	usedBytes = 0;
+}
+
+size_t FrameArena::getCapacity() const
+{
+	size_t capacity = 0;
+	for (const Block& block : blocks)
+	{
+		capacity += block.size;
+	}
+	return capacity;
+}
+
+void FrameArena::addBlock(size_t minSize)
+{
+	Block block;
+	block.size = std::max(blockSize, minSize);
+	block.data = std::make_unique<uint8_t[]>(block.size);
+	blocks.push_back(std::move(block));
+}
+
+FrameAllocator* FrameAllocator::instance = nullptr;
+bool FrameAllocator::enabled = true;
+
+void FrameAllocator::initialize(uint32_t framesInFlight)
+{
+	// 스왑체인을 다시 만들 때도 불린다. arena 를 지우면 드로우 컨텍스트의 FrameVector 가 해제된 메모리를 가리키게 된다.
+	if (!arenas.empty())
+	{
+		return;
+	}
+
+	for (uint32_t i = 0; i < framesInFlight; i++)
+	{
+		arenas.push_back(std::make_unique<FrameArena>());
+	}
+	currentArena = 0;
+	heapAllocationsAtFrameStart = getHeapAllocationCount();
+}
+
+void FrameAllocator::beginFrame(uint32_t frameIndex)
+{
+	const uint64_t heapAllocations = getHeapAllocationCount();
+	lastFrameHeapAllocations = heapAllocations - heapAllocationsAtFrameStart;
+	lastFrameArenaBytes = arenas[currentArena]->getUsedBytes();
+
+	currentArena = frameIndex % static_cast<uint32_t>(arenas.size());
+	arenas[currentArena]->reset();
+	heapStrings.clear();
+
+	// reset 이 블록을 합치면서 생긴 할당은 다음 프레임 수치에 넣지 않는다.
+	heapAllocationsAtFrameStart = getHeapAllocationCount();
+}
+
+const char* FrameAllocator::format(const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	va_list argsCopy;
+	va_copy(argsCopy, args);
+	const int length = std::vsnprintf(nullptr, 0, fmt, argsCopy);
+	va_end(argsCopy);
+
+	if (length < 0)
+	{
+		va_end(args);
+		return "";
+	}
+
+	char* buffer = nullptr;
+	if (FrameArena* arena = current())
+	{
+		buffer = static_cast<char*>(arena->allocate(length + 1, alignof(char)));
+	}
+	else
+	{
+		heapStrings.emplace_back(length, '\0');
+		buffer = heapStrings.back().data();
+	}
+
+	std::vsnprintf(buffer, length + 1, fmt, args);
+	va_end(args);
+	return buffer;
+}
+
+size_t FrameAllocator::getArenaCapacity() const
+{
+	size_t capacity = 0;
+	for (const std::unique_ptr<FrameArena>& arena : arenas)
+	{
+		capacity += arena->getCapacity();
+	}
+	return capacity;
+}
+
+uint64_t FrameAllocator::getHeapAllocationCount()
+{
+#if TRACK_HEAP_ALLOCATIONS
+	return heapAllocationCount.load(std::memory_order_relaxed);
+#else
+	return 0;
+#endif
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// 1 이면 전역 operator new 를 바꿔 프레임당 힙 할당 횟수를 센다.
+#ifndef TRACK_HEAP_ALLOCATIONS
+#define TRACK_HEAP_ALLOCATIONS 1
+#endif
+
+/**
+ * 한 프레임 동안만 쓰는 데이터를 위한 선형(bump) 할당기.
+ * 개별 해제는 하지 않고 reset 으로 한번에 비운다. 블록이 모자라서 늘어났다면 reset 때 한 블록으로 합쳐서,
+ * 몇 프레임 지나면 더 이상 힙 할당이 일어나지 않는다.
+ */
+class FrameArena
+{
+public:
+	static constexpr size_t DefaultBlockSize = 256 * 1024;
+
+	explicit FrameArena(size_t inBlockSize = DefaultBlockSize);
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	void* allocate(size_t size, size_t alignment);
+	void reset();
+
+	size_t getUsedBytes() const { return usedBytes; }
+	size_t getCapacity() const;
+
+private:
+	struct Block
+	{
+		std::unique_ptr<uint8_t[]> data;
+		size_t size = 0;
+	};
+
+	void addBlock(size_t minSize);
+
+	size_t blockSize;
+	std::vector<Block> blocks;
+	size_t blockIndex = 0;
+	size_t offset = 0;
+	size_t usedBytes = 0;
+};
+
+/**
+ * FrameArena 를 쓰는 STL 할당기. arena 가 없으면 일반 힙을 쓴다.
+ * deallocate 는 아무것도 하지 않으므로, 이 할당기를 쓰는 컨테이너는 arena 가 reset 되기 전에 다시 만들어야 한다.
+ */
+template<typename T>
+class ArenaAllocator
+{
+public:
+	using value_type = T;
+	using propagate_on_container_copy_assignment = std::true_type;
+	using propagate_on_container_move_assignment = std::true_type;
+	using propagate_on_container_swap = std::true_type;
+
+	ArenaAllocator() noexcept = default;
+	explicit ArenaAllocator(FrameArena* inArena) noexcept : arena(inArena) {}
+
+	template<typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.arena) {}
+
+	T* allocate(size_t count)
+	{
+		if (!arena)
+		{
+			return static_cast<T*>(::operator new(count * sizeof(T)));
+		}
+		return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T* pointer, size_t) noexcept
+	{
+		if (!arena)
+		{
+			::operator delete(pointer);
+		}
+	}
+
+	template<typename U>
+	bool operator==(const ArenaAllocator<U>& other) const noexcept { return arena == other.arena; }
+	template<typename U>
+	bool operator!=(const ArenaAllocator<U>& other) const noexcept { return arena != other.arena; }
+
+	FrameArena* arena = nullptr;
+};
+
+template<typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+/**
+ * 프레임 슬롯(MAX_FRAMES_IN_FLIGHT)마다 FrameArena 를 하나씩 두고, 슬롯의 펜스를 기다린 직후(beginFrame) 비운다.
+ * 드로우 리스트처럼 매 프레임 다시 만드는 데이터와 ImGui 라벨 같은 임시 문자열을 여기서 받는다.
+ */
+class FrameAllocator
+{
+public:
+	// false 면 arena 대신 일반 힙을 쓴다. 프레임당 힙 할당 횟수를 비교하기 위한 스위치.
+	static bool enabled;
+
+	static FrameAllocator& get()
+	{
+		if (instance == nullptr)
+		{
+			instance = new FrameAllocator();
+		}
+		return *instance;
+	}
+
+	static void destroyInstance()
+	{
+		delete instance;
+		instance = nullptr;
+	}
+
+	// 프레임 슬롯마다 arena 를 만든다. 이미 있으면 아무것도 하지 않는다.
+	void initialize(uint32_t framesInFlight);
+	void beginFrame(uint32_t frameIndex);
+
+	// 이번 프레임의 arena. enabled 가 꺼져 있으면 nullptr (일반 힙).
+	FrameArena* current() { return enabled && !arenas.empty() ? arenas[currentArena].get() : nullptr; }
+
+	template<typename T>
+	ArenaAllocator<T> allocator() { return ArenaAllocator<T>(current()); }
+
+	// printf 형식 문자열을 이번 프레임 동안 유효한 메모리에 만든다.
+	const char* format(const char* fmt, ...);
+
+	uint64_t getLastFrameHeapAllocations() const { return lastFrameHeapAllocations; }
+	size_t getLastFrameArenaBytes() const { return lastFrameArenaBytes; }
+	size_t getArenaCapacity() const;
+
+	static uint64_t getHeapAllocationCount();
+
+private:
+	FrameAllocator() = default;
+
+	static FrameAllocator* instance;
+
+	std::vector<std::unique_ptr<FrameArena>> arenas;
+	uint32_t currentArena = 0;
+
+	// enabled 가 꺼져 있을 때 format 결과를 담아둔다.
+	std::vector<std::string> heapStrings;
+
+	uint64_t heapAllocationsAtFrameStart = 0;
+	uint64_t lastFrameHeapAllocations = 0;
+	size_t lastFrameArenaBytes = 0;
+};
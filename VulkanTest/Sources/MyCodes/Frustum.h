@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <glm/glm.hpp>
+
+/**
+ * view-projection 행렬에서 뽑은 여섯 평면. 법선은 안쪽을 향하고 길이가 1 이다.
+ * 깊이 범위는 Vulkan 의 [0, 1] 기준이다.
+ */
+struct Frustum
+{
+	// left, right, bottom, top, near, far
+	std::array<glm::vec4, 6> planes;
+
+	static Frustum fromViewProjection(const glm::mat4& viewProjection)
+	{
+		// glm 은 열 우선이므로 행을 직접 모은다.
+		const glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+		const glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+		const glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+		const glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+		Frustum frustum;
+		frustum.planes[0] = row3 + row0;
+		frustum.planes[1] = row3 - row0;
+		frustum.planes[2] = row3 + row1;
+		frustum.planes[3] = row3 - row1;
+		frustum.planes[4] = row2;
+		frustum.planes[5] = row3 - row2;
+
+		for (glm::vec4& plane : frustum.planes)
+		{
+			plane /= glm::length(glm::vec3(plane));
+		}
+		return frustum;
+	}
+
+	bool intersectsSphere(const glm::vec3& center, float radius) const
+	{
+		for (const glm::vec4& plane : planes)
+		{
+			if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+};
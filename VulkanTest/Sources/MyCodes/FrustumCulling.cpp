@@ -0,0 +1,195 @@
+#include "FrustumCulling.h"
+
+#include <immintrin.h>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+	constexpr uint32_t SSEWidth = 4;
+	constexpr uint32_t AVXWidth = 8;
+
+#if defined(__AVX__)
+	constexpr uint32_t BatchWidth = AVXWidth;
+#else
+	constexpr uint32_t BatchWidth = SSEWidth;
+#endif
+
+	// 평면마다 |n| 을 미리 구해 둔다. 상자의 평면 방향 반지름은 |n| . extents 이다.
+	struct PlaneSet
+	{
+		float nx[6], ny[6], nz[6], d[6];
+		float ax[6], ay[6], az[6];
+	};
+
+	PlaneSet makePlaneSet(const Frustum& frustum)
+	{
+		PlaneSet set;
+		for (int p = 0; p < 6; p++)
+		{
+			const glm::vec4& plane = frustum.planes[p];
+			set.nx[p] = plane.x;
+			set.ny[p] = plane.y;
+			set.nz[p] = plane.z;
+			set.d[p] = plane.w;
+			set.ax[p] = std::fabs(plane.x);
+			set.ay[p] = std::fabs(plane.y);
+			set.az[p] = std::fabs(plane.z);
+		}
+		return set;
+	}
+
+#if defined(__AVX__)
+	void testBoxesAVX(const PlaneSet& planes, const float* cx, const float* cy, const float* cz,
+		const float* ex, const float* ey, const float* ez, uint32_t count, uint8_t* outVisible)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		for (uint32_t i = 0; i < count; i += AVXWidth)
+		{
+			const __m256 centerX = _mm256_loadu_ps(cx + i);
+			const __m256 centerY = _mm256_loadu_ps(cy + i);
+			const __m256 centerZ = _mm256_loadu_ps(cz + i);
+			const __m256 extentX = _mm256_loadu_ps(ex + i);
+			const __m256 extentY = _mm256_loadu_ps(ey + i);
+			const __m256 extentZ = _mm256_loadu_ps(ez + i);
+
+			__m256 outside = zero;
+			for (int p = 0; p < 6; p++)
+			{
+				__m256 distance = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.nx[p]), centerX), _mm256_set1_ps(planes.d[p]));
+				distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(planes.ny[p]), centerY));
+				distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(planes.nz[p]), centerZ));
+
+				__m256 radius = _mm256_mul_ps(_mm256_set1_ps(planes.ax[p]), extentX);
+				radius = _mm256_add_ps(radius, _mm256_mul_ps(_mm256_set1_ps(planes.ay[p]), extentY));
+				radius = _mm256_add_ps(radius, _mm256_mul_ps(_mm256_set1_ps(planes.az[p]), extentZ));
+
+				// distance + radius < 0 이면 상자 전체가 평면 바깥이다.
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_LT_OQ));
+			}
+
+			const int outsideMask = _mm256_movemask_ps(outside);
+			for (uint32_t lane = 0; lane < AVXWidth; lane++)
+			{
+				outVisible[i + lane] = (outsideMask >> lane) & 1 ? 0 : 1;
+			}
+		}
+	}
+#else
+	void testBoxesSSE(const PlaneSet& planes, const float* cx, const float* cy, const float* cz,
+		const float* ex, const float* ey, const float* ez, uint32_t count, uint8_t* outVisible)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		for (uint32_t i = 0; i < count; i += SSEWidth)
+		{
+			const __m128 centerX = _mm_loadu_ps(cx + i);
+			const __m128 centerY = _mm_loadu_ps(cy + i);
+			const __m128 centerZ = _mm_loadu_ps(cz + i);
+			const __m128 extentX = _mm_loadu_ps(ex + i);
+			const __m128 extentY = _mm_loadu_ps(ey + i);
+			const __m128 extentZ = _mm_loadu_ps(ez + i);
+
+			__m128 outside = zero;
+			for (int p = 0; p < 6; p++)
+			{
+				__m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.nx[p]), centerX), _mm_set1_ps(planes.d[p]));
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes.ny[p]), centerY));
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes.nz[p]), centerZ));
+
+				__m128 radius = _mm_mul_ps(_mm_set1_ps(planes.ax[p]), extentX);
+				radius = _mm_add_ps(radius, _mm_mul_ps(_mm_set1_ps(planes.ay[p]), extentY));
+				radius = _mm_add_ps(radius, _mm_mul_ps(_mm_set1_ps(planes.az[p]), extentZ));
+
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+			}
+
+			const int outsideMask = _mm_movemask_ps(outside);
+			for (uint32_t lane = 0; lane < SSEWidth; lane++)
+			{
+				outVisible[i + lane] = (outsideMask >> lane) & 1 ? 0 : 1;
+			}
+		}
+	}
+#endif
+}
+
+namespace FrustumCulling
+{
+	uint32_t getBatchWidth()
+	{
+		return BatchWidth;
+	}
+
+	void testBoxes(const Frustum& frustum, const float* centerX, const float* centerY, const float* centerZ,
+		const float* extentX, const float* extentY, const float* extentZ, uint32_t count, uint8_t* outVisible)
+	{
+		const PlaneSet planes = makePlaneSet(frustum);
+#if defined(__AVX__)
+		testBoxesAVX(planes, centerX, centerY, centerZ, extentX, extentY, extentZ, count, outVisible);
+#else
+		testBoxesSSE(planes, centerX, centerY, centerZ, extentX, extentY, extentZ, count, outVisible);
+#endif
+	}
+
+	Stats cullDrawList(FrameVector<RenderObject>& draws, const Frustum& frustum, uint32_t firstDraw)
+	{
+		Stats stats;
+		stats.tested = firstDraw < draws.size() ? static_cast<uint32_t>(draws.size()) - firstDraw : 0;
+		if (stats.tested == 0)
+		{
+			return stats;
+		}
+
+		// 남는 칸은 원점의 크기 0 상자로 채운다. 결과는 쓰지 않는다.
+		const uint32_t paddedCount = (stats.tested + BatchWidth - 1) / BatchWidth * BatchWidth;
+		FrameVector<float> soa(paddedCount * 6, 0.f, draws.get_allocator());
+		float* centerX = soa.data();
+		float* centerY = centerX + paddedCount;
+		float* centerZ = centerY + paddedCount;
+		float* extentX = centerZ + paddedCount;
+		float* extentY = extentX + paddedCount;
+		float* extentZ = extentY + paddedCount;
+
+		// 로컬 AABB 를 월드로 옮긴다. 회전된 상자를 감싸는 축 정렬 상자의 반지름은 |M| * extents 이다.
+		for (uint32_t i = 0; i < stats.tested; i++)
+		{
+			const RenderObject& draw = draws[firstDraw + i];
+			if (draw.bounds.sphereRadius < 0.f)
+			{
+				// 어느 평면에도 걸리도록 아주 큰 상자로 둔다.
+				extentX[i] = extentY[i] = extentZ[i] = FLT_MAX;
+				continue;
+			}
+
+			const glm::mat4& m = draw.transform;
+			const glm::vec3 center = glm::vec3(m * glm::vec4(draw.bounds.origin, 1.f));
+			const glm::vec3& e = draw.bounds.extents;
+			centerX[i] = center.x;
+			centerY[i] = center.y;
+			centerZ[i] = center.z;
+			extentX[i] = std::fabs(m[0][0]) * e.x + std::fabs(m[1][0]) * e.y + std::fabs(m[2][0]) * e.z;
+			extentY[i] = std::fabs(m[0][1]) * e.x + std::fabs(m[1][1]) * e.y + std::fabs(m[2][1]) * e.z;
+			extentZ[i] = std::fabs(m[0][2]) * e.x + std::fabs(m[1][2]) * e.y + std::fabs(m[2][2]) * e.z;
+		}
+
+		FrameVector<uint8_t> visible(paddedCount, 0, draws.get_allocator());
+		testBoxes(frustum, centerX, centerY, centerZ, extentX, extentY, extentZ, paddedCount, visible.data());
+
+		uint32_t kept = firstDraw;
+		for (uint32_t i = 0; i < stats.tested; i++)
+		{
+			if (visible[i])
+			{
+				if (kept != firstDraw + i)
+				{
+					draws[kept] = draws[firstDraw + i];
+				}
+				kept++;
+			}
+		}
+		draws.resize(kept);
+
+		stats.culled = stats.tested - (kept - firstDraw);
+		return stats;
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "vk_engine.h"
+#include "Frustum.h"
+
+/**
+ * 드로우 목록의 월드 AABB 를 프러스텀 여섯 평면과 비교해 화면 밖 드로우를 뺀다.
+ *
+ * 로컬 AABB(Bounds) 를 드로우의 transform 으로 월드 공간에 옮긴 뒤 SoA 배열에 모으고, 상자 여러 개를 한번에 검사한다.
+ * /arch:AVX 이상으로 빌드하면 8개씩(AVX), 아니면 4개씩(SSE) 검사한다.
+ * 경계를 모르는 드로우(sphereRadius < 0)는 항상 보이는 것으로 친다.
+ */
+namespace FrustumCulling
+{
+	struct Stats
+	{
+		uint32_t tested = 0;
+		uint32_t culled = 0;
+
+		Stats& operator+=(const Stats& other)
+		{
+			tested += other.tested;
+			culled += other.culled;
+			return *this;
+		}
+	};
+
+	// 한번에 검사하는 상자 수
+	uint32_t getBatchWidth();
+
+	// count 개 상자를 검사해 outVisible 에 0/1 을 쓴다. 배열은 getBatchWidth() 의 배수 길이여야 한다.
+	void testBoxes(const Frustum& frustum, const float* centerX, const float* centerY, const float* centerZ,
+		const float* extentX, const float* extentY, const float* extentZ, uint32_t count, uint8_t* outVisible);
+
+	// firstDraw 부터 보이지 않는 드로우를 목록에서 뺀다. 남은 드로우의 순서는 그대로다.
+	Stats cullDrawList(FrameVector<RenderObject>& draws, const Frustum& frustum, uint32_t firstDraw = 0);
+}
@@ -7,7 +7,7 @@ PFN_vkCmdInsertDebugUtilsLabelEXT GPUMarker::vkCmdInsertDebugUtilsLabelEXT = nul
 void GPUMarker::setup(VkInstance instance)
 {
 #ifndef NDEBUG
-	// Vulkan Extensions ̷ Dynamically ε ؾѴ. 
+	// Vulkan은 Extensions를 이렇게 Dynamically 로딩을 해야한다. 
 	vkCmdBeginDebugUtilsLabelEXT = reinterpret_cast<PFN_vkCmdBeginDebugUtilsLabelEXT>(vkGetInstanceProcAddr(instance, "vkCmdBeginDebugUtilsLabelEXT"));
 	vkCmdEndDebugUtilsLabelEXT = reinterpret_cast<PFN_vkCmdEndDebugUtilsLabelEXT>(vkGetInstanceProcAddr(instance, "vkCmdEndDebugUtilsLabelEXT"));
 	vkCmdInsertDebugUtilsLabelEXT = reinterpret_cast<PFN_vkCmdInsertDebugUtilsLabelEXT>(vkGetInstanceProcAddr(instance, "vkCmdInsertDebugUtilsLabelEXT"));
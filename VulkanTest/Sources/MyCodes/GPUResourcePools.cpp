@@ -0,0 +1,34 @@
+#include "GPUResourcePools.h"
+#include "DeferredDeletionQueue.h"
+
+GPUResourcePools* GPUResourcePools::instance = nullptr;
+
+void GPUResourcePools::releaseMaterial(MaterialHandle handle)
+{
+    if (!handle.isValid())
+    {
+        return;
+    }
+
+    if (!materials.release(handle))
+    {
+        LOG(Warning, "material handle (index {}, generation {}) released twice or already destroyed", handle.index, handle.generation);
+        return;
+    }
+    DeferredDeletionQueue::get().pushCallback([this, handle]() { materials.destroy(handle); });
+}
+
+void GPUResourcePools::releaseMesh(MeshHandle handle)
+{
+    if (!handle.isValid())
+    {
+        return;
+    }
+
+    if (!meshes.release(handle))
+    {
+        LOG(Warning, "mesh handle (index {}, generation {}) released twice or already destroyed", handle.index, handle.generation);
+        return;
+    }
+    DeferredDeletionQueue::get().pushCallback([this, handle]() { meshes.destroy(handle); });
+}
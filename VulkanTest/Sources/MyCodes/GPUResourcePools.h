@@ -0,0 +1,35 @@
+#pragma once
+#include "ResourcePool.h"
+#include "vk_types.h"
+#include "Vk_loader.h"
+
+/**
+ * 드로우 리스트에서 매 프레임 참조하는 리소스(MaterialInstance, MeshAsset)를 보관하는 풀.
+ * RenderObject, MeshNode 등은 핸들만 들고 있고 실제 객체는 여기서 찾는다.
+ * 해제는 releaseXXX() 로 예약하고, DeferredDeletionQueue 가 그 프레임 슬롯의 펜스를 확인한 뒤 실제로 제거한다.
+ */
+class GPUResourcePools {
+private:
+    static GPUResourcePools* instance;
+
+    GPUResourcePools() = default;
+
+public:
+    static GPUResourcePools& get() {
+        if (instance == nullptr) {
+            instance = new GPUResourcePools();
+        }
+        return *instance;
+    }
+
+    static void destroyInstance() {
+        delete instance;
+        instance = nullptr;
+    }
+
+    ResourcePool<MaterialInstance> materials;
+    ResourcePool<MeshAsset<Vertex>> meshes;
+
+    void releaseMaterial(MaterialHandle handle);
+    void releaseMesh(MeshHandle handle);
+};
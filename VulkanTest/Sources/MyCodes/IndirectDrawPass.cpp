@@ -0,0 +1,309 @@
+#include "IndirectDrawPass.h"
+#include "VulkanTutorialExtension.h"
+#include "OcclusionCulling.h"
+#include "GPUResourcePools.h"
+#include "vk_descriptor.h"
+#include "vk_initializers.h"
+#include "vk_resource_utils.h"
+#include "vk_log.h"
+
+#include <algorithm>
+
+bool IndirectDrawPass::enabled = true;
+
+namespace
+{
+	constexpr uint32_t CullGroupSize = 64;
+	constexpr uint32_t MinCapacity = 1024;
+}
+
+void IndirectDrawPass::initialize(VulkanTutorialExtension* inEngine, VkPhysicalDevice physicalDevice, uint32_t inFrameCount, const OcclusionCulling& inOcclusionCulling)
+{
+	if (isInitialized())
+	{
+		return;
+	}
+
+	engine = inEngine;
+	device = engine->getDevicePtr();
+	occlusionCulling = &inOcclusionCulling;
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+	const VulkanTutorial::OptionalDeviceFeatures& features = engine->getOptionalDeviceFeatures();
+	supported = features.multiDrawIndirect && features.drawIndirectFirstInstance;
+	if (!supported)
+	{
+		LOG(Warning, "GPU driven draws disabled : multiDrawIndirect / drawIndirectFirstInstance not supported");
+		return;
+	}
+
+	if (features.drawIndirectCount)
+	{
+		drawIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(vkGetDeviceProcAddr(*device, "vkCmdDrawIndexedIndirectCountKHR"));
+	}
+	LOG(Display, "GPU driven draws : {}", drawIndirectCount ? "draw indirect count" : "multi draw indirect (no compaction)");
+
+	std::vector<VkDescriptorSetLayoutBinding> bindings;
+	vk::desc::createDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, bindings);
+	vk::desc::createDescriptorSetLayoutBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, bindings);
+	vk::desc::createDescriptorSetLayoutBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, bindings);
+	vk::desc::createDescriptorSetLayoutBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, bindings);
+	cullSetLayout = vk::desc::createDescriptorSetLayout(*device, bindings);
+
+	// set 1 은 OcclusionCulling 의 피라미드 셋이다.
+	const VkDescriptorSetLayout setLayouts[] = { cullSetLayout, occlusionCulling->getPyramidSetLayout() };
+	VkPushConstantRange pushConstantRange = vkb::initializers::push_constant_range(VK_SHADER_STAGE_COMPUTE_BIT, sizeof(CullPushConstants), 0);
+	VkPipelineLayoutCreateInfo layoutInfo = vkb::initializers::pipeline_layout_create_info(setLayouts, 2);
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &pushConstantRange;
+	VK_CHECK_RESULT(vkCreatePipelineLayout(*device, &layoutInfo, nullptr, &cullPipelineLayout));
+
+	VkShaderModule computeShader = Utils::loadShader("shaders/DrawCompactioncomp.spv", *device);
+	VkComputePipelineCreateInfo pipelineInfo = vkb::initializers::compute_pipeline_create_info(cullPipelineLayout);
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = computeShader;
+	pipelineInfo.stage.pName = "main";
+	VK_CHECK_RESULT(vkCreateComputePipelines(*device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &cullPipeline));
+	vkDestroyShaderModule(*device, computeShader, nullptr);
+
+	// 프레임마다 컬링용 셋(바인딩 4개)과 버텍스 셰이더용 셋(바인딩 1개)
+	std::vector<VkDescriptorPoolSize> sizes =
+	{
+		vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 5 * inFrameCount)
+	};
+	VkDescriptorPoolCreateInfo poolInfo = vkb::initializers::descriptor_pool_create_info(sizes, 2 * inFrameCount);
+	VK_CHECK_RESULT(vkCreateDescriptorPool(*device, &poolInfo, nullptr, &descriptorPool));
+
+	frames.resize(inFrameCount);
+	for (FrameResources& frame : frames)
+	{
+		VkDescriptorSetAllocateInfo cullAllocInfo = vkb::initializers::descriptor_set_allocate_info(descriptorPool, &cullSetLayout, 1);
+		VK_CHECK_RESULT(vkAllocateDescriptorSets(*device, &cullAllocInfo, &frame.cullSet));
+
+		VkDescriptorSetAllocateInfo drawDataAllocInfo = vkb::initializers::descriptor_set_allocate_info(descriptorPool, &engine->metalRoughMaterial.drawDataLayout, 1);
+		VK_CHECK_RESULT(vkAllocateDescriptorSets(*device, &drawDataAllocInfo, &frame.drawDataSet));
+
+		reserve(frame, MinCapacity);
+	}
+}
+
+void IndirectDrawPass::cleanup()
+{
+	if (!supported)
+	{
+		return;
+	}
+
+	for (FrameResources& frame : frames)
+	{
+		destroyBuffers(frame);
+	}
+	frames.clear();
+
+	vkDestroyDescriptorPool(*device, descriptorPool, nullptr);
+	vkDestroyPipeline(*device, cullPipeline, nullptr);
+	vkDestroyPipelineLayout(*device, cullPipelineLayout, nullptr);
+	vkDestroyDescriptorSetLayout(*device, cullSetLayout, nullptr);
+}
+
+void IndirectDrawPass::prepare(uint32_t frameIndex, const FrameVector<RenderObject>& draws, const FrameVector<Instance>& instances,
+	const glm::mat4& viewProjection, FrameVector<RenderObject>& outFallbackDraws)
+{
+	FrameResources& frame = frames[frameIndex];
+
+	uint32_t recordCount = 0;
+	for (const RenderObject& draw : draws)
+	{
+		recordCount += draw.instanceCount;
+	}
+	reserve(frame, recordCount);
+
+	frame.drawCount = 0;
+	frame.groups.clear();
+
+	GPUResourcePools& pools = GPUResourcePools::get();
+	const MaterialPipeline* opaquePipeline = &engine->metalRoughMaterial.opaquePipeline;
+	GPUDrawRecord* records = static_cast<GPUDrawRecord*>(frame.drawRecords.mapped);
+
+	for (const RenderObject& draw : draws)
+	{
+		// 간접 파이프라인은 GLTF 불투명 파이프라인 하나만 대신한다.
+		const MaterialInstance* material = pools.materials.get(draw.material);
+		if (!material || material->pipeline != opaquePipeline)
+		{
+			outFallbackDraws.push_back(draw);
+			continue;
+		}
+
+		// 정렬 키가 파이프라인/머티리얼/메시 순이므로 같은 상태는 이미 붙어 있다.
+		if (frame.groups.empty()
+			|| frame.groups.back().material != draw.material
+			|| frame.groups.back().vertexBuffer != draw.vertexBuffer
+			|| frame.groups.back().indexBuffer != draw.indexBuffer)
+		{
+			frame.groups.push_back({ draw.material, draw.vertexBuffer, draw.indexBuffer, frame.drawCount, 0 });
+		}
+
+		Group& group = frame.groups.back();
+		for (uint32_t instance = 0; instance < draw.instanceCount; instance++)
+		{
+			GPUDrawRecord& record = records[frame.drawCount];
+			record.transform = draw.instanceCount > 1 ? instances[draw.firstInstance + instance].model : draw.transform;
+			record.boundingSphere = glm::vec4(draw.bounds.origin, draw.bounds.sphereRadius);
+			record.firstIndex = draw.firstIndex;
+			record.indexCount = draw.indexCount;
+			record.groupIndex = static_cast<uint32_t>(frame.groups.size() - 1);
+			record.groupFirstCommand = group.firstDraw;
+
+			group.drawCount++;
+			frame.drawCount++;
+		}
+	}
+
+	frame.pushConstants.viewProjection = viewProjection;
+	frame.pushConstants.drawCount = frame.drawCount;
+	frame.pushConstants.compact = isCompacting() ? 1 : 0;
+
+	lastStats.drawCount = frame.drawCount;
+	lastStats.groupCount = static_cast<uint32_t>(frame.groups.size());
+	lastStats.fallbackCount = static_cast<uint32_t>(outFallbackDraws.size());
+}
+
+void IndirectDrawPass::recordCulling(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t phase, bool testOcclusion)
+{
+	FrameResources& frame = frames[frameIndex];
+	if (frame.drawCount == 0)
+	{
+		return;
+	}
+
+	// 가림 컬링을 하지 않아도 피라미드 셋은 바인딩해야 한다. 셰이더는 useOcclusion 이 0 이면 읽지 않는다.
+	frame.pushConstants.phase = phase;
+	// recordDraws 가 phase * capacity 에서 읽으므로 1 단계는 앞쪽 절반, 2 단계는 뒤쪽 절반에 쓴다.
+	frame.pushConstants.phaseOffset = phase * frame.capacity;
+	frame.pushConstants.useOcclusion = testOcclusion && (phase == 1 || occlusionCulling->hasPyramid()) ? 1 : 0;
+
+	// 압축할 때 그룹별 개수를 atomicAdd 로 세므로 0 에서 시작한다.
+	if (isCompacting())
+	{
+		const VkDeviceSize countOffset = phase * frame.capacity * sizeof(uint32_t);
+		vkCmdFillBuffer(commandBuffer, frame.counts.Buffer, countOffset, frame.groups.size() * sizeof(uint32_t), 0);
+
+		VkMemoryBarrier fillBarrier = vkb::initializers::memory_barrier();
+		fillBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		fillBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &fillBarrier, 0, nullptr, 0, nullptr);
+	}
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline);
+	const VkDescriptorSet sets[] = { frame.cullSet, occlusionCulling->getPyramidSet(frameIndex) };
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipelineLayout, 0, 2, sets, 0, nullptr);
+	vkCmdPushConstants(commandBuffer, cullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstants), &frame.pushConstants);
+	vkCmdDispatch(commandBuffer, (frame.drawCount + CullGroupSize - 1) / CullGroupSize, 1, 1);
+
+	// 2 단계 컬링은 1 단계가 쓴 visibility 를 읽는다.
+	VkMemoryBarrier cullBarrier = vkb::initializers::memory_barrier();
+	cullBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	cullBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 1, &cullBarrier, 0, nullptr, 0, nullptr);
+}
+
+void IndirectDrawPass::recordDraws(VkCommandBuffer commandBuffer, uint32_t frameIndex, size_t imageIndex, uint32_t firstGroup, uint32_t groupEnd, uint32_t phase) const
+{
+	const FrameResources& frame = frames[frameIndex];
+	if (firstGroup >= groupEnd)
+	{
+		return;
+	}
+
+	const MaterialPipeline& pipeline = engine->metalRoughMaterial.indirectOpaquePipeline;
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.layout, 0, 1, &engine->globalDescriptorSets[imageIndex], 0, nullptr);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.layout, 2, 1, &frame.drawDataSet, 0, nullptr);
+
+	const GPUResourcePools& pools = GPUResourcePools::get();
+	const Group* previous = nullptr;
+	for (uint32_t g = firstGroup; g < groupEnd; g++)
+	{
+		const Group& group = frame.groups[g];
+
+		if (!previous || previous->material != group.material)
+		{
+			const MaterialInstance* material = pools.materials.get(group.material);
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.layout, 1, 1, &material->materialSet[imageIndex], 0, nullptr);
+		}
+		if (!previous || previous->vertexBuffer != group.vertexBuffer)
+		{
+			VkDeviceSize offset = 0;
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, &group.vertexBuffer, &offset);
+		}
+		if (!previous || previous->indexBuffer != group.indexBuffer)
+		{
+			vkCmdBindIndexBuffer(commandBuffer, group.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+		}
+		previous = &group;
+
+		const VkDeviceSize commandOffset = (phase * frame.capacity + group.firstDraw) * sizeof(VkDrawIndexedIndirectCommand);
+		if (isCompacting())
+		{
+			drawIndirectCount(commandBuffer, frame.commands.Buffer, commandOffset, frame.counts.Buffer, (phase * frame.capacity + g) * sizeof(uint32_t),
+				group.drawCount, sizeof(VkDrawIndexedIndirectCommand));
+		}
+		else
+		{
+			vkCmdDrawIndexedIndirect(commandBuffer, frame.commands.Buffer, commandOffset, group.drawCount, sizeof(VkDrawIndexedIndirectCommand));
+		}
+	}
+}
+
+void IndirectDrawPass::reserve(FrameResources& frame, uint32_t drawCount)
+{
+	if (drawCount <= frame.capacity)
+	{
+		return;
+	}
+
+	// 이 슬롯의 이전 제출은 끝났으므로 바로 지우고 새로 만든다.
+	const uint32_t capacity = std::max({ drawCount, frame.capacity * 2, MinCapacity });
+	destroyBuffers(frame);
+	frame.capacity = capacity;
+
+	frame.drawRecords.Create(*device, memoryProperties, frame.capacity * sizeof(GPUDrawRecord),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	// 가림 컬링 2 단계 결과를 뒤쪽 절반에 쓴다.
+	frame.commands.Create(*device, memoryProperties, 2 * frame.capacity * sizeof(VkDrawIndexedIndirectCommand),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	// 그룹 수는 드로우 수를 넘지 않는다.
+	frame.counts.Create(*device, memoryProperties, 2 * frame.capacity * sizeof(uint32_t),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	frame.visibility.Create(*device, memoryProperties, frame.capacity * sizeof(uint32_t),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	VkDescriptorBufferInfo recordInfo{ frame.drawRecords.Buffer, 0, VK_WHOLE_SIZE };
+	VkDescriptorBufferInfo commandInfo{ frame.commands.Buffer, 0, VK_WHOLE_SIZE };
+	VkDescriptorBufferInfo countInfo{ frame.counts.Buffer, 0, VK_WHOLE_SIZE };
+	VkDescriptorBufferInfo visibilityInfo{ frame.visibility.Buffer, 0, VK_WHOLE_SIZE };
+
+	std::vector<VkWriteDescriptorSet> writes =
+	{
+		vkb::initializers::write_descriptor_set(frame.cullSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0, &recordInfo),
+		vkb::initializers::write_descriptor_set(frame.cullSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, &commandInfo),
+		vkb::initializers::write_descriptor_set(frame.cullSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2, &countInfo),
+		vkb::initializers::write_descriptor_set(frame.cullSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3, &visibilityInfo),
+		vkb::initializers::write_descriptor_set(frame.drawDataSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0, &recordInfo)
+	};
+	vkUpdateDescriptorSets(*device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+	LOG(Log, "GPU driven draw buffers : {} draws", frame.capacity);
+}
+
+void IndirectDrawPass::destroyBuffers(FrameResources& frame)
+{
+	frame.drawRecords.Destroy(*device);
+	frame.commands.Destroy(*device);
+	frame.counts.Destroy(*device);
+	frame.visibility.Destroy(*device);
+	frame.capacity = 0;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "vk_types.h"
+#include "Buffer.h"
+#include "FrameAllocator.h"
+
+#include <vector>
+
+class VulkanTutorialExtension;
+class OcclusionCulling;
+struct RenderObject;
+
+// shaders/gpu_driven.glsl 의 DrawRecord 와 배치가 같아야 한다. (std430)
+struct GPUDrawRecord
+{
+	glm::mat4 transform;
+	glm::vec4 boundingSphere;
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	uint32_t groupIndex;
+	uint32_t groupFirstCommand;
+};
+static_assert(sizeof(GPUDrawRecord) == 96, "GPUDrawRecord must match DrawRecord in gpu_driven.glsl");
+
+/**
+ * 정렬된 불투명 드로우 목록을 GPU 에 올리고, 컴퓨트 셰이더가 프러스텀 컬링 후 간접 드로우 인자로 압축한다.
+ *
+ * 머티리얼 디스크립터 셋과 메시 버퍼가 아직 드로우마다 따로라서 한 번의 간접 드로우로 모두 그릴 수는 없다.
+ * 대신 정렬된 목록에서 파이프라인/머티리얼/버텍스/인덱스 버퍼가 같은 연속 구간을 그룹으로 묶고, 그룹마다 간접 드로우를 한번 부른다.
+ * VK_KHR_draw_indirect_count 가 있으면 살아남은 드로우만 앞으로 모으고 개수도 GPU 가 정한다.
+ * 없으면 컬링된 드로우의 instanceCount 를 0 으로 쓰고 그룹 크기만큼 multi draw indirect 한다.
+ *
+ * 모델 행렬은 push constant 대신 firstInstance 로 가리킨 드로우 레코드에서 읽는다.
+ * 가림 컬링을 켜면 OcclusionCulling 의 피라미드로 두 단계를 나눠 검사한다. 2 단계 인자와 개수는 버퍼 뒤쪽 절반에 쓴다.
+ * 버퍼는 프레임 슬롯마다 따로 두므로 매 프레임 녹화할 때만 쓸 수 있다.
+ */
+class IndirectDrawPass
+{
+public:
+	static bool enabled;
+
+	struct Stats
+	{
+		uint32_t drawCount = 0;		// GPU 에서 컬링한 드로우
+		uint32_t groupCount = 0;	// 실제로 부른 간접 드로우 수
+		uint32_t fallbackCount = 0;	// 간접 드로우로 그릴 수 없어 CPU 경로로 넘긴 드로우
+	};
+
+	// occlusionCulling 은 먼저 초기화되어 있어야 한다. 컬링 파이프라인이 피라미드 셋 레이아웃을 쓴다.
+	// 버퍼는 화면 크기와 상관없으므로 한번만 만든다.
+	void initialize(VulkanTutorialExtension* inEngine, VkPhysicalDevice physicalDevice, uint32_t inFrameCount, const OcclusionCulling& occlusionCulling);
+	void cleanup();
+
+	// multiDrawIndirect 와 drawIndirectFirstInstance 가 있어야 한다.
+	bool isSupported() const { return supported; }
+	bool isCompacting() const { return drawIndirectCount != nullptr; }
+	bool isInitialized() const { return cullPipeline != VK_NULL_HANDLE; }
+
+	// 드로우 레코드를 채우고 그룹을 만든다. 간접 드로우로 그릴 수 없는 드로우는 outFallbackDraws 에 담는다.
+	// 인스턴스 드로우는 instances 에서 행렬을 꺼내 인스턴스마다 레코드를 만들어 따로 컬링한다.
+	// 이 프레임 슬롯의 펜스를 기다린 뒤에 불러야 한다.
+	void prepare(uint32_t frameIndex, const FrameVector<RenderObject>& draws, const FrameVector<Instance>& instances,
+		const glm::mat4& viewProjection, FrameVector<RenderObject>& outFallbackDraws);
+	// 컬링과 압축. 렌더 패스 밖에서 불러야 한다.
+	// testOcclusion 이면 가림 검사도 한다. phase 0 은 지난 프레임 피라미드로, phase 1 은 0 단계에서 가려진 드로우만 새 피라미드로 검사한다.
+	void recordCulling(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t phase = 0, bool testOcclusion = false);
+	// [firstGroup, groupEnd) 그룹의 phase 단계 결과를 그린다. 여러 스레드에서 다른 구간을 동시에 녹화해도 된다.
+	void recordDraws(VkCommandBuffer commandBuffer, uint32_t frameIndex, size_t imageIndex, uint32_t firstGroup, uint32_t groupEnd, uint32_t phase = 0) const;
+
+	uint32_t getGroupCount(uint32_t frameIndex) const { return static_cast<uint32_t>(frames[frameIndex].groups.size()); }
+	const Stats& getLastStats() const { return lastStats; }
+
+private:
+	struct Group
+	{
+		MaterialHandle material;
+		VkBuffer vertexBuffer;
+		VkBuffer indexBuffer;
+		uint32_t firstDraw;
+		uint32_t drawCount;
+	};
+
+	struct CullPushConstants
+	{
+		glm::mat4 viewProjection;	// 프러스텀 평면은 셰이더에서 뽑는다.
+		uint32_t drawCount;
+		uint32_t compact;
+		uint32_t phase;
+		uint32_t useOcclusion;
+		uint32_t phaseOffset;		// 이 단계 인자와 개수의 시작 위치. phase * capacity 이다.
+	};
+
+	struct FrameResources
+	{
+		StorageBuffer drawRecords;	// 호스트에서 채운다
+		StorageBuffer commands;		// VkDrawIndexedIndirectCommand, 컴퓨트 셰이더가 단계별로 capacity 개씩 채운다
+		StorageBuffer counts;		// 단계, 그룹별 살아남은 드로우 수
+		StorageBuffer visibility;	// 1 단계 결과. 2 단계가 가려진 드로우만 다시 검사한다
+		uint32_t capacity = 0;
+
+		VkDescriptorSet cullSet = VK_NULL_HANDLE;
+		VkDescriptorSet drawDataSet = VK_NULL_HANDLE;
+
+		uint32_t drawCount = 0;
+		std::vector<Group> groups;
+		CullPushConstants pushConstants;
+	};
+
+	void reserve(FrameResources& frame, uint32_t drawCount);
+	void destroyBuffers(FrameResources& frame);
+
+	VulkanTutorialExtension* engine = nullptr;
+	DevicePtr device;
+	VkPhysicalDeviceMemoryProperties memoryProperties{};
+	bool supported = false;
+	const OcclusionCulling* occlusionCulling = nullptr;
+	PFN_vkCmdDrawIndexedIndirectCountKHR drawIndirectCount = nullptr;
+
+	VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+	VkDescriptorSetLayout cullSetLayout = VK_NULL_HANDLE;
+	VkPipelineLayout cullPipelineLayout = VK_NULL_HANDLE;
+	VkPipeline cullPipeline = VK_NULL_HANDLE;
+
+	std::vector<FrameResources> frames;
+	Stats lastStats;
+};
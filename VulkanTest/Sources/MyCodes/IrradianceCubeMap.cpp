@@ -53,6 +53,10 @@ void IrradianceCubeMap::initialize(VulkanTutorialExtension* engine)
 	draw(singleCommandBuffer, engine);
 	engine->endSingleTimeCommands(singleCommandBuffer);
 
+	// 베이크 이후 envMapPipeline 은 다시 그려지지 않는다. 이 뒤로는 G-buffer 가 메모리를 덮어쓴다.
+	equirectangularTexture.reset();
+	engine->transientAttachmentHeap.release(TransientAttachmentHeap::AliasGroup::IBLBake);
+
 	// for debugging
 	std::shared_ptr<TextureViewer> textureViewer = engine->getTextureViewer();
 	textureViewer->addTexture(envCubeMap, "EnvironmentMap");
@@ -70,7 +74,8 @@ void IrradianceCubeMap::loadEquirectangular(VulkanTutorial* engine, const std::s
 		throw std::runtime_error("failed to load texture image!");
 	}
 
-	equirectangularTexture = engine->createTexture2D((stbi_uc*)floatPixels, { (uint32_t)texWidth ,(uint32_t)texHeight, 1 }, HDRFormat, VK_IMAGE_USAGE_SAMPLED_BIT, "HDR");
+	// 베이크가 끝나면 버리는 텍스쳐라서, 첫 프레임 전까지 비어있는 G-buffer 메모리를 겹쳐 쓴다.
+	equirectangularTexture = engine->createTexture2D((stbi_uc*)floatPixels, { (uint32_t)texWidth ,(uint32_t)texHeight, 1 }, HDRFormat, VK_IMAGE_USAGE_SAMPLED_BIT, "HDR", 4, TransientAttachmentHeap::AliasGroup::IBLBake);
 }
 
 void IrradianceCubeMap::createSampler(VkDevice device)
@@ -123,10 +128,10 @@ void IrradianceCubeMap::createRenderPass()
 	dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
 	dependency.dstSubpass = 0;
 	
-	dependency.srcStageMask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT; //  
-	dependency.srcAccessMask = 0; // Ư   ٸ 0
+	dependency.srcStageMask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT; // 제약 없음
+	dependency.srcAccessMask = 0; // 특별한 이전 접근이 없다면 0
 
-	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT; //   Attachment ̾ƿ Ϲ ȯ (VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
+	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT; // 이 때 Attachment의 레이아웃 암묵적 변환 (VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
 	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
 
 	VkRenderPassCreateInfo renderPassInfo{};
@@ -140,11 +145,11 @@ void IrradianceCubeMap::createRenderPass()
 
 	VK_CHECK_RESULT(vkCreateRenderPass(*device, &renderPassInfo, nullptr, &renderPass));
 
-	// env ʿ  н 
+	// env 맵용 렌더 패스 
 	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
 	VK_CHECK_RESULT(vkCreateRenderPass(*device, &renderPassInfo, nullptr, &envCubeRenderPass));
 
-	// Integration ʿ н 
+	// Integration 맵용 렌더패스 
 	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 	colorAttachment.format = VK_FORMAT_R16G16_SFLOAT;
 
@@ -155,12 +160,13 @@ void IrradianceCubeMap::buildPipeline(VulkanTutorialExtension* engine)
 {
 	auto disableDepthTestAndWrite = [this](VkGraphicsPipelineCreateInfo& pipelineCI) {
 		pipelineCI.renderPass = this->renderPass;
+		pipelineCI.subpass = 0;
 		auto* depthStencil = const_cast<VkPipelineDepthStencilStateCreateInfo*>(pipelineCI.pDepthStencilState);
 		depthStencil->depthTestEnable = VK_FALSE;
 		depthStencil->depthWriteEnable = VK_FALSE;
 		};
 
-	// ȯ  
+	// 환경 맵 파이프라인
 	envMapPipeline = std::make_shared<SimplePipelinePosOnly>(
 		Res,
 		"shaders/IrradianceCubeMapvert.spv",
@@ -174,7 +180,7 @@ void IrradianceCubeMap::buildPipeline(VulkanTutorialExtension* engine)
 	envMapPipeline->buildPipeline(engine, disableDepthTestAndWrite);
 	envMapPipeline->updateTextureDescriptor(*device, 0, 0, equirectangularTexture->imageView, defaultSampler);
 
-	// ǻ  
+	// 디퓨즈 맵 파이프라인
 	diffuseMapPipeline = std::make_shared<SimplePipelinePosOnly>(
 		DiffuseMapRes,
 		"shaders/IrradianceCubeMapvert.spv",
@@ -188,7 +194,7 @@ void IrradianceCubeMap::buildPipeline(VulkanTutorialExtension* engine)
 	diffuseMapPipeline->buildPipeline(engine, disableDepthTestAndWrite);
 	diffuseMapPipeline->updateTextureDescriptor(*device, 0, 0, envCubeMap->image->imageView, defaultSampler);
 
-	// ŧ  
+	// 스페큘러 맵 파이프라인
 	specularMapPipeline = std::make_shared<SimplePipelinePosOnly>(
 		SpecularMapRes,
 		"shaders/IrradianceCubeMapvert.spv",
@@ -203,7 +209,7 @@ void IrradianceCubeMap::buildPipeline(VulkanTutorialExtension* engine)
 	specularMapPipeline->buildPipeline(engine, disableDepthTestAndWrite);
 	specularMapPipeline->updateTextureDescriptor(*device, 0, 0, envCubeMap->image->imageView, defaultSampler);
 
-	// BRDF LUT 
+	// BRDF LUT 파이프라인
 	integrationMapPipeline = std::make_shared<SimplePipelinePosTex>(
 		SpecularMapRes,
 		"shaders/BRDFIntegrationMapvert.spv",
@@ -214,8 +220,9 @@ void IrradianceCubeMap::buildPipeline(VulkanTutorialExtension* engine)
 	);
 	integrationMapPipeline->buildPipeline(engine, [this](VkGraphicsPipelineCreateInfo& pipelineCI) {
 		pipelineCI.renderPass = this->integrationRenderPass;
+		pipelineCI.subpass = 0;
 		auto* rasterState = const_cast<VkPipelineRasterizationStateCreateInfo*>(pipelineCI.pRasterizationState);
-		rasterState->cullMode = VK_CULL_MODE_NONE; // ø Ȱȭ
+		rasterState->cullMode = VK_CULL_MODE_NONE; // 컬링 비활성화
 		auto* depthStencil = const_cast<VkPipelineDepthStencilStateCreateInfo*>(pipelineCI.pDepthStencilState);
 		depthStencil->depthTestEnable = VK_FALSE;
 		depthStencil->depthWriteEnable = VK_FALSE;
@@ -481,7 +488,7 @@ void IrradianceCubeMap::createFrameBuffer(CubeFrameBuffer& frameBuffers, uint32_
 	frameBuffers.resize(cubeMap.imageViews.size());
 	for (int i = 0; i < cubeMap.imageViews.size(); i++)
 	{
-		//  mip  ° ũ 
+		// 현재 mip 레벨에 맞게 크기 계산
 		uint32_t mipWidth = extent.width * std::pow(0.5, i);
 		uint32_t mipHeight = extent.height * std::pow(0.5, i);
 
@@ -0,0 +1,334 @@
+#include "LightVolumes.h"
+#include "ClusteredLighting.h"
+#include "PointShadowAtlas.h"
+#include "VulkanTutorialExtension.h"
+#include "GPUMarker.h"
+#include "vk_initializers.h"
+#include "vk_resource_utils.h"
+#include "vk_log.h"
+
+#include <array>
+#include <cmath>
+
+#include <glm/gtc/constants.hpp>
+
+bool LightVolumes::enabled = false;
+
+namespace
+{
+	// shaders/LightVolume.vert 의 VolumeParams 와 같다.
+	struct VolumePushConstants
+	{
+		float volumeScale;
+	};
+}
+
+void LightVolumes::initialize(VulkanTutorialExtension* inEngine, VkPhysicalDevice physicalDevice, uint32_t imageCount, VkFormat depthFormat,
+	const std::vector<VkDescriptorSetLayout>& setLayouts)
+{
+	// 스왑체인을 다시 만들 때도 불린다. 파이프라인은 뷰포트를 동적으로 두었으므로 그대로 쓴다.
+	if (!isInitialized())
+	{
+		engine = inEngine;
+		device = engine->getDevicePtr();
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+		createRenderPass(depthFormat);
+		createPipeline(setLayouts);
+		createSphere();
+	}
+
+	if (drawCommands.size() == imageCount)
+	{
+		return;
+	}
+	destroyDrawCommands();
+
+	drawCommands.resize(imageCount);
+	for (StorageBuffer& drawCommand : drawCommands)
+	{
+		drawCommand.Create(*device, memoryProperties, sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+		VkDrawIndexedIndirectCommand& command = *static_cast<VkDrawIndexedIndirectCommand*>(drawCommand.mapped);
+		command.indexCount = static_cast<uint32_t>(sphere.indexBuffer.indices.size());
+		command.instanceCount = 0;
+		command.firstIndex = 0;
+		command.vertexOffset = 0;
+		command.firstInstance = 0;
+	}
+}
+
+void LightVolumes::createRenderPass(VkFormat depthFormat)
+{
+	VkAttachmentDescription accumulationAttachment{};
+	accumulationAttachment.format = AccumulationFormat;
+	accumulationAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	accumulationAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	accumulationAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	accumulationAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	accumulationAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	accumulationAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	accumulationAttachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	// 지오메트리 패스의 깊이와 스텐실을 테스트에만 쓴다. 라이팅 패스가 이어서 읽으므로 보존한다.
+	VkAttachmentDescription depthAttachment{};
+	depthAttachment.format = depthFormat;
+	depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+	depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+	VkAttachmentReference accumulationRef{ 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+	VkAttachmentReference depthRef{ 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL };
+
+	VkSubpassDescription subpass{};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &accumulationRef;
+	subpass.pDepthStencilAttachment = &depthRef;
+
+	// 지난번 라이팅 패스가 누적 타겟을 다 읽은 뒤에 지우고, 이번 라이팅 패스는 다 쓴 뒤에 읽는다.
+	std::array<VkSubpassDependency, 2> dependencies{};
+	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[0].dstSubpass = 0;
+	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	dependencies[0].srcAccessMask = 0;
+	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+	dependencies[1].srcSubpass = 0;
+	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	std::array<VkAttachmentDescription, 2> attachments = { accumulationAttachment, depthAttachment };
+	VkRenderPassCreateInfo renderPassInfo = vkb::initializers::render_pass_create_info();
+	renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+	renderPassInfo.pAttachments = attachments.data();
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+	renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+	renderPassInfo.pDependencies = dependencies.data();
+	VK_CHECK_RESULT(vkCreateRenderPass(*device, &renderPassInfo, nullptr, &renderPass));
+}
+
+void LightVolumes::createPipeline(const std::vector<VkDescriptorSetLayout>& setLayouts)
+{
+	VkPushConstantRange pushConstantRange = vkb::initializers::push_constant_range(VK_SHADER_STAGE_VERTEX_BIT, sizeof(VolumePushConstants), 0);
+	VkPipelineLayoutCreateInfo layoutInfo = vkb::initializers::pipeline_layout_create_info(setLayouts.data(), static_cast<uint32_t>(setLayouts.size()));
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &pushConstantRange;
+	VK_CHECK_RESULT(vkCreatePipelineLayout(*device, &layoutInfo, nullptr, &pipelineLayout));
+
+	std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+	VertexOnlyPos::getBindingDescriptions(bindingDescriptions);
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+	VertexOnlyPos::getAttributeDescriptions(attributeDescriptions);
+	VkPipelineVertexInputStateCreateInfo vertexInputState = vkb::initializers::pipeline_vertex_input_state_create_info();
+	vertexInputState.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
+	vertexInputState.pVertexBindingDescriptions = bindingDescriptions.data();
+	vertexInputState.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+	vertexInputState.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+	// 뒷면만 그리면 카메라가 구 안에 있어도 픽셀마다 한번씩 칠한다.
+	VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = vkb::initializers::pipeline_input_assembly_state_create_info(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, 0, VK_FALSE);
+	VkPipelineRasterizationStateCreateInfo rasterizationState = vkb::initializers::pipeline_rasterization_state_create_info(VK_POLYGON_MODE_FILL, VK_CULL_MODE_FRONT_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE, 0);
+	VkPipelineMultisampleStateCreateInfo multisampleState = vkb::initializers::pipeline_multisample_state_create_info(VK_SAMPLE_COUNT_1_BIT, 0);
+	VkPipelineViewportStateCreateInfo viewportState = vkb::initializers::pipeline_viewport_state_create_info(1, 1, 0);
+	std::vector<VkDynamicState> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	VkPipelineDynamicStateCreateInfo dynamicState = vkb::initializers::pipeline_dynamic_state_create_info(dynamicStates);
+
+	// 표면이 구 뒷면보다 앞에 있어야 하고, 지오메트리 패스가 그린 픽셀이어야 한다. 깊이와 스텐실은 쓰지 않는다.
+	VkPipelineDepthStencilStateCreateInfo depthStencilState = vkb::initializers::pipeline_depth_stencil_state_create_info(VK_TRUE, VK_FALSE, VK_COMPARE_OP_GREATER_OR_EQUAL);
+	VulkanTutorial::GeometryPass::testStencil(depthStencilState);
+
+	// 라이트끼리 더한다.
+	VkPipelineColorBlendAttachmentState blendAttachmentState = vkb::initializers::pipeline_color_blend_attachment_state(0xf, VK_TRUE);
+	blendAttachmentState.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+	blendAttachmentState.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+	blendAttachmentState.colorBlendOp = VK_BLEND_OP_ADD;
+	blendAttachmentState.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	blendAttachmentState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	blendAttachmentState.alphaBlendOp = VK_BLEND_OP_ADD;
+	VkPipelineColorBlendStateCreateInfo colorBlendState = vkb::initializers::pipeline_color_blend_state_create_info(1, &blendAttachmentState);
+
+	VkShaderModule vertexShader = Utils::loadShader("shaders/LightVolumevert.spv", *device);
+	VkShaderModule fragmentShader = Utils::loadShader("shaders/LightVolumefrag.spv", *device);
+	std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages{};
+	shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	shaderStages[0].module = vertexShader;
+	shaderStages[0].pName = "main";
+	shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	shaderStages[1].module = fragmentShader;
+	shaderStages[1].pName = "main";
+
+	VkGraphicsPipelineCreateInfo pipelineInfo = vkb::initializers::pipeline_create_info(pipelineLayout, renderPass);
+	pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+	pipelineInfo.pStages = shaderStages.data();
+	pipelineInfo.pVertexInputState = &vertexInputState;
+	pipelineInfo.pInputAssemblyState = &inputAssemblyState;
+	pipelineInfo.pRasterizationState = &rasterizationState;
+	pipelineInfo.pMultisampleState = &multisampleState;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pDepthStencilState = &depthStencilState;
+	pipelineInfo.pColorBlendState = &colorBlendState;
+	pipelineInfo.pDynamicState = &dynamicState;
+	VK_CHECK_RESULT(vkCreateGraphicsPipelines(*device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline));
+
+	vkDestroyShaderModule(*device, vertexShader, nullptr);
+	vkDestroyShaderModule(*device, fragmentShader, nullptr);
+}
+
+void LightVolumes::createSphere()
+{
+	// 꼭짓점이 단위 구 위에 있는 UV 구. 바깥에서 보아 반시계 방향으로 감는다.
+	const float pi = glm::pi<float>();
+	std::vector<VertexOnlyPos>& vertices = sphere.vertexBuffer.vertices;
+	for (uint32_t ring = 0; ring <= SphereRings; ring++)
+	{
+		const float theta = pi * ring / SphereRings;
+		for (uint32_t segment = 0; segment <= SphereSegments; segment++)
+		{
+			const float phi = 2.f * pi * segment / SphereSegments;
+			vertices.push_back({ glm::vec3(std::cos(phi) * std::sin(theta), std::cos(theta), std::sin(phi) * std::sin(theta)) });
+		}
+	}
+
+	std::vector<uint32_t>& indices = sphere.indexBuffer.indices;
+	for (uint32_t ring = 0; ring < SphereRings; ring++)
+	{
+		for (uint32_t segment = 0; segment < SphereSegments; segment++)
+		{
+			const uint32_t topLeft = ring * (SphereSegments + 1) + segment;
+			const uint32_t bottomLeft = topLeft + SphereSegments + 1;
+			// 극에서는 한쪽 변이 점으로 모이므로 삼각형 하나만 남는다.
+			if (ring > 0)
+			{
+				indices.insert(indices.end(), { topLeft, topLeft + 1, bottomLeft });
+			}
+			if (ring + 1 < SphereRings)
+			{
+				indices.insert(indices.end(), { topLeft + 1, bottomLeft + 1, bottomLeft });
+			}
+		}
+	}
+
+	// 면 중심까지 거리는 경도 반 칸, 위도 반 칸 각도의 코사인 곱이다. (구면 피타고라스)
+	volumeScale = 1.f / (std::cos(pi / SphereSegments) * std::cos(pi / (2.f * SphereRings)));
+
+	engine->createVertexBuffer(vertices, sphere.vertexBuffer.Buffer, sphere.vertexBuffer.BufferMemory);
+	engine->createIndexBuffer(indices, sphere.indexBuffer.Buffer, sphere.indexBuffer.BufferMemory);
+}
+
+void LightVolumes::createTargets(VkExtent2D inExtent, VkImageView depthView)
+{
+	destroyTargets();
+	extent = inExtent;
+
+	accumulation = engine->createImage(extent.width, extent.height, 1, VK_SAMPLE_COUNT_1_BIT, AccumulationFormat, VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, "LightAccumulation");
+	accumulation->imageView = engine->createImageView(accumulation->image, AccumulationFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+
+	std::array<VkImageView, 2> attachments = { accumulation->imageView, depthView };
+	VkFramebufferCreateInfo framebufferInfo = vkb::initializers::framebuffer_create_info();
+	framebufferInfo.renderPass = renderPass;
+	framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+	framebufferInfo.pAttachments = attachments.data();
+	framebufferInfo.width = extent.width;
+	framebufferInfo.height = extent.height;
+	framebufferInfo.layers = 1;
+	VK_CHECK_RESULT(vkCreateFramebuffer(*device, &framebufferInfo, nullptr, &framebuffer));
+
+	LOG(Log, "Light volumes : {}x{} accumulation, {} triangles per volume", extent.width, extent.height, sphere.indexBuffer.indices.size() / 3);
+}
+
+void LightVolumes::destroyTargets()
+{
+	if (framebuffer != VK_NULL_HANDLE)
+	{
+		vkDestroyFramebuffer(*device, framebuffer, nullptr);
+		framebuffer = VK_NULL_HANDLE;
+	}
+	accumulation.reset();
+}
+
+void LightVolumes::destroyDrawCommands()
+{
+	for (StorageBuffer& drawCommand : drawCommands)
+	{
+		drawCommand.Destroy(*device);
+	}
+	drawCommands.clear();
+}
+
+void LightVolumes::cleanup()
+{
+	if (!isInitialized())
+	{
+		return;
+	}
+
+	destroyTargets();
+	destroyDrawCommands();
+	sphere.Destroy(*device);
+	vkDestroyPipeline(*device, pipeline, nullptr);
+	vkDestroyPipelineLayout(*device, pipelineLayout, nullptr);
+	vkDestroyRenderPass(*device, renderPass, nullptr);
+	pipeline = VK_NULL_HANDLE;
+	pipelineLayout = VK_NULL_HANDLE;
+	renderPass = VK_NULL_HANDLE;
+}
+
+void LightVolumes::update(uint32_t imageIndex, uint32_t lightCount)
+{
+	VkDrawIndexedIndirectCommand& command = *static_cast<VkDrawIndexedIndirectCommand*>(drawCommands[imageIndex].mapped);
+	command.instanceCount = enabled ? lightCount : 0;
+	lastVolumeCount = command.instanceCount;
+}
+
+void LightVolumes::record(VkCommandBuffer commandBuffer, uint32_t imageIndex, VkDescriptorSet globalSet, VkDescriptorSet lightingSet, const ClusteredLighting& clusters,
+	const PointShadowAtlas& pointShadows, VkExtent2D renderExtent) const
+{
+	GPUMarker Marker(commandBuffer, "Light Volumes");
+
+	// 꺼져 있어도 패스는 기록한다. 인스턴스 수가 0 이면 누적 타겟을 지우기만 하므로 켜고 끌 때 다시 녹화하지 않아도 된다.
+	VkClearValue clearValue{};
+	clearValue.color = { { 0.f, 0.f, 0.f, 0.f } };
+	VkRenderPassBeginInfo renderPassInfo = vkb::initializers::render_pass_begin_info();
+	renderPassInfo.renderPass = renderPass;
+	renderPassInfo.framebuffer = framebuffer;
+	renderPassInfo.renderArea.offset = { 0, 0 };
+	renderPassInfo.renderArea.extent = renderExtent;
+	renderPassInfo.clearValueCount = 1;
+	renderPassInfo.pClearValues = &clearValue;
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+	VkViewport viewport = vkb::initializers::viewport(static_cast<float>(renderExtent.width), static_cast<float>(renderExtent.height), 0.f, 1.f);
+	VkRect2D scissor = vkb::initializers::rect2D(renderExtent.width, renderExtent.height, 0, 0);
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	std::array<VkDescriptorSet, 2> sets = { globalSet, lightingSet };
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, static_cast<uint32_t>(sets.size()), sets.data(), 0, nullptr);
+	clusters.bind(commandBuffer, pipelineLayout, 2, imageIndex);
+	pointShadows.bind(commandBuffer, pipelineLayout, 3, imageIndex);
+
+	VolumePushConstants pushConstants{ volumeScale };
+	vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(VolumePushConstants), &pushConstants);
+
+	VkDeviceSize offset = 0;
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &sphere.vertexBuffer.Buffer, &offset);
+	vkCmdBindIndexBuffer(commandBuffer, sphere.indexBuffer.Buffer, 0, VK_INDEX_TYPE_UINT32);
+	vkCmdDrawIndexedIndirect(commandBuffer, drawCommands[imageIndex].Buffer, 0, 1, sizeof(VkDrawIndexedIndirectCommand));
+
+	vkCmdEndRenderPass(commandBuffer);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "vk_types.h"
+#include "Buffer.h"
+#include "Vertex.h"
+
+#include <vector>
+
+class VulkanTutorialExtension;
+class ClusteredLighting;
+class PointShadowAtlas;
+
+/**
+ * 포인트 라이트마다 감쇠 반지름 크기의 구를 그려 라이트가 닿는 픽셀만 계산한다.
+ *
+ * 라이팅 패스보다 먼저 따로 렌더 패스를 열어 HDR 누적 타겟에 라이트를 더한다. 구의 뒷면을 그리고 깊이 테스트를
+ * GREATER_OR_EQUAL 로 두어 구 뒷면보다 앞에 있는 표면만 남기고, 지오메트리 패스가 남긴 스텐실로 배경 픽셀을 건너뛴다.
+ * 구 앞에 있는 표면은 프래그먼트 셰이더가 반지름으로 거른다. 라이팅 패스(Pbr.frag)는 누적 타겟을 톤매핑 전에 더하고
+ * 방향광과 IBL 만 계산한다.
+ *
+ * 라이트는 ClusteredLighting 의 버퍼에서 인스턴스 번호로 읽는다. 인스턴스 수는 스왑체인 이미지마다 둔 간접 드로우
+ * 버퍼에 매 프레임 쓰므로, 라이트 수가 바뀌거나 모드를 켜고 꺼도 커맨드 버퍼를 다시 녹화하지 않는다.
+ */
+class LightVolumes
+{
+public:
+	static constexpr VkFormat AccumulationFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+	// 구 메시의 경도, 위도 분할 수
+	static constexpr uint32_t SphereSegments = 16;
+	static constexpr uint32_t SphereRings = 12;
+
+	static bool enabled;
+
+	// 렌더 패스, 파이프라인, 구 메시를 한번 만들고, 이미지 수가 바뀌면 간접 드로우 버퍼를 다시 만든다.
+	// setLayouts 는 전역 셋, 라이팅 패스 셋, 클러스터 셋, 포인트 그림자 셋 순서다.
+	void initialize(VulkanTutorialExtension* inEngine, VkPhysicalDevice physicalDevice, uint32_t imageCount, VkFormat depthFormat,
+		const std::vector<VkDescriptorSetLayout>& setLayouts);
+	// 화면 크기의 누적 타겟과 프레임버퍼. 깊이를 다시 만들면 다시 부른다.
+	void createTargets(VkExtent2D inExtent, VkImageView depthView);
+	void cleanup();
+
+	// preDrawFrame 에서 부른다. 꺼져 있으면 인스턴스 수를 0 으로 쓴다.
+	void update(uint32_t imageIndex, uint32_t lightCount);
+	// 누적 타겟을 지우고 라이트 볼륨을 그린다. 깊이가 읽기 전용 레이아웃일 때 렌더 패스 밖에서 부른다.
+	// renderExtent 는 이번 프레임 내부 해상도다. 타겟의 왼쪽 위 그만큼만 쓴다.
+	void record(VkCommandBuffer commandBuffer, uint32_t imageIndex, VkDescriptorSet globalSet, VkDescriptorSet lightingSet, const ClusteredLighting& clusters,
+		const PointShadowAtlas& pointShadows, VkExtent2D renderExtent) const;
+
+	std::shared_ptr<AllocatedImage> getAccumulation() const { return accumulation; }
+	uint32_t getLastVolumeCount() const { return lastVolumeCount; }
+	bool isInitialized() const { return pipeline != VK_NULL_HANDLE; }
+
+private:
+	void createRenderPass(VkFormat depthFormat);
+	void createPipeline(const std::vector<VkDescriptorSetLayout>& setLayouts);
+	void createSphere();
+	void destroyTargets();
+	void destroyDrawCommands();
+
+	VulkanTutorialExtension* engine = nullptr;
+	DevicePtr device;
+	VkPhysicalDeviceMemoryProperties memoryProperties{};
+
+	VkRenderPass renderPass = VK_NULL_HANDLE;
+	VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	// 단위 구에 내접하는 다면체라 면이 구 안으로 들어온다. 반지름 구를 감싸도록 이만큼 키운다.
+	float volumeScale = 1.f;
+	GPUMeshBuffers<VertexOnlyPos> sphere{};
+
+	VkExtent2D extent{};
+	std::shared_ptr<AllocatedImage> accumulation;
+	VkFramebuffer framebuffer = VK_NULL_HANDLE;
+
+	// 스왑체인 이미지마다 VkDrawIndexedIndirectCommand 하나
+	std::vector<StorageBuffer> drawCommands;
+	uint32_t lastVolumeCount = 0;
+};
@@ -0,0 +1,143 @@
+#include "MeshDefragmenter.h"
+#include "VulkanTutorialExtension.h"
+#include "GPUResourcePools.h"
+#include "DeferredDeletionQueue.h"
+#include "GPUMarker.h"
+
+int MeshDefragmenter::budgetKBPerFrame = 4 * 1024;
+
+void MeshDefragmenter::initialize(VulkanTutorialExtension* inEngine)
+{
+	engine = inEngine;
+}
+
+// 이전 버퍼는 DeferredDeletionQueue 가 지우므로 flushAll 이 메시 힙 정리보다 먼저 불려야 한다.
+void MeshDefragmenter::cleanup()
+{
+	state = State::Idle;
+}
+
+void MeshDefragmenter::requestDefragment()
+{
+	startFrame = frame + IdleFramesBeforeStart;
+	if (state == State::Idle)
+	{
+		state = State::WaitingForIdleFrames;
+	}
+}
+
+void MeshDefragmenter::update()
+{
+	frame++;
+
+	if (state == State::WaitingForIdleFrames && frame >= startFrame)
+	{
+		reportBefore = engine->meshMemoryHeap.report();
+		movedBytesTotal = 0;
+		LOG(Display, "Mesh memory defragment start : {}", reportBefore.toString());
+		state = State::Running;
+	}
+
+	// 조각 모음 도중에 다시 요청이 들어오면 유휴 프레임이 올 때까지 멈춘다.
+	if (state == State::Running && frame >= startFrame)
+	{
+		if (!step() && retiredBufferCount == 0)
+		{
+			finish();
+		}
+	}
+}
+
+bool MeshDefragmenter::planMove(VkBuffer& buffer, MeshAllocation& allocation, VkBufferUsageFlags usage, VkDeviceSize& budget, std::vector<PendingMove>& outMoves)
+{
+	if (!allocation.isValid())
+	{
+		return false;
+	}
+
+	// 버퍼 하나가 예산보다 커도 멈추지 않도록 프레임당 최소 하나는 옮긴다.
+	if (!outMoves.empty() && allocation.size > budget)
+	{
+		return false;
+	}
+
+	MeshAllocation newAllocation;
+	VkBuffer newBuffer = engine->createMeshHeapBuffer(allocation.bufferSize, usage, newAllocation, &allocation);
+	if (newBuffer == VK_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	outMoves.push_back({ &buffer, &allocation, newBuffer, newAllocation });
+	budget = budget > allocation.size ? budget - allocation.size : 0;
+	return true;
+}
+
+bool MeshDefragmenter::step()
+{
+	VkDeviceSize budget = static_cast<VkDeviceSize>(budgetKBPerFrame) * 1024;
+	std::vector<PendingMove> moves;
+
+	const VkBufferUsageFlags vertexUsage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	const VkBufferUsageFlags indexUsage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+	// NOTE : 이 함수 안에서는 풀에 생성/삭제가 없으므로 MeshAsset 포인터를 잠시 들고 있어도 된다.
+	GPUResourcePools::get().meshes.forEach([&](MeshAsset<Vertex>& mesh) {
+		if (budget == 0)
+		{
+			return;
+		}
+		planMove(mesh.meshBuffers.vertexBuffer.Buffer, mesh.vertexAllocation, vertexUsage, budget, moves);
+		planMove(mesh.meshBuffers.indexBuffer.Buffer, mesh.indexAllocation, indexUsage, budget, moves);
+		planMove(mesh.positionBuffer, mesh.positionAllocation, vertexUsage, budget, moves);
+	});
+
+	if (moves.empty())
+	{
+		return false;
+	}
+
+	VkCommandBuffer commandBuffer = engine->beginSingleTimeCommands();
+	{
+		GPUMarker Marker(commandBuffer, "MeshDefragment");
+		for (const PendingMove& move : moves)
+		{
+			VkBufferCopy copyRegion{};
+			copyRegion.size = move.targetAllocation->bufferSize;
+			vkCmdCopyBuffer(commandBuffer, *move.target, move.newBuffer, 1, &copyRegion);
+		}
+	}
+	engine->endSingleTimeCommands(commandBuffer);
+
+	// 이전 버퍼는 아직 기록된 커맨드 버퍼가 참조하고 있으므로 바로 지우지 않는다.
+	for (const PendingMove& move : moves)
+	{
+		const VkBuffer oldBuffer = *move.target;
+		const MeshAllocation oldAllocation = *move.targetAllocation;
+		retiredBufferCount++;
+		DeferredDeletionQueue::get().pushCallback([this, oldBuffer, oldAllocation]() {
+			vkDestroyBuffer(engine->getDevice(), oldBuffer, nullptr);
+			engine->meshMemoryHeap.free(oldAllocation);
+			retiredBufferCount--;
+		}, oldAllocation.size);
+		movedBytesTotal += move.targetAllocation->size;
+
+		*move.target = move.newBuffer;
+		*move.targetAllocation = move.newAllocation;
+	}
+
+	// RenderObject 는 매 프레임 MeshAsset 에서 다시 만들어지므로 커맨드 버퍼만 새로 기록하면 된다.
+	engine->markCommandBufferRecreation();
+	return true;
+}
+
+void MeshDefragmenter::finish()
+{
+	uint32_t releasedBlocks = engine->meshMemoryHeap.releaseEmptyBlocks();
+	reportAfter = engine->meshMemoryHeap.report();
+	state = State::Idle;
+
+	LOG(Display, "Mesh memory defragment done : moved {} KB, released {} blocks", movedBytesTotal / 1024, releasedBlocks);
+	LOG(Display, "  before : {}", reportBefore.toString());
+	LOG(Display, "  after  : {}", reportAfter.toString());
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "vk_types.h"
+#include "MeshMemoryHeap.h"
+
+class VulkanTutorialExtension;
+
+/**
+ * 모델 언로드로 MeshMemoryHeap 에 생긴 구멍을 메우는 점진적 조각 모음.
+ * 요청 후 씬이 일정 프레임 동안 바뀌지 않으면(유휴 프레임) 시작하고,
+ * 매 프레임 budgetKBPerFrame 만큼만 live 버퍼를 낮은 위치로 GPU 복사한다.
+ * MeshAsset 의 버퍼를 교체한 뒤 커맨드 버퍼를 다시 기록하게 하고, 이전 버퍼는 DeferredDeletionQueue 로 펜스가 끝난 뒤 해제한다.
+ */
+class MeshDefragmenter
+{
+public:
+	static int budgetKBPerFrame;
+
+	void initialize(VulkanTutorialExtension* inEngine);
+	void cleanup();
+
+	// 언로드 등으로 씬이 바뀔 때마다 호출한다. 호출할 때마다 시작 시점이 뒤로 밀린다.
+	void requestDefragment();
+	void update();
+
+	bool isRunning() const { return state != State::Idle; }
+	const FragmentationReport& getReportBefore() const { return reportBefore; }
+	const FragmentationReport& getReportAfter() const { return reportAfter; }
+	VkDeviceSize getMovedBytesTotal() const { return movedBytesTotal; }
+
+private:
+	enum class State
+	{
+		Idle,
+		WaitingForIdleFrames,
+		Running
+	};
+
+	struct PendingMove
+	{
+		VkBuffer* target;			// MeshAsset 안의 버퍼 핸들
+		MeshAllocation* targetAllocation;
+		VkBuffer newBuffer;
+		MeshAllocation newAllocation;
+	};
+
+	bool planMove(VkBuffer& buffer, MeshAllocation& allocation, VkBufferUsageFlags usage, VkDeviceSize& budget, std::vector<PendingMove>& outMoves);
+	bool step();
+	void finish();
+
+	static constexpr uint64_t IdleFramesBeforeStart = 30;
+
+	VulkanTutorialExtension* engine = nullptr;
+	State state = State::Idle;
+	uint64_t frame = 0;
+	uint64_t startFrame = 0;
+	VkDeviceSize movedBytesTotal = 0;
+
+	FragmentationReport reportBefore;
+	FragmentationReport reportAfter;
+
+	// DeferredDeletionQueue 에 넣었지만 아직 해제되지 않은 이전 버퍼 수. 모두 해제돼야 빈 블록을 반환할 수 있다.
+	uint32_t retiredBufferCount = 0;
+};
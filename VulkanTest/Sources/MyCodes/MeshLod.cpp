@@ -0,0 +1,493 @@
+#include "MeshLod.h"
+#include "Vk_loader.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+bool MeshLod::generateOnLoad = true;
+
+bool MeshLodSelector::enabled = true;
+float MeshLodSelector::pixelError = 1.f;
+float MeshLodSelector::hysteresis = 0.25f;
+
+namespace
+{
+	// 삼각형이 이보다 적은 서피스는 LOD 를 만들지 않는다.
+	constexpr size_t MinSourceTriangles = 64;
+	// LOD 하나의 최소 삼각형 수
+	constexpr size_t MinLodTriangles = 16;
+	// 앞 LOD 보다 이 비율 이상 남으면 더 만들지 않는다.
+	constexpr float MinReduction = 0.85f;
+	// 경계 구 반지름에 대한 누적 오차 상한
+	constexpr float MaxRelativeError = 0.25f;
+	// 한 번 simplify 안에서 도는 최대 횟수. 한 번에 서로 겹치지 않는 모서리만 합친다.
+	constexpr uint32_t MaxPasses = 32;
+
+	constexpr uint32_t PruneInterval = 256;
+
+	// 대칭 4x4 행렬의 위쪽 삼각형과 누적 가중치(면적)
+	struct Quadric
+	{
+		double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+		double a11 = 0, a12 = 0, a13 = 0;
+		double a22 = 0, a23 = 0;
+		double a33 = 0;
+		double weight = 0;
+
+		Quadric& operator+=(const Quadric& other)
+		{
+			a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+			a11 += other.a11; a12 += other.a12; a13 += other.a13;
+			a22 += other.a22; a23 += other.a23;
+			a33 += other.a33;
+			weight += other.weight;
+			return *this;
+		}
+	};
+
+	// 평면 n.p + d = 0 까지 거리의 제곱에 weight 를 곱한 quadric
+	Quadric makePlaneQuadric(const glm::dvec3& n, double d, double weight)
+	{
+		Quadric q;
+		q.a00 = weight * n.x * n.x; q.a01 = weight * n.x * n.y; q.a02 = weight * n.x * n.z; q.a03 = weight * n.x * d;
+		q.a11 = weight * n.y * n.y; q.a12 = weight * n.y * n.z; q.a13 = weight * n.y * d;
+		q.a22 = weight * n.z * n.z; q.a23 = weight * n.z * d;
+		q.a33 = weight * d * d;
+		q.weight = weight;
+		return q;
+	}
+
+	// 가중 평균한 거리 제곱
+	double evaluate(const Quadric& q, const glm::vec3& position)
+	{
+		if (q.weight <= 0.0)
+		{
+			return 0.0;
+		}
+
+		const double x = position.x, y = position.y, z = position.z;
+		const double error =
+			x * x * q.a00 + 2.0 * x * y * q.a01 + 2.0 * x * z * q.a02 + 2.0 * x * q.a03 +
+			y * y * q.a11 + 2.0 * y * z * q.a12 + 2.0 * y * q.a13 +
+			z * z * q.a22 + 2.0 * z * q.a23 +
+			q.a33;
+		return std::max(error, 0.0) / q.weight;
+	}
+
+	struct PositionHash
+	{
+		size_t operator()(const glm::vec3& p) const
+		{
+			uint32_t bits[3];
+			std::memcpy(bits, &p, sizeof(bits));
+			return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+		}
+	};
+
+	struct Collapse
+	{
+		uint32_t from;
+		uint32_t to;
+		double cost;
+	};
+}
+
+namespace MeshLod
+{
+	size_t simplify(const std::vector<Vertex>& vertices, uint32_t* indices, size_t indexCount, size_t targetIndexCount, float maxError, float& outError)
+	{
+		outError = 0.f;
+		if (indexCount <= targetIndexCount || indexCount < 3)
+		{
+			return indexCount;
+		}
+
+		// 서피스가 쓰는 정점 구간만 로컬 번호로 다룬다.
+		const auto [minIt, maxIt] = std::minmax_element(indices, indices + indexCount);
+		const uint32_t firstVertex = *minIt;
+		const uint32_t vertexCount = *maxIt - firstVertex + 1;
+		auto position = [&](uint32_t v) -> const glm::vec3& { return vertices[firstVertex + v].pos; };
+
+		std::vector<uint32_t> local(indices, indices + indexCount);
+		for (uint32_t& index : local)
+		{
+			index -= firstVertex;
+		}
+
+		// 이음매 : 같은 위치에 정점이 여럿이면 UV 나 노멀이 갈라진 곳이다.
+		std::vector<uint8_t> locked(vertexCount, 0);
+		{
+			std::vector<uint8_t> used(vertexCount, 0);
+			for (uint32_t index : local)
+			{
+				used[index] = 1;
+			}
+
+			std::unordered_map<glm::vec3, uint32_t, PositionHash> groupByPosition;
+			std::vector<uint32_t> groupSizes;
+			std::vector<uint32_t> groups(vertexCount, 0);
+			for (uint32_t v = 0; v < vertexCount; v++)
+			{
+				if (!used[v])
+				{
+					continue;
+				}
+				const auto [it, inserted] = groupByPosition.try_emplace(position(v), static_cast<uint32_t>(groupSizes.size()));
+				if (inserted)
+				{
+					groupSizes.push_back(0);
+				}
+				groups[v] = it->second;
+				groupSizes[it->second]++;
+			}
+			for (uint32_t v = 0; v < vertexCount; v++)
+			{
+				locked[v] = used[v] && groupSizes[groups[v]] > 1;
+			}
+		}
+
+		// 경계 : 인덱스 공간에서 삼각형 하나만 쓰는 모서리. 이음매 양쪽도 인덱스가 달라 여기에 걸린다.
+		{
+			std::vector<uint64_t> edges;
+			edges.reserve(local.size());
+			for (size_t i = 0; i < local.size(); i += 3)
+			{
+				for (uint32_t e = 0; e < 3; e++)
+				{
+					const uint32_t a = local[i + e];
+					const uint32_t b = local[i + (e + 1) % 3];
+					edges.push_back((uint64_t(std::min(a, b)) << 32) | std::max(a, b));
+				}
+			}
+			std::sort(edges.begin(), edges.end());
+
+			for (size_t i = 0; i < edges.size();)
+			{
+				size_t end = i + 1;
+				while (end < edges.size() && edges[end] == edges[i])
+				{
+					end++;
+				}
+				if (end - i == 1)
+				{
+					locked[uint32_t(edges[i] >> 32)] = 1;
+					locked[uint32_t(edges[i])] = 1;
+				}
+				i = end;
+			}
+		}
+
+		std::vector<Quadric> quadrics(vertexCount);
+		for (size_t i = 0; i < local.size(); i += 3)
+		{
+			const glm::dvec3 p0 = position(local[i]);
+			const glm::dvec3 p1 = position(local[i + 1]);
+			const glm::dvec3 p2 = position(local[i + 2]);
+			glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+			const double length = glm::length(normal);
+			if (length <= 0.0)
+			{
+				continue;
+			}
+			normal /= length;
+
+			const Quadric plane = makePlaneQuadric(normal, -glm::dot(normal, p0), length * 0.5);
+			quadrics[local[i]] += plane;
+			quadrics[local[i + 1]] += plane;
+			quadrics[local[i + 2]] += plane;
+		}
+
+		// 합친 정점이 옮겨 가도 삼각형이 뒤집히지 않는지 본다. to 를 포함한 삼각형은 없어지므로 건너뛴다.
+		std::vector<uint32_t> triangleOffsets(vertexCount + 1);
+		std::vector<uint32_t> vertexTriangles;
+		auto flips = [&](uint32_t from, uint32_t to)
+		{
+			const glm::vec3& target = position(to);
+			for (uint32_t t = triangleOffsets[from]; t < triangleOffsets[from + 1]; t++)
+			{
+				const uint32_t* triangle = &local[vertexTriangles[t] * 3];
+				if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+				{
+					continue;
+				}
+
+				glm::vec3 before[3], after[3];
+				for (uint32_t k = 0; k < 3; k++)
+				{
+					before[k] = position(triangle[k]);
+					after[k] = triangle[k] == from ? target : before[k];
+				}
+				const glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+				const glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+				if (glm::dot(normalBefore, normalAfter) <= 0.f)
+				{
+					return true;
+				}
+			}
+			return false;
+		};
+
+		const double maxCost = double(maxError) * double(maxError);
+		double worstCost = 0.0;
+
+		std::vector<Collapse> candidates;
+		std::vector<uint32_t> remap(vertexCount);
+		std::vector<uint8_t> touched(vertexCount);
+
+		for (uint32_t pass = 0; pass < MaxPasses && local.size() > targetIndexCount; pass++)
+		{
+			const uint32_t triangleCount = static_cast<uint32_t>(local.size() / 3);
+
+			std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+			for (uint32_t index : local)
+			{
+				triangleOffsets[index + 1]++;
+			}
+			std::partial_sum(triangleOffsets.begin(), triangleOffsets.end(), triangleOffsets.begin());
+			vertexTriangles.resize(local.size());
+			{
+				std::vector<uint32_t> cursor(triangleOffsets.begin(), triangleOffsets.end() - 1);
+				for (uint32_t t = 0; t < triangleCount; t++)
+				{
+					for (uint32_t k = 0; k < 3; k++)
+					{
+						vertexTriangles[cursor[local[t * 3 + k]]++] = t;
+					}
+				}
+			}
+
+			// 모서리는 양쪽 삼각형에서 반대 방향으로 한 번씩 나오므로 a < b 인 쪽만 본다.
+			candidates.clear();
+			for (uint32_t t = 0; t < triangleCount; t++)
+			{
+				for (uint32_t e = 0; e < 3; e++)
+				{
+					const uint32_t a = local[t * 3 + e];
+					const uint32_t b = local[t * 3 + (e + 1) % 3];
+					if (a >= b || (locked[a] && locked[b]))
+					{
+						continue;
+					}
+
+					const double costAB = locked[a] ? DBL_MAX : evaluate(quadrics[a], position(b));
+					const double costBA = locked[b] ? DBL_MAX : evaluate(quadrics[b], position(a));
+					candidates.push_back(costAB <= costBA ? Collapse{ a, b, costAB } : Collapse{ b, a, costBA });
+				}
+			}
+			if (candidates.empty())
+			{
+				break;
+			}
+			std::sort(candidates.begin(), candidates.end(), [](const Collapse& lhs, const Collapse& rhs) { return lhs.cost < rhs.cost; });
+
+			std::iota(remap.begin(), remap.end(), 0);
+			std::fill(touched.begin(), touched.end(), 0);
+
+			const size_t trianglesToRemove = (local.size() - targetIndexCount + 2) / 3;
+			size_t removed = 0;
+			uint32_t collapses = 0;
+			for (const Collapse& collapse : candidates)
+			{
+				if (collapse.cost > maxCost || removed >= trianglesToRemove)
+				{
+					break;
+				}
+				if (touched[collapse.from] || touched[collapse.to] || flips(collapse.from, collapse.to))
+				{
+					continue;
+				}
+
+				// from 의 이웃은 이번에 건드리지 않아야 뒤집힘 검사가 틀리지 않는다.
+				for (uint32_t t = triangleOffsets[collapse.from]; t < triangleOffsets[collapse.from + 1]; t++)
+				{
+					const uint32_t* triangle = &local[vertexTriangles[t] * 3];
+					removed += (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to) ? 1 : 0;
+					touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = 1;
+				}
+
+				remap[collapse.from] = collapse.to;
+				quadrics[collapse.to] += quadrics[collapse.from];
+				worstCost = std::max(worstCost, collapse.cost);
+				collapses++;
+			}
+			if (collapses == 0)
+			{
+				break;
+			}
+
+			// 합쳐서 넓이가 없어진 삼각형을 뺀다.
+			size_t write = 0;
+			for (size_t i = 0; i < local.size(); i += 3)
+			{
+				const uint32_t a = remap[local[i]];
+				const uint32_t b = remap[local[i + 1]];
+				const uint32_t c = remap[local[i + 2]];
+				if (a == b || b == c || a == c)
+				{
+					continue;
+				}
+				local[write++] = a;
+				local[write++] = b;
+				local[write++] = c;
+			}
+			local.resize(write);
+		}
+
+		for (size_t i = 0; i < local.size(); i++)
+		{
+			indices[i] = local[i] + firstVertex;
+		}
+		outError = static_cast<float>(std::sqrt(worstCost));
+		return local.size();
+	}
+
+	void generateLods(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, GeoSurface& surface)
+	{
+		surface.lods.clear();
+
+		const float radius = surface.bounds.sphereRadius;
+		if (surface.count / 3 < MinSourceTriangles || radius <= 0.f)
+		{
+			return;
+		}
+
+		surface.lods.push_back({ surface.startIndex, surface.count, 0.f });
+
+		std::vector<uint32_t> lodIndices(indices.begin() + surface.startIndex, indices.begin() + surface.startIndex + surface.count);
+		float accumulatedError = 0.f;
+		while (surface.lods.size() < MaxLevels)
+		{
+			const size_t previousCount = lodIndices.size();
+			const size_t targetCount = previousCount / 6 * 3;
+			const float remainingError = MaxRelativeError * radius - accumulatedError;
+			if (targetCount < MinLodTriangles * 3 || remainingError <= 0.f)
+			{
+				break;
+			}
+
+			float error = 0.f;
+			const size_t count = simplify(vertices, lodIndices.data(), lodIndices.size(), targetCount, remainingError, error);
+			// 이음매가 많아 거의 줄지 않으면 LOD 를 늘려 봐야 메모리만 쓴다.
+			if (count == 0 || count > previousCount * MinReduction)
+			{
+				break;
+			}
+
+			// 앞 LOD 를 줄인 것이라 원본에 대한 오차는 더해서 어림한다.
+			lodIndices.resize(count);
+			accumulatedError += error;
+			surface.lods.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(count), accumulatedError / radius });
+			indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+		}
+
+		// 원본만 남았으면 LOD 가 없는 것과 같다.
+		if (surface.lods.size() == 1)
+		{
+			surface.lods.clear();
+		}
+	}
+
+	uint64_t makeSelectionKey(uint32_t instance, const void* node, uint32_t surface)
+	{
+		uint64_t key = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(node)) * 0x9E3779B97F4A7C15ull;
+		key ^= (static_cast<uint64_t>(instance) << 32 | surface) + 0x632BE59BD9B4E019ull + (key << 6) + (key >> 2);
+		// 0 은 상태를 기억하지 않는다는 뜻이므로 피한다.
+		return key | 1;
+	}
+}
+
+void MeshLodSelector::beginFrame(const glm::vec3& inCameraPosition, float viewportHeight, float verticalFov)
+{
+	cameraPosition = inCameraPosition;
+	pixelsPerUnit = viewportHeight / (2.f * std::tan(verticalFov * 0.5f));
+	stats = {};
+	frame++;
+
+	// 모델을 내렸거나 한동안 그리지 않은 서피스는 다음에 처음부터 다시 고른다.
+	if (frame % PruneInterval == 0)
+	{
+		for (auto it = states.begin(); it != states.end();)
+		{
+			it = frame - it->second.lastFrame > PruneInterval ? states.erase(it) : std::next(it);
+		}
+	}
+}
+
+float MeshLodSelector::screenError(const SurfaceLod& lod, float projectedRadius) const
+{
+	return lod.error > 0.f ? lod.error * projectedRadius : 0.f;
+}
+
+const SurfaceLod* MeshLodSelector::select(uint64_t key, const GeoSurface& surface, const glm::mat4& transform)
+{
+	const uint32_t sourceTriangles = surface.count / 3;
+	stats.sourceTriangles += sourceTriangles;
+	if (surface.lods.empty())
+	{
+		stats.draws[0]++;
+		stats.triangles[0] += sourceTriangles;
+		stats.selectedTriangles += sourceTriangles;
+		return nullptr;
+	}
+
+	// 경계 구를 월드로 옮긴다. 축마다 스케일이 다르면 가장 큰 것을 쓴다.
+	const glm::vec3 center = glm::vec3(transform * glm::vec4(surface.bounds.origin, 1.f));
+	const float scale = std::max({ glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2])) });
+	const float radius = surface.bounds.sphereRadius * scale;
+	// 구의 가장 가까운 점까지 거리로 보고, 카메라가 구 안에 있으면 가장 고운 LOD 를 쓴다.
+	const float distance = glm::length(center - cameraPosition) - radius;
+	const float projectedRadius = distance > 0.f ? radius / distance * pixelsPerUnit : FLT_MAX;
+
+	const uint32_t levelCount = static_cast<uint32_t>(surface.lods.size());
+	State* state = nullptr;
+	bool hasPrevious = false;
+	if (key != 0)
+	{
+		const auto [it, inserted] = states.try_emplace(key);
+		state = &it->second;
+		hasPrevious = !inserted;
+	}
+
+	uint32_t level = 0;
+	if (!hasPrevious)
+	{
+		while (level + 1 < levelCount && screenError(surface.lods[level + 1], projectedRadius) <= pixelError)
+		{
+			level++;
+		}
+	}
+	else
+	{
+		level = std::min(state->level, levelCount - 1);
+		if (screenError(surface.lods[level], projectedRadius) > pixelError)
+		{
+			while (level > 0 && screenError(surface.lods[level], projectedRadius) > pixelError)
+			{
+				level--;
+			}
+		}
+		else
+		{
+			const float coarserLimit = pixelError * (1.f - hysteresis);
+			while (level + 1 < levelCount && screenError(surface.lods[level + 1], projectedRadius) <= coarserLimit)
+			{
+				level++;
+			}
+		}
+	}
+
+	if (state)
+	{
+		state->level = level;
+		state->lastFrame = frame;
+	}
+
+	const uint32_t selectedTriangles = surface.lods[level].count / 3;
+	stats.draws[level]++;
+	stats.triangles[level] += selectedTriangles;
+	stats.selectedTriangles += selectedTriangles;
+	return &surface.lods[level];
+}
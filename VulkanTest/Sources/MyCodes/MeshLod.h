@@ -0,0 +1,86 @@
+#pragma once
+
+#include "vk_types.h"
+#include "Vertex.h"
+
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+struct GeoSurface;
+struct SurfaceLod;
+
+/**
+ * 서피스마다 LOD 인덱스를 만든다.
+ *
+ * 정점은 새로 만들지 않고 한 정점을 이웃 정점으로 합치는 half-edge collapse 만 하므로 LOD 가 원본 정점 버퍼를 같이 쓴다.
+ * 비용은 면적 가중 평면 quadric 이다. 인덱스 공간에서 삼각형 하나만 쓰는 모서리(UV/노멀 이음매, 열린 경계)의 정점과
+ * 같은 위치에 정점이 여럿인 이음매 정점은 잠가서 움직이지 않는다. 이음매가 많은 메시는 덜 줄어든다.
+ */
+namespace MeshLod
+{
+	// 원본 포함 최대 LOD 수
+	constexpr uint32_t MaxLevels = 5;
+
+	// 로드할 때 LOD 를 만들지. 바꾸면 다음에 로드하는 모델부터 적용된다.
+	extern bool generateOnLoad;
+
+	// surface 의 인덱스를 단계마다 절반 가까이 줄여 indices 뒤에 붙이고 surface.lods 를 채운다.
+	// 더 줄지 않거나 오차가 너무 커지면 거기서 멈추므로 LOD 수는 서피스마다 다르다.
+	void generateLods(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, GeoSurface& surface);
+
+	// indices 를 targetIndexCount 이하로 줄이고 남은 인덱스 수를 반환한다. outError 는 합친 정점이 벗어난 최대 거리다.
+	size_t simplify(const std::vector<Vertex>& vertices, uint32_t* indices, size_t indexCount, size_t targetIndexCount, float maxError, float& outError);
+
+	// 인스턴스 안의 노드 서피스 하나를 가리키는 키. MeshLodSelector 가 지난 프레임 LOD 를 찾는 데 쓴다.
+	uint64_t makeSelectionKey(uint32_t instance, const void* node, uint32_t surface);
+}
+
+/**
+ * 화면에 투영한 크기로 서피스 LOD 를 고른다.
+ *
+ * LOD 오차(경계 구 반지름에 대한 비율)에 경계 구의 투영 반지름(픽셀)을 곱해 화면 오차를 구하고,
+ * 화면 오차가 pixelError 를 넘지 않는 가장 거친 LOD 를 쓴다.
+ * 경계에서 LOD 가 매 프레임 바뀌지 않도록 거친 쪽으로 갈 때만 pixelError * (1 - hysteresis) 로 더 엄격하게 본다.
+ */
+class MeshLodSelector
+{
+public:
+	static bool enabled;
+	static float pixelError;
+	static float hysteresis;
+
+	struct Stats
+	{
+		std::array<uint32_t, MeshLod::MaxLevels> draws{};
+		std::array<uint64_t, MeshLod::MaxLevels> triangles{};
+		// 모두 LOD 0 으로 그렸을 때의 삼각형 수
+		uint64_t sourceTriangles = 0;
+		uint64_t selectedTriangles = 0;
+	};
+
+	// 이번 프레임 카메라로 바꾸고 통계를 0 으로 되돌린다. 오래 고르지 않은 서피스의 상태는 가끔 지운다.
+	void beginFrame(const glm::vec3& cameraPosition, float viewportHeight, float verticalFov);
+	// LOD 가 없거나 key 가 0 이면 지난 LOD 를 기억하지 않는다.
+	const SurfaceLod* select(uint64_t key, const GeoSurface& surface, const glm::mat4& transform);
+
+	const Stats& getStats() const { return stats; }
+
+private:
+	struct State
+	{
+		uint32_t level = 0;
+		uint32_t lastFrame = 0;
+	};
+
+	float screenError(const SurfaceLod& lod, float projectedRadius) const;
+
+	std::unordered_map<uint64_t, State> states;
+	uint32_t frame = 0;
+
+	glm::vec3 cameraPosition = glm::vec3(0.f);
+	// 거리 1 에서 월드 단위 1 이 차지하는 픽셀 수
+	float pixelsPerUnit = 1.f;
+
+	Stats stats;
+};
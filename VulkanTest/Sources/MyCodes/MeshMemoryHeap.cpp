@@ -0,0 +1,235 @@
+#include "MeshMemoryHeap.h"
+#include "VulkanTools.h"
+#include "vk_log.h"
+
+#include <cstdio>
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+	VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return alignment == 0 ? value : (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+int FragmentationReport::format(char* buffer, size_t size) const
+{
+	return std::snprintf(buffer, size, "blocks %u, reserved %llu KB, used %llu KB, free %llu KB in %u ranges, largest free %llu KB, fragmentation %d%%",
+		blockCount,
+		static_cast<unsigned long long>(reservedBytes / 1024),
+		static_cast<unsigned long long>(usedBytes / 1024),
+		static_cast<unsigned long long>(freeBytes / 1024), freeRangeCount,
+		static_cast<unsigned long long>(largestFreeRange / 1024),
+		static_cast<int>(fragmentation() * 100.f));
+}
+
+std::string FragmentationReport::toString() const
+{
+	char buffer[256];
+	format(buffer, sizeof(buffer));
+	return buffer;
+}
+
+void MeshMemoryHeap::initialize(DevicePtr inDevice, VkDeviceSize inBlockSize)
+{
+	device = inDevice;
+	blockSize = inBlockSize;
+}
+
+void MeshMemoryHeap::cleanup()
+{
+	for (Block& block : blocks)
+	{
+		if (block.memory != VK_NULL_HANDLE)
+		{
+			vkFreeMemory(*device, block.memory, nullptr);
+		}
+	}
+	blocks.clear();
+}
+
+MeshAllocation MeshMemoryHeap::allocate(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex)
+{
+	MeshAllocation allocation;
+	for (uint32_t i = 0; i < blocks.size(); i++)
+	{
+		if (blocks[i].memory != VK_NULL_HANDLE && blocks[i].memoryTypeIndex == memoryTypeIndex &&
+			tryAllocateInBlock(i, requirements, blocks[i].size, allocation))
+		{
+			return allocation;
+		}
+	}
+
+	uint32_t newBlock = createBlock(requirements.size, memoryTypeIndex);
+	if (!tryAllocateInBlock(newBlock, requirements, blocks[newBlock].size, allocation))
+	{
+		throw std::runtime_error("failed to sub-allocate mesh memory!");
+	}
+	return allocation;
+}
+
+MeshAllocation MeshMemoryHeap::allocateBelow(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, const MeshAllocation& current)
+{
+	MeshAllocation allocation;
+	for (uint32_t i = 0; i <= current.blockIndex && i < blocks.size(); i++)
+	{
+		if (blocks[i].memory == VK_NULL_HANDLE || blocks[i].memoryTypeIndex != memoryTypeIndex)
+		{
+			continue;
+		}
+
+		// 같은 블록이면 현재 구간과 겹치지 않는 앞쪽만 본다. (vkCmdCopyBuffer 는 겹치는 구간을 허용하지 않는다)
+		VkDeviceSize limit = (i == current.blockIndex) ? current.offset : blocks[i].size;
+		if (tryAllocateInBlock(i, requirements, limit, allocation))
+		{
+			return allocation;
+		}
+	}
+	return MeshAllocation{};
+}
+
+void MeshMemoryHeap::free(const MeshAllocation& allocation)
+{
+	if (!allocation.isValid())
+	{
+		return;
+	}
+
+	Block& block = blocks[allocation.blockIndex];
+	block.usedBytes -= allocation.size;
+
+	VkDeviceSize offset = allocation.offset;
+	VkDeviceSize size = allocation.size;
+
+	// 앞뒤로 붙어있는 빈 구간과 합친다.
+	auto next = block.freeRanges.lower_bound(offset);
+	if (next != block.freeRanges.begin())
+	{
+		auto prev = std::prev(next);
+		if (prev->first + prev->second == offset)
+		{
+			offset = prev->first;
+			size += prev->second;
+			block.freeRanges.erase(prev);
+		}
+	}
+	if (next != block.freeRanges.end() && offset + size == next->first)
+	{
+		size += next->second;
+		block.freeRanges.erase(next);
+	}
+
+	block.freeRanges[offset] = size;
+}
+
+uint32_t MeshMemoryHeap::releaseEmptyBlocks()
+{
+	uint32_t released = 0;
+	for (uint32_t i = 1; i < blocks.size(); i++)
+	{
+		Block& block = blocks[i];
+		if (block.memory != VK_NULL_HANDLE && block.usedBytes == 0)
+		{
+			vkFreeMemory(*device, block.memory, nullptr);
+			block = Block{};
+			released++;
+		}
+	}
+	return released;
+}
+
+FragmentationReport MeshMemoryHeap::report() const
+{
+	FragmentationReport result;
+	for (const Block& block : blocks)
+	{
+		if (block.memory == VK_NULL_HANDLE)
+		{
+			continue;
+		}
+
+		result.blockCount++;
+		result.reservedBytes += block.size;
+		result.usedBytes += block.usedBytes;
+		for (const auto& [offset, size] : block.freeRanges)
+		{
+			result.freeBytes += size;
+			result.freeRangeCount++;
+			result.largestFreeRange = std::max(result.largestFreeRange, size);
+		}
+	}
+	return result;
+}
+
+bool MeshMemoryHeap::tryAllocateInBlock(uint32_t blockIndex, const VkMemoryRequirements& requirements, VkDeviceSize limitOffset, MeshAllocation& outAllocation)
+{
+	Block& block = blocks[blockIndex];
+
+	// 낮은 오프셋부터 first-fit 으로 찾는다. 앞쪽부터 채워야 뒤쪽 블록이 비워진다.
+	for (auto it = block.freeRanges.begin(); it != block.freeRanges.end(); ++it)
+	{
+		const VkDeviceSize rangeBegin = it->first;
+		const VkDeviceSize rangeEnd = it->first + it->second;
+		const VkDeviceSize alignedOffset = alignUp(rangeBegin, requirements.alignment);
+		const VkDeviceSize allocationEnd = alignedOffset + requirements.size;
+
+		if (allocationEnd > limitOffset)
+		{
+			return false;
+		}
+
+		if (allocationEnd > rangeEnd)
+		{
+			continue;
+		}
+
+		block.freeRanges.erase(it);
+		if (alignedOffset > rangeBegin)
+		{
+			block.freeRanges[rangeBegin] = alignedOffset - rangeBegin;
+		}
+		if (rangeEnd > allocationEnd)
+		{
+			block.freeRanges[allocationEnd] = rangeEnd - allocationEnd;
+		}
+
+		block.usedBytes += requirements.size;
+
+		outAllocation.blockIndex = blockIndex;
+		outAllocation.offset = alignedOffset;
+		outAllocation.size = requirements.size;
+		return true;
+	}
+	return false;
+}
+
+uint32_t MeshMemoryHeap::createBlock(VkDeviceSize minSize, uint32_t memoryTypeIndex)
+{
+	Block block;
+	block.size = std::max(blockSize, minSize);
+	block.memoryTypeIndex = memoryTypeIndex;
+	block.freeRanges[0] = block.size;
+
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = block.size;
+	allocInfo.memoryTypeIndex = memoryTypeIndex;
+	VK_CHECK_RESULT(vkAllocateMemory(*device, &allocInfo, nullptr, &block.memory));
+
+	LOG(Display, "MeshMemoryHeap : new block {} KB (memory type {})", block.size / 1024, memoryTypeIndex);
+
+	// 해제된 블록 자리가 있으면 재사용해서 기존 MeshAllocation 의 blockIndex 가 바뀌지 않게 한다.
+	for (uint32_t i = 0; i < blocks.size(); i++)
+	{
+		if (blocks[i].memory == VK_NULL_HANDLE)
+		{
+			blocks[i] = std::move(block);
+			return i;
+		}
+	}
+
+	blocks.push_back(std::move(block));
+	return static_cast<uint32_t>(blocks.size() - 1);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "vk_types.h"
+
+#include <map>
+#include <string>
+
+/**
+ * 힙 안에서 버퍼 하나가 차지하는 구간.
+ */
+struct MeshAllocation
+{
+	static constexpr uint32_t InvalidBlock = UINT32_MAX;
+
+	uint32_t blockIndex = InvalidBlock;
+	VkDeviceSize offset = 0;
+	VkDeviceSize size = 0;			// 메모리 요구사항 기준 크기
+	VkDeviceSize bufferSize = 0;	// 버퍼를 만들 때 요청한 크기. 옮길 때 복사 크기로 쓴다.
+
+	bool isValid() const { return blockIndex != InvalidBlock; }
+};
+
+struct FragmentationReport
+{
+	uint32_t blockCount = 0;
+	VkDeviceSize reservedBytes = 0;
+	VkDeviceSize usedBytes = 0;
+	VkDeviceSize freeBytes = 0;
+	VkDeviceSize largestFreeRange = 0;
+	uint32_t freeRangeCount = 0;
+
+	// 0 이면 빈 공간이 한 덩어리, 1 에 가까울수록 잘게 쪼개져 있다.
+	float fragmentation() const
+	{
+		return freeBytes == 0 ? 0.f : 1.f - static_cast<float>(largestFreeRange) / static_cast<float>(freeBytes);
+	}
+
+	// 버퍼에 써넣는다. 매 프레임 UI 에서 부를 때 임시 문자열을 만들지 않기 위함.
+	int format(char* buffer, size_t size) const;
+	std::string toString() const;
+};
+
+/**
+ * glTF 메시의 정점/인덱스 버퍼를 큰 VkDeviceMemory 블록에서 나눠주는 힙.
+ * 리소스마다 vkAllocateMemory 를 하지 않으므로 모델을 여러번 로드/언로드해도 드라이버 할당 개수가 늘지 않는다.
+ * 대신 블록 안에 구멍이 생기므로 MeshDefragmenter 가 live 버퍼를 앞쪽으로 옮겨 메운다.
+ */
+class MeshMemoryHeap
+{
+public:
+	static constexpr VkDeviceSize DefaultBlockSize = 64ull * 1024 * 1024;
+
+	void initialize(DevicePtr inDevice, VkDeviceSize inBlockSize = DefaultBlockSize);
+	void cleanup();
+
+	MeshAllocation allocate(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex);
+	// current 보다 낮은 위치에 들어갈 자리가 있을 때만 할당한다. 없으면 invalid 를 반환한다.
+	MeshAllocation allocateBelow(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, const MeshAllocation& current);
+	void free(const MeshAllocation& allocation);
+
+	// 비어있는 블록을 드라이버에 돌려준다. 첫 블록은 다음 로드를 위해 남겨둔다.
+	uint32_t releaseEmptyBlocks();
+
+	VkDeviceMemory getMemory(const MeshAllocation& allocation) const { return blocks[allocation.blockIndex].memory; }
+	uint32_t getMemoryTypeIndex(const MeshAllocation& allocation) const { return blocks[allocation.blockIndex].memoryTypeIndex; }
+
+	FragmentationReport report() const;
+
+private:
+	struct Block
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize size = 0;
+		uint32_t memoryTypeIndex = 0;
+		VkDeviceSize usedBytes = 0;
+		std::map<VkDeviceSize /* offset */, VkDeviceSize /* size */> freeRanges;
+	};
+
+	bool tryAllocateInBlock(uint32_t blockIndex, const VkMemoryRequirements& requirements, VkDeviceSize limitOffset, MeshAllocation& outAllocation);
+	uint32_t createBlock(VkDeviceSize minSize, uint32_t memoryTypeIndex);
+
+	DevicePtr device;
+	VkDeviceSize blockSize = DefaultBlockSize;
+	std::vector<Block> blocks;
+};
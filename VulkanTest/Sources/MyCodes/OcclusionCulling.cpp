@@ -0,0 +1,418 @@
+#include "OcclusionCulling.h"
+#include "VulkanTutorialExtension.h"
+#include "BVH.h"
+#include "vk_descriptor.h"
+#include "vk_initializers.h"
+#include "vk_resource_utils.h"
+#include "vk_log.h"
+
+#include <algorithm>
+#include <cstring>
+
+bool OcclusionCulling::enabled = true;
+
+namespace
+{
+	constexpr uint32_t TestGroupSize = 64;
+	constexpr uint32_t DownsampleGroupSize = 8;
+	constexpr uint32_t MinCapacity = 1024;
+	constexpr VkFormat PyramidFormat = VK_FORMAT_R32_SFLOAT;
+
+	VkImageAspectFlags getDepthAspect(VkFormat format)
+	{
+		const bool hasStencil = format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
+		return VK_IMAGE_ASPECT_DEPTH_BIT | (hasStencil ? VK_IMAGE_ASPECT_STENCIL_BIT : 0);
+	}
+
+	VkPipeline createComputePipeline(VkDevice device, VkPipelineLayout layout, const char* shaderPath)
+	{
+		VkShaderModule computeShader = Utils::loadShader(shaderPath, device);
+		VkComputePipelineCreateInfo pipelineInfo = vkb::initializers::compute_pipeline_create_info(layout);
+		pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		pipelineInfo.stage.module = computeShader;
+		pipelineInfo.stage.pName = "main";
+
+		VkPipeline pipeline;
+		VK_CHECK_RESULT(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline));
+		vkDestroyShaderModule(device, computeShader, nullptr);
+		return pipeline;
+	}
+}
+
+void OcclusionCulling::initialize(VulkanTutorialExtension* inEngine, VkPhysicalDevice physicalDevice, uint32_t inFrameCount, VkFormat inDepthFormat, VkSampleCountFlagBits depthSamples)
+{
+	// 스왑체인을 다시 만들 때도 불린다. 크기에 따라 바뀌는 피라미드는 createPyramid 만 다시 만든다.
+	if (isInitialized())
+	{
+		return;
+	}
+
+	engine = inEngine;
+	device = engine->getDevicePtr();
+	depthFormat = inDepthFormat;
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+	// 지원하지 않아도 IndirectDrawPass 가 피라미드 셋을 바인딩하므로 리소스는 모두 만든다. 검사만 하지 않는다.
+	VkFormatProperties depthProperties;
+	vkGetPhysicalDeviceFormatProperties(physicalDevice, depthFormat, &depthProperties);
+	const bool depthSampleable = (depthProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+	supported = depthSampleable && depthSamples == VK_SAMPLE_COUNT_1_BIT && engine->getOptionalDeviceFeatures().drawIndirectFirstInstance;
+	if (!supported)
+	{
+		LOG(Warning, "Occlusion culling disabled : depth is not sampleable / multisampled, or drawIndirectFirstInstance not supported");
+	}
+
+	std::vector<VkDescriptorSetLayoutBinding> testBindings;
+	vk::desc::createDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, testBindings);
+	vk::desc::createDescriptorSetLayoutBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, testBindings);
+	testSetLayout = vk::desc::createDescriptorSetLayout(*device, testBindings);
+
+	std::vector<VkDescriptorSetLayoutBinding> pyramidBindings;
+	vk::desc::createDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT, pyramidBindings);
+	vk::desc::createDescriptorSetLayoutBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, pyramidBindings);
+	pyramidSetLayout = vk::desc::createDescriptorSetLayout(*device, pyramidBindings);
+
+	std::vector<VkDescriptorSetLayoutBinding> downsampleBindings;
+	vk::desc::createDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT, downsampleBindings);
+	vk::desc::createDescriptorSetLayoutBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT, downsampleBindings);
+	downsampleSetLayout = vk::desc::createDescriptorSetLayout(*device, downsampleBindings);
+
+	const VkDescriptorSetLayout testSetLayouts[] = { testSetLayout, pyramidSetLayout };
+	VkPushConstantRange testPushConstantRange = vkb::initializers::push_constant_range(VK_SHADER_STAGE_COMPUTE_BIT, sizeof(TestPushConstants), 0);
+	VkPipelineLayoutCreateInfo testLayoutInfo = vkb::initializers::pipeline_layout_create_info(testSetLayouts, 2);
+	testLayoutInfo.pushConstantRangeCount = 1;
+	testLayoutInfo.pPushConstantRanges = &testPushConstantRange;
+	VK_CHECK_RESULT(vkCreatePipelineLayout(*device, &testLayoutInfo, nullptr, &testPipelineLayout));
+	testPipeline = createComputePipeline(*device, testPipelineLayout, "shaders/OcclusionCullingcomp.spv");
+
+	VkPushConstantRange downsamplePushConstantRange = vkb::initializers::push_constant_range(VK_SHADER_STAGE_COMPUTE_BIT, sizeof(DownsamplePushConstants), 0);
+	VkPipelineLayoutCreateInfo downsampleLayoutInfo = vkb::initializers::pipeline_layout_create_info(&downsampleSetLayout, 1);
+	downsampleLayoutInfo.pushConstantRangeCount = 1;
+	downsampleLayoutInfo.pPushConstantRanges = &downsamplePushConstantRange;
+	VK_CHECK_RESULT(vkCreatePipelineLayout(*device, &downsampleLayoutInfo, nullptr, &downsamplePipelineLayout));
+	downsamplePipeline = createComputePipeline(*device, downsamplePipelineLayout, "shaders/HiZDownsamplecomp.spv");
+
+	// texelFetch 로만 읽으므로 필터는 상관없다.
+	VkSamplerCreateInfo samplerInfo = vkb::initializers::sampler_create_info();
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+	VK_CHECK_RESULT(vkCreateSampler(*device, &samplerInfo, nullptr, &pyramidSampler));
+
+	// 프레임마다 검사용 셋(바인딩 2개)과 피라미드 셋(샘플러 1개, 버퍼 1개)
+	std::vector<VkDescriptorPoolSize> sizes =
+	{
+		vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * inFrameCount),
+		vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, inFrameCount)
+	};
+	VkDescriptorPoolCreateInfo poolInfo = vkb::initializers::descriptor_pool_create_info(sizes, 2 * inFrameCount);
+	VK_CHECK_RESULT(vkCreateDescriptorPool(*device, &poolInfo, nullptr, &descriptorPool));
+
+	frames.resize(inFrameCount);
+	for (FrameResources& frame : frames)
+	{
+		VkDescriptorSetAllocateInfo testAllocInfo = vkb::initializers::descriptor_set_allocate_info(descriptorPool, &testSetLayout, 1);
+		VK_CHECK_RESULT(vkAllocateDescriptorSets(*device, &testAllocInfo, &frame.testSet));
+
+		VkDescriptorSetAllocateInfo pyramidAllocInfo = vkb::initializers::descriptor_set_allocate_info(descriptorPool, &pyramidSetLayout, 1);
+		VK_CHECK_RESULT(vkAllocateDescriptorSets(*device, &pyramidAllocInfo, &frame.pyramidSet));
+
+		frame.stats.Create(*device, memoryProperties, sizeof(Stats),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		std::memset(frame.stats.mapped, 0, sizeof(Stats));
+
+		VkDescriptorBufferInfo statsInfo{ frame.stats.Buffer, 0, VK_WHOLE_SIZE };
+		VkWriteDescriptorSet statsWrite = vkb::initializers::write_descriptor_set(frame.pyramidSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, &statsInfo);
+		vkUpdateDescriptorSets(*device, 1, &statsWrite, 0, nullptr);
+
+		reserve(frame, MinCapacity);
+	}
+}
+
+void OcclusionCulling::cleanup()
+{
+	destroyPyramid();
+
+	for (FrameResources& frame : frames)
+	{
+		destroyBuffers(frame);
+		frame.stats.Destroy(*device);
+	}
+	frames.clear();
+
+	vkDestroySampler(*device, pyramidSampler, nullptr);
+	vkDestroyDescriptorPool(*device, descriptorPool, nullptr);
+	vkDestroyPipeline(*device, testPipeline, nullptr);
+	vkDestroyPipelineLayout(*device, testPipelineLayout, nullptr);
+	vkDestroyPipeline(*device, downsamplePipeline, nullptr);
+	vkDestroyPipelineLayout(*device, downsamplePipelineLayout, nullptr);
+	vkDestroyDescriptorSetLayout(*device, testSetLayout, nullptr);
+	vkDestroyDescriptorSetLayout(*device, pyramidSetLayout, nullptr);
+	vkDestroyDescriptorSetLayout(*device, downsampleSetLayout, nullptr);
+}
+
+void OcclusionCulling::createPyramid(VkExtent2D inDepthExtent, VkImageView depthView)
+{
+	destroyPyramid();
+	depthExtent = inDepthExtent;
+
+	// 0 단계는 깊이의 절반 크기이고, 1x1 이 될 때까지 반씩 줄인다.
+	VkExtent2D extent = { std::max(depthExtent.width / 2, 1u), std::max(depthExtent.height / 2, 1u) };
+	std::vector<VkExtent2D> extents{ extent };
+	while (extent.width > 1 || extent.height > 1)
+	{
+		extent = { std::max(extent.width / 2, 1u), std::max(extent.height / 2, 1u) };
+		extents.push_back(extent);
+	}
+	const uint32_t levelCount = static_cast<uint32_t>(extents.size());
+
+	pyramid = engine->createImage(extents[0].width, extents[0].height, levelCount, VK_SAMPLE_COUNT_1_BIT, PyramidFormat, VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, "HiZPyramid");
+	pyramid->imageView = engine->createImageView(pyramid->image, PyramidFormat, VK_IMAGE_ASPECT_COLOR_BIT, levelCount);
+
+	VkCommandBuffer commandBuffer = engine->beginSingleTimeCommands();
+	VkImageMemoryBarrier barrier = vkb::initializers::image_memory_barrier();
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.image = pyramid->image;
+	barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount, 0, 1 };
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	engine->endSingleTimeCommands(commandBuffer);
+
+	std::vector<VkDescriptorPoolSize> sizes =
+	{
+		vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, levelCount),
+		vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, levelCount)
+	};
+	VkDescriptorPoolCreateInfo poolInfo = vkb::initializers::descriptor_pool_create_info(sizes, levelCount);
+	VK_CHECK_RESULT(vkCreateDescriptorPool(*device, &poolInfo, nullptr, &pyramidDescriptorPool));
+
+	pyramidLevels.resize(levelCount);
+	for (uint32_t level = 0; level < levelCount; level++)
+	{
+		PyramidLevel& pyramidLevel = pyramidLevels[level];
+		pyramidLevel.extent = extents[level];
+		pyramidLevel.view = engine->createImageView(pyramid->image, PyramidFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1, 0, level);
+
+		VkDescriptorSetAllocateInfo allocInfo = vkb::initializers::descriptor_set_allocate_info(pyramidDescriptorPool, &downsampleSetLayout, 1);
+		VK_CHECK_RESULT(vkAllocateDescriptorSets(*device, &allocInfo, &pyramidLevel.downsampleSet));
+	}
+
+	for (uint32_t level = 0; level < levelCount; level++)
+	{
+		// 0 단계는 깊이를, 나머지는 바로 위 단계를 읽는다. 깊이를 샘플링할 수 없으면 0 단계 셋은 쓰지 않는다.
+		VkDescriptorImageInfo sourceInfo = level == 0
+			? vkb::initializers::descriptor_image_info(pyramidSampler, depthView, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL)
+			: vkb::initializers::descriptor_image_info(pyramidSampler, pyramidLevels[level - 1].view, VK_IMAGE_LAYOUT_GENERAL);
+		VkDescriptorImageInfo destinationInfo = vkb::initializers::descriptor_image_info(VK_NULL_HANDLE, pyramidLevels[level].view, VK_IMAGE_LAYOUT_GENERAL);
+
+		std::vector<VkWriteDescriptorSet> writes;
+		if (level > 0 || supported)
+		{
+			writes.push_back(vkb::initializers::write_descriptor_set(pyramidLevels[level].downsampleSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 0, &sourceInfo));
+		}
+		writes.push_back(vkb::initializers::write_descriptor_set(pyramidLevels[level].downsampleSet, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, &destinationInfo));
+		vkUpdateDescriptorSets(*device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+	}
+
+	VkDescriptorImageInfo pyramidInfo = vkb::initializers::descriptor_image_info(pyramidSampler, pyramid->imageView, VK_IMAGE_LAYOUT_GENERAL);
+	for (FrameResources& frame : frames)
+	{
+		VkWriteDescriptorSet pyramidWrite = vkb::initializers::write_descriptor_set(frame.pyramidSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 0, &pyramidInfo);
+		vkUpdateDescriptorSets(*device, 1, &pyramidWrite, 0, nullptr);
+	}
+
+	LOG(Log, "Hi-Z pyramid : {}x{}, {} levels", extents[0].width, extents[0].height, levelCount);
+}
+
+void OcclusionCulling::destroyPyramid()
+{
+	for (PyramidLevel& level : pyramidLevels)
+	{
+		vkDestroyImageView(*device, level.view, nullptr);
+	}
+	pyramidLevels.clear();
+
+	if (pyramidDescriptorPool != VK_NULL_HANDLE)
+	{
+		vkDestroyDescriptorPool(*device, pyramidDescriptorPool, nullptr);
+		pyramidDescriptorPool = VK_NULL_HANDLE;
+	}
+
+	pyramid.reset();
+	pyramidValid = false;
+}
+
+void OcclusionCulling::beginFrame(uint32_t frameIndex)
+{
+	FrameResources& frame = frames[frameIndex];
+	std::memcpy(&lastStats, frame.stats.mapped, sizeof(Stats));
+	std::memset(frame.stats.mapped, 0, sizeof(Stats));
+}
+
+void OcclusionCulling::prepare(uint32_t frameIndex, const FrameVector<RenderObject>& draws, const FrameVector<Instance>& instances, const glm::mat4& viewProjection)
+{
+	FrameResources& frame = frames[frameIndex];
+	reserve(frame, static_cast<uint32_t>(draws.size()));
+
+	GPUOcclusionRecord* records = static_cast<GPUOcclusionRecord*>(frame.records.mapped);
+	for (uint32_t d = 0; d < draws.size(); d++)
+	{
+		const RenderObject& draw = draws[d];
+		GPUOcclusionRecord& record = records[d];
+		record.indexCount = draw.indexCount;
+		record.instanceCount = draw.instanceCount;
+		record.firstIndex = draw.firstIndex;
+		// 인스턴스가 하나면 모델 행렬을 push constant 로 넘기므로 인스턴스 버퍼를 쓰지 않는다.
+		record.firstInstance = draw.instanceCount > 1 ? draw.firstInstance : 0;
+
+		if (draw.bounds.sphereRadius < 0.f)
+		{
+			record.boundsMin = glm::vec4(0.f, 0.f, 0.f, -1.f);
+			record.boundsMax = glm::vec4(0.f);
+			continue;
+		}
+
+		AABB bounds;
+		if (draw.instanceCount > 1)
+		{
+			for (uint32_t instance = 0; instance < draw.instanceCount; instance++)
+			{
+				bounds.grow(AABB::fromTransformedBox(draw.bounds.origin, draw.bounds.extents, instances[draw.firstInstance + instance].model));
+			}
+		}
+		else
+		{
+			bounds = AABB::fromTransformedBox(draw.bounds.origin, draw.bounds.extents, draw.transform);
+		}
+		record.boundsMin = glm::vec4(bounds.min, 0.f);
+		record.boundsMax = glm::vec4(bounds.max, 0.f);
+	}
+
+	frame.drawCount = static_cast<uint32_t>(draws.size());
+	frame.pushConstants.viewProjection = viewProjection;
+	frame.pushConstants.drawCount = frame.drawCount;
+}
+
+void OcclusionCulling::recordTest(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t phase)
+{
+	FrameResources& frame = frames[frameIndex];
+	if (frame.drawCount == 0)
+	{
+		return;
+	}
+
+	frame.pushConstants.phase = phase;
+	frame.pushConstants.usePyramid = (phase == 1 || pyramidValid) ? 1 : 0;
+
+	const VkDescriptorSet sets[] = { frame.testSet, frame.pyramidSet };
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, testPipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, testPipelineLayout, 0, 2, sets, 0, nullptr);
+	vkCmdPushConstants(commandBuffer, testPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(TestPushConstants), &frame.pushConstants);
+	vkCmdDispatch(commandBuffer, (frame.drawCount + TestGroupSize - 1) / TestGroupSize, 1, 1);
+
+	// 2 단계 검사는 1 단계 결과를 읽는다.
+	VkMemoryBarrier testBarrier = vkb::initializers::memory_barrier();
+	testBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	testBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 1, &testBarrier, 0, nullptr, 0, nullptr);
+}
+
+void OcclusionCulling::recordBuildPyramid(VkCommandBuffer commandBuffer, VkImage depthImage, VkExtent2D depthSourceExtent)
+{
+	if (!supported || pyramidLevels.empty())
+	{
+		return;
+	}
+
+	const VkImageAspectFlags depthAspect = getDepthAspect(depthFormat);
+
+	// 깊이 쓰기가 끝나야 읽을 수 있고, 이번 프레임 1 단계 검사가 피라미드를 다 읽어야 덮어쓸 수 있다.
+	VkImageMemoryBarrier depthBarrier = vkb::initializers::image_memory_barrier();
+	depthBarrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depthBarrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+	depthBarrier.image = depthImage;
+	depthBarrier.subresourceRange = { depthAspect, 0, 1, 0, 1 };
+	depthBarrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	depthBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &depthBarrier);
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, downsamplePipeline);
+
+	VkMemoryBarrier levelBarrier = vkb::initializers::memory_barrier();
+	levelBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	levelBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	for (uint32_t level = 0; level < pyramidLevels.size(); level++)
+	{
+		const VkExtent2D sourceExtent = level == 0 ? depthSourceExtent : pyramidLevels[level - 1].extent;
+		const VkExtent2D destinationExtent = pyramidLevels[level].extent;
+
+		DownsamplePushConstants pushConstants;
+		pushConstants.sourceSize = glm::ivec2(sourceExtent.width, sourceExtent.height);
+		pushConstants.destinationSize = glm::ivec2(destinationExtent.width, destinationExtent.height);
+
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, downsamplePipelineLayout, 0, 1, &pyramidLevels[level].downsampleSet, 0, nullptr);
+		vkCmdPushConstants(commandBuffer, downsamplePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(DownsamplePushConstants), &pushConstants);
+		vkCmdDispatch(commandBuffer, (destinationExtent.width + DownsampleGroupSize - 1) / DownsampleGroupSize,
+			(destinationExtent.height + DownsampleGroupSize - 1) / DownsampleGroupSize, 1);
+
+		// 다음 단계와 2 단계 검사가 방금 쓴 단계를 읽는다.
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &levelBarrier, 0, nullptr, 0, nullptr);
+	}
+
+	// 2 단계 드로우가 이어서 깊이를 쓴다.
+	depthBarrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+	depthBarrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depthBarrier.srcAccessMask = 0;
+	depthBarrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &depthBarrier);
+
+	pyramidValid = true;
+}
+
+void OcclusionCulling::reserve(FrameResources& frame, uint32_t drawCount)
+{
+	if (drawCount <= frame.capacity)
+	{
+		return;
+	}
+
+	// 이 슬롯의 이전 제출은 끝났으므로 바로 지우고 새로 만든다.
+	const uint32_t capacity = std::max({ drawCount, frame.capacity * 2, MinCapacity });
+	destroyBuffers(frame);
+	frame.capacity = capacity;
+
+	frame.records.Create(*device, memoryProperties, frame.capacity * sizeof(GPUOcclusionRecord),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	frame.commands.Create(*device, memoryProperties, 2 * frame.capacity * sizeof(VkDrawIndexedIndirectCommand),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	VkDescriptorBufferInfo recordInfo{ frame.records.Buffer, 0, VK_WHOLE_SIZE };
+	VkDescriptorBufferInfo commandInfo{ frame.commands.Buffer, 0, VK_WHOLE_SIZE };
+
+	std::vector<VkWriteDescriptorSet> writes =
+	{
+		vkb::initializers::write_descriptor_set(frame.testSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0, &recordInfo),
+		vkb::initializers::write_descriptor_set(frame.testSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, &commandInfo)
+	};
+	vkUpdateDescriptorSets(*device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+	LOG(Log, "Occlusion culling buffers : {} draws", frame.capacity);
+}
+
+void OcclusionCulling::destroyBuffers(FrameResources& frame)
+{
+	frame.records.Destroy(*device);
+	frame.commands.Destroy(*device);
+	frame.capacity = 0;
+}
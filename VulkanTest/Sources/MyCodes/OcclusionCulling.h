@@ -0,0 +1,156 @@
+#pragma once
+
+#include "vk_types.h"
+#include "Buffer.h"
+#include "FrameAllocator.h"
+
+#include <vector>
+
+class VulkanTutorialExtension;
+struct RenderObject;
+
+// shaders/OcclusionCulling.comp 의 OcclusionRecord 와 배치가 같아야 한다. (std430)
+struct GPUOcclusionRecord
+{
+	glm::vec4 boundsMin;	// w 가 음수면 경계를 몰라서 항상 그린다.
+	glm::vec4 boundsMax;
+	uint32_t indexCount;
+	uint32_t instanceCount;
+	uint32_t firstIndex;
+	uint32_t firstInstance;
+};
+static_assert(sizeof(GPUOcclusionRecord) == 48, "GPUOcclusionRecord must match OcclusionRecord in OcclusionCulling.comp");
+
+/**
+ * 깊이 버퍼로 Hi-Z 피라미드를 만들고 드로우의 월드 AABB 를 피라미드에 대어 가려진 드로우를 뺀다.
+ *
+ * 두 단계로 나눈다.
+ * 1 단계 : 지난 프레임 피라미드로 검사해 보이는 드로우만 지오메트리 패스에서 그린다. 대부분 지난 프레임에 보였던 것들이다.
+ * 2 단계 : 방금 그린 깊이로 피라미드를 다시 만들고, 1 단계에서 가려졌던 드로우만 다시 검사해 보이면 이어서 그린다.
+ * 카메라가 움직여 지난 프레임 피라미드가 틀려도 2 단계가 보충하므로 빠지는 물체는 없다.
+ * 이번 프레임에 만든 피라미드는 다음 프레임 1 단계에서 쓴다.
+ *
+ * CPU 에서 그리는 드로우는 드로우마다 간접 드로우 인자를 하나씩 만들고, 검사 결과가 instanceCount 를 정한다.
+ * IndirectDrawPass 는 같은 피라미드 셋을 받아 자기 컬링 셰이더 안에서 검사한다.
+ * 버퍼는 프레임 슬롯마다 따로 두므로 매 프레임 녹화할 때만 쓸 수 있다.
+ */
+class OcclusionCulling
+{
+public:
+	static bool enabled;
+
+	struct Stats
+	{
+		uint32_t tested = 0;		// 프러스텀 안에서 검사한 드로우
+		uint32_t occludedEarly = 0;	// 1 단계에서 가려진 드로우
+		uint32_t recovered = 0;		// 1 단계에서 가려졌지만 2 단계에서 보여 그린 드로우
+		uint32_t occluded = 0;		// 두 단계 모두 가려져 그리지 않은 드로우
+	};
+
+	// 파이프라인과 셋 레이아웃을 한번 만든다. 피라미드는 createPyramid 가 만든다.
+	void initialize(VulkanTutorialExtension* inEngine, VkPhysicalDevice physicalDevice, uint32_t inFrameCount, VkFormat inDepthFormat, VkSampleCountFlagBits depthSamples);
+	void cleanup();
+
+	// 깊이 버퍼 크기에 맞춰 피라미드를 다시 만든다. 스왑체인을 다시 만들 때마다 불러야 한다.
+	void createPyramid(VkExtent2D depthExtent, VkImageView depthView);
+	void destroyPyramid();
+
+	// 깊이를 샘플링할 수 있고 멀티샘플이 아니어야 하며, drawIndirectFirstInstance 가 있어야 한다.
+	bool isSupported() const { return supported; }
+	bool isInitialized() const { return testPipeline != VK_NULL_HANDLE; }
+	// 지난 프레임에 피라미드를 만들었는지. 아니면 1 단계는 검사하지 않고 모두 그린다.
+	bool hasPyramid() const { return pyramidValid; }
+	// 이번 프레임에 피라미드를 만들지 않으면 불러서 다음 프레임이 오래된 피라미드를 쓰지 않게 한다.
+	void invalidatePyramid() { pyramidValid = false; }
+
+	// set 1 : binding 0 피라미드, binding 1 통계 버퍼. IndirectDrawPass 컬링 셰이더도 이 셋을 쓴다.
+	VkDescriptorSetLayout getPyramidSetLayout() const { return pyramidSetLayout; }
+	VkDescriptorSet getPyramidSet(uint32_t frameIndex) const { return frames[frameIndex].pyramidSet; }
+
+	// 이 프레임 슬롯의 펜스를 기다린 뒤에 불러야 한다. 지난번 이 슬롯의 통계를 읽고 0 으로 되돌린다.
+	void beginFrame(uint32_t frameIndex);
+	// CPU 에서 그릴 드로우의 월드 AABB 와 드로우 인자를 채운다. 인스턴스 드로우는 인스턴스 AABB 를 합친다.
+	void prepare(uint32_t frameIndex, const FrameVector<RenderObject>& draws, const FrameVector<Instance>& instances, const glm::mat4& viewProjection);
+	// phase 0 은 지난 프레임 피라미드로, phase 1 은 recordBuildPyramid 로 만든 피라미드로 검사한다. 렌더 패스 밖에서 불러야 한다.
+	void recordTest(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t phase);
+	// 지오메트리 패스가 끝난 깊이로 피라미드를 만든다. 깊이는 DEPTH_STENCIL_ATTACHMENT_OPTIMAL 이어야 하고 끝나면 되돌린다.
+	// 깊이의 왼쪽 위 sourceExtent 만 읽는다. 동적 해상도로 일부만 그려도 피라미드는 화면 전체를 나타낸다.
+	void recordBuildPyramid(VkCommandBuffer commandBuffer, VkImage depthImage, VkExtent2D sourceExtent);
+
+	// prepare 에 넘긴 drawIndex 번째 드로우의 간접 드로우 인자
+	VkBuffer getDrawCommandBuffer(uint32_t frameIndex) const { return frames[frameIndex].commands.Buffer; }
+	VkDeviceSize getDrawCommandOffset(uint32_t frameIndex, uint32_t phase, uint32_t drawIndex) const
+	{
+		return (phase * frames[frameIndex].drawCount + drawIndex) * sizeof(VkDrawIndexedIndirectCommand);
+	}
+
+	const Stats& getLastStats() const { return lastStats; }
+	uint32_t getPyramidLevelCount() const { return static_cast<uint32_t>(pyramidLevels.size()); }
+	VkExtent2D getPyramidExtent() const { return pyramidLevels.empty() ? VkExtent2D{} : pyramidLevels[0].extent; }
+
+private:
+	struct TestPushConstants
+	{
+		glm::mat4 viewProjection;
+		uint32_t drawCount;
+		uint32_t phase;
+		uint32_t usePyramid;
+	};
+
+	struct DownsamplePushConstants
+	{
+		glm::ivec2 sourceSize;
+		glm::ivec2 destinationSize;
+	};
+
+	struct PyramidLevel
+	{
+		VkImageView view = VK_NULL_HANDLE;
+		VkExtent2D extent{};
+		VkDescriptorSet downsampleSet = VK_NULL_HANDLE;
+	};
+
+	struct FrameResources
+	{
+		StorageBuffer records;		// 호스트에서 채운다
+		StorageBuffer commands;		// VkDrawIndexedIndirectCommand 가 단계별로 drawCount 개씩
+		StorageBuffer stats;		// Stats, 셰이더가 atomicAdd 로 센다
+		uint32_t capacity = 0;
+
+		VkDescriptorSet testSet = VK_NULL_HANDLE;
+		VkDescriptorSet pyramidSet = VK_NULL_HANDLE;
+
+		uint32_t drawCount = 0;
+		TestPushConstants pushConstants;
+	};
+
+	void reserve(FrameResources& frame, uint32_t drawCount);
+	void destroyBuffers(FrameResources& frame);
+
+	VulkanTutorialExtension* engine = nullptr;
+	DevicePtr device;
+	VkPhysicalDeviceMemoryProperties memoryProperties{};
+	bool supported = false;
+	VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+
+	VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+	VkDescriptorSetLayout testSetLayout = VK_NULL_HANDLE;
+	VkDescriptorSetLayout pyramidSetLayout = VK_NULL_HANDLE;
+	VkPipelineLayout testPipelineLayout = VK_NULL_HANDLE;
+	VkPipeline testPipeline = VK_NULL_HANDLE;
+
+	VkDescriptorSetLayout downsampleSetLayout = VK_NULL_HANDLE;
+	VkPipelineLayout downsamplePipelineLayout = VK_NULL_HANDLE;
+	VkPipeline downsamplePipeline = VK_NULL_HANDLE;
+	VkSampler pyramidSampler = VK_NULL_HANDLE;
+
+	// 피라미드는 깊이 절반 크기에서 시작하고 항상 GENERAL 레이아웃에 둔다.
+	std::shared_ptr<AllocatedImage> pyramid;
+	std::vector<PyramidLevel> pyramidLevels;
+	VkDescriptorPool pyramidDescriptorPool = VK_NULL_HANDLE;
+	VkExtent2D depthExtent{};
+	bool pyramidValid = false;
+
+	std::vector<FrameResources> frames;
+	Stats lastStats;
+};
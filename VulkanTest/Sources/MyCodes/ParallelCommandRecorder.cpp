@@ -0,0 +1,240 @@
+#include "ParallelCommandRecorder.h"
+#include "VulkanTools.h"
+#include "vk_log.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+void ParallelCommandRecorder::initialize(DevicePtr inDevice, uint32_t inQueueFamilyIndex, uint32_t threadCount)
+{
+	device = inDevice;
+	queueFamilyIndex = inQueueFamilyIndex;
+
+	if (threadCount == 0)
+	{
+		const uint32_t coreCount = std::max(1u, std::thread::hardware_concurrency());
+		threadCount = coreCount - 1;
+	}
+
+	stopping = false;
+	for (uint32_t i = 0; i < threadCount; i++)
+	{
+		threads.emplace_back(&ParallelCommandRecorder::workerLoop, this, i);
+	}
+
+	LOG(Display, "command recording workers : {}", getWorkerCount());
+}
+
+void ParallelCommandRecorder::cleanup()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	jobCondition.notify_all();
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	threads.clear();
+
+	for (Slot& slot : slots)
+	{
+		destroySlotPools(slot);
+	}
+	slots.clear();
+}
+
+void ParallelCommandRecorder::beginSlot(uint32_t slotIndex, VkCommandPoolCreateFlags poolFlags)
+{
+	if (slots.size() <= slotIndex)
+	{
+		slots.resize(slotIndex + 1);
+	}
+
+	Slot& slot = slots[slotIndex];
+	if (!slot.workers.empty() && slot.poolFlags != poolFlags)
+	{
+		destroySlotPools(slot);
+	}
+
+	if (slot.workers.empty())
+	{
+		slot.poolFlags = poolFlags;
+		for (uint32_t i = 0; i < getWorkerCount(); i++)
+		{
+			slot.workers.push_back(createWorkerPool(poolFlags));
+		}
+		return;
+	}
+
+	for (WorkerPool& worker : slot.workers)
+	{
+		VK_CHECK_RESULT(vkResetCommandPool(*device, worker.pool, 0));
+		worker.usedCount = 0;
+	}
+}
+
+uint32_t ParallelCommandRecorder::getChunkCount(uint32_t drawCount, uint32_t maxWorkers) const
+{
+	if (drawCount == 0)
+	{
+		return 0;
+	}
+
+	const uint32_t workerLimit = maxWorkers == 0 ? getWorkerCount() : std::min(maxWorkers, getWorkerCount());
+	const uint32_t chunkLimit = (drawCount + MinDrawsPerChunk - 1) / MinDrawsPerChunk;
+	return std::max(1u, std::min(workerLimit, chunkLimit));
+}
+
+void ParallelCommandRecorder::record(uint32_t slot, const VkCommandBufferInheritanceInfo& inheritance, uint32_t drawCount,
+	const RecordFunction& recordFunction, std::vector<VkCommandBuffer>& outCommandBuffers, uint32_t maxWorkers)
+{
+	assert(slot < slots.size() && !slots[slot].workers.empty() && "beginSlot must be called before record");
+
+	const uint32_t chunkCount = getChunkCount(drawCount, maxWorkers);
+	if (chunkCount == 0)
+	{
+		return;
+	}
+
+	const size_t firstOutput = outCommandBuffers.size();
+	outCommandBuffers.resize(firstOutput + chunkCount, VK_NULL_HANDLE);
+
+	{
+		// 이전 작업을 늦게 집어간 워커가 job 을 읽는 중일 수 있으므로 모두 빠져나간 뒤에 바꾼다.
+		std::unique_lock<std::mutex> lock(mutex);
+		doneCondition.wait(lock, [this]() { return activeWorkers == 0; });
+
+		job.slot = slot;
+		job.inheritance = &inheritance;
+		job.recordFunction = &recordFunction;
+		job.drawCount = drawCount;
+		job.chunkCount = chunkCount;
+		job.chunkBuffers = outCommandBuffers.data() + firstOutput;
+		nextChunk.store(0);
+		completedChunks.store(0);
+		jobGeneration++;
+	}
+
+	// 조각이 하나면 스레드를 깨우지 않고 메인 스레드에서 바로 녹화한다.
+	if (chunkCount > 1)
+	{
+		jobCondition.notify_all();
+	}
+
+	runChunks(static_cast<uint32_t>(threads.size()));
+
+	std::unique_lock<std::mutex> lock(mutex);
+	doneCondition.wait(lock, [this, chunkCount]() { return completedChunks.load() == chunkCount; });
+}
+
+void ParallelCommandRecorder::workerLoop(uint32_t workerIndex)
+{
+	uint64_t seenGeneration = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			jobCondition.wait(lock, [this, &seenGeneration]() { return stopping || jobGeneration != seenGeneration; });
+			if (stopping)
+			{
+				return;
+			}
+			seenGeneration = jobGeneration;
+			activeWorkers++;
+		}
+
+		runChunks(workerIndex);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			activeWorkers--;
+		}
+		doneCondition.notify_all();
+	}
+}
+
+void ParallelCommandRecorder::runChunks(uint32_t workerIndex)
+{
+	while (true)
+	{
+		const uint32_t chunk = nextChunk.fetch_add(1);
+		if (chunk >= job.chunkCount)
+		{
+			return;
+		}
+
+		const uint32_t begin = static_cast<uint32_t>(static_cast<uint64_t>(job.drawCount) * chunk / job.chunkCount);
+		const uint32_t end = static_cast<uint32_t>(static_cast<uint64_t>(job.drawCount) * (chunk + 1) / job.chunkCount);
+
+		VkCommandBuffer commandBuffer = acquireBuffer(job.slot, workerIndex);
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		// TRANSIENT 슬롯이 아니면 primary 버퍼를 여러 프레임 동안 다시 제출하므로 ONE_TIME_SUBMIT 을 쓸 수 없다.
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		if (slots[job.slot].poolFlags & VK_COMMAND_POOL_CREATE_TRANSIENT_BIT)
+		{
+			beginInfo.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		}
+		beginInfo.pInheritanceInfo = job.inheritance;
+
+		VK_CHECK_RESULT(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+		(*job.recordFunction)(commandBuffer, begin, end, chunk);
+		VK_CHECK_RESULT(vkEndCommandBuffer(commandBuffer));
+
+		job.chunkBuffers[chunk] = commandBuffer;
+
+		if (completedChunks.fetch_add(1) + 1 == job.chunkCount)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			doneCondition.notify_all();
+		}
+	}
+}
+
+VkCommandBuffer ParallelCommandRecorder::acquireBuffer(uint32_t slot, uint32_t workerIndex)
+{
+	WorkerPool& worker = slots[slot].workers[workerIndex];
+	if (worker.usedCount == worker.buffers.size())
+	{
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = worker.pool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		allocInfo.commandBufferCount = 1;
+
+		VkCommandBuffer commandBuffer;
+		VK_CHECK_RESULT(vkAllocateCommandBuffers(*device, &allocInfo, &commandBuffer));
+		worker.buffers.push_back(commandBuffer);
+	}
+	return worker.buffers[worker.usedCount++];
+}
+
+ParallelCommandRecorder::WorkerPool ParallelCommandRecorder::createWorkerPool(VkCommandPoolCreateFlags poolFlags)
+{
+	VkCommandPoolCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	createInfo.queueFamilyIndex = queueFamilyIndex;
+	createInfo.flags = poolFlags;
+
+	WorkerPool worker;
+	if (vkCreateCommandPool(*device, &createInfo, nullptr, &worker.pool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create worker command pool!");
+	}
+	return worker;
+}
+
+void ParallelCommandRecorder::destroySlotPools(Slot& slot)
+{
+	// 풀을 지우면 그 풀에서 할당한 커맨드 버퍼도 함께 해제된다.
+	for (WorkerPool& worker : slot.workers)
+	{
+		vkDestroyCommandPool(*device, worker.pool, nullptr);
+	}
+	slot.workers.clear();
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "vk_types.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * 드로우 목록을 여러 조각으로 나눠 워커 스레드들이 secondary 커맨드 버퍼에 동시에 녹화하게 한다.
+ *
+ * 커맨드 풀은 외부 동기화가 필요하므로 (슬롯, 워커) 마다 하나씩 둔다. 슬롯은 따로 녹화되는 primary 커맨드 버퍼 하나에 대응하고,
+ * beginSlot 에서 그 슬롯의 풀을 한번에 리셋한 뒤 secondary 버퍼를 앞에서부터 다시 쓴다.
+ * 메인 스레드도 기다리는 동안 조각을 가져가 녹화하므로 워커 수는 스레드 수 + 1 이다.
+ * 조각은 드로우 순서대로 나뉘고 outCommandBuffers 에도 그 순서로 들어가므로, 정렬된 순서가 그대로 유지된다.
+ */
+class ParallelCommandRecorder
+{
+public:
+	// (커맨드 버퍼, 시작 인덱스, 끝 인덱스, 조각 번호)
+	using RecordFunction = std::function<void(VkCommandBuffer, uint32_t, uint32_t, uint32_t)>;
+
+	// 조각이 이보다 작으면 스레드를 깨우는 비용이 녹화보다 크다.
+	static constexpr uint32_t MinDrawsPerChunk = 256;
+
+	ParallelCommandRecorder() = default;
+	ParallelCommandRecorder(const ParallelCommandRecorder&) = delete;
+	ParallelCommandRecorder& operator=(const ParallelCommandRecorder&) = delete;
+
+	// threadCount 가 0 이면 코어 수 - 1 개의 스레드를 만든다.
+	void initialize(DevicePtr inDevice, uint32_t inQueueFamilyIndex, uint32_t threadCount = 0);
+	void cleanup();
+
+	// 슬롯의 이전 녹화 결과를 버린다. 그 슬롯의 secondary 버퍼를 실행하는 커맨드 버퍼가 GPU 에서 끝난 뒤에 불러야 한다.
+	// poolFlags 에 VK_COMMAND_POOL_CREATE_TRANSIENT_BIT 가 있으면 한번만 제출할 버퍼로 녹화한다. 플래그가 바뀌면 풀을 다시 만든다.
+	void beginSlot(uint32_t slot, VkCommandPoolCreateFlags poolFlags = 0);
+
+	// drawCount 개를 조각으로 나눠 녹화하고, 조각 순서대로 secondary 버퍼를 outCommandBuffers 에 붙인다.
+	// maxWorkers 가 0 이 아니면 조각을 그 수 이하로만 나눈다. (벤치마크용)
+	void record(uint32_t slot, const VkCommandBufferInheritanceInfo& inheritance, uint32_t drawCount,
+		const RecordFunction& recordFunction, std::vector<VkCommandBuffer>& outCommandBuffers, uint32_t maxWorkers = 0);
+
+	uint32_t getWorkerCount() const { return static_cast<uint32_t>(threads.size()) + 1; }
+	uint32_t getChunkCount(uint32_t drawCount, uint32_t maxWorkers = 0) const;
+
+private:
+	struct WorkerPool
+	{
+		VkCommandPool pool = VK_NULL_HANDLE;
+		std::vector<VkCommandBuffer> buffers;
+		uint32_t usedCount = 0;
+	};
+
+	struct Job
+	{
+		uint32_t slot = 0;
+		const VkCommandBufferInheritanceInfo* inheritance = nullptr;
+		const RecordFunction* recordFunction = nullptr;
+		uint32_t drawCount = 0;
+		uint32_t chunkCount = 0;
+		VkCommandBuffer* chunkBuffers = nullptr;
+	};
+
+	struct Slot
+	{
+		VkCommandPoolCreateFlags poolFlags = 0;
+		std::vector<WorkerPool> workers;
+	};
+
+	void workerLoop(uint32_t workerIndex);
+	void runChunks(uint32_t workerIndex);
+	VkCommandBuffer acquireBuffer(uint32_t slot, uint32_t workerIndex);
+	WorkerPool createWorkerPool(VkCommandPoolCreateFlags poolFlags);
+	void destroySlotPools(Slot& slot);
+
+	DevicePtr device;
+	uint32_t queueFamilyIndex = 0;
+
+	// slots[slot].workers[worker]
+	std::vector<Slot> slots;
+
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable jobCondition;
+	std::condition_variable doneCondition;
+	uint64_t jobGeneration = 0;
+	uint32_t activeWorkers = 0;
+	bool stopping = false;
+
+	Job job;
+	std::atomic<uint32_t> nextChunk{ 0 };
+	std::atomic<uint32_t> completedChunks{ 0 };
+};
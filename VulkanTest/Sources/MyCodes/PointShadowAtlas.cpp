@@ -0,0 +1,874 @@
+#include "PointShadowAtlas.h"
+#include "VulkanTutorialExtension.h"
+#include "TransformHierarchy.h"
+#include "GPUResourcePools.h"
+#include "FrustumCulling.h"
+#include "GPUMarker.h"
+#include "vk_descriptor.h"
+#include "vk_initializers.h"
+#include "vk_resource_utils.h"
+#include "vk_log.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+bool PointShadowAtlas::enabled = true;
+int PointShadowAtlas::maxFaceUpdatesPerFrame = 24;
+float PointShadowAtlas::resolutionScale = 0.5f;
+float PointShadowAtlas::depthBiasConstant = 1.5f;
+float PointShadowAtlas::depthBiasSlope = 2.f;
+float PointShadowAtlas::normalOffset = 1.5f;
+
+namespace
+{
+	// shaders/ShadowDepth.vert 의 ShadowPushConstants 와 같다.
+	struct ShadowPushConstants
+	{
+		glm::mat4 lightViewProjection;
+		glm::mat4 model;
+	};
+
+	// shaders/point_shadow.glsl 의 PointShadows 헤더. x 노멀 방향으로 미는 거리(텍셀 단위), y 아틀라스 크기
+	constexpr VkDeviceSize HeaderSize = sizeof(glm::vec4);
+
+	// +X, -X, +Y, -Y, +Z, -Z. point_shadow.glsl 의 getCubeFace 와 순서가 같다.
+	const glm::vec3 FaceDirections[6] =
+	{
+		{ 1.f, 0.f, 0.f }, { -1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.f, -1.f, 0.f }, { 0.f, 0.f, 1.f }, { 0.f, 0.f, -1.f }
+	};
+	const glm::vec3 FaceUps[6] =
+	{
+		{ 0.f, -1.f, 0.f }, { 0.f, -1.f, 0.f }, { 0.f, 0.f, 1.f }, { 0.f, 0.f, -1.f }, { 0.f, -1.f, 0.f }, { 0.f, -1.f, 0.f }
+	};
+
+	uint32_t getLevel(uint32_t size)
+	{
+		uint32_t level = 0;
+		for (uint32_t levelSize = PointShadowAtlas::AtlasSize; levelSize > size; levelSize /= 2)
+		{
+			level++;
+		}
+		return level;
+	}
+}
+
+void PointShadowAtlas::TileAllocator::reset()
+{
+	for (std::vector<glm::uvec2>& tiles : freeTiles)
+	{
+		tiles.clear();
+	}
+	freeTiles[0].push_back(glm::uvec2(0));
+	usedTexels = 0;
+}
+
+bool PointShadowAtlas::TileAllocator::allocateLevel(uint32_t level, glm::uvec2& outPosition)
+{
+	std::vector<glm::uvec2>& tiles = freeTiles[level];
+	if (!tiles.empty())
+	{
+		outPosition = tiles.back();
+		tiles.pop_back();
+		return true;
+	}
+	if (level == 0)
+	{
+		return false;
+	}
+
+	// 한 단계 큰 타일을 넷으로 나눠 하나를 쓰고 셋을 남긴다.
+	glm::uvec2 parent;
+	if (!allocateLevel(level - 1, parent))
+	{
+		return false;
+	}
+	const uint32_t size = AtlasSize >> level;
+	tiles.push_back(parent + glm::uvec2(size, 0));
+	tiles.push_back(parent + glm::uvec2(0, size));
+	tiles.push_back(parent + glm::uvec2(size, size));
+	outPosition = parent;
+	return true;
+}
+
+void PointShadowAtlas::TileAllocator::freeLevel(uint32_t level, glm::uvec2 position)
+{
+	std::vector<glm::uvec2>& tiles = freeTiles[level];
+	if (level > 0)
+	{
+		// 형제 셋이 모두 비어 있으면 합쳐서 한 단계 위로 돌려준다.
+		const uint32_t size = AtlasSize >> level;
+		const glm::uvec2 parent = position / (size * 2) * (size * 2);
+		std::array<std::vector<glm::uvec2>::iterator, 3> siblings;
+		uint32_t found = 0;
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			const glm::uvec2 sibling = parent + glm::uvec2(i % 2, i / 2) * size;
+			if (sibling == position)
+			{
+				continue;
+			}
+			auto it = std::find(tiles.begin(), tiles.end(), sibling);
+			if (it == tiles.end())
+			{
+				break;
+			}
+			siblings[found++] = it;
+		}
+		if (found == 3)
+		{
+			std::sort(siblings.begin(), siblings.end(), [](const auto& a, const auto& b) { return a > b; });
+			for (const auto& it : siblings)
+			{
+				tiles.erase(it);
+			}
+			freeLevel(level - 1, parent);
+			return;
+		}
+	}
+	tiles.push_back(position);
+}
+
+bool PointShadowAtlas::TileAllocator::allocate(uint32_t size, Tile& outTile)
+{
+	glm::uvec2 position;
+	if (!allocateLevel(getLevel(size), position))
+	{
+		return false;
+	}
+	outTile = { position.x, position.y, size };
+	usedTexels += static_cast<uint64_t>(size) * size;
+	return true;
+}
+
+void PointShadowAtlas::TileAllocator::free(const Tile& tile)
+{
+	freeLevel(getLevel(tile.size), glm::uvec2(tile.x, tile.y));
+	usedTexels -= static_cast<uint64_t>(tile.size) * tile.size;
+}
+
+void PointShadowAtlas::createDescriptorSetLayout(VkDevice inDevice, VkPhysicalDevice physicalDevice)
+{
+	setLayoutDevice = inDevice;
+
+	// 보장되는 셋은 4 개뿐이다. 라이트 볼륨은 set 3 으로 묶으므로 레이아웃은 어느 장치에서나 만든다.
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	supported = properties.limits.maxBoundDescriptorSets > LightingSetIndex;
+
+	std::vector<VkDescriptorSetLayoutBinding> bindings;
+	vk::desc::createDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, bindings);
+	vk::desc::createDescriptorSetLayoutBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, bindings);
+	setLayout = vk::desc::createDescriptorSetLayout(inDevice, bindings);
+}
+
+void PointShadowAtlas::initialize(VulkanTutorialExtension* inEngine, VkPhysicalDevice physicalDevice, uint32_t imageCount)
+{
+	// 스왑체인을 다시 만들 때도 불린다. 아틀라스는 화면 크기와 상관없으므로 그대로 쓴다.
+	if (!isInitialized())
+	{
+		engine = inEngine;
+		device = engine->getDevicePtr();
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		timestampsSupported = properties.limits.timestampComputeAndGraphics == VK_TRUE;
+		timestampPeriod = properties.limits.timestampPeriod;
+
+		createRenderPass();
+		createPipeline();
+
+		// D16 은 깊이 첨부와 샘플링이 항상 되지만 선형 필터는 장치에 따라 다르다.
+		VkFormatProperties formatProperties;
+		vkGetPhysicalDeviceFormatProperties(physicalDevice, depthFormat, &formatProperties);
+		const bool linearFilter = (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) != 0;
+		createAtlas();
+
+		VkSamplerCreateInfo samplerInfo = vkb::initializers::sampler_create_info();
+		samplerInfo.magFilter = linearFilter ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+		samplerInfo.minFilter = samplerInfo.magFilter;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.compareEnable = VK_TRUE;
+		samplerInfo.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+		samplerInfo.maxLod = 1.f;
+		samplerInfo.maxAnisotropy = 1.f;
+		VK_CHECK_RESULT(vkCreateSampler(*device, &samplerInfo, nullptr, &sampler));
+
+		allocator.reset();
+	}
+
+	if (frames.size() == imageCount)
+	{
+		return;
+	}
+	destroyFrames();
+
+	std::vector<VkDescriptorPoolSize> sizes =
+	{
+		vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, imageCount),
+		vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, imageCount)
+	};
+	VkDescriptorPoolCreateInfo poolInfo = vkb::initializers::descriptor_pool_create_info(sizes, imageCount);
+	VK_CHECK_RESULT(vkCreateDescriptorPool(*device, &poolInfo, nullptr, &descriptorPool));
+
+	if (timestampsSupported)
+	{
+		VkQueryPoolCreateInfo queryPoolInfo{};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = imageCount * 2;
+		VK_CHECK_RESULT(vkCreateQueryPool(*device, &queryPoolInfo, nullptr, &queryPool));
+	}
+
+	const VkMemoryPropertyFlags hostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	const VkDeviceSize bufferSize = HeaderSize + sizeof(GPUPointShadow) * MaxShadowedLights;
+	VkDescriptorImageInfo atlasInfo = vkb::initializers::descriptor_image_info(sampler, atlas->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+	frames.resize(imageCount);
+	for (FrameResources& frame : frames)
+	{
+		frame.shadows.Create(*device, memoryProperties, bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible);
+		std::memset(frame.shadows.mapped, 0, bufferSize);
+
+		VkDescriptorSetAllocateInfo allocInfo = vkb::initializers::descriptor_set_allocate_info(descriptorPool, &setLayout, 1);
+		VK_CHECK_RESULT(vkAllocateDescriptorSets(*device, &allocInfo, &frame.set));
+
+		VkDescriptorBufferInfo shadowsInfo{ frame.shadows.Buffer, 0, VK_WHOLE_SIZE };
+		std::vector<VkWriteDescriptorSet> writes =
+		{
+			vkb::initializers::write_descriptor_set(frame.set, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0, &shadowsInfo),
+			vkb::initializers::write_descriptor_set(frame.set, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, &atlasInfo)
+		};
+		vkUpdateDescriptorSets(*device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+	}
+
+	LOG(Log, "Point shadow atlas : {}x{}, {} ~ {} tiles, {} lights max", AtlasSize, AtlasSize, MinTileSize, MaxTileSize, MaxShadowedLights);
+}
+
+void PointShadowAtlas::createRenderPass()
+{
+	// 타일만 골라 다시 그리므로 아틀라스 나머지는 보존한다. 타일은 렌더 패스 안에서 지운다.
+	VkAttachmentDescription depthAttachment{};
+	depthAttachment.format = depthFormat;
+	depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	depthAttachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkAttachmentReference depthRef{ 0, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+
+	VkSubpassDescription subpass{};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.pDepthStencilAttachment = &depthRef;
+
+	// 지난번 라이팅 패스가 다 읽은 뒤에 쓰고, 이번 라이팅 패스는 다 쓴 뒤에 읽는다.
+	std::array<VkSubpassDependency, 2> dependencies{};
+	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[0].dstSubpass = 0;
+	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	dependencies[0].srcAccessMask = 0;
+	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+	dependencies[1].srcSubpass = 0;
+	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	VkRenderPassCreateInfo renderPassInfo = vkb::initializers::render_pass_create_info();
+	renderPassInfo.attachmentCount = 1;
+	renderPassInfo.pAttachments = &depthAttachment;
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+	renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+	renderPassInfo.pDependencies = dependencies.data();
+	VK_CHECK_RESULT(vkCreateRenderPass(*device, &renderPassInfo, nullptr, &renderPass));
+}
+
+void PointShadowAtlas::createPipeline()
+{
+	VkPushConstantRange pushConstantRange = vkb::initializers::push_constant_range(VK_SHADER_STAGE_VERTEX_BIT, sizeof(ShadowPushConstants), 0);
+	VkPipelineLayoutCreateInfo layoutInfo = vkb::initializers::pipeline_layout_create_info(nullptr, 0);
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &pushConstantRange;
+	VK_CHECK_RESULT(vkCreatePipelineLayout(*device, &layoutInfo, nullptr, &pipelineLayout));
+
+	std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+	VertexOnlyPos::getBindingDescriptions(bindingDescriptions);
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+	VertexOnlyPos::getAttributeDescriptions(attributeDescriptions);
+	VkPipelineVertexInputStateCreateInfo vertexInputState = vkb::initializers::pipeline_vertex_input_state_create_info();
+	vertexInputState.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
+	vertexInputState.pVertexBindingDescriptions = bindingDescriptions.data();
+	vertexInputState.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+	vertexInputState.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+	// CascadedShadowMap 과 같은 깊이 전용 셰이더를 쓴다. 뷰포트는 타일마다 바뀐다.
+	VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = vkb::initializers::pipeline_input_assembly_state_create_info(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, 0, VK_FALSE);
+	VkPipelineRasterizationStateCreateInfo rasterizationState = vkb::initializers::pipeline_rasterization_state_create_info(VK_POLYGON_MODE_FILL, VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE, 0);
+	rasterizationState.depthBiasEnable = VK_TRUE;
+	VkPipelineMultisampleStateCreateInfo multisampleState = vkb::initializers::pipeline_multisample_state_create_info(VK_SAMPLE_COUNT_1_BIT, 0);
+	VkPipelineViewportStateCreateInfo viewportState = vkb::initializers::pipeline_viewport_state_create_info(1, 1, 0);
+	std::vector<VkDynamicState> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR, VK_DYNAMIC_STATE_DEPTH_BIAS };
+	VkPipelineDynamicStateCreateInfo dynamicState = vkb::initializers::pipeline_dynamic_state_create_info(dynamicStates);
+	VkPipelineDepthStencilStateCreateInfo depthStencilState = vkb::initializers::pipeline_depth_stencil_state_create_info(VK_TRUE, VK_TRUE, VK_COMPARE_OP_LESS_OR_EQUAL);
+	VkPipelineColorBlendStateCreateInfo colorBlendState = vkb::initializers::pipeline_color_blend_state_create_info(0, nullptr);
+
+	VkShaderModule vertexShader = Utils::loadShader("shaders/ShadowDepthvert.spv", *device);
+	VkPipelineShaderStageCreateInfo shaderStage{};
+	shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStage.stage = VK_SHADER_STAGE_VERTEX_BIT;
+	shaderStage.module = vertexShader;
+	shaderStage.pName = "main";
+
+	VkGraphicsPipelineCreateInfo pipelineInfo = vkb::initializers::pipeline_create_info(pipelineLayout, renderPass);
+	pipelineInfo.stageCount = 1;
+	pipelineInfo.pStages = &shaderStage;
+	pipelineInfo.pVertexInputState = &vertexInputState;
+	pipelineInfo.pInputAssemblyState = &inputAssemblyState;
+	pipelineInfo.pRasterizationState = &rasterizationState;
+	pipelineInfo.pMultisampleState = &multisampleState;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pDepthStencilState = &depthStencilState;
+	pipelineInfo.pColorBlendState = &colorBlendState;
+	pipelineInfo.pDynamicState = &dynamicState;
+	VK_CHECK_RESULT(vkCreateGraphicsPipelines(*device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline));
+
+	vkDestroyShaderModule(*device, vertexShader, nullptr);
+}
+
+void PointShadowAtlas::createAtlas()
+{
+	atlas = engine->createImage(AtlasSize, AtlasSize, 1, VK_SAMPLE_COUNT_1_BIT, depthFormat, VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, "PointShadowAtlas");
+	atlas->imageView = engine->createImageView(atlas->image, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
+
+	VkFramebufferCreateInfo framebufferInfo = vkb::initializers::framebuffer_create_info();
+	framebufferInfo.renderPass = renderPass;
+	framebufferInfo.attachmentCount = 1;
+	framebufferInfo.pAttachments = &atlas->imageView;
+	framebufferInfo.width = AtlasSize;
+	framebufferInfo.height = AtlasSize;
+	framebufferInfo.layers = 1;
+	VK_CHECK_RESULT(vkCreateFramebuffer(*device, &framebufferInfo, nullptr, &framebuffer));
+
+	// 렌더 패스가 읽기 레이아웃에서 시작하므로 옮겨 둔다. 여섯 면을 다 그리기 전의 타일은 셰이더가 읽지 않는다.
+	VkCommandBuffer commandBuffer = engine->beginSingleTimeCommands();
+	VkImageMemoryBarrier barrier = vkb::initializers::image_memory_barrier();
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barrier.image = atlas->image;
+	barrier.subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 };
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	engine->endSingleTimeCommands(commandBuffer);
+}
+
+void PointShadowAtlas::destroyFrames()
+{
+	for (FrameResources& frame : frames)
+	{
+		frame.shadows.Destroy(*device);
+	}
+	frames.clear();
+
+	if (descriptorPool != VK_NULL_HANDLE)
+	{
+		vkDestroyDescriptorPool(*device, descriptorPool, nullptr);
+		descriptorPool = VK_NULL_HANDLE;
+	}
+	if (queryPool != VK_NULL_HANDLE)
+	{
+		vkDestroyQueryPool(*device, queryPool, nullptr);
+		queryPool = VK_NULL_HANDLE;
+	}
+}
+
+void PointShadowAtlas::cleanup()
+{
+	if (isInitialized())
+	{
+		destroyFrames();
+		faceUpdates.clear();
+		vkDestroyFramebuffer(*device, framebuffer, nullptr);
+		atlas.reset();
+		vkDestroySampler(*device, sampler, nullptr);
+		vkDestroyPipeline(*device, pipeline, nullptr);
+		vkDestroyPipelineLayout(*device, pipelineLayout, nullptr);
+		vkDestroyRenderPass(*device, renderPass, nullptr);
+		framebuffer = VK_NULL_HANDLE;
+		sampler = VK_NULL_HANDLE;
+		pipeline = VK_NULL_HANDLE;
+		pipelineLayout = VK_NULL_HANDLE;
+		renderPass = VK_NULL_HANDLE;
+	}
+
+	vkDestroyDescriptorSetLayout(setLayoutDevice, setLayout, nullptr);
+	setLayout = VK_NULL_HANDLE;
+}
+
+uint32_t PointShadowAtlas::pickTileSize(float desiredSize, uint32_t currentSize)
+{
+	// 경계에서 두 크기를 오가며 매번 다시 그리지 않도록 줄일 때는 여유를 둔다.
+	if (currentSize != 0 && desiredSize <= currentSize && desiredSize > currentSize * 0.35f)
+	{
+		return currentSize;
+	}
+
+	uint32_t size = MinTileSize;
+	while (size < MaxTileSize && static_cast<float>(size) < desiredSize)
+	{
+		size *= 2;
+	}
+	return size;
+}
+
+void PointShadowAtlas::releaseSlot(Slot& slot)
+{
+	if (slot.tileSize != 0)
+	{
+		for (const Tile& tile : slot.tiles)
+		{
+			allocator.free(tile);
+		}
+	}
+	slot = Slot();
+}
+
+bool PointShadowAtlas::allocateTiles(Slot& slot, uint32_t tileSize, uint32_t minTileSize)
+{
+	// 여섯 면을 모두 받지 못하면 한 단계 작은 크기로 다시 시도한다. 실패하면 slot 을 건드리지 않는다.
+	std::array<Tile, FaceCount> tiles;
+	for (uint32_t size = tileSize; size >= minTileSize; size /= 2)
+	{
+		uint32_t allocated = 0;
+		while (allocated < FaceCount && allocator.allocate(size, tiles[allocated]))
+		{
+			allocated++;
+		}
+		if (allocated == FaceCount)
+		{
+			slot.tiles = tiles;
+			slot.tileSize = size;
+			slot.dirtyFaces = AllFaces;
+			slot.renderedFaces = 0;
+			return true;
+		}
+		for (uint32_t face = 0; face < allocated; face++)
+		{
+			allocator.free(tiles[face]);
+		}
+	}
+	return false;
+}
+
+void PointShadowAtlas::setLight(Slot& slot, const glm::vec3& position, float radius)
+{
+	slot.position = position;
+	slot.radius = radius;
+
+	glm::mat4 projection = glm::perspective(glm::radians(90.f), 1.f, NearPlane, std::max(radius, NearPlane * 2.f));
+	projection[1][1] *= -1;
+	for (uint32_t face = 0; face < FaceCount; face++)
+	{
+		slot.faceViewProjection[face] = projection * glm::lookAt(position, position + FaceDirections[face], FaceUps[face]);
+	}
+	slot.dirtyFaces = AllFaces;
+}
+
+void PointShadowAtlas::markFacesTouching(const AABB& bounds)
+{
+	// 서피스가 없어 비어 있는 상자
+	if (bounds.min.x > bounds.max.x)
+	{
+		return;
+	}
+
+	const glm::vec3 center = bounds.center();
+	const float radius = glm::length(bounds.extents());
+	for (Slot& slot : slots)
+	{
+		if (!slot.used || glm::length(center - slot.position) > radius + slot.radius)
+		{
+			continue;
+		}
+		for (uint32_t face = 0; face < FaceCount; face++)
+		{
+			if (Frustum::fromViewProjection(slot.faceViewProjection[face]).intersectsSphere(center, radius))
+			{
+				slot.dirtyFaces |= 1u << face;
+			}
+		}
+	}
+}
+
+void PointShadowAtlas::markMovedCasters(const TransformHierarchy& hierarchy)
+{
+	const std::vector<TransformHierarchy::MeshEntry>& entries = hierarchy.getMeshEntries();
+	const bool rebuilt = hierarchy.getStructureVersion() != casterStructureVersion;
+	if (!rebuilt && !hierarchy.hasUpdates())
+	{
+		return;
+	}
+
+	// 배열을 다시 만들었으면 항목 번호가 바뀌었으므로 모든 면을 다시 그린다.
+	if (rebuilt)
+	{
+		casterStructureVersion = hierarchy.getStructureVersion();
+		casterBounds.assign(entries.size(), AABB());
+		for (Slot& slot : slots)
+		{
+			slot.dirtyFaces = slot.used ? AllFaces : 0;
+		}
+	}
+
+	const GPUResourcePools& pools = GPUResourcePools::get();
+	for (uint32_t e = 0; e < entries.size(); e++)
+	{
+		const TransformHierarchy::MeshEntry& entry = entries[e];
+		if (!rebuilt && !hierarchy.wasUpdated(entry.transform))
+		{
+			continue;
+		}
+
+		const MeshAsset<Vertex>* mesh = pools.meshes.get(entry.mesh);
+		if (!mesh)
+		{
+			continue;
+		}
+
+		AABB bounds;
+		const glm::mat4& transform = hierarchy.getWorldTransform(entry.transform);
+		for (const GeoSurface& surface : mesh->surfaces)
+		{
+			if (surface.bounds.sphereRadius < 0.f)
+			{
+				// 크기를 모르는 서피스는 모든 라이트에 걸리게 한다.
+				bounds.grow(AABB{ glm::vec3(-FLT_MAX * 0.5f), glm::vec3(FLT_MAX * 0.5f) });
+				continue;
+			}
+			bounds.grow(AABB::fromTransformedBox(surface.bounds.origin, surface.bounds.extents, transform));
+		}
+
+		if (!rebuilt)
+		{
+			markFacesTouching(casterBounds[e]);
+			markFacesTouching(bounds);
+		}
+		casterBounds[e] = bounds;
+	}
+}
+
+void PointShadowAtlas::update(uint32_t imageIndex, bool active, std::vector<GPUClusterLight>& lights, const glm::vec3& cameraPosition, const Frustum& cameraFrustum,
+	float fovY, float screenHeight, const FrameVector<RenderObject>& casters, const TransformHierarchy& hierarchy)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	FrameResources& frame = frames[imageIndex];
+	if (frame.timed)
+	{
+		// 이 이미지의 펜스를 기다렸으므로 결과가 있다. 없으면 지난 값을 그대로 둔다.
+		uint64_t ticks[2] = {};
+		if (vkGetQueryPoolResults(*device, queryPool, imageIndex * 2, 2, sizeof(ticks), ticks, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+		{
+			stats.gpuMilliseconds = static_cast<float>(static_cast<double>(ticks[1] - ticks[0]) * timestampPeriod / 1000000.0);
+		}
+		frame.timed = false;
+	}
+
+	faceUpdates.clear();
+	const uint32_t allocationFailures = stats.allocationFailures;
+	const float gpuMilliseconds = stats.gpuMilliseconds;
+	stats = {};
+	stats.allocationFailures = allocationFailures;
+	stats.gpuMilliseconds = gpuMilliseconds;
+
+	if (!active || !enabled)
+	{
+		for (GPUClusterLight& light : lights)
+		{
+			light.color.w = 0.f;
+		}
+		for (Slot& slot : slots)
+		{
+			if (slot.used)
+			{
+				releaseSlot(slot);
+			}
+		}
+		casterStructureVersion = UINT32_MAX;
+		return;
+	}
+
+	// 화면에서 차지하는 크기. 구를 감싸는 원뿔의 반각으로 재고, 카메라가 구 안에 있으면 화면 전체로 본다.
+	const float tanHalfFov = std::tan(fovY * 0.5f);
+	std::vector<std::pair<float, uint32_t>> candidates;
+	for (uint32_t i = 0; i < lights.size(); i++)
+	{
+		lights[i].color.w = 0.f;
+		const glm::vec3 position = glm::vec3(lights[i].positionRadius);
+		const float radius = lights[i].positionRadius.w;
+		if (radius <= NearPlane || !cameraFrustum.intersectsSphere(position, radius))
+		{
+			continue;
+		}
+		const float distance = glm::length(position - cameraPosition);
+		const float coverage = distance <= radius ? 1.f : std::min(radius / (std::sqrt(distance * distance - radius * radius) * tanHalfFov), 1.f);
+		candidates.push_back({ coverage * screenHeight, i });
+	}
+	stats.candidateLights = static_cast<uint32_t>(candidates.size());
+
+	const size_t shadowedCount = std::min<size_t>(candidates.size(), MaxShadowedLights);
+	std::partial_sort(candidates.begin(), candidates.begin() + shadowedCount, candidates.end(),
+		[](const auto& a, const auto& b) { return a.first > b.first; });
+	candidates.resize(shadowedCount);
+
+	// 빠진 라이트의 타일을 먼저 돌려받아야 새 라이트가 자리를 얻는다.
+	// NOTE : 라이트는 목록 번호로 구분한다. 번호가 바뀌면 위치도 달라 다시 그리게 된다.
+	for (Slot& slot : slots)
+	{
+		if (!slot.used)
+		{
+			continue;
+		}
+		auto it = std::find_if(candidates.begin(), candidates.end(), [&slot](const auto& candidate) { return candidate.second == slot.lightIndex; });
+		if (it == candidates.end())
+		{
+			releaseSlot(slot);
+		}
+	}
+
+	// 큰 라이트부터 타일을 받는다.
+	for (const auto& [diameter, lightIndex] : candidates)
+	{
+		auto it = std::find_if(slots.begin(), slots.end(), [lightIndex = lightIndex](const Slot& slot) { return slot.used && slot.lightIndex == lightIndex; });
+		if (it == slots.end())
+		{
+			it = std::find_if(slots.begin(), slots.end(), [](const Slot& slot) { return !slot.used; });
+			it->used = true;
+			it->lightIndex = lightIndex;
+		}
+		Slot& slot = *it;
+		slot.priority = diameter;
+
+		const uint32_t tileSize = pickTileSize(diameter * resolutionScale, slot.tileSize);
+		if (slot.tileSize != 0 && tileSize > slot.tileSize)
+		{
+			// 키울 때는 새 타일을 먼저 받아 본다. 자리가 없으면 지금 타일을 그대로 써서 매 프레임 다시 그리지 않는다.
+			const std::array<Tile, FaceCount> previousTiles = slot.tiles;
+			if (allocateTiles(slot, tileSize, tileSize))
+			{
+				for (const Tile& tile : previousTiles)
+				{
+					allocator.free(tile);
+				}
+			}
+		}
+		else if (tileSize != slot.tileSize)
+		{
+			if (slot.tileSize != 0)
+			{
+				for (const Tile& tile : slot.tiles)
+				{
+					allocator.free(tile);
+				}
+				slot.tileSize = 0;
+			}
+			if (!allocateTiles(slot, tileSize, MinTileSize))
+			{
+				stats.allocationFailures++;
+				releaseSlot(slot);
+				continue;
+			}
+		}
+
+		const glm::vec3 position = glm::vec3(lights[lightIndex].positionRadius);
+		const float radius = lights[lightIndex].positionRadius.w;
+		if (glm::length(position - slot.position) > 0.0001f || std::abs(radius - slot.radius) > 0.0001f)
+		{
+			setLight(slot, position, radius);
+		}
+	}
+
+	markMovedCasters(hierarchy);
+
+	// 아직 여섯 면을 다 그리지 않은 라이트부터, 같으면 큰 라이트부터 예산만큼 면을 고른다.
+	std::array<Slot*, MaxShadowedLights> order;
+	uint32_t usedCount = 0;
+	for (Slot& slot : slots)
+	{
+		if (slot.used)
+		{
+			order[usedCount++] = &slot;
+		}
+	}
+	std::sort(order.begin(), order.begin() + usedCount, [](const Slot* a, const Slot* b)
+		{
+			const bool readyA = a->renderedFaces == AllFaces;
+			const bool readyB = b->renderedFaces == AllFaces;
+			return readyA != readyB ? !readyA : a->priority > b->priority;
+		});
+
+	const uint32_t budget = static_cast<uint32_t>(std::max(maxFaceUpdatesPerFrame, 0));
+	for (uint32_t s = 0; s < usedCount; s++)
+	{
+		Slot& slot = *order[s];
+		for (uint32_t face = 0; face < FaceCount; face++)
+		{
+			if ((slot.dirtyFaces & (1u << face)) == 0)
+			{
+				continue;
+			}
+			if (faceUpdates.size() >= budget)
+			{
+				stats.pendingFaces++;
+				continue;
+			}
+
+			FaceUpdate& faceUpdate = faceUpdates.emplace_back();
+			faceUpdate.tile = slot.tiles[face];
+			faceUpdate.viewProjection = slot.faceViewProjection[face];
+			faceUpdate.draws = FrameVector<RenderObject>(casters.begin(), casters.end(), FrameAllocator::get().allocator<RenderObject>());
+			FrustumCulling::cullDrawList(faceUpdate.draws, Frustum::fromViewProjection(faceUpdate.viewProjection));
+			stats.casterDraws += static_cast<uint32_t>(faceUpdate.draws.size());
+
+			slot.renderedViewProjection[face] = slot.faceViewProjection[face];
+			slot.dirtyFaces &= ~(1u << face);
+			slot.renderedFaces |= 1u << face;
+		}
+	}
+	stats.faceUpdates = static_cast<uint32_t>(faceUpdates.size());
+
+	// 여섯 면을 다 그린 라이트만 그림자를 쓴다. 이번 프레임 그린 면은 렌더 패스가 끝난 뒤에 읽으므로 같이 켜도 된다.
+	glm::vec4& header = *static_cast<glm::vec4*>(frame.shadows.mapped);
+	header = glm::vec4(normalOffset, static_cast<float>(AtlasSize), 0.f, 0.f);
+	GPUPointShadow* gpuShadows = reinterpret_cast<GPUPointShadow*>(static_cast<uint8_t*>(frame.shadows.mapped) + HeaderSize);
+	for (uint32_t s = 0; s < MaxShadowedLights; s++)
+	{
+		const Slot& slot = slots[s];
+		if (!slot.used)
+		{
+			continue;
+		}
+
+		stats.shadowedLights++;
+		stats.lightsPerTileSize[getLevel(MinTileSize) - getLevel(slot.tileSize)]++;
+		if (slot.renderedFaces != AllFaces)
+		{
+			continue;
+		}
+
+		stats.readyLights++;
+		GPUPointShadow& gpuShadow = gpuShadows[s];
+		for (uint32_t face = 0; face < FaceCount; face++)
+		{
+			const Tile& tile = slot.tiles[face];
+			gpuShadow.faceViewProjection[face] = slot.renderedViewProjection[face];
+			gpuShadow.faceRects[face] = glm::vec4(glm::vec2(tile.x, tile.y), static_cast<float>(tile.size), 0.f) / static_cast<float>(AtlasSize);
+		}
+		// 0 은 그림자 없음이다.
+		lights[slot.lightIndex].color.w = static_cast<float>(s + 1);
+	}
+
+	stats.atlasUsage = static_cast<float>(static_cast<double>(allocator.getUsedTexels()) / (static_cast<double>(AtlasSize) * AtlasSize));
+	stats.cpuMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void PointShadowAtlas::record(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+{
+	FrameResources& frame = frames[imageIndex];
+	frame.timed = false;
+	if (faceUpdates.empty())
+	{
+		return;
+	}
+
+	GPUMarker Marker(commandBuffer, "Point Light Shadows");
+
+	const uint32_t query = imageIndex * 2;
+	if (queryPool != VK_NULL_HANDLE)
+	{
+		vkCmdResetQueryPool(commandBuffer, queryPool, query, 2);
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, query);
+	}
+
+	VkRenderPassBeginInfo renderPassInfo = vkb::initializers::render_pass_begin_info();
+	renderPassInfo.renderPass = renderPass;
+	renderPassInfo.framebuffer = framebuffer;
+	renderPassInfo.renderArea.offset = { 0, 0 };
+	renderPassInfo.renderArea.extent = { AtlasSize, AtlasSize };
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	vkCmdSetDepthBias(commandBuffer, depthBiasConstant, 0.f, depthBiasSlope);
+
+	for (const FaceUpdate& face : faceUpdates)
+	{
+		VkViewport viewport = vkb::initializers::viewport(static_cast<float>(face.tile.size), static_cast<float>(face.tile.size), 0.f, 1.f);
+		viewport.x = static_cast<float>(face.tile.x);
+		viewport.y = static_cast<float>(face.tile.y);
+		VkRect2D scissor = vkb::initializers::rect2D(face.tile.size, face.tile.size, face.tile.x, face.tile.y);
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+		// 타일만 지운다.
+		VkClearAttachment clearAttachment{};
+		clearAttachment.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+		clearAttachment.clearValue.depthStencil = { 1.f, 0 };
+		VkClearRect clearRect{ scissor, 0, 1 };
+		vkCmdClearAttachments(commandBuffer, 1, &clearAttachment, 1, &clearRect);
+
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, offsetof(ShadowPushConstants, lightViewProjection), sizeof(glm::mat4), &face.viewProjection);
+
+		// 같은 메시가 이어지면 버퍼를 다시 바인딩하지 않는다.
+		VkBuffer boundPositions = VK_NULL_HANDLE;
+		VkBuffer boundIndices = VK_NULL_HANDLE;
+		for (const RenderObject& draw : face.draws)
+		{
+			if (draw.positionBuffer == VK_NULL_HANDLE)
+			{
+				continue;
+			}
+			if (draw.positionBuffer != boundPositions)
+			{
+				VkDeviceSize offset = 0;
+				vkCmdBindVertexBuffers(commandBuffer, 0, 1, &draw.positionBuffer, &offset);
+				boundPositions = draw.positionBuffer;
+			}
+			if (draw.indexBuffer != boundIndices)
+			{
+				vkCmdBindIndexBuffer(commandBuffer, draw.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+				boundIndices = draw.indexBuffer;
+			}
+			vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, offsetof(ShadowPushConstants, model), sizeof(glm::mat4), &draw.transform);
+			vkCmdDrawIndexed(commandBuffer, draw.indexCount, 1, draw.firstIndex, 0, 0);
+		}
+	}
+
+	vkCmdEndRenderPass(commandBuffer);
+
+	if (queryPool != VK_NULL_HANDLE)
+	{
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, query + 1);
+		frame.timed = true;
+	}
+}
+
+void PointShadowAtlas::bind(VkCommandBuffer commandBuffer, VkPipelineLayout layout, uint32_t setIndex, uint32_t imageIndex) const
+{
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, setIndex, 1, &frames[imageIndex].set, 0, nullptr);
+}
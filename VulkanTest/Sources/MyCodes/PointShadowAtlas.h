@@ -0,0 +1,198 @@
+#pragma once
+
+#include "vk_types.h"
+#include "vk_engine.h"
+#include "Buffer.h"
+#include "BVH.h"
+#include "Frustum.h"
+#include "ClusteredLighting.h"
+
+#include <array>
+#include <vector>
+
+class VulkanTutorialExtension;
+class TransformHierarchy;
+
+// shaders/point_shadow.glsl 의 PointShadow 와 배치가 같아야 한다. (std430)
+struct GPUPointShadow
+{
+	glm::mat4 faceViewProjection[6];	// 그 면을 마지막으로 그릴 때 쓴 행렬
+	glm::vec4 faceRects[6];				// 아틀라스 uv 로 xy 시작, z 크기
+};
+static_assert(sizeof(GPUPointShadow) == 480, "GPUPointShadow must match PointShadow in point_shadow.glsl");
+
+/**
+ * 포인트 라이트 그림자를 깊이 아틀라스 하나에 모아 그린다. 라이트마다 큐브 면 여섯 개를 아틀라스의 정사각형 타일에 그린다.
+ *
+ * 매 프레임 카메라 프러스텀에 닿는 라이트를 화면에서 차지하는 크기 순으로 MaxShadowedLights 개까지 골라 슬롯을 준다.
+ * 타일 크기는 화면 지름에 resolutionScale 을 곱해 MinTileSize ~ MaxTileSize 의 2 의 거듭제곱으로 고르고,
+ * 아틀라스는 4 분할 버디 할당으로 나눈다. 자리가 없으면 작은 타일로 다시 시도하고 그래도 없으면 그림자 없이 그린다.
+ *
+ * 면은 라이트가 움직이거나, 그 면 프러스텀에 든 물체(이전 또는 지금 위치)가 움직이거나, 장면 구조가 바뀔 때만 다시 그린다.
+ * 한 프레임에 다시 그리는 면은 maxFaceUpdatesPerFrame 개까지이고, 아직 여섯 면을 다 그리지 않은 라이트부터 채운다.
+ * 다시 그리지 못한 면은 그릴 때의 행렬로 계속 샘플링하므로 한두 프레임 늦을 뿐 틀어지지 않는다.
+ *
+ * 여섯 면을 다 그린 라이트만 GPUClusterLight::color.w 에 슬롯 번호를 적어 라이팅 패스와 라이트 볼륨이 그림자를 읽게 한다.
+ * 드리우는 물체 목록이 매 프레임 바뀌므로 매 프레임 녹화할 때만 켜진다.
+ */
+class PointShadowAtlas
+{
+public:
+	static constexpr uint32_t AtlasSize = 4096;
+	static constexpr uint32_t MinTileSize = 128;
+	static constexpr uint32_t MaxTileSize = 512;
+	static constexpr uint32_t MaxShadowedLights = 32;
+	static constexpr uint32_t FaceCount = 6;
+	static constexpr float NearPlane = 0.05f;
+
+	static bool enabled;
+	static int maxFaceUpdatesPerFrame;
+	// 화면 지름 1 픽셀당 타일 픽셀 수
+	static float resolutionScale;
+	static float depthBiasConstant;
+	static float depthBiasSlope;
+	static float normalOffset;
+
+	struct Stats
+	{
+		uint32_t candidateLights = 0;	// 카메라 프러스텀에 닿은 라이트
+		uint32_t shadowedLights = 0;	// 슬롯을 받은 라이트
+		uint32_t readyLights = 0;		// 여섯 면을 다 그려 그림자를 쓰는 라이트
+		uint32_t faceUpdates = 0;		// 이번 프레임 다시 그린 면
+		uint32_t pendingFaces = 0;		// 예산을 넘어 다음 프레임으로 미룬 면
+		uint32_t casterDraws = 0;		// 이번 프레임 면마다 그린 드로우의 합
+		uint32_t allocationFailures = 0;
+		std::array<uint32_t, 3> lightsPerTileSize{};	// 128, 256, 512
+		float atlasUsage = 0.f;
+		float gpuMilliseconds = 0.f;
+		float cpuMilliseconds = 0.f;
+	};
+
+	// 라이팅 패스에서 이 셋의 번호. 장치가 이만큼 셋을 묶지 못하면 그림자 없이 그린다.
+	static constexpr uint32_t LightingSetIndex = 4;
+
+	// 라이팅 파이프라인 레이아웃보다 먼저 있어야 하므로 initialize 와 따로 만든다.
+	void createDescriptorSetLayout(VkDevice device, VkPhysicalDevice physicalDevice);
+	VkDescriptorSetLayout getDescriptorSetLayout() const { return setLayout; }
+	// maxBoundDescriptorSets 가 LightingSetIndex 보다 커야 라이팅 패스가 아틀라스를 묶을 수 있다.
+	bool isSupported() const { return supported; }
+
+	// 아틀라스와 파이프라인을 한번 만들고, 이미지 수가 바뀌면 그림자 버퍼와 셋을 다시 만든다.
+	void initialize(VulkanTutorialExtension* inEngine, VkPhysicalDevice physicalDevice, uint32_t imageCount);
+	void cleanup();
+
+	// lights 를 ClusteredLighting 에 넘기기 전에 부른다. 그림자를 쓸 라이트의 color.w 를 채운다.
+	// casters 는 카메라 컬링 전의 불투명 드로우이고 record 까지 살아 있어야 한다. active 가 아니면 모든 슬롯을 비운다.
+	void update(uint32_t imageIndex, bool active, std::vector<GPUClusterLight>& lights, const glm::vec3& cameraPosition, const Frustum& cameraFrustum,
+		float fovY, float screenHeight, const FrameVector<RenderObject>& casters, const TransformHierarchy& hierarchy);
+	// update 에서 고른 면만 그린다. 렌더 패스 밖에서 라이팅 패스보다 먼저 부른다.
+	void record(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+	void bind(VkCommandBuffer commandBuffer, VkPipelineLayout layout, uint32_t setIndex, uint32_t imageIndex) const;
+
+	const Stats& getStats() const { return stats; }
+	bool isInitialized() const { return pipeline != VK_NULL_HANDLE; }
+
+private:
+	static constexpr uint32_t LevelCount = 6;	// AtlasSize 부터 MinTileSize 까지
+	static constexpr uint8_t AllFaces = (1u << FaceCount) - 1;
+
+	struct Tile
+	{
+		uint32_t x = 0;
+		uint32_t y = 0;
+		uint32_t size = 0;
+	};
+
+	// 정사각형을 4 등분해 나눠 주고, 돌려받은 네 조각이 모두 비면 다시 합친다.
+	class TileAllocator
+	{
+	public:
+		void reset();
+		bool allocate(uint32_t size, Tile& outTile);
+		void free(const Tile& tile);
+		uint64_t getUsedTexels() const { return usedTexels; }
+
+	private:
+		bool allocateLevel(uint32_t level, glm::uvec2& outPosition);
+		void freeLevel(uint32_t level, glm::uvec2 position);
+
+		std::array<std::vector<glm::uvec2>, LevelCount> freeTiles;
+		uint64_t usedTexels = 0;
+	};
+
+	struct Slot
+	{
+		bool used = false;
+		uint32_t lightIndex = 0;
+		float priority = 0.f;
+		glm::vec3 position{ 0.f };
+		float radius = 0.f;
+		uint32_t tileSize = 0;
+		std::array<Tile, FaceCount> tiles;
+		std::array<glm::mat4, FaceCount> faceViewProjection;
+		std::array<glm::mat4, FaceCount> renderedViewProjection;
+		uint8_t dirtyFaces = 0;
+		// 지금 타일에 한번이라도 그린 면. 모두 그려야 그림자를 쓴다.
+		uint8_t renderedFaces = 0;
+	};
+
+	struct FaceUpdate
+	{
+		Tile tile;
+		glm::mat4 viewProjection;
+		FrameVector<RenderObject> draws;
+	};
+
+	struct FrameResources
+	{
+		StorageBuffer shadows;		// 헤더 vec4 뒤에 GPUPointShadow * MaxShadowedLights
+		VkDescriptorSet set = VK_NULL_HANDLE;
+		bool timed = false;
+	};
+
+	void createRenderPass();
+	void createPipeline();
+	void createAtlas();
+	void destroyFrames();
+
+	void releaseSlot(Slot& slot);
+	bool allocateTiles(Slot& slot, uint32_t tileSize, uint32_t minTileSize);
+	void setLight(Slot& slot, const glm::vec3& position, float radius);
+	// 움직인 물체의 이전, 지금 상자가 걸친 면을 다시 그리게 표시한다.
+	void markMovedCasters(const TransformHierarchy& hierarchy);
+	void markFacesTouching(const AABB& bounds);
+	static uint32_t pickTileSize(float desiredSize, uint32_t currentSize);
+
+	VulkanTutorialExtension* engine = nullptr;
+	DevicePtr device;
+	VkPhysicalDeviceMemoryProperties memoryProperties{};
+	VkDevice setLayoutDevice = VK_NULL_HANDLE;
+	VkFormat depthFormat = VK_FORMAT_D16_UNORM;
+
+	VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+	VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+	VkRenderPass renderPass = VK_NULL_HANDLE;
+	VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+	VkPipeline pipeline = VK_NULL_HANDLE;
+
+	std::shared_ptr<AllocatedImage> atlas;
+	VkFramebuffer framebuffer = VK_NULL_HANDLE;
+	VkSampler sampler = VK_NULL_HANDLE;
+
+	// 스왑체인 이미지마다 시작, 끝 두 개
+	VkQueryPool queryPool = VK_NULL_HANDLE;
+	bool timestampsSupported = false;
+	float timestampPeriod = 1.f;
+	bool supported = false;
+
+	std::vector<FrameResources> frames;
+	TileAllocator allocator;
+	std::array<Slot, MaxShadowedLights> slots;
+	std::vector<FaceUpdate> faceUpdates;
+
+	// 메시 노드마다 지난번 본 월드 상자. 물체가 떠난 자리의 그림자도 지워야 하므로 이전 위치가 필요하다.
+	std::vector<AABB> casterBounds;
+	uint32_t casterStructureVersion = UINT32_MAX;
+
+	Stats stats;
+};
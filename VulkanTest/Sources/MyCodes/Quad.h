@@ -17,19 +17,19 @@ public:
 		if constexpr (std::is_same_v<T, VertexOnlyTex>) {
 			// For texture-only vertices (using vec2 texCoord)
 			mesh.vertexBuffer.vertices = {
-				{ {-1.0f, -1.0f, 0.0f} , {0.0f, 0.0f} },  // ϴ
-				{ { 1.0f, -1.0f, 0.0f} , {1.0f, 0.0f} },  // ϴ
-				{ { 1.0f,  1.0f, 0.0f} , {1.0f, 1.0f} },  // 
-				{ {-1.0f,  1.0f, 0.0f} , {0.0f, 1.0f} }   // »
+				{ {-1.0f, -1.0f, 0.0f} , {0.0f, 0.0f} },  // 좌하단
+				{ { 1.0f, -1.0f, 0.0f} , {1.0f, 0.0f} },  // 우하단
+				{ { 1.0f,  1.0f, 0.0f} , {1.0f, 1.0f} },  // 우상단
+				{ {-1.0f,  1.0f, 0.0f} , {0.0f, 1.0f} }   // 좌상단
 			};
 		}
 		else if constexpr (std::is_same_v<T, VertexOnlyPos>) {
 			// For vertices with position
 			mesh.vertexBuffer.vertices = {
-				{ {-1.0f, -1.0f, 0.0f} },  // ϴ
-				{ { 1.0f, -1.0f, 0.0f} },  // ϴ
-				{ { 1.0f,  1.0f, 0.0f} },  // 
-				{ {-1.0f,  1.0f, 0.0f} }   // »
+				{ {-1.0f, -1.0f, 0.0f} },  // 좌하단
+				{ { 1.0f, -1.0f, 0.0f} },  // 우하단
+				{ { 1.0f,  1.0f, 0.0f} },  // 우상단
+				{ {-1.0f,  1.0f, 0.0f} }   // 좌상단
 			};
 		}
 		else
@@ -38,8 +38,8 @@ public:
 		}
 
 		mesh.indexBuffer.indices = {
-			0, 1, 2,  // ù ° ﰢ
-			2, 3, 0   //  ° ﰢ
+			0, 1, 2,  // 첫 번째 삼각형
+			2, 3, 0   // 두 번째 삼각형
 		};
 
 		engine->createVertexBuffer(mesh.vertexBuffer.vertices, mesh.vertexBuffer.Buffer, mesh.vertexBuffer.BufferMemory);
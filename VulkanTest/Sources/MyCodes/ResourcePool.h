@@ -0,0 +1,168 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cassert>
+#include <utility>
+#include <algorithm>
+
+/**
+ * 세대(generation) 기반 핸들.
+ * index 는 슬롯 번호, generation 은 해당 슬롯이 재사용된 횟수이다.
+ * 슬롯이 해제되면 generation 이 증가하므로 이전에 발급된 핸들은 더 이상 유효하지 않다.
+ * shared_ptr 과 달리 복사해도 참조 카운트를 건드리지 않는다.
+ */
+template<typename T>
+struct Handle
+{
+	static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+	uint32_t index = InvalidIndex;
+	uint32_t generation = 0;
+
+	bool isValid() const { return index != InvalidIndex; }
+
+	bool operator==(const Handle& other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const Handle& other) const { return !(*this == other); }
+};
+
+/**
+ * Handle<T> 로 접근하는 dense 리소스 풀.
+ * 실제 객체는 dense 배열에 빈틈없이 저장되고, 슬롯 테이블이 핸들 -> dense 인덱스를 연결한다.
+ * 해제는 release() 로 예약만 해두고, GPU 가 더 이상 쓰지 않게 된 뒤 destroy() 로 실제로 제거한다.
+ * (GPU 가 아직 사용중일 수 있는 리소스를 바로 지우지 않기 위함. 언제 지울지는 소유자가 정한다.)
+ *
+ * NOTE : create() 나 destroy() 이후에는 dense 배열이 재배치 될 수 있으므로 get() 으로 얻은 포인터를 보관하지 않는다.
+ */
+template<typename T>
+class ResourcePool
+{
+public:
+	template<typename... Args>
+	Handle<T> create(Args&&... args)
+	{
+		uint32_t slotIndex;
+		if (!freeSlots.empty())
+		{
+			slotIndex = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else
+		{
+			slotIndex = static_cast<uint32_t>(slots.size());
+			slots.push_back({});
+		}
+
+		Slot& slot = slots[slotIndex];
+		slot.denseIndex = static_cast<uint32_t>(dense.size());
+		slot.pendingRelease = false;
+
+		dense.emplace_back(std::forward<Args>(args)...);
+		denseToSlot.push_back(slotIndex);
+
+		return Handle<T>{ slotIndex, slot.generation };
+	}
+
+	bool isAlive(Handle<T> handle) const
+	{
+		return handle.index < slots.size() && slots[handle.index].generation == handle.generation;
+	}
+
+	// 해제된 핸들이면 nullptr 를 반환한다.
+	T* get(Handle<T> handle)
+	{
+		if (!isAlive(handle))
+		{
+			staleLookupCount++;
+			return nullptr;
+		}
+		return &dense[slots[handle.index].denseIndex];
+	}
+
+	const T* get(Handle<T> handle) const
+	{
+		if (!isAlive(handle))
+		{
+			staleLookupCount++;
+			return nullptr;
+		}
+		return &dense[slots[handle.index].denseIndex];
+	}
+
+	T& operator[](Handle<T> handle)
+	{
+		assert(isAlive(handle) && "stale or invalid resource handle");
+		return dense[slots[handle.index].denseIndex];
+	}
+
+	/**
+	 * 해제를 예약한다. 핸들은 destroy() 가 불릴 때까지 유효하다.
+	 * 같은 핸들을 두 번 해제하거나 이미 제거된 핸들을 해제하면 false 를 반환한다.
+	 */
+	bool release(Handle<T> handle)
+	{
+		if (!isAlive(handle) || slots[handle.index].pendingRelease)
+		{
+			return false;
+		}
+
+		slots[handle.index].pendingRelease = true;
+		pendingReleaseCount++;
+		return true;
+	}
+
+	// release() 로 예약한 핸들을 제거한다. 마지막 원소를 빈 자리로 옮겨 dense 배열을 빈틈없이 유지한다.
+	void destroy(Handle<T> handle)
+	{
+		if (!isAlive(handle) || !slots[handle.index].pendingRelease)
+		{
+			return;
+		}
+
+		Slot& slot = slots[handle.index];
+		const uint32_t removedIndex = slot.denseIndex;
+		const uint32_t lastIndex = static_cast<uint32_t>(dense.size() - 1);
+
+		if (removedIndex != lastIndex)
+		{
+			dense[removedIndex] = std::move(dense[lastIndex]);
+			denseToSlot[removedIndex] = denseToSlot[lastIndex];
+			slots[denseToSlot[removedIndex]].denseIndex = removedIndex;
+		}
+
+		dense.pop_back();
+		denseToSlot.pop_back();
+
+		slot.generation++;
+		slot.pendingRelease = false;
+		freeSlots.push_back(handle.index);
+		pendingReleaseCount--;
+	}
+
+	template<typename Func>
+	void forEach(Func&& func)
+	{
+		for (T& item : dense)
+		{
+			func(item);
+		}
+	}
+
+	size_t size() const { return dense.size(); }
+	size_t getPendingReleaseCount() const { return pendingReleaseCount; }
+	uint64_t getStaleLookupCount() const { return staleLookupCount; }
+
+private:
+	struct Slot
+	{
+		uint32_t denseIndex = 0;
+		uint32_t generation = 0;
+		bool pendingRelease = false;
+	};
+
+	std::vector<T> dense;
+	std::vector<uint32_t> denseToSlot;
+	std::vector<Slot> slots;
+	std::vector<uint32_t> freeSlots;
+	size_t pendingReleaseCount = 0;
+	mutable uint64_t staleLookupCount = 0;
+};
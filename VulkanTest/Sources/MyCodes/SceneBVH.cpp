@@ -0,0 +1,168 @@
+#include "SceneBVH.h"
+#include "GPUResourcePools.h"
+#include "MeshLod.h"
+
+void SceneBVH::update(const TransformHierarchy& inTransforms)
+{
+	if (dirty || transforms != &inTransforms || structureVersion != inTransforms.getStructureVersion())
+	{
+		transforms = &inTransforms;
+		rebuild();
+		return;
+	}
+
+	// 마지막으로 맞춘 뒤 움직인 것이 없다.
+	const uint32_t sinceVersion = syncedVersion;
+	syncedVersion = transforms->getVersion();
+	if (transforms->getLastUpdateVersion() <= sinceVersion)
+	{
+		return;
+	}
+
+	for (const Item& item : items)
+	{
+		if (item.primitive != UINT32_MAX && transforms->wasUpdatedSince(item.transform, sinceVersion))
+		{
+			bvh.updatePrimitive(item.primitive, computeBounds(item));
+		}
+	}
+
+	bvh.refit();
+	stats.refits++;
+
+	if (bvh.needsRebuild())
+	{
+		std::vector<AABB> bounds;
+		bounds.reserve(primitiveItems.size());
+		for (uint32_t primitive = 0; primitive < primitiveItems.size(); primitive++)
+		{
+			bounds.push_back(bvh.getPrimitiveBounds(primitive));
+		}
+		bvh.build(bounds);
+		stats.nodes = bvh.getNodeCount();
+		stats.rebuilds++;
+	}
+}
+
+void SceneBVH::rebuild()
+{
+	items.clear();
+	primitiveItems.clear();
+	unboundedItems.clear();
+
+	GPUResourcePools& pools = GPUResourcePools::get();
+	for (const TransformHierarchy::MeshEntry& entry : transforms->getMeshEntries())
+	{
+		if (const MeshAsset<Vertex>* mesh = pools.meshes.get(entry.mesh))
+		{
+			for (uint32_t s = 0; s < mesh->surfaces.size(); s++)
+			{
+				Item item;
+				item.instance = entry.instance;
+				item.mesh = entry.mesh;
+				item.node = entry.node;
+				item.surface = s;
+				item.transform = entry.transform;
+				items.push_back(item);
+			}
+		}
+	}
+
+	std::vector<AABB> bounds;
+	for (uint32_t i = 0; i < items.size(); i++)
+	{
+		Item& item = items[i];
+
+		const MeshAsset<Vertex>* mesh = pools.meshes.get(item.mesh);
+		if (mesh->surfaces[item.surface].bounds.sphereRadius < 0.f)
+		{
+			unboundedItems.push_back(i);
+			continue;
+		}
+
+		item.primitive = static_cast<uint32_t>(primitiveItems.size());
+		primitiveItems.push_back(i);
+		bounds.push_back(computeBounds(item));
+	}
+	bvh.build(bounds);
+
+	dirty = false;
+	structureVersion = transforms->getStructureVersion();
+	syncedVersion = transforms->getVersion();
+	stats.items = static_cast<uint32_t>(items.size());
+	stats.nodes = bvh.getNodeCount();
+	stats.rebuilds++;
+}
+
+AABB SceneBVH::computeBounds(const Item& item) const
+{
+	const MeshAsset<Vertex>* mesh = GPUResourcePools::get().meshes.get(item.mesh);
+	const Bounds& bounds = mesh->surfaces[item.surface].bounds;
+	return AABB::fromTransformedBox(bounds.origin, bounds.extents, transforms->getWorldTransform(item.transform));
+}
+
+bool SceneBVH::emit(const Item& item, DrawContext& ctx) const
+{
+	// 메시는 지워질 때 markDirty 로 항목도 함께 빠지지만, 다음 update 전까지는 없는 핸들일 수 있다.
+	const MeshAsset<Vertex>* mesh = GPUResourcePools::get().meshes.get(item.mesh);
+	if (!mesh)
+	{
+		return false;
+	}
+	const uint64_t lodKey = ctx.lodSelector ? MeshLod::makeSelectionKey(item.instance, item.node, item.surface) : 0;
+	return ctx.addSurface(*mesh, mesh->surfaces[item.surface], transforms->getWorldTransform(item.transform), lodKey);
+}
+
+FrustumCulling::Stats SceneBVH::draw(const Frustum& frustum, DrawContext& ctx) const
+{
+	uint32_t visible = 0;
+	for (uint32_t itemIndex : unboundedItems)
+	{
+		visible += emit(items[itemIndex], ctx) ? 1 : 0;
+	}
+
+	bvh.queryFrustum(frustum, [&](uint32_t primitive) {
+		visible += emit(items[primitiveItems[primitive]], ctx) ? 1 : 0;
+	});
+
+	FrustumCulling::Stats cullingStats;
+	cullingStats.tested = static_cast<uint32_t>(items.size());
+	cullingStats.culled = cullingStats.tested - visible;
+	return cullingStats;
+}
+
+SceneBVH::Hit SceneBVH::makeHit(const BVH::RayHit& rayHit) const
+{
+	const Item& item = items[primitiveItems[rayHit.primitive]];
+
+	Hit hit;
+	hit.instanceIndex = static_cast<int>(item.instance);
+	hit.mesh = item.mesh;
+	hit.surface = item.surface;
+	hit.distance = rayHit.distance;
+	return hit;
+}
+
+bool SceneBVH::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Hit& outHit) const
+{
+	BVH::RayHit rayHit;
+	if (!bvh.raycast(origin, direction, maxDistance, rayHit))
+	{
+		outHit = Hit{};
+		return false;
+	}
+	outHit = makeHit(rayHit);
+	return true;
+}
+
+bool SceneBVH::findNearest(const glm::vec3& point, float maxDistance, Hit& outHit) const
+{
+	BVH::RayHit rayHit;
+	if (!bvh.findNearest(point, maxDistance, rayHit))
+	{
+		outHit = Hit{};
+		return false;
+	}
+	outHit = makeHit(rayHit);
+	return true;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "BVH.h"
+#include "FrustumCulling.h"
+#include "Vk_loader.h"
+#include "TransformHierarchy.h"
+
+/**
+ * sceneInstances 의 메시 서피스를 월드 AABB 로 감싸 BVH 에 담는다.
+ *
+ * 항목 하나는 (인스턴스, 메시 노드, 서피스) 이고 모델 행렬은 TransformHierarchy 의 월드 행렬이다.
+ * 계층 구조가 바뀌면(모델을 넣거나 빼면) 다시 만들고, 마지막으로 맞춘 뒤 월드 행렬이 바뀐 항목만 고쳐서 refit 한다.
+ * 컬링을 끈 동안 건너뛴 프레임의 움직임도 다음 update 에서 함께 반영한다.
+ * 경계를 모르는 서피스(sphereRadius < 0)는 BVH 밖에 두고 항상 그린다.
+ */
+class SceneBVH
+{
+public:
+	struct Stats
+	{
+		uint32_t items = 0;
+		uint32_t nodes = 0;
+		uint32_t rebuilds = 0;
+		uint32_t refits = 0;
+	};
+
+	struct Hit
+	{
+		int instanceIndex = -1;
+		MeshHandle mesh;
+		uint32_t surface = 0;
+		float distance = FLT_MAX;
+	};
+
+	void markDirty() { dirty = true; }
+
+	// 바뀐 월드 행렬을 반영한다. transforms.update 다음, 질의하기 전에 불러야 한다. 매 프레임 부르지 않아도 된다.
+	// transforms 는 이 객체보다 오래 남아야 한다.
+	void update(const TransformHierarchy& transforms);
+
+	// 프러스텀 안의 서피스를 ctx 에 넣는다.
+	FrustumCulling::Stats draw(const Frustum& frustum, DrawContext& ctx) const;
+	// 광선이 가장 먼저 지나는 서피스의 AABB 를 찾는다. direction 은 정규화되어 있어야 한다.
+	bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Hit& outHit) const;
+	// point 에서 가장 가까운 서피스의 AABB 를 찾는다.
+	bool findNearest(const glm::vec3& point, float maxDistance, Hit& outHit) const;
+
+	const Stats& getStats() const { return stats; }
+
+private:
+	struct Item
+	{
+		uint32_t instance = 0;
+		MeshHandle mesh;
+		// LOD 선택 키에만 쓴다. 장면이 바뀌면 항목을 다시 모으므로 노드보다 오래 남지 않는다.
+		const Node* node = nullptr;
+		uint32_t surface = 0;
+		// TransformHierarchy 항목 번호
+		uint32_t transform = 0;
+		// BVH 에 들어가지 않았으면 UINT32_MAX
+		uint32_t primitive = UINT32_MAX;
+	};
+
+	void rebuild();
+	AABB computeBounds(const Item& item) const;
+	bool emit(const Item& item, DrawContext& ctx) const;
+	Hit makeHit(const BVH::RayHit& rayHit) const;
+
+	std::vector<Item> items;
+	// BVH 프리미티브 -> items 인덱스
+	std::vector<uint32_t> primitiveItems;
+	std::vector<uint32_t> unboundedItems;
+
+	const TransformHierarchy* transforms = nullptr;
+	uint32_t structureVersion = 0;
+	// 마지막으로 경계를 맞춘 TransformHierarchy::getVersion()
+	uint32_t syncedVersion = 0;
+
+	BVH bvh;
+	bool dirty = true;
+	Stats stats;
+};
@@ -3,11 +3,12 @@
 #include "VulkanTools.h"       
 #include "vk_initializers.h"
 #include "vk_resource_utils.h"
+#include "GPUResourcePools.h"
 
-//   ʱȭ
+// 정적 변수 초기화
 std::unordered_map<uint32_t, size_t> SimplePipeline::TypeSizeTracker::typeSizes;
 
-// TypeSizeTracker ޼ҵ 
+// TypeSizeTracker 메소드 구현
 template<typename T>
 void SimplePipeline::TypeSizeTracker::registerType(uint32_t binding) {
     typeSizes[binding] = sizeof(T);
@@ -18,10 +19,10 @@ size_t SimplePipeline::TypeSizeTracker::getRegisteredSize(uint32_t binding) {
     if (it != typeSizes.end()) {
         return it->second;
     }
-    return 0; // ⺻
+    return 0; // 기본값
 }
 
-// DescriptorBuilder ޼ҵ 
+// DescriptorBuilder 메소드 구현
 SimplePipeline::DescriptorBuilder& SimplePipeline::DescriptorBuilder::addTexture(VkShaderStageFlags stageFlags) {
     VkDescriptorSetLayoutBinding binding{};
     binding.binding = currentBinding;
@@ -64,7 +65,7 @@ const std::vector<VkDescriptorSetLayoutBinding>& SimplePipeline::DescriptorBuild
     return bindings;
 }
 
-// SimplePipeline ޼ҵ 
+// SimplePipeline 메소드 구현
 SimplePipeline::SimplePipeline(VkExtent2D viewportExtent, std::string vertShaderPath, std::string fragShaderPath,
     RenderType renderType, VkDescriptorPool pool, int swapchainImageNum)
     : viewportExtent(viewportExtent)
@@ -80,7 +81,7 @@ SimplePipeline::DescriptorBuilder& SimplePipeline::getDescriptorBuilder() {
     return descriptorBuilder;
 }
 
-// ߰ ũ  ̾ƿ ο 
+// 추가 디스크립터 셋 레이아웃을 파이프라인에 포함
 void SimplePipeline::addExternalDescriptorSetLayout(VkDescriptorSetLayout externalLayout) {
     externalLayouts.push_back(externalLayout);
 }
@@ -94,7 +95,7 @@ void SimplePipeline::addExternalDescriptorSet(const std::vector<VkDescriptorSet>
 }
 
 void SimplePipeline::createDescriptorSetLayout(VkDevice device) {
-    // ũ  ̾ƿ 
+    // 디스크립터 빌더로 레이아웃 생성
     layout = descriptorBuilder.buildLayout(device);
 }
 
@@ -111,7 +112,7 @@ void SimplePipeline::allocateDescriptorSet(VkDevice device) {
     std::vector<VkDescriptorSetLayout> layouts(swapchainImageNum, layout);
     VkDescriptorSetAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocInfo.descriptorPool = descriptorPool;  // ο  Ǯ 
+    allocInfo.descriptorPool = descriptorPool;  // 내부에 저장된 풀 사용
     allocInfo.descriptorSetCount = layouts.size();
     allocInfo.pSetLayouts = layouts.data();
 
@@ -126,8 +127,8 @@ void SimplePipeline::buildPipeline(VulkanTutorialExtension* engine, std::functio
 
     createDescriptorSetLayout(device);
 
-    std::vector<VkDescriptorSetLayout> layouts = externalLayouts; // ܺ ̾ƿ  ߰
-    layouts.push_back(layout); // ڽ ̾ƿ  ߰
+    std::vector<VkDescriptorSetLayout> layouts = externalLayouts; // 외부 레이아웃을 먼저 추가
+    layouts.push_back(layout); // 자신의 레이아웃을 마지막에 추가
 
     VkPipelineLayoutCreateInfo mesh_layout_info = vkb::initializers::pipeline_layout_create_info(layouts.data(), layouts.size());
     mesh_layout_info.pPushConstantRanges = matrixRanges.data();
@@ -151,6 +152,8 @@ void SimplePipeline::buildPipeline(VulkanTutorialExtension* engine, std::functio
     VkPipelineDynamicStateCreateInfo dynamicState = vkb::initializers::pipeline_dynamic_state_create_info(dynamicStates);
 
     VkGraphicsPipelineCreateInfo pipelineCI = vkb::initializers::pipeline_create_info(newLayout, renderType == RenderType::forward ? engine->forward.renderPass : engine->geometry.renderPass);
+    // 렌더 패스를 바꾸는 modifyFunc 는 subpass 도 함께 맞춰야 한다.
+    pipelineCI.subpass = renderType == RenderType::forward ? engine->forward.subpass : engine->geometry.subpass;
     pipelineCI.pInputAssemblyState = &inputAssemblyState;
     pipelineCI.pRasterizationState = &rasterizationState;
     pipelineCI.pMultisampleState = &multisampleState;
@@ -168,6 +171,7 @@ void SimplePipeline::buildPipeline(VulkanTutorialExtension* engine, std::functio
     VkPipelineColorBlendStateCreateInfo colorBlendState;
 
     if (renderType == RenderType::deferred) {
+        VulkanTutorial::GeometryPass::writeStencil(depthStencilState);
         blendAttachmentStates = {
             vkb::initializers::pipeline_color_blend_attachment_state(0xf, VK_FALSE),
             vkb::initializers::pipeline_color_blend_attachment_state(0xf, VK_FALSE),
@@ -217,7 +221,7 @@ void SimplePipeline::buildPipeline(VulkanTutorialExtension* engine, std::functio
     vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
     pipelineCI.pVertexInputState = &vertexInputInfo;
 
-    //  ݹ Լ  ϰ
+    // 사용자 콜백 함수로 수정 가능하게
     if (modifyFunc) {
         modifyFunc(pipelineCI);
     }
@@ -227,7 +231,7 @@ void SimplePipeline::buildPipeline(VulkanTutorialExtension* engine, std::functio
     vkDestroyShaderModule(device, meshVertexShader, nullptr);
     vkDestroyShaderModule(device, meshFragShader, nullptr);
 
-    // ũ  Ҵ
+    // 디스크립터 셋 할당
     allocateDescriptorSet(device);
 }
 
@@ -245,7 +249,7 @@ void SimplePipeline::updateTextureDescriptor(VkDevice device, uint32_t index, ui
 
     VkWriteDescriptorSet write{};
     write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    write.dstSet = descriptorSets[index];  //  ũ  
+    write.dstSet = descriptorSets[index];  // 내부 디스크립터 셋 사용
     write.dstBinding = binding;
     write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
     write.descriptorCount = 1;
@@ -262,7 +266,7 @@ void SimplePipeline::updateBufferDescriptor(VkDevice device, uint32_t index, uin
         throw std::runtime_error("Binding is not a buffer descriptor");
     }
 
-    // ϵ Ÿ ũ 
+    // 등록된 타입 크기 사용
     VkDeviceSize range = TypeSizeTracker::getRegisteredSize(binding);
     if (range == 0) {
         throw std::runtime_error("Buffer size not registered for binding");
@@ -275,7 +279,7 @@ void SimplePipeline::updateBufferDescriptor(VkDevice device, uint32_t index, uin
 
     VkWriteDescriptorSet write{};
     write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    write.dstSet = descriptorSets[index];  //  ũ  
+    write.dstSet = descriptorSets[index];  // 내부 디스크립터 셋 사용
     write.dstBinding = binding;
     write.descriptorType = type;
     write.descriptorCount = 1;
@@ -300,7 +304,7 @@ void SimplePipeline::updateBufferDescriptor(VkDevice device, uint32_t index, uin
 
     VkWriteDescriptorSet write{};
     write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    write.dstSet = descriptorSets[index];  //  ũ  
+    write.dstSet = descriptorSets[index];  // 내부 디스크립터 셋 사용
     write.dstBinding = binding;
     write.descriptorType = type;
     write.descriptorCount = 1;
@@ -309,17 +313,17 @@ void SimplePipeline::updateBufferDescriptor(VkDevice device, uint32_t index, uin
     vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
 }
 
-std::shared_ptr<MaterialInstance> SimplePipeline::makeMaterial() {
+MaterialHandle SimplePipeline::makeMaterial() {
 	
-    auto material = std::make_shared<MaterialInstance>();
-	material->pipeline = &pipeline;  // ڽ MaterialPipeline Ŵ
-	material->materialSet = descriptorSets;  // ڽ  ߰
-	material->passType = renderType == RenderType::forward ? MaterialPass::Transparent : MaterialPass::MainColor;
+    MaterialInstance material;
+	material.pipeline = &pipeline;  // 자신의 MaterialPipeline을 가리킴
+	material.materialSet = descriptorSets;  // 자신의 셋 추가
+	material.passType = renderType == RenderType::forward ? MaterialPass::Transparent : MaterialPass::MainColor;
 
-	return material;
+	return GPUResourcePools::get().materials.create(std::move(material));
 }
 
-// Ǫ   ߰
+// 푸시 상수 범위 추가
 void SimplePipeline::addPushConstantRange(VkShaderStageFlags stageFlags, uint32_t size, uint32_t offset) {
     VkPushConstantRange range{};
     range.stageFlags = stageFlags;
@@ -329,19 +333,19 @@ void SimplePipeline::addPushConstantRange(VkShaderStageFlags stageFlags, uint32_
 }
 
 void SimplePipeline::cleanup(VkDevice device) {
-    //  ü 
+    // 파이프라인 객체 정리
     if (pipeline.pipeline != VK_NULL_HANDLE) {
         vkDestroyPipeline(device, pipeline.pipeline, nullptr);
         pipeline.pipeline = VK_NULL_HANDLE;
     }
 
-    //  ̾ƿ 
+    // 파이프라인 레이아웃 정리
     if (pipeline.layout != VK_NULL_HANDLE) {
         vkDestroyPipelineLayout(device, pipeline.layout, nullptr);
         pipeline.layout = VK_NULL_HANDLE;
     }
 
-    // ũ  ̾ƿ 
+    // 디스크립터 셋 레이아웃 정리
     if (layout != VK_NULL_HANDLE) {
         vkDestroyDescriptorSetLayout(device, layout, nullptr);
         layout = VK_NULL_HANDLE;
@@ -23,7 +23,7 @@ public:
 	};
 
 private:
-	//   ϱ  Ÿ  
+	// 사이즈 정보를 추적하기 위한 타입 매핑 헬퍼
 	class TypeSizeTracker {
 	public:
 		template<typename T>
@@ -40,7 +40,7 @@ private:
 		static std::unordered_map<uint32_t, size_t> typeSizes;
 	};
 
-	// ũ   Ŭ
+	// 디스크립터 빌더 내부 클래스
 	class DescriptorBuilder {
 	private:
 		std::vector<VkDescriptorSetLayoutBinding> bindings;
@@ -48,10 +48,10 @@ private:
 		uint32_t currentBinding = 0;
 
 	public:
-		// ؽó ߰
+		// 텍스처 추가
 		DescriptorBuilder& addTexture(VkShaderStageFlags stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT);
 
-		// øȭ   ߰
+		// 템플릿화된 유니폼 버퍼 추가
 		template<typename T>
 		DescriptorBuilder& addUniformBuffer(VkShaderStageFlags stageFlags = VK_SHADER_STAGE_VERTEX_BIT) {
 			VkDescriptorSetLayoutBinding binding{};
@@ -62,14 +62,14 @@ private:
 			bindings.push_back(binding);
 			descriptorTypes.push_back(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
 
-			// Ÿ ũ 
+			// 타입 크기 등록
 			TypeSizeTracker::registerType<T>(currentBinding);
 
 			currentBinding++;
 			return *this;
 		}
 
-		// øȭ 丮  ߰
+		// 템플릿화된 스토리지 버퍼 추가
 		template<typename T>
 		DescriptorBuilder& addStorageBuffer(VkShaderStageFlags stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT) {
 			VkDescriptorSetLayoutBinding binding{};
@@ -80,31 +80,31 @@ private:
 			bindings.push_back(binding);
 			descriptorTypes.push_back(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
 
-			// Ÿ ũ 
+			// 타입 크기 등록
 			TypeSizeTracker::registerType<T>(currentBinding);
 
 			currentBinding++;
 			return *this;
 		}
 
-		// ũ ̾ƿ 
+		// 디스크립터 레이아웃 생성
 		VkDescriptorSetLayout buildLayout(VkDevice device) const;
 
-		// Ư ε ũ Ÿ 
+		// 특정 바인딩의 디스크립터 타입 가져오기
 		VkDescriptorType getDescriptorType(uint32_t binding) const;
 
-		// ε  ȯ
+		// 바인딩 개수 반환
 		size_t getBindingCount() const;
 
-		//  ̾ƿ ε 
+		// 상수 레이아웃 바인딩 가져오기
 		const std::vector<VkDescriptorSetLayoutBinding>& getBindings() const;
 	};
 
 	VkDescriptorSetLayout layout;
 	MaterialPipeline pipeline;
-	VkDescriptorPool descriptorPool;  // ũ Ǯ  ( )
-	std::vector<VkDescriptorSet> descriptorSets; //  ũ  
-	std::vector<VkDescriptorSetLayout> externalLayouts; // ܺ ̾ƿ 
+	VkDescriptorPool descriptorPool;  // 디스크립터 풀 참조 (소유권 없음)
+	std::vector<VkDescriptorSet> descriptorSets; // 내부적으로 디스크립터 셋 관리
+	std::vector<VkDescriptorSetLayout> externalLayouts; // 외부 레이아웃 저장
 	std::vector<VkDescriptorSet> externalDescriptorSets;
 
 protected:
@@ -122,7 +122,7 @@ public:
 	SimplePipeline(VkExtent2D viewportExtent, std::string vertShaderPath, std::string fragShaderPath,
 		RenderType renderType, VkDescriptorPool pool, int swapchainImageNum);
 
-	// ũ  
+	// 디스크립터 빌더 가져오기
 	DescriptorBuilder& getDescriptorBuilder();
 
 	virtual void createDescriptorSetLayout(VkDevice device);
@@ -132,30 +132,30 @@ public:
 	void addExternalDescriptorSet(VkDescriptorSet externalDescriptorSet);
 	void addExternalDescriptorSet(const std::vector<VkDescriptorSet>& externalDescriptorSet);
 
-	// ũ  Ҵ
+	// 디스크립터 셋 할당
 	void allocateDescriptorSet(VkDevice device);
 	void buildPipeline(VulkanTutorialExtension* engine, std::function<void(VkGraphicsPipelineCreateInfo&)> modifyFunc = nullptr);
 
-	// ؽó ũ Ʈ
+	// 텍스처 디스크립터 업데이트
 	void updateTextureDescriptor(VkDevice device, uint32_t index, uint32_t binding,
 		VkImageView imageView, VkSampler sampler,
 		VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
-	//  ũ Ʈ (ڵ ũ)
+	// 버퍼 디스크립터 업데이트 (자동 크기)
 	void updateBufferDescriptor(VkDevice device, uint32_t index, uint32_t binding,
 		VkBuffer buffer, VkDeviceSize offset = 0);
 
-	//  ũ Ʈ ( ũ)
+	// 버퍼 디스크립터 업데이트 (명시적 크기)
 	void updateBufferDescriptor(VkDevice device, uint32_t index, uint32_t binding,
 		VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
 
-	// Ǫ   ߰
+	// 푸시 상수 범위 추가
 	void addPushConstantRange(VkShaderStageFlags stageFlags, uint32_t size, uint32_t offset = 0);
 
 	void cleanup(VkDevice device);
 
-	// pipeline ͷ  ° Ҿ.
-	std::shared_ptr<MaterialInstance> makeMaterial();
+	// pipeline을 포인터로 갖고 가는게 불안함.
+	MaterialHandle makeMaterial();
 	MaterialPipeline& getPipeline() { return pipeline; }
 	std::vector<VkDescriptorSet>& getDescriptorSets() { return descriptorSets; }
 };
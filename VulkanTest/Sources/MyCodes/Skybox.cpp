@@ -8,6 +8,7 @@
 #include "Vertex.h"
 #include "SimplePipeline.h"
 #include "IrradianceCubeMap.h"
+#include "GPUResourcePools.h"
 
 void Skybox::initialize(VulkanTutorialExtension* engine)
 {
@@ -57,13 +58,14 @@ void Skybox::initialize(VulkanTutorialExtension* engine)
 
 void Skybox::update(uint32_t currentImage)
 {
-	// vkUpdateDescriptorSets   θ° ƴϴ. 
-	// ̰ ѹ θ ⿡ ε ͸ Ʈϴ ̴. 
-	// ⼭ ̷ update   ʿ䰡 . 
+	// vkUpdateDescriptorSets를 매 프레임 부르는게 아니다. 
+	// 이건 한번만 부르고 여기에 바인딩된 데이터를 업데이트하는 것이다. 
+	// 여기서 이렇게 update를 매 프레임할 필요가 없다. 
 }
 
 void Skybox::cleanup(VkDevice device)
 {
+	GPUResourcePools::get().releaseMaterial(renderObject.material);
 	cube->cleanUp(device);
 	pipeline->cleanup(device);
 }
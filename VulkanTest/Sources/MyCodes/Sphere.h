@@ -64,7 +64,7 @@ struct Sphere
             oddRow = !oddRow;
         }
 
-        // ﰢ Ʈ ﰢ  ȯ (Vulkan ﰢ   Ϲ)
+        // 삼각형 스트립을 삼각형 목록으로 변환 (Vulkan에서는 삼각형 목록이 더 일반적)
         std::vector<uint32_t> triangleListIndices;
         for (size_t i = 0; i < indices.size() - 2; ++i)
         {
@@ -82,7 +82,7 @@ struct Sphere
             }
         }
 
-        //   
+        // 정점 데이터 생성
         if constexpr (std::is_same_v<T, VertexOnlyPos>)
         {
             mesh.vertexBuffer.vertices.resize(positions.size());
@@ -101,11 +101,11 @@ struct Sphere
         }
         else if constexpr (std::is_same_v<T, Vertex>)
         {
-            // źƮ źƮ   غ
+            // 탄젠트와 바이탄젠트 계산을 위한 준비
             std::vector<glm::vec3> tangents(positions.size(), glm::vec3(0.0f));
             std::vector<glm::vec3> bitangents(positions.size(), glm::vec3(0.0f));
 
-            // ﰢ źƮ źƮ 
+            // 삼각형별로 탄젠트와 바이탄젠트 계산
             for (size_t i = 0; i < triangleListIndices.size(); i += 3)
             {
                 uint32_t idx0 = triangleListIndices[i];
@@ -132,7 +132,7 @@ struct Sphere
 
                 if (std::abs(denominator) < 0.0000001f)
                 {
-                    // UV ǥ ߺǰų  ִ  ⺻ 
+                    // UV 좌표가 중복되거나 문제가 있는 경우 기본값 사용
                     tangent = glm::vec3(1.0f, 0.0f, 0.0f);
                     bitangent = glm::vec3(0.0f, 1.0f, 0.0f);
                 }
@@ -149,7 +149,7 @@ struct Sphere
                     bitangent.z = f * (-deltaUV2.x * edge1.z + deltaUV1.x * edge2.z);
                 }
 
-                // ̰ 0  ⺻ 
+                // 길이가 0에 가까우면 기본값 사용
                 if (glm::length(tangent) > 0.0000001f)
                 {
                     tangent = glm::normalize(tangent);
@@ -168,7 +168,7 @@ struct Sphere
                     bitangent = glm::vec3(0.0f, 1.0f, 0.0f);
                 }
 
-                //   źƮ źƮ ߰
+                // 각 정점에 탄젠트와 바이탄젠트 추가
                 tangents[idx0] += tangent;
                 tangents[idx1] += tangent;
                 tangents[idx2] += tangent;
@@ -178,7 +178,7 @@ struct Sphere
                 bitangents[idx2] += bitangent;
             }
 
-            //    źƮ źƮ ȭ
+            // 각 정점의 최종 탄젠트와 바이탄젠트 정규화
             for (size_t i = 0; i < tangents.size(); ++i)
             {
                 if (glm::length(tangents[i]) > 0.0000001f)
@@ -200,7 +200,7 @@ struct Sphere
                 }
             }
 
-            //   
+            // 정점 데이터 생성
             const glm::vec3 defaultColor = glm::vec3(1.0f, 1.0f, 1.0f);
             mesh.vertexBuffer.vertices.resize(positions.size());
             for (size_t i = 0; i < positions.size(); ++i)
@@ -221,21 +221,21 @@ struct Sphere
         }
 
 #if DEBUG_MODEL
-        // ﰢ   ׽Ʈ ڵ ߰
+        // 삼각형 감김 방향 테스트 코드 추가
         {
             std::cout << "Analyzing winding order for sphere mesh...\n";
             int ccwCount = 0;
             int cwCount = 0;
 
             auto isCounterClockwise = [](const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& normal) -> bool {
-                // ﰢ   
+                // 삼각형의 두 엣지 계산
                 glm::vec3 edge1 = p1 - p0;
                 glm::vec3 edge2 = p2 - p0;
 
-                //   ﰢ  
+                // 외적을 통해 삼각형의 법선 계산
                 glm::vec3 computedNormal = glm::cross(edge1, edge2);
 
-                //   ־   ġϴ Ȯ
+                // 계산된 법선과 주어진 법선의 방향이 일치하는지 확인
                 return glm::dot(computedNormal, normal) > 0.0f;
                 };
 
@@ -247,7 +247,7 @@ struct Sphere
                 glm::vec3 p0 = positions[idx0];
                 glm::vec3 p1 = positions[idx1];
                 glm::vec3 p2 = positions[idx2];
-                glm::vec3 normal = normals[idx0]; //    ġ ȭ  
+                glm::vec3 normal = normals[idx0]; // 구의 경우 정점 위치가 정규화된 법선과 동일
 
                 bool isCCW = isCounterClockwise(p0, p1, p2, normal);
 
@@ -258,7 +258,7 @@ struct Sphere
                     cwCount++;
                 }
 
-                // ù 10 ﰢ м  
+                // 첫 10개 삼각형의 분석 결과 출력
                 if (i / 3 < 10) {
                     std::cout << "Triangle " << (i / 3) << ": "
                         << (isCCW ? "CCW" : "CW") << "\n";
@@ -30,6 +30,7 @@ void TextureViewer::createPipeline(VulkanTutorialExtension* engine)
 	pipeline->getDescriptorBuilder().addTexture(VK_SHADER_STAGE_FRAGMENT_BIT);
 	pipeline->buildPipeline(engine, [renderPass = engine->getDefaultRenderPass()](VkGraphicsPipelineCreateInfo& pipelineCI) {
 		pipelineCI.renderPass = renderPass;
+		pipelineCI.subpass = 0;
 		auto* depthStencil = const_cast<VkPipelineDepthStencilStateCreateInfo*>(pipelineCI.pDepthStencilState);
 		depthStencil->depthTestEnable = VK_FALSE;
 		depthStencil->depthWriteEnable = VK_FALSE;
@@ -43,7 +44,7 @@ void TextureViewer::createPipeline(VulkanTutorialExtension* engine)
 
 void TextureViewer::updateTextureIfNeeded(VulkanTutorialExtension* engine, size_t index) 
 {
-	// ؽó ε  쿡 Ʈ
+	// 텍스처 인덱스가 변경된 경우에만 업데이트
 	if (((lastUpdatedIndex[index] != targetTextureIndex) || (lastUpdatedMipLevel[index] != selectedMipLevel) || (lastUpdatedCubeMapFace[index] != selectedCubeMapFace))
 	&& !textures.empty() && (textures[targetTextureIndex].image || textures[targetTextureIndex].cubeMap)) 
 	{
@@ -72,7 +73,8 @@ void TextureViewer::draw(VkCommandBuffer commandBuffer, VulkanTutorialExtension*
 {
 	updateTextureIfNeeded(engine, index);
 
-	VkExtent2D Res = engine->getSwapchainExtent();
+	// 디버그 패스도 라이팅 패스와 같은 타겟에 그리므로 내부 해상도 영역에 맞춘다.
+	VkExtent2D Res = engine->getRenderExtent();
 
 	VkViewport viewport = vkb::initializers::viewport(static_cast<float>(Res.width), static_cast<float>(Res.height), 0.0f, 1.0f);
 	VkRect2D scissor = vkb::initializers::rect2D(Res.width, Res.height, 0, 0);
@@ -0,0 +1,276 @@
+#include "TransformHierarchy.h"
+#include "GPUResourcePools.h"
+#include "MeshLod.h"
+
+#include <algorithm>
+#include <future>
+#include <thread>
+
+void TransformHierarchy::update(const std::vector<LoadedGLTFInstance>& instances, const std::unordered_map<std::string, std::shared_ptr<LoadedGLTF>>& scenes)
+{
+	if (structureDirty || instances.size() != instanceRoots.size())
+	{
+		clear();
+		for (uint32_t i = 0; i < instances.size(); i++)
+		{
+			static const std::vector<std::shared_ptr<Node>> noNodes;
+			auto scene = scenes.find(instances[i].modelName);
+			const bool loaded = scene != scenes.end() && scene->second;
+			addInstance(i, instances[i].transform, loaded ? scene->second->topNodes : noNodes);
+		}
+		structureDirty = false;
+		stats.rebuilds++;
+	}
+	else
+	{
+		for (uint32_t i = 0; i < instances.size(); i++)
+		{
+			if (instances[i].transform != localTransforms[instanceRoots[i]])
+			{
+				setLocalTransform(instanceRoots[i], instances[i].transform);
+			}
+		}
+	}
+
+	propagate();
+}
+
+void TransformHierarchy::clear()
+{
+	parents.clear();
+	subtreeEnds.clear();
+	localTransforms.clear();
+	worldTransforms.clear();
+	dirtyFlags.clear();
+	updateVersions.clear();
+	instanceRoots.clear();
+	meshEntries.clear();
+	dirtyRoots.clear();
+
+	structureVersion++;
+	stats.nodes = 0;
+	stats.meshNodes = 0;
+}
+
+uint32_t TransformHierarchy::addInstance(uint32_t instance, const glm::mat4& transform, const std::vector<std::shared_ptr<Node>>& topNodes)
+{
+	const uint32_t root = static_cast<uint32_t>(parents.size());
+	parents.push_back(-1);
+	subtreeEnds.push_back(root + 1);
+	localTransforms.push_back(transform);
+	worldTransforms.push_back(transform);
+	dirtyFlags.push_back(0);
+	updateVersions.push_back(0);
+
+	for (const std::shared_ptr<Node>& node : topNodes)
+	{
+		addNode(*node, static_cast<int32_t>(root), instance);
+	}
+	subtreeEnds[root] = static_cast<uint32_t>(parents.size());
+
+	if (instanceRoots.size() <= instance)
+	{
+		instanceRoots.resize(instance + 1, 0);
+	}
+	instanceRoots[instance] = root;
+
+	// 새 서브트리는 한번 계산해야 한다.
+	setLocalTransform(root, transform);
+
+	structureVersion++;
+	stats.nodes = static_cast<uint32_t>(parents.size());
+	stats.meshNodes = static_cast<uint32_t>(meshEntries.size());
+	return root;
+}
+
+uint32_t TransformHierarchy::addNode(const Node& node, int32_t parent, uint32_t instance)
+{
+	const uint32_t index = static_cast<uint32_t>(parents.size());
+	parents.push_back(parent);
+	subtreeEnds.push_back(index + 1);
+	localTransforms.push_back(node.localTransform);
+	worldTransforms.push_back(glm::mat4(1.f));
+	dirtyFlags.push_back(0);
+	updateVersions.push_back(0);
+
+	if (const MeshNode* meshNode = dynamic_cast<const MeshNode*>(&node))
+	{
+		meshEntries.push_back({ index, instance, &node, meshNode->mesh });
+	}
+
+	// 로드할 때 한번만 따라 내려가므로 재귀로 충분하다.
+	for (const std::shared_ptr<Node>& child : node.children)
+	{
+		addNode(*child, static_cast<int32_t>(index), instance);
+	}
+	subtreeEnds[index] = static_cast<uint32_t>(parents.size());
+	return index;
+}
+
+void TransformHierarchy::setLocalTransform(uint32_t index, const glm::mat4& transform)
+{
+	localTransforms[index] = transform;
+	if (!dirtyFlags[index])
+	{
+		dirtyFlags[index] = 1;
+		dirtyRoots.push_back(index);
+	}
+}
+
+void TransformHierarchy::propagate(uint32_t maxThreads)
+{
+	version++;
+	stats.updatedNodes = 0;
+	stats.chunks = 0;
+	if (dirtyRoots.empty())
+	{
+		return;
+	}
+
+	// 표시된 항목을 앞에서부터 보며 다른 표시된 서브트리 안에 든 것은 버린다. 남은 구간은 서로 겹치지 않는다.
+	std::sort(dirtyRoots.begin(), dirtyRoots.end());
+	ranges.clear();
+	uint32_t coveredEnd = 0;
+	uint32_t totalNodes = 0;
+	for (uint32_t root : dirtyRoots)
+	{
+		dirtyFlags[root] = 0;
+		if (root < coveredEnd)
+		{
+			continue;
+		}
+		ranges.push_back({ root, subtreeEnds[root] });
+		coveredEnd = subtreeEnds[root];
+		totalNodes += coveredEnd - root;
+	}
+	dirtyRoots.clear();
+	stats.updatedNodes = totalNodes;
+	if (totalNodes > 0)
+	{
+		lastUpdateVersion = version;
+	}
+
+	const uint32_t coreCount = std::max(1u, std::thread::hardware_concurrency());
+	const uint32_t threadCount = std::min({ maxThreads == 0 ? coreCount : maxThreads, coreCount, totalNodes / MinNodesPerChunk });
+	if (threadCount <= 1)
+	{
+		for (const Range& range : ranges)
+		{
+			computeRange(range.begin, range.end);
+		}
+		stats.chunks = static_cast<uint32_t>(ranges.size());
+		return;
+	}
+
+	// 스레드마다 몇 조각씩 돌아가도록 잘게 나눈다. 나눌 때 조각의 부모는 여기서 먼저 계산한다.
+	const uint32_t chunkSize = std::max(MinNodesPerChunk / 4, totalNodes / (threadCount * 4));
+	chunks.clear();
+	for (const Range& range : ranges)
+	{
+		splitRange(range.begin, range.end, chunkSize, chunks);
+	}
+	stats.chunks = static_cast<uint32_t>(chunks.size());
+
+	// 조각을 노드 수가 비슷하도록 이어서 스레드에 나눈다. 조각끼리는 겹치지 않으므로 잠그지 않는다.
+	std::vector<std::future<void>> workers;
+	uint32_t firstChunk = 0;
+	uint32_t remainingNodes = 0;
+	for (const Range& chunk : chunks)
+	{
+		remainingNodes += chunk.end - chunk.begin;
+	}
+	for (uint32_t thread = 0; thread < threadCount && firstChunk < chunks.size(); thread++)
+	{
+		const uint32_t share = remainingNodes / (threadCount - thread);
+		uint32_t lastChunk = firstChunk;
+		uint32_t nodes = 0;
+		while (lastChunk < chunks.size() && (nodes < share || lastChunk == firstChunk))
+		{
+			nodes += chunks[lastChunk].end - chunks[lastChunk].begin;
+			lastChunk++;
+		}
+		remainingNodes -= nodes;
+
+		auto work = [this, firstChunk, lastChunk]()
+		{
+			for (uint32_t c = firstChunk; c < lastChunk; c++)
+			{
+				computeRange(chunks[c].begin, chunks[c].end);
+			}
+		};
+		// 마지막 몫은 이 스레드가 맡는다.
+		if (thread + 1 == threadCount || lastChunk == chunks.size())
+		{
+			work();
+		}
+		else
+		{
+			workers.push_back(std::async(std::launch::async, work));
+		}
+		firstChunk = lastChunk;
+	}
+
+	for (std::future<void>& worker : workers)
+	{
+		worker.get();
+	}
+}
+
+void TransformHierarchy::computeRange(uint32_t begin, uint32_t end)
+{
+	// 전위 순서라 부모는 이미 계산되어 있다.
+	for (uint32_t i = begin; i < end; i++)
+	{
+		const int32_t parent = parents[i];
+		worldTransforms[i] = parent < 0 ? localTransforms[i] : worldTransforms[parent] * localTransforms[i];
+		updateVersions[i] = version;
+	}
+}
+
+void TransformHierarchy::splitRange(uint32_t begin, uint32_t end, uint32_t chunkSize, std::vector<Range>& outChunks)
+{
+	if (end - begin <= chunkSize)
+	{
+		// 바로 앞 조각과 이어져 있으면 합친다. 앞 조각도 온전한 서브트리들이라 부모가 이 조각 안에 있을 수 없다.
+		if (!outChunks.empty() && outChunks.back().end == begin && outChunks.back().end - outChunks.back().begin + (end - begin) <= chunkSize)
+		{
+			outChunks.back().end = end;
+		}
+		else
+		{
+			outChunks.push_back({ begin, end });
+		}
+		return;
+	}
+
+	computeRange(begin, begin + 1);
+	for (uint32_t child = begin + 1; child < end; child = subtreeEnds[child])
+	{
+		splitRange(child, subtreeEnds[child], chunkSize, outChunks);
+	}
+}
+
+void TransformHierarchy::draw(DrawContext& ctx) const
+{
+	GPUResourcePools& pools = GPUResourcePools::get();
+	for (const MeshEntry& entry : meshEntries)
+	{
+		const MeshAsset<Vertex>* mesh = pools.meshes.get(entry.mesh);
+		if (!mesh)
+		{
+			LOG(Warning, "MeshNode has a stale mesh handle (index {}, generation {})", entry.mesh.index, entry.mesh.generation);
+			continue;
+		}
+
+		ctx.instanceIndex = entry.instance;
+		const glm::mat4& transform = worldTransforms[entry.transform];
+		for (uint32_t s = 0; s < mesh->surfaces.size(); s++)
+		{
+			const uint64_t lodKey = ctx.lodSelector ? MeshLod::makeSelectionKey(entry.instance, entry.node, s) : 0;
+			if (!ctx.addSurface(*mesh, mesh->surfaces[s], transform, lodKey))
+			{
+				LOG(Warning, "surface of mesh {} has a stale material handle", mesh->name);
+			}
+		}
+	}
+}
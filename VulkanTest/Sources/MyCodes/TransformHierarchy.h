@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Vk_loader.h"
+
+#include <vector>
+
+/**
+ * sceneInstances 의 노드 행렬을 전위 순서의 평평한 배열(SoA)에 담는다.
+ *
+ * 인스턴스마다 루트 항목 하나(로컬 행렬 = 인스턴스 행렬)를 두고 그 아래에 모델의 노드를 전위 순서로 넣는다.
+ * 부모는 항상 자식보다 앞에 있고 i 의 서브트리는 [i, subtreeEnds[i]) 로 이어져 있으므로,
+ * 로컬 행렬이 바뀐 항목의 서브트리 구간만 앞에서부터 한 번 훑으면 월드 행렬이 맞춰진다.
+ * 월드 행렬에는 인스턴스 행렬이 이미 곱해져 있어 그릴 때 다시 곱하지 않는다. 바뀐 것이 없으면 propagate 는 바로 돌아간다.
+ * 바뀐 구간이 크면 서로 겹치지 않는 서브트리 조각으로 나눠 여러 스레드에서 계산한다.
+ *
+ * Node 의 localTransform/worldTransform 은 로드할 때의 값으로 남고, 매 프레임 쓰는 행렬은 여기 있다.
+ */
+class TransformHierarchy
+{
+public:
+	// 한 스레드가 맡는 최소 노드 수. 이보다 적으면 스레드를 띄우는 비용이 더 크다.
+	static constexpr uint32_t MinNodesPerChunk = 2048;
+
+	struct Stats
+	{
+		uint32_t nodes = 0;
+		uint32_t meshNodes = 0;
+		// 마지막 propagate 에서 다시 계산한 노드 수와 나눈 조각 수
+		uint32_t updatedNodes = 0;
+		uint32_t chunks = 0;
+		uint32_t rebuilds = 0;
+	};
+
+	// 메시가 붙은 노드. 서피스는 모두 같은 월드 행렬을 쓴다.
+	struct MeshEntry
+	{
+		uint32_t transform = 0;
+		uint32_t instance = 0;
+		const Node* node = nullptr;
+		MeshHandle mesh;
+	};
+
+	// 모델을 넣거나 빼면 불러서 다음 update 에서 배열을 다시 만든다.
+	void markDirty() { structureDirty = true; }
+
+	// 인스턴스 행렬을 루트 항목과 비교해 바뀐 것만 표시하고 propagate 한다. 매 프레임 드로우 목록을 만들기 전에 부른다.
+	void update(const std::vector<LoadedGLTFInstance>& instances, const std::unordered_map<std::string, std::shared_ptr<LoadedGLTF>>& scenes);
+
+	void clear();
+	// 인스턴스 루트 항목과 그 아래 노드를 넣고 루트 항목 번호를 반환한다. 월드 행렬은 다음 propagate 에서 계산한다.
+	uint32_t addInstance(uint32_t instance, const glm::mat4& transform, const std::vector<std::shared_ptr<Node>>& topNodes);
+	// 로컬 행렬을 바꾸고 다음 propagate 에서 서브트리를 다시 계산하게 표시한다.
+	void setLocalTransform(uint32_t index, const glm::mat4& transform);
+	// 표시된 서브트리의 월드 행렬을 다시 계산한다. maxThreads 가 0 이면 코어 수만큼 쓴다.
+	void propagate(uint32_t maxThreads = 0);
+
+	// 배열을 다시 만들 때마다 바뀐다. 항목 번호를 들고 있는 쪽은 값이 다르면 번호를 새로 받아야 한다.
+	uint32_t getStructureVersion() const { return structureVersion; }
+	// 마지막 propagate 에서 월드 행렬을 다시 계산한 항목인지
+	bool wasUpdated(uint32_t index) const { return updateVersions[index] == version; }
+	bool hasUpdates() const { return stats.updatedNodes > 0; }
+	// 여러 프레임에 한번 따라잡는 쪽이 쓴다. 마지막으로 본 getVersion() 이후 월드 행렬이 바뀐 항목인지
+	bool wasUpdatedSince(uint32_t index, uint32_t sinceVersion) const { return updateVersions[index] > sinceVersion; }
+	uint32_t getVersion() const { return version; }
+	// 월드 행렬을 하나라도 다시 계산한 마지막 propagate 의 버전
+	uint32_t getLastUpdateVersion() const { return lastUpdateVersion; }
+
+	uint32_t getNodeCount() const { return static_cast<uint32_t>(parents.size()); }
+	const glm::mat4& getWorldTransform(uint32_t index) const { return worldTransforms[index]; }
+	const std::vector<MeshEntry>& getMeshEntries() const { return meshEntries; }
+
+	// 메시 노드의 서피스를 모두 ctx 에 넣는다. 매 프레임 Node::Draw 로 트리를 따라 내려가는 대신 쓴다.
+	void draw(DrawContext& ctx) const;
+
+	const Stats& getStats() const { return stats; }
+
+private:
+	struct Range
+	{
+		uint32_t begin;
+		uint32_t end;
+	};
+
+	uint32_t addNode(const Node& node, int32_t parent, uint32_t instance);
+	void computeRange(uint32_t begin, uint32_t end);
+	// 구간이 chunkSize 보다 크면 루트만 여기서 계산하고 자식 서브트리로 나눈다. 이웃한 작은 조각은 합친다.
+	void splitRange(uint32_t begin, uint32_t end, uint32_t chunkSize, std::vector<Range>& outChunks);
+
+	// 항목별 SoA. 모두 같은 길이다.
+	std::vector<int32_t> parents;
+	std::vector<uint32_t> subtreeEnds;
+	std::vector<glm::mat4> localTransforms;
+	std::vector<glm::mat4> worldTransforms;
+	std::vector<uint8_t> dirtyFlags;
+	std::vector<uint32_t> updateVersions;
+
+	// 인스턴스 번호 -> 루트 항목
+	std::vector<uint32_t> instanceRoots;
+	std::vector<MeshEntry> meshEntries;
+
+	// setLocalTransform 으로 표시한 항목. 프레임마다 모든 플래그를 훑지 않도록 따로 모은다.
+	std::vector<uint32_t> dirtyRoots;
+	std::vector<Range> ranges;
+	std::vector<Range> chunks;
+
+	bool structureDirty = true;
+	uint32_t structureVersion = 0;
+	uint32_t version = 0;
+	uint32_t lastUpdateVersion = 0;
+	Stats stats;
+};
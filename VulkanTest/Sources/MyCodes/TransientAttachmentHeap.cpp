@@ -0,0 +1,217 @@
+#include "TransientAttachmentHeap.h"
+#include "VulkanTools.h"
+#include "vk_log.h"
+
+#include <cassert>
+#include <stdexcept>
+
+namespace
+{
+	VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return alignment == 0 ? value : (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+void TransientAttachmentHeap::initialize(DevicePtr inDevice, VkPhysicalDevice physicalDevice)
+{
+	device = inDevice;
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+}
+
+void TransientAttachmentHeap::cleanup()
+{
+	for (Block& block : blocks)
+	{
+		if (block.memory != VK_NULL_HANDLE)
+		{
+			vkFreeMemory(*device, block.memory, nullptr);
+		}
+	}
+	blocks.clear();
+	groups = {};
+}
+
+std::shared_ptr<AllocatedImage> TransientAttachmentHeap::createImage(AliasGroup group, const VkImageCreateInfo& imageInfo, const char* name)
+{
+	std::shared_ptr<AllocatedImage> image = std::make_shared<AllocatedImage>(device);
+
+	if (vkCreateImage(*device, &imageInfo, nullptr, &image->image) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create image");
+	}
+	else
+	{
+		LOG(Log, "VkImage {} ({}, aliased)", image->image, name);
+	}
+
+	// 메모리는 힙이 가지고 있으므로 imageMemory 는 비워둔다. AllocatedImage 는 이미지와 뷰만 지운다.
+	PendingImage pending;
+	pending.image = image->image;
+	vkGetImageMemoryRequirements(*device, image->image, &pending.requirements);
+
+	Group& target = groups[static_cast<size_t>(group)];
+	target.pendingImages.push_back(pending);
+	target.allTransient &= (imageInfo.usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) != 0;
+
+	return image;
+}
+
+void TransientAttachmentHeap::commit(AliasGroup group)
+{
+	Group& target = groups[static_cast<size_t>(group)];
+	if (target.pendingImages.empty())
+	{
+		return;
+	}
+
+	std::vector<VkDeviceSize> offsets;
+	offsets.reserve(target.pendingImages.size());
+
+	VkDeviceSize totalSize = 0;
+	uint32_t typeBits = UINT32_MAX;
+	for (const PendingImage& pending : target.pendingImages)
+	{
+		totalSize = alignUp(totalSize, pending.requirements.alignment);
+		offsets.push_back(totalSize);
+		totalSize += pending.requirements.size;
+		typeBits &= pending.requirements.memoryTypeBits;
+	}
+
+	uint32_t memoryTypeIndex = UINT32_MAX;
+	if (target.allTransient)
+	{
+		memoryTypeIndex = findMemoryType(typeBits, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+	}
+	if (memoryTypeIndex == UINT32_MAX)
+	{
+		memoryTypeIndex = findMemoryType(typeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	}
+	if (memoryTypeIndex == UINT32_MAX)
+	{
+		throw std::runtime_error("failed to find suitable memory type for transient attachments!");
+	}
+
+	// 다시 commit 하는 경우(스왑체인 재생성) 이전 블록에 들어갈 수 있으면 그대로 쓰도록, 새 블록을 먼저 잡고 이전 것을 놓는다.
+	const uint32_t previousBlock = target.blockIndex;
+	target.blockIndex = acquireBlock(totalSize, memoryTypeIndex);
+	if (previousBlock != UINT32_MAX)
+	{
+		releaseBlock(previousBlock);
+	}
+
+	const Block& block = blocks[target.blockIndex];
+	for (size_t i = 0; i < target.pendingImages.size(); i++)
+	{
+		VK_CHECK_RESULT(vkBindImageMemory(*device, target.pendingImages[i].image, block.memory, offsets[i]));
+	}
+
+	target.bytes = totalSize;
+	target.pendingImages.clear();
+	target.allTransient = true;
+}
+
+void TransientAttachmentHeap::release(AliasGroup group)
+{
+	Group& target = groups[static_cast<size_t>(group)];
+	assert(target.pendingImages.empty() && "TransientAttachmentHeap::commit() must be called before release");
+
+	if (target.blockIndex != UINT32_MAX)
+	{
+		releaseBlock(target.blockIndex);
+	}
+	target.blockIndex = UINT32_MAX;
+	target.bytes = 0;
+}
+
+TransientAttachmentHeap::Stats TransientAttachmentHeap::getStats() const
+{
+	Stats stats;
+	for (const Group& group : groups)
+	{
+		stats.requestedBytes += group.bytes;
+	}
+	for (const Block& block : blocks)
+	{
+		if (block.memory == VK_NULL_HANDLE)
+		{
+			continue;
+		}
+		stats.blockCount++;
+		stats.allocatedBytes += block.size;
+		if (block.lazilyAllocated)
+		{
+			stats.lazyBytes += block.size;
+		}
+	}
+	return stats;
+}
+
+uint32_t TransientAttachmentHeap::findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const
+{
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+	{
+		if ((typeBits & (1 << i)) &&
+			((memoryProperties.memoryTypes[i].propertyFlags & properties) == properties))
+		{
+			return i;
+		}
+	}
+	return UINT32_MAX;
+}
+
+uint32_t TransientAttachmentHeap::acquireBlock(VkDeviceSize size, uint32_t memoryTypeIndex)
+{
+	// 다른 그룹이 이미 잡아둔 블록에 들어가면 그 메모리를 겹쳐 쓴다.
+	for (uint32_t i = 0; i < blocks.size(); i++)
+	{
+		Block& block = blocks[i];
+		if (block.memory != VK_NULL_HANDLE && block.memoryTypeIndex == memoryTypeIndex && block.size >= size)
+		{
+			block.groupCount++;
+			return i;
+		}
+	}
+
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = size;
+	allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+	Block block;
+	if (vkAllocateMemory(*device, &allocInfo, nullptr, &block.memory) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to allocate transient attachment memory!");
+	}
+	block.size = size;
+	block.memoryTypeIndex = memoryTypeIndex;
+	block.lazilyAllocated = (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0;
+	block.groupCount = 1;
+
+	LOG(Display, "Transient attachment block : {} KB{}", size / 1024, block.lazilyAllocated ? " (lazily allocated)" : "");
+
+	for (uint32_t i = 0; i < blocks.size(); i++)
+	{
+		if (blocks[i].memory == VK_NULL_HANDLE)
+		{
+			blocks[i] = block;
+			return i;
+		}
+	}
+
+	blocks.push_back(block);
+	return static_cast<uint32_t>(blocks.size() - 1);
+}
+
+void TransientAttachmentHeap::releaseBlock(uint32_t blockIndex)
+{
+	Block& block = blocks[blockIndex];
+	assert(block.groupCount > 0);
+
+	// 이 블록에 바인딩된 이미지가 남아 있어도 다시 쓰지 않는다면 메모리를 먼저 해제해도 된다.
+	if (--block.groupCount == 0)
+	{
+		vkFreeMemory(*device, block.memory, nullptr);
+		block = Block();
+	}
+}
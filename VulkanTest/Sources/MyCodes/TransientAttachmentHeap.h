@@ -0,0 +1,81 @@
+#pragma once
+
+#include "vk_types.h"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+/**
+ * 수명이 겹치지 않는 렌더 타겟들이 같은 VkDeviceMemory 를 나눠 쓰게 하는 힙.
+ *
+ * 같은 그룹 안의 이미지는 동시에 쓰이므로 겹치지 않게 나란히 놓고, 다른 그룹끼리는 같은 메모리의 0 번 오프셋부터 겹쳐 놓는다.
+ * 예를 들어 G-buffer 는 첫 프레임 이전에 내용이 필요 없으므로, 초기화 때만 쓰는 IBL 베이크 소스가 그 메모리를 먼저 빌려 쓴다.
+ * 겹친 이미지를 쓰고 나면 다른 그룹 이미지의 내용은 정의되지 않으므로, 렌더 패스의 initialLayout 은 UNDEFINED 여야 한다.
+ *
+ * 그룹의 모든 이미지가 VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT 이면 lazily allocated 메모리를 먼저 찾는다.
+ * 단일 렌더 패스 디퍼드의 G-buffer 가 그렇다. 타일 기반 GPU 에서는 이 경우 실제 메모리가 거의 잡히지 않는다.
+ */
+class TransientAttachmentHeap
+{
+public:
+	enum class AliasGroup : uint32_t
+	{
+		GBuffer,
+		IBLBake,
+		Count
+	};
+
+	struct Stats
+	{
+		VkDeviceSize requestedBytes = 0;	// 그룹별 이미지 크기를 모두 더한 값 (별도로 할당했다면 필요했을 크기)
+		VkDeviceSize allocatedBytes = 0;	// 실제로 잡은 VkDeviceMemory 크기
+		VkDeviceSize lazyBytes = 0;			// allocatedBytes 중 lazily allocated 메모리
+		uint32_t blockCount = 0;
+	};
+
+	void initialize(DevicePtr inDevice, VkPhysicalDevice physicalDevice);
+	void cleanup();
+
+	// 이미지만 만들고 메모리 요구사항을 기록한다. commit 전에는 메모리가 없으므로 뷰를 만들 수 없다.
+	std::shared_ptr<AllocatedImage> createImage(AliasGroup group, const VkImageCreateInfo& imageInfo, const char* name);
+	// createImage 로 만든 이미지들을 배치하고 메모리에 바인딩한다.
+	void commit(AliasGroup group);
+	// 그룹의 이미지를 더 이상 쓰지 않을 때 호출한다. 어떤 그룹도 쓰지 않는 블록은 해제된다.
+	void release(AliasGroup group);
+
+	Stats getStats() const;
+
+private:
+	struct PendingImage
+	{
+		VkImage image;
+		VkMemoryRequirements requirements;
+	};
+
+	struct Group
+	{
+		std::vector<PendingImage> pendingImages;
+		bool allTransient = true;
+		uint32_t blockIndex = UINT32_MAX;
+		VkDeviceSize bytes = 0;
+	};
+
+	struct Block
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize size = 0;
+		uint32_t memoryTypeIndex = 0;
+		bool lazilyAllocated = false;
+		uint32_t groupCount = 0;
+	};
+
+	uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const;
+	uint32_t acquireBlock(VkDeviceSize size, uint32_t memoryTypeIndex);
+	void releaseBlock(uint32_t blockIndex);
+
+	DevicePtr device;
+	VkPhysicalDeviceMemoryProperties memoryProperties{};
+	std::array<Group, static_cast<size_t>(AliasGroup::Count)> groups;
+	std::vector<Block> blocks;
+};
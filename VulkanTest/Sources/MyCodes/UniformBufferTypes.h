@@ -2,8 +2,10 @@
 
 #include "vk_types.h"
 
-//  ִ Ʈ Ʈ . ObjectShader.frag  NR_POINT_LIGHTS ݵ ġŲ. 
+//  처음 장면에 두는 포인트 라이트 개수. 라이트는 실행 중에 더하고 뺄 수 있다.
 #define NR_POINT_LIGHTS 4
+//  포인트 라이트 버퍼에 담을 수 있는 최대 개수
+#define MAX_POINT_LIGHTS 256
 
 struct Transform {
 	alignas(16) glm::mat4 model;
@@ -32,15 +34,19 @@ struct DirLight {
 	alignas(16) glm::vec4 colorIntensity = glm::vec4(0.f);
 };
 
+// shaders/light_structures.glsl 의 PointLight 와 배치가 같아야 한다. (std430)
 struct PointLight {
-	alignas(16) glm::vec3 position;
-	alignas(16) glm::vec3 clq; // constant, linear, quadratic
-	alignas(16) glm::vec4 colorIntensity;
+	glm::vec3 position;
+	uint32_t enabled = 0; // 0 이면 셰이더가 건너뛴다
+	glm::vec3 clq; // constant, linear, quadratic
+	float _pad0 = 0.f;
+	glm::vec4 colorIntensity;
 };
+static_assert(sizeof(PointLight) == 48, "PointLight must match PointLight in light_structures.glsl");
 
-struct PointLightsUniform {
-	std::array<PointLight, NR_POINT_LIGHTS> pointLights;
-	int activeLightMask;
+// shaders/global.glsl 의 PointLights 버퍼. 헤더 뒤에 PointLight 가 count.x 개 이어진다.
+struct PointLightsHeader {
+	glm::uvec4 count; // x 라이트 수
 };
 
 struct GPUSceneData {
@@ -53,5 +59,8 @@ struct GPUSceneData {
 	alignas(16) glm::mat4 proj;
 	alignas(16) glm::vec4 exposureDisplay; // x=exposure, y=debugDisplayTarget
 	alignas(16) DirLight dirLight;
-	alignas(16) PointLightsUniform activePointLight;
+	// 라이팅 패스가 깊이에서 월드 위치를 복원한다.
+	alignas(16) glm::mat4 inverseViewProj;
+	// xy 이번 프레임 내부 해상도, zw 그 역수. 동적 해상도가 꺼져 있으면 스왑체인 크기다.
+	alignas(16) glm::vec4 renderExtent;
 };
\ No newline at end of file
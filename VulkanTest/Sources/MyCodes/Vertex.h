@@ -60,7 +60,7 @@ struct Vertex
 
 	// Bindings: spacing between data and whether the data is per-vertex or
 	// per - instance(see instancing)
-	// Stride ϰ ̰ Vertex Instance ϴ . 
+	// Stride를 정하고 이게 Vertex인지 Instance인지 정하는 듯. 
 	static void getBindingDescriptions(std::vector<VkVertexInputBindingDescription>& bindingDescriptions)
 	{
 		//VkVertexInputBindingDescription bindingDescription;
@@ -196,7 +196,7 @@ struct Instance
 
 	// Bindings: spacing between data and whether the data is per-vertex or
 	// per - instance(see instancing)
-	// Stride ϰ ̰ Vertex Instance ϴ . 
+	// Stride를 정하고 이게 Vertex인지 Instance인지 정하는 듯. 
 	static void getBindingDescriptions(std::vector<VkVertexInputBindingDescription>& bindingDescriptions)
 	{
 		bindingDescriptions.emplace_back(VkVertexInputBindingDescription{ 1, sizeof(glm::vec4) * 4, VK_VERTEX_INPUT_RATE_INSTANCE });
@@ -204,14 +204,15 @@ struct Instance
 
 	// Attribute descriptions: type of the attributes passed to the vertex shader,
 	// which binding to load them from and at which offset
-	static void getAttributeDescriptions(std::vector<VkVertexInputAttributeDescription>& attributeDescriptions)
+	// firstLocation 은 버텍스 속성 뒤에 이어지는 location. mat4 는 location 4개를 차지한다.
+	static void getAttributeDescriptions(std::vector<VkVertexInputAttributeDescription>& attributeDescriptions, uint32_t firstLocation = 4)
 	{
 		// Per-Instance attributes
 		// These are advanced for each instance rendered
-		attributeDescriptions.emplace_back(VkVertexInputAttributeDescription{ 4, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 0 });
-		attributeDescriptions.emplace_back(VkVertexInputAttributeDescription{ 5, 1, VK_FORMAT_R32G32B32A32_SFLOAT, sizeof(glm::vec4) * 1 });
-		attributeDescriptions.emplace_back(VkVertexInputAttributeDescription{ 6, 1, VK_FORMAT_R32G32B32A32_SFLOAT, sizeof(glm::vec4) * 2 });
-		attributeDescriptions.emplace_back(VkVertexInputAttributeDescription{ 7, 1, VK_FORMAT_R32G32B32A32_SFLOAT, sizeof(glm::vec4) * 3 });
+		attributeDescriptions.emplace_back(VkVertexInputAttributeDescription{ firstLocation + 0, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 0 });
+		attributeDescriptions.emplace_back(VkVertexInputAttributeDescription{ firstLocation + 1, 1, VK_FORMAT_R32G32B32A32_SFLOAT, sizeof(glm::vec4) * 1 });
+		attributeDescriptions.emplace_back(VkVertexInputAttributeDescription{ firstLocation + 2, 1, VK_FORMAT_R32G32B32A32_SFLOAT, sizeof(glm::vec4) * 2 });
+		attributeDescriptions.emplace_back(VkVertexInputAttributeDescription{ firstLocation + 3, 1, VK_FORMAT_R32G32B32A32_SFLOAT, sizeof(glm::vec4) * 3 });
 
 	}
 
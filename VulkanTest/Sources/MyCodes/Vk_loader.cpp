@@ -14,6 +14,8 @@
 #include "VulkanTools.h"
 #include "vk_resource_utils.h"
 #include "vk_pathes.h"
+#include "GPUResourcePools.h"
+#include "MeshLod.h"
 
 VkFilter extract_filter(fastgltf::Filter filter)
 {
@@ -155,16 +157,16 @@ std::optional<std::shared_ptr<AllocatedImage>> load_image(VulkanTutorialExtensio
     }
 }
 
-// ޽ winding order м  Լ - Լ   ߰
+// 메시의 winding order 분석을 위한 함수 - 함수 시작 전에 추가
 bool isCounterClockwise(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& normal) {
-    // ﰢ   
+    // 삼각형의 두 엣지 계산
     glm::vec3 edge1 = p1 - p0;
     glm::vec3 edge2 = p2 - p0;
 
-    //   ﰢ  
+    // 외적을 통해 삼각형의 법선 계산
     glm::vec3 computedNormal = glm::cross(edge1, edge2);
 
-    //   ־   ġϴ Ȯ
+    // 계산된 법선과 주어진 법선의 방향이 일치하는지 확인
     return glm::dot(computedNormal, normal) > 0.0f;
 }
 
@@ -246,7 +248,7 @@ std::optional<std::shared_ptr<LoadedGLTF>> loadGltf(VulkanTutorialExtension* eng
     }
 
     // temporal arrays for all the objects to use while creating the GLTF data
-    std::vector<std::shared_ptr<MeshAsset<Vertex>>> meshes;
+    std::vector<MeshHandle> meshes;
     std::vector<std::shared_ptr<Node>> nodes;
     std::vector<std::shared_ptr<AllocatedImage>> images;
     std::vector<std::shared_ptr<GLTFMaterial>> materials;
@@ -365,6 +367,7 @@ std::optional<std::shared_ptr<LoadedGLTF>> loadGltf(VulkanTutorialExtension* eng
 
         // build material
         newMat->data = engine->metalRoughMaterial.write_material(engine, passType, materialResources, file.descriptorPool);
+        file.materialHandles.push_back(newMat->data);
 
         data_index++;
     }
@@ -377,10 +380,9 @@ std::optional<std::shared_ptr<LoadedGLTF>> loadGltf(VulkanTutorialExtension* eng
     std::vector<Vertex> vertices;
 
     for (fastgltf::Mesh& mesh : gltf.meshes) {
-        std::shared_ptr<MeshAsset<Vertex>> newmesh = std::make_shared<MeshAsset<Vertex>>();
-        meshes.push_back(newmesh);
-        file.meshes.push_back(newmesh);
-        newmesh->name = mesh.name;
+        // 완성된 메시를 풀로 옮긴다. 풀의 dense 배열이 재배치될 수 있으므로 포인터를 들고 있지 않는다.
+        MeshAsset<Vertex> newmesh;
+        newmesh.name = mesh.name;
 
         // clear the mesh arrays each mesh, we dont want to merge them by error
         indices.clear();
@@ -421,6 +423,30 @@ std::optional<std::shared_ptr<LoadedGLTF>> loadGltf(VulkanTutorialExtension* eng
                     });
             }
 
+            // 위치만으로 경계를 구한다. 구는 AABB 를 감싸는 크기라 조금 크지만 컬링에는 충분하다.
+            // glTF 는 POSITION 접근자에 min/max 를 반드시 적게 되어 있어 보통은 버텍스를 다시 훑지 않아도 된다.
+            {
+                fastgltf::Accessor& posAccessor = gltf.accessors[p.findAttribute("POSITION")->accessorIndex];
+                auto* accessorMin = std::get_if<FASTGLTF_STD_PMR_NS::vector<double>>(&posAccessor.min);
+                auto* accessorMax = std::get_if<FASTGLTF_STD_PMR_NS::vector<double>>(&posAccessor.max);
+
+                glm::vec3 minPos = vertices[initial_vtx].pos;
+                glm::vec3 maxPos = vertices[initial_vtx].pos;
+                if (accessorMin && accessorMax && accessorMin->size() == 3 && accessorMax->size() == 3) {
+                    minPos = glm::vec3((*accessorMin)[0], (*accessorMin)[1], (*accessorMin)[2]);
+                    maxPos = glm::vec3((*accessorMax)[0], (*accessorMax)[1], (*accessorMax)[2]);
+                }
+                else {
+                    for (size_t i = initial_vtx; i < vertices.size(); i++) {
+                        minPos = glm::min(minPos, vertices[i].pos);
+                        maxPos = glm::max(maxPos, vertices[i].pos);
+                    }
+                }
+                newSurface.bounds.origin = (maxPos + minPos) / 2.f;
+                newSurface.bounds.extents = (maxPos - minPos) / 2.f;
+                newSurface.bounds.sphereRadius = glm::length(newSurface.bounds.extents);
+            }
+
             // load vertex normals
             auto normals = p.findAttribute("NORMAL");
             if (normals != p.attributes.end()) {
@@ -452,42 +478,42 @@ std::optional<std::shared_ptr<LoadedGLTF>> loadGltf(VulkanTutorialExtension* eng
                     });
             }
     
-            // źƮ/źƮ 
+            // 탄젠트/바이탄젠트 계산
             for (size_t i = 0; i < newSurface.count; i += 3) {
-                // ﰢ   ε
+                // 삼각형의 세 정점 인덱스
                 uint32_t idx0 = indices[newSurface.startIndex + i] - initial_vtx;
                 uint32_t idx1 = indices[newSurface.startIndex + i + 1] - initial_vtx;
                 uint32_t idx2 = indices[newSurface.startIndex + i + 2] - initial_vtx;
 
-                // ﰢ  
+                // 삼각형의 세 정점
                 Vertex& v0 = vertices[initial_vtx + idx0];
                 Vertex& v1 = vertices[initial_vtx + idx1];
                 Vertex& v2 = vertices[initial_vtx + idx2];
 
-                // 𼭸 
+                // 모서리 벡터
                 glm::vec3 edge1 = v1.pos - v0.pos;
                 glm::vec3 edge2 = v2.pos - v0.pos;
 
-                // ؽó ǥ 
+                // 텍스처 좌표 차이
                 glm::vec2 deltaUV1 = v1.texCoord - v0.texCoord;
                 glm::vec2 deltaUV2 = v2.texCoord - v0.texCoord;
 
-                // и  
+                // 분모 값 계산
                 float f = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
 
-                // źƮ 
+                // 탄젠트 계산
                 glm::vec3 tangent;
                 tangent.x = f * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x);
                 tangent.y = f * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y);
                 tangent.z = f * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z);
 
-                // źƮ 
+                // 바이탄젠트 계산
                 glm::vec3 bitangent;
                 bitangent.x = f * (-deltaUV2.x * edge1.x + deltaUV1.x * edge2.x);
                 bitangent.y = f * (-deltaUV2.x * edge1.y + deltaUV1.x * edge2.y);
                 bitangent.z = f * (-deltaUV2.x * edge1.z + deltaUV1.x * edge2.z);
 
-                // ﰢ   źƮ źƮ Ҵ
+                // 삼각형의 세 정점에 탄젠트와 바이탄젠트 할당
                 /*v0.tangent += tangent;
                 v0.bitangent += bitangent;
 
@@ -498,19 +524,19 @@ std::optional<std::shared_ptr<LoadedGLTF>> loadGltf(VulkanTutorialExtension* eng
                 v2.bitangent += bitangent;*/
             }
 
-            // źƮ źƮ ȭ
+            // 탄젠트와 바이탄젠트 정규화
             //for (size_t i = 0; i < gltf.accessors[p.findAttribute("POSITION")->accessorIndex].count; i++) {
             //    Vertex& v = vertices[initial_vtx + i];
 
-            //    // ȭ
+            //    // 정규화
             //    v.tangent = glm::normalize(v.tangent);
             //    v.bitangent = glm::normalize(v.bitangent);
 
-            //    //   κп ޵ Gram-Schmidt  
-            //    // źƮ 븻  ȭ
+            //    // 문서의 마지막 부분에서 언급된 Gram-Schmidt 과정 적용
+            //    // 탄젠트를 노말에 대해 직교화
             //    v.tangent = glm::normalize(v.tangent - glm::dot(v.tangent, v.normal) * v.normal);
 
-            //    // źƮ 
+            //    // 바이탄젠트 재계산
             //    v.bitangent = glm::cross(v.normal, v.tangent);
             //}
 
@@ -522,17 +548,17 @@ std::optional<std::shared_ptr<LoadedGLTF>> loadGltf(VulkanTutorialExtension* eng
                 int cwCount = 0;
 
                 for (size_t i = 0; i < newSurface.count; i += 3) {
-                    // ﰢ   ε
+                    // 삼각형의 세 정점 인덱스
                     uint32_t idx0 = indices[newSurface.startIndex + i] - initial_vtx;
                     uint32_t idx1 = indices[newSurface.startIndex + i + 1] - initial_vtx;
                     uint32_t idx2 = indices[newSurface.startIndex + i + 2] - initial_vtx;
 
-                    // ﰢ  
+                    // 삼각형의 세 정점
                     Vertex& v0 = vertices[initial_vtx + idx0];
                     Vertex& v1 = vertices[initial_vtx + idx1];
                     Vertex& v2 = vertices[initial_vtx + idx2];
 
-                    // ﰢ CCW Ȯ
+                    // 삼각형이 CCW인지 확인
                     bool isCCW = isCounterClockwise(v0.pos, v1.pos, v2.pos, v0.normal);
 
                     if (isCCW) {
@@ -542,7 +568,7 @@ std::optional<std::shared_ptr<LoadedGLTF>> loadGltf(VulkanTutorialExtension* eng
                         cwCount++;
                     }
 
-                    // ù 10 ﰢ м  
+                    // 첫 10개 삼각형의 분석 결과 출력
                     if (i / 3 < 10) {
                         std::cout << "Triangle " << (i / 3) << ": "
                             << (isCCW ? "CCW" : "CW") << "\n";
@@ -565,17 +591,43 @@ std::optional<std::shared_ptr<LoadedGLTF>> loadGltf(VulkanTutorialExtension* eng
             }
 #endif
             if (p.materialIndex.has_value()) {
-                newSurface.material = materials[p.materialIndex.value()];
+                newSurface.material = materials[p.materialIndex.value()]->data;
             }
             else {
-                newSurface.material = materials[0];
+                newSurface.material = materials[0]->data;
             }
 
-            newmesh->surfaces.push_back(newSurface);
+            newmesh.surfaces.push_back(newSurface);
+        }
+
+        // LOD 인덱스는 원본 인덱스 뒤에 붙여 같은 인덱스 버퍼에 올린다.
+        if (MeshLod::generateOnLoad)
+        {
+            for (GeoSurface& surface : newmesh.surfaces)
+            {
+                MeshLod::generateLods(vertices, indices, surface);
+            }
         }
 
-        engine->createVertexBuffer(vertices, newmesh->meshBuffers.vertexBuffer.Buffer, newmesh->meshBuffers.vertexBuffer.BufferMemory);
-        engine->createIndexBuffer(indices, newmesh->meshBuffers.indexBuffer.Buffer, newmesh->meshBuffers.indexBuffer.BufferMemory);
+        // 모델을 여러번 로드/언로드 하므로 전용 메모리 대신 MeshMemoryHeap 에서 나눠 받는다.
+        engine->uploadMeshBuffer(vertices.data(), vertices.size() * sizeof(Vertex), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            newmesh.meshBuffers.vertexBuffer.Buffer, newmesh.vertexAllocation);
+        engine->uploadMeshBuffer(indices.data(), indices.size() * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+            newmesh.meshBuffers.indexBuffer.Buffer, newmesh.indexAllocation);
+
+        // 그림자 패스는 위치만 읽으므로 위치만 모은 스트림을 따로 올려 정점 대역폭을 줄인다.
+        std::vector<VertexOnlyPos> positions(vertices.size());
+        for (size_t v = 0; v < vertices.size(); v++) {
+            positions[v].pos = vertices[v].pos;
+        }
+        engine->uploadMeshBuffer(positions.data(), positions.size() * sizeof(VertexOnlyPos), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            newmesh.positionBuffer, newmesh.positionAllocation);
+        newmesh.meshBuffers.vertexBuffer.BufferMemory = VK_NULL_HANDLE;
+        newmesh.meshBuffers.indexBuffer.BufferMemory = VK_NULL_HANDLE;
+
+        MeshHandle meshHandle = GPUResourcePools::get().meshes.create(std::move(newmesh));
+        meshes.push_back(meshHandle);
+        file.meshes.push_back(meshHandle);
     }
 
 
@@ -652,16 +704,35 @@ void LoadedGLTF::clearAll()
 
     //materialDataBuffer.destroy(0);
 
-    for (std::shared_ptr<MeshAsset<Vertex>> mesh : meshes)
+    GPUResourcePools& pools = GPUResourcePools::get();
+
+    for (MeshHandle meshHandle : meshes)
     {
-        if (mesh.get())
+        if (MeshAsset<Vertex>* mesh = pools.meshes.get(meshHandle))
         {
             vkDestroyBuffer(creator->getDevice(), mesh->meshBuffers.vertexBuffer.Buffer, nullptr);
-            vkFreeMemory(creator->getDevice(), mesh->meshBuffers.vertexBuffer.BufferMemory, nullptr);
+            creator->meshMemoryHeap.free(mesh->vertexAllocation);
 
             vkDestroyBuffer(creator->getDevice(), mesh->meshBuffers.indexBuffer.Buffer, nullptr);
-            vkFreeMemory(creator->getDevice(), mesh->meshBuffers.indexBuffer.BufferMemory, nullptr);
+            creator->meshMemoryHeap.free(mesh->indexAllocation);
+
+            vkDestroyBuffer(creator->getDevice(), mesh->positionBuffer, nullptr);
+            creator->meshMemoryHeap.free(mesh->positionAllocation);
+
+            // 풀에서 실제로 빠지기 전까지 MeshDefragmenter 가 이 메시를 옮기거나 다시 해제하지 않도록 무효로 만든다.
+            mesh->meshBuffers.vertexBuffer.Buffer = VK_NULL_HANDLE;
+            mesh->meshBuffers.indexBuffer.Buffer = VK_NULL_HANDLE;
+            mesh->positionBuffer = VK_NULL_HANDLE;
+            mesh->vertexAllocation = MeshAllocation();
+            mesh->indexAllocation = MeshAllocation();
+            mesh->positionAllocation = MeshAllocation();
         }
+        pools.releaseMesh(meshHandle);
+    }
+
+    for (MaterialHandle materialHandle : materialHandles)
+    {
+        pools.releaseMaterial(materialHandle);
     }
 
     for (VkSampler sampler : samplers)
@@ -8,18 +8,32 @@
 #include "vk_engine.h"
 #include "UniformBuffer.h"
 #include "Buffer.h"
+#include "MeshMemoryHeap.h"
 
 class VulkanTutorialExtension;
 
 struct GLTFMaterial {
-	std::shared_ptr<MaterialInstance> data;
+	MaterialHandle data;
+};
+
+// 같은 인덱스 버퍼 안의 LOD 인덱스 구간. 정점 버퍼는 원본과 같이 쓴다.
+struct SurfaceLod
+{
+	uint32_t startIndex;
+	uint32_t count;
+	// 원본에서 벗어난 거리. 서피스 경계 구 반지름에 대한 비율이다.
+	float error;
 };
 
 struct GeoSurface 
 {
 	uint32_t startIndex;
 	uint32_t count;
-	std::shared_ptr<GLTFMaterial> material;
+	MaterialHandle material;
+	Bounds bounds;
+
+	// lods[0] 은 startIndex/count 와 같은 원본이고 뒤로 갈수록 거칠다. 비어 있으면 원본만 있다. (MeshLod::generateLods)
+	std::vector<SurfaceLod> lods;
 };
 
 template<typename T>
@@ -29,6 +43,14 @@ struct MeshAsset
 
 	std::vector<GeoSurface> surfaces;
 	GPUMeshBuffers<T> meshBuffers;
+
+	// MeshMemoryHeap 에서 할당된 경우에만 유효하다. 이 때 meshBuffers 의 BufferMemory 는 사용하지 않는다.
+	MeshAllocation vertexAllocation;
+	MeshAllocation indexAllocation;
+
+	// 그림자 패스용 위치 전용 정점 스트림. 정점 순서가 같아 indexBuffer 를 그대로 쓴다.
+	VkBuffer positionBuffer = VK_NULL_HANDLE;
+	MeshAllocation positionAllocation;
 };
 
 struct LoadedGLTF : public IRenderable {
@@ -41,11 +63,13 @@ struct LoadedGLTF : public IRenderable {
     }
     // storage for all the data on a given glTF file
     //std::unordered_map<std::string, std::shared_ptr<MeshAsset>> meshes;
-    std::vector<std::shared_ptr<MeshAsset<Vertex>>> meshes;
+    std::vector<MeshHandle> meshes;
     std::unordered_map<std::string, std::shared_ptr<Node>> nodes;
     //std::unordered_map<std::string, std::shared_ptr<AllocatedImage>> images;
     std::vector <std::shared_ptr<AllocatedImage>> images;
     std::unordered_map<std::string, std::shared_ptr<GLTFMaterial>> materials;
+    // 이름이 겹치는 머티리얼도 빠짐없이 해제할 수 있도록 핸들을 따로 보관한다.
+    std::vector<MaterialHandle> materialHandles;
 
     // nodes that dont have a parent, for iterating through the file in tree order
     std::vector<std::shared_ptr<Node>> topNodes;
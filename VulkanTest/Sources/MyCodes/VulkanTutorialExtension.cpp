@@ -15,11 +15,20 @@
 #include "TextureViewer.h"
 #include "GPUMarker.h"
 #include "DeferredDeletionQueue.h"
+#include "GPUResourcePools.h"
+#include "MeshDefragmenter.h"
+#include "FrameAllocator.h"
+#include "DrawSorting.h"
+
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <random>
 
 static int UniqueBufferIndex = 0;
 
 /**
-* GUI   Ƴ´. 
+* GUI에서 사용할 변수들을 모아놓는다. 
 */
 int VulkanTutorialExtension::instanceCount = 2;
 int VulkanTutorialExtension::maxInstanceCount = instanceCount;
@@ -27,16 +36,31 @@ bool VulkanTutorialExtension::useDirectionalLight = true;
 int VulkanTutorialExtension::debugDisplayTarget = 0;
 float VulkanTutorialExtension::exposure = 1.f;
 bool VulkanTutorialExtension::usePointLights = true;
-std::array<bool, NR_POINT_LIGHTS> VulkanTutorialExtension::pointLightsSwitch;
 float VulkanTutorialExtension::pointLightlinear = 0.09f;
 float VulkanTutorialExtension::pointLightQuadratic = 0.032f;
 float VulkanTutorialExtension::pointLightIntensity = 1.f;
 float VulkanTutorialExtension::directionalLightIntensity = 1.f;
+glm::vec3 VulkanTutorialExtension::directionalLightDirection = glm::vec3(-0.2f, -1.0f, -0.3f);
+bool VulkanTutorialExtension::useParallelRecording = true;
+bool VulkanTutorialExtension::useAutoInstancing = true;
+bool VulkanTutorialExtension::useFrustumCulling = true;
+bool VulkanTutorialExtension::useSceneBVH = true;
+bool VulkanTutorialExtension::useSinglePassDeferred = false;
 
 VulkanTutorialExtension::VulkanTutorialExtension()
 	: camera({ 5.f, 5.f, 5.f }, { 0.f,1.f,0.f })
 {
-	pointLightsSwitch[0] = true;
+	// 처음에는 첫 라이트만 켠다.
+	const glm::vec3 pointLightPositions[NR_POINT_LIGHTS] = {
+		glm::vec3(0.7f,  0.2f,  2.0f),
+		glm::vec3(2.3f, -3.3f, -4.0f),
+		glm::vec3(-4.0f,  2.0f, -12.0f),
+		glm::vec3(0.0f,  0.0f, -3.0f)
+	};
+	for (int i = 0; i < NR_POINT_LIGHTS; i++)
+	{
+		addPointLight(pointLightPositions[i], i == 0);
+	}
 
 	for (int i = 0; i < NR_POINT_LIGHTS ; i++)
 	{
@@ -46,7 +70,6 @@ VulkanTutorialExtension::VulkanTutorialExtension()
 	colorUniformBuffer = UniformBuffer<ColorUBO>::create();
 	materialUniformBuffer = UniformBuffer<Material>::create();
 	dirLightUniformBuffer = UniformBuffer<DirLight>::create();
-	pointLightsUniformBuffer = UniformBuffer<PointLightsUniform>::create();
 	materialConstants = UniformBuffer<GLTFMetallic_Roughness::MaterialConstants>::create();
 	globalSceneData = UniformBuffer<GPUSceneData>::create();
 }
@@ -59,8 +82,8 @@ void VulkanTutorialExtension::initVulkan()
 	rightPanel = std::make_shared<ImGui::RightPanelUI>(this);
 
 	VulkanTutorial::initVulkan();
-	// NOTE : ġ ߿!
-	// Descriptor ʱȭ Ǿ Ʈ ͸ .  Ŀ  Լ ҷѴ.
+	// NOTE : 위치 중요!
+	// Descriptor가 초기화 되어야 디폴트 머터리얼이 만들어진다. 그 이후에 이 함수가 불려야한다.
 	init_default_data();
 
 	createImGui();
@@ -90,7 +113,8 @@ void VulkanTutorialExtension::processInput()
 	if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS)
 		camera.ProcessKeyboard(Camera_Movement::UP, deltaTime);
 
-	ImGui::stringToDebug.append(camera.ToString());
+	// stringToDebug 는 clear 해도 용량이 남아 있으므로 임시 문자열 없이 바로 써넣는다.
+	camera.AppendTo(ImGui::stringToDebug);
 }
 
 void VulkanTutorialExtension::initWindow()
@@ -168,13 +192,28 @@ void VulkanTutorialExtension::createUniformBuffers()
 	{
 		globalSceneData->createUniformBuffer(swapChainImages.size(), device, physicalDevice);
 		materialConstants->createUniformBuffer(1, device, physicalDevice);
+
+		// 이미지마다 최대 개수만큼 한번 만들어 두므로 라이트 수가 바뀌어도 디스크립터를 다시 쓰지 않는다.
+		// 스왑체인을 다시 만들면 이미지 수가 바뀔 수 있으므로 새로 만든다. 장치는 이미 쉬고 있다.
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+		for (StorageBuffer& buffer : pointLightBuffers)
+		{
+			buffer.Destroy(*device);
+		}
+		pointLightBuffers.resize(swapChainImages.size());
+		for (StorageBuffer& buffer : pointLightBuffers)
+		{
+			buffer.Create(*device, memoryProperties, sizeof(PointLightsHeader) + sizeof(PointLight) * MAX_POINT_LIGHTS,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			std::memset(buffer.mapped, 0, buffer.size);
+		}
 	}
 
 	objectTransformUniformBuffer->createUniformBuffer(swapChainImages.size(), device, physicalDevice);
 	colorUniformBuffer->createUniformBuffer(swapChainImages.size(), device, physicalDevice);
 	materialUniformBuffer->createUniformBuffer(swapChainImages.size(), device, physicalDevice);
 	dirLightUniformBuffer->createUniformBuffer(swapChainImages.size(), device, physicalDevice);
-	pointLightsUniformBuffer->createUniformBuffer(swapChainImages.size(), device, physicalDevice);
 	for (int lightIndex = 0; lightIndex < NR_POINT_LIGHTS; lightIndex++)
 	{
 		lightTransformUniformBuffer[lightIndex]->createUniformBuffer(swapChainImages.size(), device, physicalDevice);
@@ -220,22 +259,29 @@ void VulkanTutorialExtension::createDescriptorSets()
 
 void VulkanTutorialExtension::createGlobalDescriptorSets()
 {
-	VkDescriptorSetAllocateInfo allocInfo = vkb::initializers::descriptor_set_allocate_info(descriptorPool, &globalDescriptorSetLayout, 1);
-	VK_CHECK_RESULT(vkAllocateDescriptorSets(*device, &allocInfo, &globalDescriptorSet));
+	// update_scene 이 이미지마다 다른 버퍼에 쓰므로 셋도 이미지마다 둔다.
+	std::vector<VkDescriptorSetLayout> layouts(swapChainImages.size(), globalDescriptorSetLayout);
+	VkDescriptorSetAllocateInfo allocInfo = vkb::initializers::descriptor_set_allocate_info(descriptorPool, layouts.data(), static_cast<uint32_t>(layouts.size()));
+	globalDescriptorSets.resize(swapChainImages.size());
+	VK_CHECK_RESULT(vkAllocateDescriptorSets(*device, &allocInfo, globalDescriptorSets.data()));
 
-	std::vector<VkWriteDescriptorSet> writeDescriptorSets;
+	for (size_t i = 0; i < swapChainImages.size(); i++)
+	{
+		VkDescriptorBufferInfo bufDescriptor =
+			vkb::initializers::descriptor_buffer_info(
+				globalSceneData->getUniformBuffer(static_cast<int>(i)),
+				0,
+				sizeof(GPUSceneData));
 
-	VkDescriptorBufferInfo bufDescriptor =
-		vkb::initializers::descriptor_buffer_info(
-			globalSceneData->getUniformBuffer(UniqueBufferIndex),
-			0,
-			sizeof(GPUSceneData));
+		VkDescriptorBufferInfo pointLightDescriptor = vkb::initializers::descriptor_buffer_info(pointLightBuffers[i].Buffer, 0, VK_WHOLE_SIZE);
 
-	writeDescriptorSets = {
-		vkb::initializers::write_descriptor_set(globalDescriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &bufDescriptor),
-	};
-	
-	vkUpdateDescriptorSets(*device, static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, nullptr);
+		std::vector<VkWriteDescriptorSet> writeDescriptorSets = {
+			vkb::initializers::write_descriptor_set(globalDescriptorSets[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &bufDescriptor),
+			vkb::initializers::write_descriptor_set(globalDescriptorSets[i], VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, &pointLightDescriptor),
+		};
+		
+		vkUpdateDescriptorSets(*device, static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, nullptr);
+	}
 }
 
 void VulkanTutorialExtension::createDescriptorSetsPointLights(UniformBuffer<Transform>& inUniformBuffer, std::vector<VkDescriptorSet>& outDescriptorSets)
@@ -249,13 +295,13 @@ void VulkanTutorialExtension::createDescriptorSetsPointLights(UniformBuffer<Tran
 	allocInfo.pSetLayouts = layouts.data();
 
 	outDescriptorSets.resize(swapChainImages.size());
-	//  Ÿ  Pool ȿ ̾ƿ 缭 DescriptorSet ҴѴ. 
+	// 각 타입의 여러개 Pool 안에서 레이아웃에 맞춰서 DescriptorSet을 할당한다. 
 	if (vkAllocateDescriptorSets(*device, &allocInfo, outDescriptorSets.data()) != VK_SUCCESS)
 	{
 		throw std::runtime_error("failed to allocate descriptor sets!");
 	}
 
-	// Ҵ DescriptorSet  /÷ .
+	// 할당된 DescriptorSet에 유니폼 버퍼/샘플러를 쓴다.
 	for (size_t i = 0; i < swapChainImages.size(); i++)
 	{
 		std::vector<VkWriteDescriptorSet> descriptorWrites;
@@ -277,51 +323,99 @@ void VulkanTutorialExtension::createLightingPassDescriptorSets(std::vector<VkDes
 	allocInfo.pSetLayouts = layouts.data();
 
 	outDescriptorSets.resize(swapChainImages.size());
-	//  Ÿ  Pool ȿ ̾ƿ 缭 DescriptorSet ҴѴ. 
+	// 각 타입의 여러개 Pool 안에서 레이아웃에 맞춰서 DescriptorSet을 할당한다. 
 	if (vkAllocateDescriptorSets(*device, &allocInfo, outDescriptorSets.data()) != VK_SUCCESS)
 	{
 		throw std::runtime_error("failed to allocate descriptor sets!");
 	}
-	// Ҵ DescriptorSet  /÷ .
-	// binding  index οȴ. shader ġؾѴ.
+	// 할당된 DescriptorSet에 유니폼 버퍼/샘플러를 쓴다.
+	// binding 순서대로 index가 부여된다. shader와 일치해야한다.
 	std::vector<VkWriteDescriptorSet> descriptorWrites;
 
-	VkDescriptorImageInfo pos = vkb::initializers::descriptor_image_info(textureSampler, geometry.position->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	VkDescriptorImageInfo depthMap = vkb::initializers::descriptor_image_info(textureSampler, depth->imageView, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
 	VkDescriptorImageInfo normal = vkb::initializers::descriptor_image_info(textureSampler, geometry.normal->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 	VkDescriptorImageInfo albedo = vkb::initializers::descriptor_image_info(textureSampler, geometry.albedo->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-	VkDescriptorImageInfo arm = vkb::initializers::descriptor_image_info(textureSampler, geometry.arm->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	VkDescriptorImageInfo material = vkb::initializers::descriptor_image_info(textureSampler, geometry.material->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 	VkDescriptorImageInfo emissive = vkb::initializers::descriptor_image_info(textureSampler, geometry.emissive->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 	assert(irradianceCubeMap);
 	VkDescriptorImageInfo diffuseMap = vkb::initializers::descriptor_image_info(textureSampler, irradianceCubeMap->getDiffuseMapImageView()->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 	VkDescriptorImageInfo specularPrefilterMap = vkb::initializers::descriptor_image_info(textureSampler, irradianceCubeMap->getSpecularMapImageView()->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 	VkDescriptorImageInfo specularBRDFLUT = vkb::initializers::descriptor_image_info(textureSampler, irradianceCubeMap->getSpecularBRDFLUTImageView()->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	VkDescriptorImageInfo lightAccumulation = vkb::initializers::descriptor_image_info(textureSampler, lightVolumes.getAccumulation()->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
 	auto geometryTextureDescriptor = [&](VkImageView imageView){
 		return vkb::initializers::descriptor_image_info(textureSampler, imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 	};
 	
+	// 단일 렌더 패스의 G-buffer 는 TRANSIENT 라 샘플링할 수 없다. 그 때 라이팅은 input attachment 셋으로 읽으므로
+	// 이 셋의 G-buffer 바인딩은 비워 두고, 텍스처 뷰어에도 올리지 않는다.
+	const bool gbufferSampled = !isSinglePassDeferred();
+
 	for (size_t i = 0; i < swapChainImages.size(); i++)
 	{
 		descriptorWrites = {
-			vkb::initializers::write_descriptor_set(outDescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 0, &pos),
-			vkb::initializers::write_descriptor_set(outDescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, &normal),
-			vkb::initializers::write_descriptor_set(outDescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2, &albedo),
-			vkb::initializers::write_descriptor_set(outDescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 3, &arm),
+			vkb::initializers::write_descriptor_set(outDescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 0, &depthMap),
 			vkb::initializers::write_descriptor_set(outDescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4, &diffuseMap),
 			vkb::initializers::write_descriptor_set(outDescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 5, &specularPrefilterMap),
 			vkb::initializers::write_descriptor_set(outDescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 6, &specularBRDFLUT),
-			vkb::initializers::write_descriptor_set(outDescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 7, &emissive)
+			vkb::initializers::write_descriptor_set(outDescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 8, &lightAccumulation)
 		};
+		if (gbufferSampled)
+		{
+			descriptorWrites.push_back(vkb::initializers::write_descriptor_set(outDescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, &normal));
+			descriptorWrites.push_back(vkb::initializers::write_descriptor_set(outDescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2, &albedo));
+			descriptorWrites.push_back(vkb::initializers::write_descriptor_set(outDescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 3, &material));
+			descriptorWrites.push_back(vkb::initializers::write_descriptor_set(outDescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 7, &emissive));
+		}
 
 		vkUpdateDescriptorSets(*device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
 	}
 
 	{
-		textureViewer->addTexture(geometry.position, "Position");
-		textureViewer->addTexture(geometry.normal, "WorldNormal");
-		textureViewer->addTexture(geometry.albedo, "Albedo");
-		textureViewer->addTexture(geometry.arm, "AO,Roughness,Metallic");
-		textureViewer->addTexture(geometry.emissive, "Emissive");
+		if (gbufferSampled)
+		{
+			textureViewer->addTexture(geometry.normal, "WorldNormal (Octahedral)");
+			textureViewer->addTexture(geometry.albedo, "Albedo");
+			textureViewer->addTexture(geometry.material, "Roughness,Metallic");
+			textureViewer->addTexture(geometry.emissive, "Emissive");
+		}
+		textureViewer->addTexture(lightVolumes.getAccumulation(), "Light Accumulation");
+	}
+}
+
+void VulkanTutorialExtension::createLightingPassInputAttachmentSets()
+{
+	std::vector<VkDescriptorSetLayout> layouts(swapChainImages.size(), lightingPass.inputAttachmentSetLayout);
+	VkDescriptorSetAllocateInfo allocInfo = vkb::initializers::descriptor_set_allocate_info(descriptorPool, layouts.data(), static_cast<uint32_t>(layouts.size()));
+
+	lightingPass.inputAttachmentSets.resize(swapChainImages.size());
+	VK_CHECK_RESULT(vkAllocateDescriptorSets(*device, &allocInfo, lightingPass.inputAttachmentSets.data()));
+
+	// input attachment 는 샘플러 없이 서브패스의 레이아웃으로 읽는다.
+	VkDescriptorImageInfo depthMap = vkb::initializers::descriptor_image_info(VK_NULL_HANDLE, depth->imageView, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+	VkDescriptorImageInfo normal = vkb::initializers::descriptor_image_info(VK_NULL_HANDLE, geometry.normal->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	VkDescriptorImageInfo albedo = vkb::initializers::descriptor_image_info(VK_NULL_HANDLE, geometry.albedo->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	VkDescriptorImageInfo material = vkb::initializers::descriptor_image_info(VK_NULL_HANDLE, geometry.material->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	VkDescriptorImageInfo emissive = vkb::initializers::descriptor_image_info(VK_NULL_HANDLE, geometry.emissive->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	VkDescriptorImageInfo diffuseMap = vkb::initializers::descriptor_image_info(textureSampler, irradianceCubeMap->getDiffuseMapImageView()->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	VkDescriptorImageInfo specularPrefilterMap = vkb::initializers::descriptor_image_info(textureSampler, irradianceCubeMap->getSpecularMapImageView()->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	VkDescriptorImageInfo specularBRDFLUT = vkb::initializers::descriptor_image_info(textureSampler, irradianceCubeMap->getSpecularBRDFLUTImageView()->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+	for (size_t i = 0; i < swapChainImages.size(); i++)
+	{
+		const VkDescriptorSet set = lightingPass.inputAttachmentSets[i];
+		std::vector<VkWriteDescriptorSet> descriptorWrites = {
+			vkb::initializers::write_descriptor_set(set, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 0, &depthMap),
+			vkb::initializers::write_descriptor_set(set, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1, &normal),
+			vkb::initializers::write_descriptor_set(set, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 2, &albedo),
+			vkb::initializers::write_descriptor_set(set, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 3, &material),
+			vkb::initializers::write_descriptor_set(set, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4, &diffuseMap),
+			vkb::initializers::write_descriptor_set(set, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 5, &specularPrefilterMap),
+			vkb::initializers::write_descriptor_set(set, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 6, &specularBRDFLUT),
+			vkb::initializers::write_descriptor_set(set, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 7, &emissive)
+		};
+
+		vkUpdateDescriptorSets(*device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
 	}
 }
 
@@ -343,6 +437,8 @@ int VulkanTutorialExtension::loadGltfModel(const std::string& modelPath)
 	loadedScenes[fileName] = *structureFile;
 	leftPanel->SetModelLoadResult(true, modelPath);
 	sceneInstances.push_back({ fileName.c_str(), glm::identity<glm::mat4>()});
+	transformHierarchy.markDirty();
+	sceneBVH.markDirty();
 	markCommandBufferRecreation();
 
 	return sceneInstances.size() - 1;
@@ -376,10 +472,23 @@ void VulkanTutorialExtension::removeGltfModelDeferred(const std::string& modelPa
 		sceneInstances.end()
 	);
 
-	DeferredDeletionQueue::get().pushResource(loadedScenes[fileName]);
+	VkDeviceSize meshBytes = 0;
+	GPUResourcePools& pools = GPUResourcePools::get();
+	for (MeshHandle meshHandle : loadedScenes[fileName]->meshes)
+	{
+		if (const MeshAsset<Vertex>* mesh = pools.meshes.get(meshHandle))
+		{
+			meshBytes += mesh->vertexAllocation.size + mesh->indexAllocation.size + mesh->positionAllocation.size;
+		}
+	}
+
+	DeferredDeletionQueue::get().pushResource(loadedScenes[fileName], meshBytes);
 	loadedScenes.erase(fileName);
+	transformHierarchy.markDirty();
+	sceneBVH.markDirty();
 
 	markCommandBufferRecreation();
+	meshDefragmenter->requestDefragment();
 }
 
 void VulkanTutorialExtension::removeGltfModel(const std::string& fileName)
@@ -389,6 +498,8 @@ void VulkanTutorialExtension::removeGltfModel(const std::string& fileName)
 	std::cout << "Remove gltf model " << fileName << std::endl;
 
 	loadedScenes.erase(fileName);
+	transformHierarchy.markDirty();
+	sceneBVH.markDirty();
 }
 
 void VulkanTutorialExtension::init_default_data()
@@ -411,28 +522,78 @@ void VulkanTutorialExtension::updateDebugDisplayTarget()
 
 void VulkanTutorialExtension::update_scene(uint32_t currentImage)
 {
-	static glm::vec3 pointLightPositions[] = {
-		glm::vec3(0.7f,  0.2f,  2.0f),
-		glm::vec3(2.3f, -3.3f, -4.0f),
-		glm::vec3(-4.0f,  2.0f, -12.0f),
-		glm::vec3(0.0f,  0.0f, -3.0f)
-	};
+	// 렌더컨텍스트를 이번 프레임 arena 위에 새로 만들고,
+	mainDrawContext.reset(FrameAllocator::get().current());
+
+	const float nearPlane = 0.1f;
+	const float farPlane = 100.f;
+	glm::mat4 viewMat = camera.GetViewMatrix();
+	glm::mat4 persMat = glm::perspective(glm::radians(45.f), swapChainExtent.width / (float)(swapChainExtent.height), nearPlane, farPlane);
+	persMat[1][1] *= -1;
+	const Frustum frustum = Frustum::fromViewProjection(persMat * viewMat);
 
-	// ؽƮ ʱȭ ϰ,
-	mainDrawContext.OpaqueSurfaces.clear();
-	mainDrawContext.TranslucentSurfaces.clear();
+	// 화면 밖 드로우를 뺀다. 드로우 목록이 카메라에 따라 바뀌므로 매 프레임 녹화할 때만 한다.
+	const bool cullDraws = useFrustumCulling && isRecordingCommandsEveryFrame();
+	lastCullingStats = {};
 
-	// OpaqueSurfaces RenderObject ְ Ŀǵ ۸  غ ģ.
-	for (const auto& instance : sceneInstances)
+	// 서피스 LOD 도 카메라 거리에 따라 바뀌므로 매 프레임 녹화할 때만 고른다.
+	const bool selectLods = MeshLodSelector::enabled && isRecordingCommandsEveryFrame();
+	mainDrawContext.lodSelector = selectLods ? &meshLodSelector : nullptr;
+	if (selectLods)
 	{
-		loadedScenes[instance.modelName]->Draw(instance.transform, mainDrawContext);
+		meshLodSelector.beginFrame(camera.Position, static_cast<float>(swapChainExtent.height), glm::radians(45.f));
+	}
+
+	// 움직인 인스턴스의 서브트리만 월드 행렬을 다시 계산한다. 정적인 장면에서는 거의 비용이 없다.
+	transformHierarchy.update(sceneInstances, loadedScenes);
+
+	// OpaqueSurfaces에 RenderObject를 넣고 커맨드 버퍼를 만들 준비를 마친다.
+	// BVH 를 쓰면 프러스텀 안의 서피스만 꺼내고, 아니면 메시 노드를 평평한 배열에서 모두 꺼낸다.
+	uint32_t firstOpaqueToCull = 0;
+	uint32_t firstTranslucentToCull = 0;
+	if (cullDraws && useSceneBVH)
+	{
+		sceneBVH.update(transformHierarchy);
+		lastCullingStats += sceneBVH.draw(frustum, mainDrawContext);
+		firstOpaqueToCull = static_cast<uint32_t>(mainDrawContext.OpaqueSurfaces.size());
+		firstTranslucentToCull = static_cast<uint32_t>(mainDrawContext.TranslucentSurfaces.size());
+
+		sceneBVH.raycast(camera.Position, camera.Front, 100.f, lastPickHit);
+		sceneBVH.findNearest(camera.Position, 100.f, lastNearestHit);
+	}
+	else
+	{
+		transformHierarchy.draw(mainDrawContext);
+		lastPickHit = {};
+		lastNearestHit = {};
 	}
 
 	materialTester->draw(mainDrawContext, "viewer");
 
-	glm::mat4 viewMat = camera.GetViewMatrix();
-	glm::mat4 persMat = glm::perspective(glm::radians(45.f), swapChainExtent.width / (float)(swapChainExtent.height), 0.1f, 100.f);
-	persMat[1][1] *= -1;
+	if (cullDraws)
+	{
+		lastCullingStats += FrustumCulling::cullDrawList(mainDrawContext.OpaqueSurfaces, frustum, firstOpaqueToCull);
+		lastCullingStats += FrustumCulling::cullDrawList(mainDrawContext.TranslucentSurfaces, frustum, firstTranslucentToCull);
+	}
+
+	// 같은 서피스를 인스턴스 드로우로 합친다. 정렬보다 먼저 해야 인스턴스 배치가 카메라와 무관해진다.
+	drawInstances = FrameVector<Instance>(FrameAllocator::get().allocator<Instance>());
+	if (useAutoInstancing)
+	{
+		lastInstancingStats = DrawInstancing::mergeInstances(mainDrawContext.OpaqueSurfaces, drawInstances);
+	}
+	else
+	{
+		lastInstancingStats = {};
+		lastInstancingStats.sourceDraws = lastInstancingStats.mergedDraws = static_cast<uint32_t>(mainDrawContext.OpaqueSurfaces.size());
+	}
+	uploadDrawInstances(currentImage);
+
+	// 파이프라인/머티리얼/메시 순으로 묶고, 반투명은 뒤에서 앞으로 그린다.
+	// OIT 로 합성하면 반투명의 순서가 결과를 바꾸지 않으므로 불투명처럼 상태로만 묶는다.
+	DrawSorting::sortDrawList(mainDrawContext.OpaqueSurfaces, DrawSorting::Pass::Opaque, camera.Position, camera.Front);
+	const DrawSorting::Pass translucentOrder = weightedBlendedOIT.hasTargets() ? DrawSorting::Pass::Opaque : DrawSorting::Pass::Translucent;
+	DrawSorting::sortDrawList(mainDrawContext.TranslucentSurfaces, translucentOrder, camera.Position, camera.Front);
 
 	GPUSceneData& sceneData = globalSceneData->getFirstInstanceData();
 	sceneData = {};
@@ -442,6 +603,8 @@ void VulkanTutorialExtension::update_scene(uint32_t currentImage)
 	sceneData.view = viewMat;
 	// camera projection
 	sceneData.proj = persMat;
+	sceneData.inverseViewProj = glm::inverse(persMat * viewMat);
+	sceneData.renderExtent = glm::vec4(renderExtent.width, renderExtent.height, 1.f / renderExtent.width, 1.f / renderExtent.height);
 
 	//some default lighting parameters
 	sceneData.ambientColor = glm::vec4(.1f);
@@ -449,15 +612,34 @@ void VulkanTutorialExtension::update_scene(uint32_t currentImage)
 	sceneData.sunlightDirection = glm::vec4(0, 1, 0.5, 1.f); 
 
 	// Point Lights
-	sceneData.activePointLight.activeLightMask = activePointLightsMask;
-	auto& pointLights = sceneData.activePointLight.pointLights;
-	for (int i = 0; i < NR_POINT_LIGHTS; i++)
+	uploadPointLights(currentImage);
+
+	// 라이팅 패스는 포인트 라이트를 클러스터 버퍼에서 읽는다. 버퍼를 매 프레임 채우므로 라이트가 바뀌어도 다시 녹화하지 않는다.
+	clusterLights.clear();
+	for (const ScenePointLight& light : scenePointLights)
+	{
+		if (light.enabled)
+		{
+			clusterLights.push_back(ClusteredLighting::makeLight(light.position, glm::vec3(1.f), pointLightIntensity));
+		}
+	}
+	ClusteredLighting::appendTestLights(clusterLights, static_cast<uint32_t>(ClusteredLighting::testLightCount), static_cast<float>(glfwGetTime()));
+
+	// 그림자는 화면 밖 물체도 드리우므로 카메라 컬링과 LOD 를 거치지 않은 목록을 따로 만든다.
+	const bool shadowsActive = CascadedShadowMap::enabled && useDirectionalLight && isRecordingCommandsEveryFrame();
+	const bool pointShadowsActive = PointShadowAtlas::enabled && pointShadowAtlas.isSupported() && isRecordingCommandsEveryFrame() && !clusterLights.empty();
+	shadowCasterContext.reset(FrameAllocator::get().current());
+	if (shadowsActive || pointShadowsActive)
 	{
-		PointLight& pointLight = pointLights[i];
-		pointLight.position = pointLightPositions[i];
-		pointLight.clq = glm::vec3(1.0f, pointLightlinear, pointLightQuadratic);
-		pointLight.colorIntensity = glm::vec4(1.f, 1.f, 1.f, pointLightIntensity);
+		transformHierarchy.draw(shadowCasterContext);
 	}
+	// 그림자를 쓸 라이트의 color.w 를 채우므로 클러스터 버퍼에 올리기 전에 부른다.
+	pointShadowAtlas.update(currentImage, pointShadowsActive, clusterLights, camera.Position, frustum, glm::radians(45.f),
+		static_cast<float>(swapChainExtent.height), shadowCasterContext.OpaqueSurfaces, transformHierarchy);
+
+	// 라이트 볼륨은 라이팅 패스 앞에 따로 그려야 하므로 단일 렌더 패스에서는 클러스터로 되돌아간다.
+	clusteredLighting.update(currentImage, viewMat, persMat, renderExtent, nearPlane, farPlane, clusterLights, LightVolumes::enabled && !isSinglePassDeferred());
+	lightVolumes.update(currentImage, clusteredLighting.getLightCount(currentImage));
 
 	// Directional Light
 	DirLight dirLight = {};
@@ -465,9 +647,15 @@ void VulkanTutorialExtension::update_scene(uint32_t currentImage)
 	{
 		dirLight.colorIntensity = glm::vec4(0.4f, 0.4f, 0.4f, directionalLightIntensity); // darken diffuse light a bit
 	}
-	dirLight.direction = glm::vec3(-0.2f, -1.0f, -0.3f);
+	dirLight.direction = directionalLightDirection;
 	sceneData.dirLight = std::move(dirLight);
 
+	// 인스턴스가 움직이거나 모델을 넣고 빼면 캐시한 먼 캐스케이드도 다시 그린다.
+	const bool shadowSceneChanged = transformHierarchy.hasUpdates() || transformHierarchy.getStructureVersion() != shadowStructureVersion;
+	shadowStructureVersion = transformHierarchy.getStructureVersion();
+	cascadedShadowMap.update(currentImage, shadowsActive, directionalLightDirection, viewMat, glm::radians(45.f),
+		swapChainExtent.width / (float)(swapChainExtent.height), nearPlane, farPlane, shadowCasterContext.OpaqueSurfaces, shadowSceneChanged);
+
 	globalSceneData->CopyData(currentImage);
 }
 
@@ -475,13 +663,6 @@ void VulkanTutorialExtension::updateUniformBuffer(uint32_t currentImage)
 {
 	VulkanTutorial::updateUniformBuffer(currentImage);
 
-	static glm::vec3 pointLightPositions[] = {
-		glm::vec3(0.7f,  0.2f,  2.0f),
-		glm::vec3(2.3f, -3.3f, -4.0f),
-		glm::vec3(-4.0f,  2.0f, -12.0f),
-		glm::vec3(0.0f,  0.0f, -3.0f)
-	};
-
 	glm::mat4 viewMat = camera.GetViewMatrix();
 	glm::mat4 persMat = glm::perspective(glm::radians(45.f), swapChainExtent.width / (float)(swapChainExtent.height), 0.1f, 100.f);
 	persMat[1][1] *= -1;
@@ -505,18 +686,11 @@ void VulkanTutorialExtension::updateUniformBuffer(uint32_t currentImage)
 	material.ambient = glm::vec3(1.0f, 0.5f, 0.31f);
 	material.diffuse = glm::vec3(1.0f, 0.5f, 0.31f);
 	material.specular = glm::vec3(1.0f, 0.5f, 0.31f);
-	//    Ÿ   float  ȵȴ. 
-	// float ҰŸ vec3/vec4 ؼ Ʈ Ѱִ ͸ ۵Ѵ. 
+	// 유니폼 버퍼 멤버의 타입을 정할 때 float은 잘 안된다. 
+	// float을 할거면 vec3/vec4로 해서 컴포넌트로 넘겨주는 것만 작동한다. 
 	material.shininess = glm::vec3(32.0f, 0.5f, 0.31f);
 
 	materialUniformBuffer->CopyData(currentImage);
-
-	// Point Lights
-	clearPointLightsSwitch();
-	for (int i = 0; i < NR_POINT_LIGHTS; i++)
-	{
-		turnPointLightOn(i);
-	}
 }
 
 void VulkanTutorialExtension::clearUniformBuffer(uint32_t i)
@@ -551,6 +725,8 @@ void VulkanTutorialExtension::createGlobalDescriptorSetLayout()
 {
 	std::vector<VkDescriptorSetLayoutBinding> bindings;
 	createDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, bindings);
+	// 포인트 라이트 목록
+	createDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, bindings);
 	globalDescriptorSetLayout = vk::desc::createDescriptorSetLayout(*device, bindings);
 }
 
@@ -585,13 +761,13 @@ void VulkanTutorialExtension::createLightingPassDescriptorSetLayout()
 {
 	std::vector<VkDescriptorSetLayoutBinding> bindings;
 
-	//	position
+	//	depth (월드 위치 복원)
 	createDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, bindings);
 	//	normal
 	createDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, bindings);
-	//	color 
+	//	color, ao
 	createDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, bindings);
-	//	arm
+	//	roughness, metallic
 	createDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, bindings);
 	// diffuse map
 	createDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, bindings);
@@ -601,8 +777,38 @@ void VulkanTutorialExtension::createLightingPassDescriptorSetLayout()
 	createDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, bindings);
 	// emissive
 	createDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, bindings);
+	// light accumulation (LightVolumes)
+	createDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, bindings);
 
 	lightingPass.descriptorSetLayout = vk::desc::createDescriptorSetLayout(*device, bindings);
+
+	// 단일 렌더 패스에서는 G-buffer 와 깊이를 같은 binding 의 input attachment 로 읽는다. 라이트 볼륨은 쓰지 않는다.
+	bindings.clear();
+	//	depth
+	createDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_SHADER_STAGE_FRAGMENT_BIT, bindings);
+	//	normal
+	createDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_SHADER_STAGE_FRAGMENT_BIT, bindings);
+	//	color, ao
+	createDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_SHADER_STAGE_FRAGMENT_BIT, bindings);
+	//	roughness, metallic
+	createDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_SHADER_STAGE_FRAGMENT_BIT, bindings);
+	// diffuse map
+	createDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, bindings);
+	// specular prefilter map
+	createDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, bindings);
+	// brdf lut 2d
+	createDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, bindings);
+	// emissive
+	createDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_SHADER_STAGE_FRAGMENT_BIT, bindings);
+
+	lightingPass.inputAttachmentSetLayout = vk::desc::createDescriptorSetLayout(*device, bindings);
+
+	// set 2 : 포인트 라이트와 클러스터 목록
+	clusteredLighting.createDescriptorSetLayout(*device);
+	// set 3 : 방향광 캐스케이드 그림자
+	cascadedShadowMap.createDescriptorSetLayout(*device);
+	// set 4 : 포인트 라이트 그림자 아틀라스. 셋을 4 개까지만 묶는 장치에서는 쓰지 않는다.
+	pointShadowAtlas.createDescriptorSetLayout(*device, physicalDevice);
 }
 
 void VulkanTutorialExtension::createGraphicsPipelines()
@@ -726,12 +932,12 @@ void VulkanTutorialExtension::createGraphicsPipelines()
 	auto& colorBlendAttachment = colorBlendAttachments[0];
 	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
 	colorBlendAttachment.blendEnable = VK_TRUE;
-	colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;  // ҽ   
-	colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;  //    
-	colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;  //   
-	colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;  // ҽ   
-	colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;  //    
-	colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;  //   
+	colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;  // 소스 색상 블렌딩 팩터
+	colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;  // 대상 색상 블렌딩 팩터
+	colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;  // 색상 블렌딩 연산
+	colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;  // 소스 알파 블렌딩 팩터
+	colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;  // 대상 알파 블렌딩 팩터
+	colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;  // 알파 블렌딩 연산
 
 	VkPipelineColorBlendStateCreateInfo colorBlending{};
 	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
@@ -751,7 +957,7 @@ void VulkanTutorialExtension::createGraphicsPipelines()
 	pipelineInfo.renderPass = forward.renderPass;
 	pipelineInfo.pColorBlendState = &colorBlending;
 
-	// vk_engine ڵ ϴ Ѵ.
+	// vk_engine의 코드로 일단은 갈음한다.
 	//if (vkCreateGraphicsPipelines(*device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &forward.pipeline) != VK_SUCCESS)
 	//{
 	//	throw std::runtime_error("failed to create graphics pipeline");
@@ -812,14 +1018,31 @@ void VulkanTutorialExtension::createGraphicsPipelines()
 	* For lightpass
 	*/
 
-	std::array<VkDescriptorSetLayout, 2> layouts = { globalDescriptorSetLayout, lightingPass.descriptorSetLayout };
-	VkPipelineLayoutCreateInfo mesh_layout_info = vkb::initializers::pipeline_layout_create_info(layouts.size());
+	// 단일 렌더 패스에서는 G-buffer 를 subpassInput 으로 읽는 변형을 라이팅 서브패스에 만든다.
+	const bool singlePassLighting = isSinglePassDeferred();
+	const VkDescriptorSetLayout gbufferSetLayout = singlePassLighting ? lightingPass.inputAttachmentSetLayout : lightingPass.descriptorSetLayout;
+	std::vector<VkDescriptorSetLayout> layouts = { globalDescriptorSetLayout, gbufferSetLayout, clusteredLighting.getDescriptorSetLayout(),
+		cascadedShadowMap.getDescriptorSetLayout() };
+	// 셋을 4 개까지만 묶는 장치에서는 set 4 를 선언하지 않은 셰이더 변형을 쓴다.
+	const bool pointShadowSet = pointShadowAtlas.isSupported();
+	if (pointShadowSet)
+	{
+		layouts.push_back(pointShadowAtlas.getDescriptorSetLayout());
+	}
+	VkPipelineLayoutCreateInfo mesh_layout_info = vkb::initializers::pipeline_layout_create_info(static_cast<uint32_t>(layouts.size()));
 	mesh_layout_info.pSetLayouts = layouts.data();
 	
 	VK_CHECK_RESULT(vkCreatePipelineLayout(*device, &mesh_layout_info, nullptr, &lightingPass.pipelineLayout));
 	 
 	vertShaderModule = Utils::loadShader("shaders/LightingPassvert.spv", *device);
-	fragShaderModule = Utils::loadShader("shaders/Pbrfrag.spv", *device);
+	if (singlePassLighting)
+	{
+		fragShaderModule = Utils::loadShader(pointShadowSet ? "shaders/PbrSubpassfrag.spv" : "shaders/PbrSubpassNoPointShadowfrag.spv", *device);
+	}
+	else
+	{
+		fragShaderModule = Utils::loadShader(pointShadowSet ? "shaders/Pbrfrag.spv" : "shaders/PbrNoPointShadowfrag.spv", *device);
+	}
 	
 	vertShaderStageInfo.module = vertShaderModule;
 	fragShaderStageInfo.module = fragShaderModule;
@@ -841,14 +1064,24 @@ void VulkanTutorialExtension::createGraphicsPipelines()
 	colorBlending.attachmentCount = 1;
 	colorBlending.pAttachments = &lightingColorBlendAttachment;
 
-	// NOTE : ̰ ٽ̴. BACK_FACE_CULLING ϴϱ ȳ. 
+	// NOTE : 이게 핵심이다. BACK_FACE_CULLING으로 하니까 안나오네. 
 	rasterizer.cullMode = VK_CULL_MODE_FRONT_BIT;
 
 	pipelineInfo.stageCount = 2;
 	pipelineInfo.pStages = shaderStages;
 	pipelineInfo.layout = lightingPass.pipelineLayout;
-	pipelineInfo.renderPass = renderPass;
-	pipelineInfo.pDepthStencilState = nullptr;
+	pipelineInfo.renderPass = singlePassLighting ? singlePass.renderPass : renderPass;
+	pipelineInfo.subpass = lightingPass.subpass;
+
+	// 지오메트리 패스가 스텐실을 남긴 픽셀만 칠한다. 깊이는 셰이더에서 읽기만 한다.
+	VkPipelineDepthStencilStateCreateInfo lightingDepthStencil = vkb::initializers::pipeline_depth_stencil_state_create_info(VK_FALSE, VK_FALSE, VK_COMPARE_OP_ALWAYS);
+	GeometryPass::testStencil(lightingDepthStencil);
+	pipelineInfo.pDepthStencilState = &lightingDepthStencil;
+
+	// 동적 해상도를 켜면 그리는 영역이 매 프레임 바뀐다.
+	std::vector<VkDynamicState> lightingDynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	VkPipelineDynamicStateCreateInfo lightingDynamicState = vkb::initializers::pipeline_dynamic_state_create_info(lightingDynamicStates);
+	pipelineInfo.pDynamicState = &lightingDynamicState;
 
 	if (vkCreateGraphicsPipelines(*device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &lightingPass.pipeline) != VK_SUCCESS)
 	{
@@ -861,14 +1094,97 @@ void VulkanTutorialExtension::createGraphicsPipelines()
 
 void VulkanTutorialExtension::recordCommandBuffer(VkCommandBuffer commandBuffer, size_t index)
 {	
-	// PBR  
+	// PBR 디버그 용
 	//irradianceCubeMap->draw(commandBuffer, this);
 
+	// 동적 해상도의 GPU 시간은 프레임 커맨드 버퍼 전체로 잰다.
+	if (dynamicResolution.hasTargets() && isRecordingFrameCommandBuffer())
+	{
+		dynamicResolution.recordBeginTimestamp(commandBuffer, static_cast<uint32_t>(currentFrame));
+	}
+
+	// 매 프레임 녹화할 때는 프레임 슬롯의, 한번 녹화해 둘 때는 스왑체인 이미지의 secondary 버퍼를 새로 녹화한다.
+	if (useParallelRecording)
+	{
+		const bool everyFrame = isRecordingFrameCommandBuffer();
+		recordSlot = everyFrame ? 1 + static_cast<uint32_t>(currentFrame) : 1 + MAX_FRAMES_IN_FLIGHT + static_cast<uint32_t>(index);
+		commandRecorder.beginSlot(recordSlot, everyFrame ? VK_COMMAND_POOL_CREATE_TRANSIENT_BIT : 0);
+	}
+
+	// 간접 드로우 버퍼는 프레임 슬롯마다 하나라서 매 프레임 녹화할 때만 쓴다. 컬링은 지오메트리 패스보다 먼저 기록한다.
+	const uint32_t frameIndex = static_cast<uint32_t>(currentFrame);
+	const GPUSceneData& sceneData = globalSceneData->getFirstInstanceData();
+	const glm::mat4 viewProjection = sceneData.proj * sceneData.view;
+	indirectDrawActive = IndirectDrawPass::enabled && indirectDrawPass.isSupported() && isRecordingFrameCommandBuffer();
+	if (indirectDrawActive)
+	{
+		indirectFallbackDraws = FrameVector<RenderObject>(FrameAllocator::get().allocator<RenderObject>());
+		indirectDrawPass.prepare(frameIndex, mainDrawContext.OpaqueSurfaces, drawInstances, viewProjection, indirectFallbackDraws);
+	}
+
+	// 가림 컬링 1 단계. 지난 프레임 피라미드로 검사하고, 2 단계는 recordPostGeometryPassCommands 에서 한다.
+	// 단일 렌더 패스는 지오메트리와 라이팅 사이에 피라미드를 만들 수 없으므로 끈다.
+	occlusionActive = OcclusionCulling::enabled && occlusionCulling.isSupported() && isRecordingFrameCommandBuffer() && !isSinglePassDeferred();
+	if (occlusionActive)
+	{
+		occlusionCulling.beginFrame(frameIndex);
+		occlusionCulling.prepare(frameIndex, indirectDrawActive ? indirectFallbackDraws : mainDrawContext.OpaqueSurfaces, drawInstances, viewProjection);
+
+		GPUMarker Marker(commandBuffer, "Occlusion Culling Early");
+		occlusionCulling.recordTest(commandBuffer, frameIndex, 0);
+	}
+	else
+	{
+		occlusionCulling.invalidatePyramid();
+	}
+
+	// 간접 드로우와 가림 컬링은 그릴 드로우를 GPU 가 정하므로 CPU 목록으로 깊이를 미리 채울 수 없다.
+	// 단일 렌더 패스는 지오메트리 서브패스 앞에 다른 패스를 넣을 수 없으므로 끈다.
+	depthPrepassActive = DepthPrepass::enabled && !indirectDrawActive && !occlusionActive && !isSinglePassDeferred();
+	// 병렬 녹화면 쿼리가 켜진 채로 secondary 를 실행하므로 inheritedQueries 가 없으면 재지 않는다.
+	geometryStatisticsActive = depthPrepass.isStatisticsSupported() && isRecordingFrameCommandBuffer() && !isSinglePassDeferred()
+		&& (!useParallelRecording || getOptionalDeviceFeatures().inheritedQueries);
+
+	if (indirectDrawActive)
+	{
+		GPUMarker Marker(commandBuffer, "GPU Culling");
+		indirectDrawPass.recordCulling(commandBuffer, frameIndex, 0, occlusionActive);
+	}
+
+	// 클러스터 경계는 카메라만으로 정해지므로 지오메트리 패스를 기다리지 않는다.
+	{
+		GPUMarker Marker(commandBuffer, "Light Clustering");
+		clusteredLighting.recordClustering(commandBuffer, static_cast<uint32_t>(index));
+	}
+
+	// 그림자 맵도 카메라 패스와 상관없다. 다시 그릴 캐스케이드가 없으면 아무것도 기록하지 않는다.
+	cascadedShadowMap.record(commandBuffer, static_cast<uint32_t>(index));
+	pointShadowAtlas.record(commandBuffer, static_cast<uint32_t>(index));
+
 	VulkanTutorial::recordCommandBuffer(commandBuffer, index);
 
+	/**
+	* Weighted Blended OIT
+	*/
+	if (weightedBlendedOIT.hasTargets())
+	{
+		{
+			GPUMarker Marker(commandBuffer, "OIT Accumulation");
+			weightedBlendedOIT.beginAccumulation(commandBuffer, renderExtent);
+			DrawStateCache cache;
+			cache.weightedBlended = true;
+			for (const RenderObject& r : mainDrawContext.TranslucentSurfaces)
+			{
+				drawRenderObject(commandBuffer, index, r, cache, lastBindStats);
+			}
+			weightedBlendedOIT.endAccumulation(commandBuffer);
+		}
+		weightedBlendedOIT.recordResolve(commandBuffer, static_cast<uint32_t>(index), renderExtent);
+	}
+
 	VkRenderPassBeginInfo renderPassInfo = vkb::initializers::render_pass_begin_info();
 	renderPassInfo.renderArea.offset = { 0,0 };
-	renderPassInfo.renderArea.extent = swapChainExtent;
+	renderPassInfo.renderArea.extent = renderExtent;
 	renderPassInfo.renderPass = renderPass;
 	renderPassInfo.framebuffer = swapChainFrameBuffers[index];
 	std::array<VkClearValue, 1> ClearValues{};
@@ -881,78 +1197,675 @@ void VulkanTutorialExtension::recordCommandBuffer(VkCommandBuffer commandBuffer,
 	*/
 	if (textureViewer->getSelectedTextureIndex() > 0)
 	{
+		// 라이팅 패스와 같은 렌더 패스라 깊이를 읽기 전용 레이아웃으로 붙인다.
+		const VkFormat depthFormat = findDepthFormat();
+		transitionImageLayout(commandBuffer, depth->image, depthFormat, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, 1);
+
 		GPUMarker Marker(commandBuffer, "Debug");
 		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 		textureViewer->draw(commandBuffer, this, index);
 		vkCmdEndRenderPass(commandBuffer);
+
+		transitionImageLayout(commandBuffer, depth->image, depthFormat, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, 1);
+	}
+
+	/**
+	* Upscale
+	*/
+	if (dynamicResolution.hasTargets())
+	{
+		dynamicResolution.recordUpscale(commandBuffer, static_cast<uint32_t>(index), renderExtent);
+		if (isRecordingFrameCommandBuffer())
+		{
+			dynamicResolution.recordEndTimestamp(commandBuffer, static_cast<uint32_t>(currentFrame));
+		}
 	}
 }
 
+bool VulkanTutorialExtension::recordDepthPrepassCommands(VkCommandBuffer commandBuffer, size_t i)
+{
+	if (depthPrepassActive)
+	{
+		const VkBuffer instanceBuffer = i < drawInstanceBuffers.size() ? drawInstanceBuffers[i].Buffer : VK_NULL_HANDLE;
+		depthPrepass.record(commandBuffer, mainDrawContext.OpaqueSurfaces, instanceBuffer, globalDescriptorSets[i], renderExtent);
+	}
+
+	// 프리패스는 프래그먼트 셰이더가 없으므로 지오메트리 패스만 잰다. 가림 컬링 2 단계까지 recordPreLightingPassCommands 에서 끝낸다.
+	if (geometryStatisticsActive)
+	{
+		depthPrepass.beginStatistics(commandBuffer, static_cast<uint32_t>(currentFrame), depthPrepassActive);
+	}
+	return depthPrepassActive;
+}
+
 void VulkanTutorialExtension::recordRenderPassCommands(VkCommandBuffer commandBuffer, size_t i)
 {
 	VulkanTutorial::recordRenderPassCommands(commandBuffer, i);
 
-	for (const RenderObject& r : mainDrawContext.OpaqueSurfaces)
+	// 지오메트리 패스가 첫 패스이므로 여기서 통계를 새로 센다.
+	lastBindStats = {};
+
+	recordGeometryDraws(commandBuffer, i, 0);
+}
+
+void VulkanTutorialExtension::recordPostGeometryPassCommands(VkCommandBuffer commandBuffer, size_t i)
+{
+	VulkanTutorial::recordPostGeometryPassCommands(commandBuffer, i);
+
+	if (!occlusionActive)
+	{
+		return;
+	}
+
+	const uint32_t frameIndex = static_cast<uint32_t>(currentFrame);
+	{
+		GPUMarker Marker(commandBuffer, "Hi-Z Pyramid");
+		occlusionCulling.recordBuildPyramid(commandBuffer, depth->image, renderExtent);
+	}
+
+	// 가림 컬링 2 단계. 1 단계에서 가려졌던 드로우만 방금 만든 피라미드로 다시 검사한다.
+	{
+		GPUMarker Marker(commandBuffer, "Occlusion Culling Late");
+		occlusionCulling.recordTest(commandBuffer, frameIndex, 1);
+		if (indirectDrawActive)
+		{
+			indirectDrawPass.recordCulling(commandBuffer, frameIndex, 1, true);
+		}
+	}
+
+	// 살아난 드로우를 지우지 않고 이어 그린다.
+	VkRenderPassBeginInfo renderPassInfo = vkb::initializers::render_pass_begin_info();
+	renderPassInfo.renderPass = geometry.loadRenderPass;
+	renderPassInfo.framebuffer = geometry.frameBuffer;
+	renderPassInfo.renderArea.offset = { 0,0 };
+	renderPassInfo.renderArea.extent = renderExtent;
+
+	GPUMarker Marker(commandBuffer, "Geometry Pass Late");
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, getDrawPassSubpassContents());
+	recordGeometryDraws(commandBuffer, i, 1);
+	vkCmdEndRenderPass(commandBuffer);
+}
+
+void VulkanTutorialExtension::recordGeometryDraws(VkCommandBuffer commandBuffer, size_t i, uint32_t phase)
+{
+	const FrameVector<RenderObject>& opaqueDraws = indirectDrawActive ? indirectFallbackDraws : mainDrawContext.OpaqueSurfaces;
+	const uint32_t frameIndex = static_cast<uint32_t>(currentFrame);
+	const uint32_t indirectGroupCount = indirectDrawActive ? indirectDrawPass.getGroupCount(frameIndex) : 0;
+
+	// 가림 컬링 중이면 CPU 드로우도 검사 결과로 채운 간접 드로우 인자로 그린다.
+	const VkBuffer occlusionArgs = occlusionActive ? occlusionCulling.getDrawCommandBuffer(frameIndex) : VK_NULL_HANDLE;
+	const VkDeviceSize occlusionArgsOffset = occlusionActive ? occlusionCulling.getDrawCommandOffset(frameIndex, phase, 0) : 0;
+
+	if (useParallelRecording)
+	{
+		VkCommandBufferInheritanceInfo inheritance{};
+		inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritance.renderPass = geometry.renderPass;
+		inheritance.subpass = geometry.subpass;
+		inheritance.framebuffer = getGeometryFrameBuffer(i);
+		// 통계 쿼리가 켜진 채로 실행하므로 secondary 도 같은 통계를 물려받아야 한다.
+		inheritance.pipelineStatistics = geometryStatisticsActive ? VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT : 0;
+
+		recordSecondaryDraws(i, recordSlot, inheritance, nullptr,
+			opaqueDraws.data(), static_cast<uint32_t>(opaqueDraws.size()), 0, lastBindStats, occlusionArgs, occlusionArgsOffset);
+
+		if (indirectGroupCount > 0)
+		{
+			const VkViewport viewport = vkb::initializers::viewport((float)renderExtent.width, (float)renderExtent.height, 0.0f, 1.0f);
+			const VkRect2D scissor = vkb::initializers::rect2D(renderExtent.width, renderExtent.height, 0, 0);
+
+			// 간접 드로우는 그룹 단위로 나눈다. 그룹이 적으면 조각 하나로 녹화된다.
+			const ParallelCommandRecorder::RecordFunction recordGroups = [&](VkCommandBuffer secondary, uint32_t begin, uint32_t end, uint32_t)
+			{
+				vkCmdSetViewport(secondary, 0, 1, &viewport);
+				vkCmdSetScissor(secondary, 0, 1, &scissor);
+				indirectDrawPass.recordDraws(secondary, frameIndex, i, begin, end, phase);
+			};
+			commandRecorder.record(recordSlot, inheritance, indirectGroupCount, recordGroups, secondaryCommandBuffers);
+		}
+
+		if (!secondaryCommandBuffers.empty())
+		{
+			vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaryCommandBuffers.size()), secondaryCommandBuffers.data());
+		}
+		return;
+	}
+
+	VkViewport viewport = vkb::initializers::viewport((float)renderExtent.width, (float)renderExtent.height, 0.0f, 1.0f);
+	VkRect2D scissor = vkb::initializers::rect2D(renderExtent.width, renderExtent.height, 0, 0);
+
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+	DrawStateCache cache;
+	cache.depthEqual = depthPrepassActive;
+	for (uint32_t d = 0; d < opaqueDraws.size(); d++)
 	{
-		drawRenderObject(commandBuffer, i, r);
+		drawRenderObject(commandBuffer, i, opaqueDraws[d], cache, lastBindStats,
+			occlusionArgs, occlusionArgsOffset + d * sizeof(VkDrawIndexedIndirectCommand));
 	}
+
+	indirectDrawPass.recordDraws(commandBuffer, frameIndex, i, 0, indirectGroupCount, phase);
+}
+
+void VulkanTutorialExtension::recordPreLightingPassCommands(VkCommandBuffer commandBuffer, size_t i)
+{
+	VulkanTutorial::recordPreLightingPassCommands(commandBuffer, i);
+
+	if (geometryStatisticsActive)
+	{
+		depthPrepass.endStatistics(commandBuffer, static_cast<uint32_t>(currentFrame));
+	}
+
+	// 포인트 라이트를 누적 타겟에 더한다. 꺼져 있으면 타겟을 지우기만 한다.
+	lightVolumes.record(commandBuffer, static_cast<uint32_t>(i), globalDescriptorSets[i], lightingPass.descriptorSets[i], clusteredLighting, pointShadowAtlas, renderExtent);
 }
 
 void VulkanTutorialExtension::recordLightingRenderPassCommands(VkCommandBuffer commandBuffer, size_t i)
 {
 	// Lighting Pass
-	vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, lightingPass.pipeline);
-	vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, lightingPass.pipelineLayout, 0, 1, &globalDescriptorSet, 0, nullptr);
-	vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, lightingPass.pipelineLayout, 1, 1, &lightingPass.descriptorSets[i], 0, nullptr);
+	VkViewport viewport = vkb::initializers::viewport((float)renderExtent.width, (float)renderExtent.height, 0.0f, 1.0f);
+	VkRect2D scissor = vkb::initializers::rect2D(renderExtent.width, renderExtent.height, 0, 0);
+
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, lightingPass.pipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, lightingPass.pipelineLayout, 0, 1, &globalDescriptorSets[i], 0, nullptr);
+	const VkDescriptorSet gbufferSet = isSinglePassDeferred() ? lightingPass.inputAttachmentSets[i] : lightingPass.descriptorSets[i];
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, lightingPass.pipelineLayout, 1, 1, &gbufferSet, 0, nullptr);
+	clusteredLighting.bind(commandBuffer, lightingPass.pipelineLayout, 2, static_cast<uint32_t>(i));
+	cascadedShadowMap.bind(commandBuffer, lightingPass.pipelineLayout, 3, static_cast<uint32_t>(i));
+	if (pointShadowAtlas.isSupported())
+	{
+		pointShadowAtlas.bind(commandBuffer, lightingPass.pipelineLayout, PointShadowAtlas::LightingSetIndex, static_cast<uint32_t>(i));
+	}
 	// Final composition
 	// This is done by simply drawing a full screen quad
 	// The fragment shader then combines the geometry attachments into the final image
 	// Note: Also used for debug display if debugDisplayTarget > 0
-	vkCmdDraw(commandBuffers[i], 3, 1, 0, 0);
+	vkCmdDraw(commandBuffer, 3, 1, 0, 0);
 }
 
 void VulkanTutorialExtension::recordForwardPassCommands(VkCommandBuffer commandBuffer, size_t i)
 {
 	VulkanTutorial::recordForwardPassCommands(commandBuffer, i);
 
-	VkViewport viewport = vkb::initializers::viewport((float)swapChainExtent.width, (float)swapChainExtent.height, 0.0f, 1.0f);
-	VkRect2D scissor = vkb::initializers::rect2D(swapChainExtent.width, swapChainExtent.height, 0, 0);
+	// OIT 를 쓰면 반투명은 포워드 패스 뒤의 누적 패스에서 그린다.
+	const uint32_t forwardTranslucentCount = weightedBlendedOIT.hasTargets() ? 0 : static_cast<uint32_t>(mainDrawContext.TranslucentSurfaces.size());
+
+	if (useParallelRecording)
+	{
+		VkCommandBufferInheritanceInfo inheritance{};
+		inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritance.renderPass = forward.renderPass;
+		inheritance.subpass = forward.subpass;
+		inheritance.framebuffer = getForwardFrameBuffer(i);
+
+		// 스카이박스를 첫 조각 맨 앞에 넣어서 반투명 드로우보다 먼저 그린다.
+		const RenderObject* skyboxDraw = skybox->isValid() ? &skybox->getRenderObject() : nullptr;
+		recordSecondaryDraws(i, recordSlot, inheritance, skyboxDraw,
+			mainDrawContext.TranslucentSurfaces.data(), forwardTranslucentCount, 0, lastBindStats);
+		if (!secondaryCommandBuffers.empty())
+		{
+			vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaryCommandBuffers.size()), secondaryCommandBuffers.data());
+		}
+		return;
+	}
+
+	VkViewport viewport = vkb::initializers::viewport((float)renderExtent.width, (float)renderExtent.height, 0.0f, 1.0f);
+	VkRect2D scissor = vkb::initializers::rect2D(renderExtent.width, renderExtent.height, 0, 0);
 
 	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
+	DrawStateCache cache;
 	if (skybox->isValid())
 	{
-		drawRenderObject(commandBuffer, i, skybox->getRenderObject());
+		drawRenderObject(commandBuffer, i, skybox->getRenderObject(), cache, lastBindStats);
 	}
 
-	for (const RenderObject& r : mainDrawContext.TranslucentSurfaces)
+	for (uint32_t d = 0; d < forwardTranslucentCount; d++)
 	{
-		drawRenderObject(commandBuffer, i, r);
+		drawRenderObject(commandBuffer, i, mainDrawContext.TranslucentSurfaces[d], cache, lastBindStats);
 	}
 }
 
-void VulkanTutorialExtension::drawRenderObject(VkCommandBuffer commandBuffer, size_t i, const RenderObject& draw)
+VkSubpassContents VulkanTutorialExtension::getDrawPassSubpassContents()
+{
+	return useParallelRecording ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+}
+
+void VulkanTutorialExtension::recordSecondaryDraws(size_t i, uint32_t slot, const VkCommandBufferInheritanceInfo& inheritance, const RenderObject* firstDraw,
+	const RenderObject* draws, uint32_t drawCount, uint32_t maxWorkers, DrawBindStats& outStats,
+	VkBuffer indirectArgs, VkDeviceSize indirectArgsOffset)
 {
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, draw.material->pipeline->pipeline);
-	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, draw.material->pipeline->layout, 0, 1, &globalDescriptorSet, 0, nullptr);
-	LOG(Log, "draw descriptor set {}", draw.material->materialSet[i]);
-	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, draw.material->pipeline->layout, 1, 1, &draw.material->materialSet[i], 0, nullptr);
+	secondaryCommandBuffers.clear();
 
-	LOG(Log, "draw vertex buffer {}", draw.vertexBuffer);
-	VkBuffer vertexBuffers[]{ draw.vertexBuffer };
-	VkDeviceSize offsets[]{ 0 };
-	vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-	LOG(Log, "draw index buffer {}", draw.indexBuffer);
-	vkCmdBindIndexBuffer(commandBuffer, draw.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+	const uint32_t totalCount = drawCount + (firstDraw ? 1 : 0);
+	const uint32_t chunkCount = commandRecorder.getChunkCount(totalCount, maxWorkers);
+	FrameVector<DrawBindStats> chunkStats(chunkCount, DrawBindStats{}, FrameAllocator::get().allocator<DrawBindStats>());
+
+	const VkViewport viewport = vkb::initializers::viewport((float)renderExtent.width, (float)renderExtent.height, 0.0f, 1.0f);
+	const VkRect2D scissor = vkb::initializers::rect2D(renderExtent.width, renderExtent.height, 0, 0);
+
+	const ParallelCommandRecorder::RecordFunction recordChunk = [&](VkCommandBuffer secondary, uint32_t begin, uint32_t end, uint32_t chunk)
+	{
+		// secondary 커맨드 버퍼는 동적 상태를 물려받지 않으므로 조각마다 다시 설정한다.
+		vkCmdSetViewport(secondary, 0, 1, &viewport);
+		vkCmdSetScissor(secondary, 0, 1, &scissor);
+
+		// 조각마다 바인딩이 처음부터 다시 시작된다. depthEqual 변형은 불투명 파이프라인만 가지므로 포워드 패스에는 영향이 없다.
+		DrawStateCache cache;
+		cache.depthEqual = depthPrepassActive;
+		for (uint32_t d = begin; d < end; d++)
+		{
+			const RenderObject& draw = !firstDraw ? draws[d] : (d == 0 ? *firstDraw : draws[d - 1]);
+			drawRenderObject(secondary, i, draw, cache, chunkStats[chunk], indirectArgs, indirectArgsOffset + d * sizeof(VkDrawIndexedIndirectCommand));
+		}
+	};
+
+	commandRecorder.record(slot, inheritance, totalCount, recordChunk, secondaryCommandBuffers, maxWorkers);
+
+	for (const DrawBindStats& stats : chunkStats)
+	{
+		outStats.draws += stats.draws;
+		outStats.bindsIssued += stats.bindsIssued;
+		outStats.bindsSkipped += stats.bindsSkipped;
+	}
+}
+
+void VulkanTutorialExtension::benchmarkCommandRecording(uint32_t drawCount)
+{
+	recordBenchmarkResults.clear();
+
+	if (mainDrawContext.OpaqueSurfaces.empty())
+	{
+		LOG(Warning, "record benchmark skipped : no opaque draws to replicate");
+		return;
+	}
+
+	std::vector<RenderObject> draws;
+	draws.reserve(drawCount);
+	for (uint32_t d = 0; d < drawCount; d++)
+	{
+		draws.push_back(mainDrawContext.OpaqueSurfaces[d % mainDrawContext.OpaqueSurfaces.size()]);
+	}
+
+	VkCommandBufferInheritanceInfo inheritance{};
+	inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritance.renderPass = geometry.renderPass;
+	inheritance.subpass = geometry.subpass;
+	inheritance.framebuffer = getGeometryFrameBuffer(0);
+
+	const uint32_t maxWorkers = commandRecorder.getWorkerCount();
+	for (uint32_t workers = 1; ; workers = std::min(workers * 2, maxWorkers))
+	{
+		// 가장 빠른 값을 쓴다. 첫 번째 실행은 secondary 버퍼 할당이 섞여 있다.
+		double best = std::numeric_limits<double>::max();
+		for (int run = 0; run < 3; run++)
+		{
+			commandRecorder.beginSlot(BenchmarkRecordSlot);
+
+			DrawBindStats stats;
+			const auto start = std::chrono::steady_clock::now();
+			recordSecondaryDraws(0, BenchmarkRecordSlot, inheritance, nullptr, draws.data(), drawCount, workers, stats);
+			const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			best = std::min(best, elapsed.count());
+		}
+
+		recordBenchmarkResults.push_back({ workers, best });
+		LOG(Display, "record benchmark : {} draws, {} workers, {} ms", drawCount, workers, best);
+
+		if (workers == maxWorkers)
+		{
+			break;
+		}
+	}
+
+	secondaryCommandBuffers.clear();
+}
+
+void VulkanTutorialExtension::benchmarkSceneCulling(uint32_t objectCount)
+{
+	cullingBenchmarkResults.clear();
+
+	glm::mat4 persMat = glm::perspective(glm::radians(45.f), swapChainExtent.width / (float)(swapChainExtent.height), 0.1f, 100.f);
+	persMat[1][1] *= -1;
+	const Frustum frustum = Frustum::fromViewProjection(persMat * camera.GetViewMatrix());
+
+	// 매번 같은 장면이 되도록 시드를 고정한다.
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> position(-200.f, 200.f);
+	std::uniform_real_distribution<float> size(0.25f, 2.f);
+
+	std::vector<AABB> boxes(objectCount);
+	for (AABB& box : boxes)
+	{
+		const glm::vec3 center = camera.Position + glm::vec3(position(random), position(random), position(random));
+		const glm::vec3 extents(size(random), size(random), size(random));
+		box = { center - extents, center + extents };
+	}
+
+	// 모두 검사하는 쪽은 FrustumCulling 과 같은 SoA 배치로 SIMD 검사한다.
+	const uint32_t batchWidth = FrustumCulling::getBatchWidth();
+	const uint32_t paddedCount = (objectCount + batchWidth - 1) / batchWidth * batchWidth;
+	std::vector<float> soa(paddedCount * 6, 0.f);
+	for (uint32_t i = 0; i < objectCount; i++)
+	{
+		const glm::vec3 center = boxes[i].center();
+		const glm::vec3 extents = boxes[i].extents();
+		for (int axis = 0; axis < 3; axis++)
+		{
+			soa[axis * paddedCount + i] = center[axis];
+			soa[(3 + axis) * paddedCount + i] = extents[axis];
+		}
+	}
+	std::vector<uint8_t> visible(paddedCount);
+
+	using Milliseconds = std::chrono::duration<double, std::milli>;
+	CullingBenchmarkResult result;
+	result.objects = objectCount;
+	result.linearMilliseconds = std::numeric_limits<double>::max();
+	result.bvhBuildMilliseconds = std::numeric_limits<double>::max();
+	result.bvhRefitMilliseconds = std::numeric_limits<double>::max();
+	result.bvhQueryMilliseconds = std::numeric_limits<double>::max();
+
+	BVH bvh;
+	for (int run = 0; run < 3; run++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		FrustumCulling::testBoxes(frustum, &soa[0], &soa[paddedCount], &soa[paddedCount * 2],
+			&soa[paddedCount * 3], &soa[paddedCount * 4], &soa[paddedCount * 5], paddedCount, visible.data());
+		result.linearMilliseconds = std::min(result.linearMilliseconds, Milliseconds(std::chrono::steady_clock::now() - start).count());
+
+		start = std::chrono::steady_clock::now();
+		bvh.build(boxes);
+		result.bvhBuildMilliseconds = std::min(result.bvhBuildMilliseconds, Milliseconds(std::chrono::steady_clock::now() - start).count());
+
+		start = std::chrono::steady_clock::now();
+		bvh.refit();
+		result.bvhRefitMilliseconds = std::min(result.bvhRefitMilliseconds, Milliseconds(std::chrono::steady_clock::now() - start).count());
+
+		uint32_t visibleCount = 0;
+		start = std::chrono::steady_clock::now();
+		bvh.queryFrustum(frustum, [&visibleCount](uint32_t) { visibleCount++; });
+		result.bvhQueryMilliseconds = std::min(result.bvhQueryMilliseconds, Milliseconds(std::chrono::steady_clock::now() - start).count());
+		result.visible = visibleCount;
+	}
+
+	cullingBenchmarkResults.push_back(result);
+	LOG(Display, "culling benchmark : {} objects, {} visible, linear {} ms, bvh query {} ms (build {} ms, refit {} ms)",
+		objectCount, result.visible, result.linearMilliseconds, result.bvhQueryMilliseconds, result.bvhBuildMilliseconds, result.bvhRefitMilliseconds);
+}
+
+void VulkanTutorialExtension::benchmarkTransformUpdate(uint32_t nodeCount)
+{
+	transformBenchmarkResults.clear();
+
+	// 부모는 앞서 만든 노드의 뒤쪽 절반에서 고르므로 깊이가 여러 가지인 트리가 된다. 매번 같은 트리가 되도록 시드를 고정한다.
+	constexpr uint32_t InstanceCount = 16;
+	constexpr uint32_t RootsPerInstance = 4;
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> offset(-1.f, 1.f);
+
+	const uint32_t nodesPerInstance = std::max(RootsPerInstance, nodeCount / InstanceCount);
+	std::vector<std::vector<std::shared_ptr<Node>>> topNodes(InstanceCount);
+	for (std::vector<std::shared_ptr<Node>>& roots : topNodes)
+	{
+		std::vector<std::shared_ptr<Node>> nodes;
+		nodes.reserve(nodesPerInstance);
+		for (uint32_t n = 0; n < nodesPerInstance; n++)
+		{
+			std::shared_ptr<Node> node = std::make_shared<Node>();
+			node->localTransform = glm::translate(glm::mat4(1.f), glm::vec3(offset(random), offset(random), offset(random)));
+			node->worldTransform = glm::mat4(1.f);
+			if (n < RootsPerInstance)
+			{
+				roots.push_back(node);
+			}
+			else
+			{
+				const std::shared_ptr<Node>& parent = nodes[std::uniform_int_distribution<uint32_t>(n / 2, n - 1)(random)];
+				parent->children.push_back(node);
+				node->parent = parent;
+			}
+			nodes.push_back(node);
+		}
+	}
+
+	TransformHierarchy hierarchy;
+	std::vector<uint32_t> instanceRoots;
+	for (uint32_t i = 0; i < InstanceCount; i++)
+	{
+		instanceRoots.push_back(hierarchy.addInstance(i, glm::mat4(1.f), topNodes[i]));
+	}
+	hierarchy.propagate();
+
+	using Milliseconds = std::chrono::duration<double, std::milli>;
+	TransformBenchmarkResult result;
+	result.nodes = hierarchy.getNodeCount();
+	result.recursiveMilliseconds = std::numeric_limits<double>::max();
+	result.staticMilliseconds = std::numeric_limits<double>::max();
+	result.oneInstanceMilliseconds = std::numeric_limits<double>::max();
+	result.allSerialMilliseconds = std::numeric_limits<double>::max();
+	result.allParallelMilliseconds = std::numeric_limits<double>::max();
+
+	const glm::mat4 moved = glm::translate(glm::mat4(1.f), glm::vec3(0.f, 1.f, 0.f));
+	for (int run = 0; run < 3; run++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (const std::vector<std::shared_ptr<Node>>& roots : topNodes)
+		{
+			for (const std::shared_ptr<Node>& root : roots)
+			{
+				root->refreshTransform(moved);
+			}
+		}
+		result.recursiveMilliseconds = std::min(result.recursiveMilliseconds, Milliseconds(std::chrono::steady_clock::now() - start).count());
+
+		start = std::chrono::steady_clock::now();
+		hierarchy.propagate();
+		result.staticMilliseconds = std::min(result.staticMilliseconds, Milliseconds(std::chrono::steady_clock::now() - start).count());
+
+		start = std::chrono::steady_clock::now();
+		hierarchy.setLocalTransform(instanceRoots[0], moved);
+		hierarchy.propagate();
+		result.oneInstanceMilliseconds = std::min(result.oneInstanceMilliseconds, Milliseconds(std::chrono::steady_clock::now() - start).count());
+
+		start = std::chrono::steady_clock::now();
+		for (uint32_t root : instanceRoots)
+		{
+			hierarchy.setLocalTransform(root, moved);
+		}
+		hierarchy.propagate(1);
+		result.allSerialMilliseconds = std::min(result.allSerialMilliseconds, Milliseconds(std::chrono::steady_clock::now() - start).count());
+
+		start = std::chrono::steady_clock::now();
+		for (uint32_t root : instanceRoots)
+		{
+			hierarchy.setLocalTransform(root, moved);
+		}
+		hierarchy.propagate();
+		result.allParallelMilliseconds = std::min(result.allParallelMilliseconds, Milliseconds(std::chrono::steady_clock::now() - start).count());
+		result.chunks = hierarchy.getStats().chunks;
+	}
+
+	transformBenchmarkResults.push_back(result);
+	LOG(Display, "transform benchmark : {} nodes, recursive {} ms, static {} ms, one instance {} ms, all {} ms (parallel {} ms, {} chunks)",
+		result.nodes, result.recursiveMilliseconds, result.staticMilliseconds, result.oneInstanceMilliseconds,
+		result.allSerialMilliseconds, result.allParallelMilliseconds, result.chunks);
+}
+
+void VulkanTutorialExtension::drawRenderObject(VkCommandBuffer commandBuffer, size_t i, const RenderObject& draw, DrawStateCache& cache, DrawBindStats& stats,
+	VkBuffer indirectArgs, VkDeviceSize indirectArgsOffset)
+{
+	const MaterialInstance* material = GPUResourcePools::get().materials.get(draw.material);
+	if (!material)
+	{
+		LOG(Error, "draw skipped : stale material handle (index {}, generation {})", draw.material.index, draw.material.generation);
+		return;
+	}
+
+	stats.draws++;
+
+	// 합친 드로우는 인스턴싱 파이프라인으로 그린다. 레이아웃이 같으므로 바인딩된 디스크립터 셋은 그대로 유효하다.
+	// 인스턴스 버퍼는 uploadDrawInstances 가 이미지마다 늦게 만든다. 이 이미지의 버퍼가 아직 없으면 인스턴스마다 나눠 그린다.
+	const VkBuffer instanceBuffer = i < drawInstanceBuffers.size() ? drawInstanceBuffers[i].Buffer : VK_NULL_HANDLE;
+	const bool instanced = draw.instanceCount > 1 && instanceBuffer != VK_NULL_HANDLE;
+	const MaterialPipeline* pipeline = instanced ? material->pipeline->instanced : material->pipeline;
+	if (cache.weightedBlended && pipeline->weightedBlended)
+	{
+		pipeline = pipeline->weightedBlended;
+	}
+	// 프리패스가 깊이를 그린 드로우만 EQUAL 로 그린다. 나머지는 원래 파이프라인으로 깊이를 쓴다.
+	// 프리패스도 인스턴스 버퍼가 없는 합친 드로우는 건너뛴다.
+	const bool drawnByPrepass = draw.positionBuffer != VK_NULL_HANDLE && (draw.instanceCount <= 1 || instanced);
+	if (cache.depthEqual && drawnByPrepass && pipeline->depthEqual)
+	{
+		pipeline = pipeline->depthEqual;
+	}
+
+	if (cache.pipeline != pipeline->pipeline)
+	{
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipeline);
+		cache.pipeline = pipeline->pipeline;
+		stats.bindsIssued++;
+	}
+	else
+	{
+		stats.bindsSkipped++;
+	}
+
+	// 레이아웃이 같으면 파이프라인이 바뀌어도 바인딩된 디스크립터 셋은 유효하다. 레이아웃이 바뀌면 둘 다 다시 바인딩한다.
+	if (cache.layout != pipeline->layout)
+	{
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->layout, 0, 1, &globalDescriptorSets[i], 0, nullptr);
+		cache.layout = pipeline->layout;
+		cache.materialSet = VK_NULL_HANDLE;
+		stats.bindsIssued++;
+	}
+	else
+	{
+		stats.bindsSkipped++;
+	}
+
+	if (cache.materialSet != material->materialSet[i])
+	{
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->layout, 1, 1, &material->materialSet[i], 0, nullptr);
+		cache.materialSet = material->materialSet[i];
+		stats.bindsIssued++;
+	}
+	else
+	{
+		stats.bindsSkipped++;
+	}
+
+	if (cache.vertexBuffer != draw.vertexBuffer)
+	{
+		VkBuffer vertexBuffers[]{ draw.vertexBuffer };
+		VkDeviceSize offsets[]{ 0 };
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+		cache.vertexBuffer = draw.vertexBuffer;
+		stats.bindsIssued++;
+	}
+	else
+	{
+		stats.bindsSkipped++;
+	}
+
+	if (cache.indexBuffer != draw.indexBuffer)
+	{
+		vkCmdBindIndexBuffer(commandBuffer, draw.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+		cache.indexBuffer = draw.indexBuffer;
+		stats.bindsIssued++;
+	}
+	else
+	{
+		stats.bindsSkipped++;
+	}
+
+	if (instanced)
+	{
+		if (cache.instanceBuffer != instanceBuffer)
+		{
+			VkDeviceSize offset = 0;
+			vkCmdBindVertexBuffers(commandBuffer, 1, 1, &instanceBuffer, &offset);
+			cache.instanceBuffer = instanceBuffer;
+			stats.bindsIssued++;
+		}
+		else
+		{
+			stats.bindsSkipped++;
+		}
+
+		if (indirectArgs != VK_NULL_HANDLE)
+		{
+			vkCmdDrawIndexedIndirect(commandBuffer, indirectArgs, indirectArgsOffset, 1, sizeof(VkDrawIndexedIndirectCommand));
+			return;
+		}
+		vkCmdDrawIndexed(commandBuffer, draw.indexCount, draw.instanceCount, draw.firstIndex, 0, draw.firstInstance);
+		return;
+	}
 
 	GPUDrawPushConstants pushConstants;
+	if (draw.instanceCount > 1)
+	{
+		// 가림 컬링 인자는 합친 드로우 하나에 대한 것이므로 쓰지 않고 모두 그린다.
+		for (uint32_t instance = 0; instance < draw.instanceCount; instance++)
+		{
+			pushConstants.model = drawInstances[draw.firstInstance + instance].model;
+			vkCmdPushConstants(commandBuffer, pipeline->layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(GPUDrawPushConstants), &pushConstants);
+			vkCmdDrawIndexed(commandBuffer, draw.indexCount, 1, draw.firstIndex, 0, 0);
+		}
+		return;
+	}
+
 	pushConstants.model = draw.transform;
-	vkCmdPushConstants(commandBuffer, draw.material->pipeline->layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(GPUDrawPushConstants), &pushConstants);
+	vkCmdPushConstants(commandBuffer, pipeline->layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(GPUDrawPushConstants), &pushConstants);
 
+	if (indirectArgs != VK_NULL_HANDLE)
+	{
+		vkCmdDrawIndexedIndirect(commandBuffer, indirectArgs, indirectArgsOffset, 1, sizeof(VkDrawIndexedIndirectCommand));
+		return;
+	}
 	vkCmdDrawIndexed(commandBuffer, draw.indexCount, 1, draw.firstIndex, 0, 0);
 }
 
+void VulkanTutorialExtension::uploadDrawInstances(uint32_t imageIndex)
+{
+	if (drawInstanceBuffers.size() <= imageIndex)
+	{
+		drawInstanceBuffers.resize(imageIndex + 1);
+	}
+
+	if (drawInstances.empty())
+	{
+		return;
+	}
+
+	StorageBuffer& buffer = drawInstanceBuffers[imageIndex];
+	const VkDeviceSize size = drawInstances.size() * sizeof(Instance);
+	if (buffer.size < size)
+	{
+		// 이 이미지로 녹화해 둔 커맨드 버퍼가 옛 버퍼를 가리킬 수 있으므로 지우기를 미루고 다시 녹화한다.
+		if (buffer.Buffer != VK_NULL_HANDLE)
+		{
+			DeferredDeletionQueue::get().pushBuffer(buffer.Buffer);
+			DeferredDeletionQueue::get().pushMemory(buffer.BufferMemory, buffer.size);
+		}
+		const VkDeviceSize capacity = std::max(size, buffer.size * 2);
+		buffer = StorageBuffer();
+
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+		buffer.Create(*device, memoryProperties, capacity, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		markCommandBufferRecreation();
+	}
+
+	memcpy(buffer.mapped, drawInstances.data(), size);
+}
+
 void VulkanTutorialExtension::createInstanceBuffer(uint32_t imageIndex)
 {
 	VkDeviceSize bufferSize = sizeof(instances[0]) * instanceCount;
@@ -972,6 +1885,48 @@ void VulkanTutorialExtension::createInstanceBuffer(uint32_t imageIndex)
 	vkFreeMemory(*device, stagingBufferMemory, nullptr);
 }
 
+VkBuffer VulkanTutorialExtension::createMeshHeapBuffer(VkDeviceSize size, VkBufferUsageFlags usage, MeshAllocation& outAllocation, const MeshAllocation* moveBelow)
+{
+	VkBuffer buffer;
+	VkBufferCreateInfo bufferInfo = vkb::initializers::buffer_create_info(usage, size);
+	VK_CHECK_RESULT(vkCreateBuffer(*device, &bufferInfo, nullptr, &buffer));
+
+	VkMemoryRequirements memRequirements;
+	vkGetBufferMemoryRequirements(*device, buffer, &memRequirements);
+	uint32_t memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	outAllocation = moveBelow ? meshMemoryHeap.allocateBelow(memRequirements, memoryTypeIndex, *moveBelow)
+							  : meshMemoryHeap.allocate(memRequirements, memoryTypeIndex);
+	if (!outAllocation.isValid())
+	{
+		vkDestroyBuffer(*device, buffer, nullptr);
+		return VK_NULL_HANDLE;
+	}
+	outAllocation.bufferSize = size;
+
+	VK_CHECK_RESULT(vkBindBufferMemory(*device, buffer, meshMemoryHeap.getMemory(outAllocation), outAllocation.offset));
+	return buffer;
+}
+
+void VulkanTutorialExtension::uploadMeshBuffer(const void* data, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& outBuffer, MeshAllocation& outAllocation)
+{
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingBufferMemory;
+	createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+
+	void* mapped;
+	vkMapMemory(*device, stagingBufferMemory, 0, size, 0, &mapped);
+	memcpy(mapped, data, (size_t)size);
+	vkUnmapMemory(*device, stagingBufferMemory);
+
+	// 조각 모음 때 다른 위치로 복사할 수 있도록 TRANSFER_SRC 도 켠다.
+	outBuffer = createMeshHeapBuffer(size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, outAllocation);
+	copyBuffer(stagingBuffer, outBuffer, size);
+
+	vkDestroyBuffer(*device, stagingBuffer, nullptr);
+	vkFreeMemory(*device, stagingBufferMemory, nullptr);
+}
+
 void VulkanTutorialExtension::setWindowFocused(int inFocused)
 {
 	focused = inFocused;
@@ -1037,6 +1992,10 @@ void VulkanTutorialExtension::recreateSwapChain()
 {
 	VulkanTutorial::recreateSwapChain();
 
+	// 깊이 버퍼를 다시 만들었으므로 피라미드도 새 크기로 만든다.
+	occlusionCulling.createPyramid(swapChainExtent, depth->imageView);
+	depthPrepass.createFramebuffer(swapChainExtent, depth->imageView);
+
 	ImGui_ImplVulkan_SetMinImageCount(swapChainImages.size());
 }
 
@@ -1044,21 +2003,30 @@ void VulkanTutorialExtension::preDrawFrame(uint32_t imageIndex)
 {
 	VulkanTutorial::preDrawFrame(imageIndex);
 
+	// drawFrame 에서 inFlightFences[currentFrame] 을 기다린 뒤이므로 이 슬롯에 쌓인 리소스를 지워도 된다.
+	DeferredDeletionQueue::get().beginFrame(static_cast<uint32_t>(currentFrame));
+	FrameAllocator::get().beginFrame(static_cast<uint32_t>(currentFrame));
+
 	updateDebugDisplayTarget();
 
+	// 드로우 리스트를 만들기 전에 옮겨야 이번 프레임부터 새 버퍼를 쓴다.
+	meshDefragmenter->update();
+
+	// 이 슬롯의 지난 지오메트리 패스 통계를 읽는다.
+	depthPrepass.readStatistics(static_cast<uint32_t>(currentFrame));
+
+	// 이 슬롯의 지난 GPU 시간으로 이번 프레임 내부 해상도를 정한다. update_scene 이 클러스터와 셰이더에 넘긴다.
+	renderExtent = dynamicResolution.update(static_cast<uint32_t>(currentFrame), dynamicResolution.hasTargets() && isRecordingCommandsEveryFrame(), swapChainExtent);
+
 	update_scene(imageIndex);
 
-	if (pointLightSwitchChanged(imageIndex))
+	// 매 프레임 녹화하면 drawFrame 에서 지금 상태로 녹화하므로 무효화를 확인할 필요가 없다.
+	// 포인트 라이트는 버퍼로만 바뀌므로 녹화 조건에 들지 않는다.
+	if (!isRecordingCommandsEveryFrame())
 	{
-		//vkFreeCommandBuffers(*device, commandPool, 1, &commandBuffers[imageIndex]);
-		createCommandBuffer(imageIndex);
-		previousActivePointLightsMask[imageIndex] = activePointLightsMask;
+		tryRecreateCommandBuffer(imageIndex);
 	}
 
-	tryRecreateCommandBuffer(imageIndex);
-
-	DeferredDeletionQueue::get().update();
-
 	drawImGui(imageIndex);
 }
 
@@ -1086,30 +2054,82 @@ void VulkanTutorialExtension::postDrawFrame(uint32_t imageIndex)
 		recreateInstanceBuffer(usingInstanceBufferIndex);
 		recreateSwapChain();
 	}
+
+	// 렌더 패스, 파이프라인, 프레임버퍼, 커맨드 버퍼를 모두 새 구성으로 만든다.
+	if (useSinglePassDeferred != singlePass.enabled)
+	{
+		setSinglePassDeferred(useSinglePassDeferred);
+		recreateSwapChain();
+	}
+
+	// 장면 색 프레임버퍼가 sceneColor 와 스왑체인 사이를 옮겨 가야 한다.
+	if (DynamicResolution::enabled != dynamicResolution.hasTargets())
+	{
+		recreateSwapChain();
+	}
+
+	// 누적 타겟을 만들거나 지우고, 반투명 드로우를 옮긴 커맨드 버퍼를 다시 녹화한다.
+	if (WeightedBlendedOIT::enabled != weightedBlendedOIT.hasTargets())
+	{
+		recreateSwapChain();
+	}
 }
 
 void VulkanTutorialExtension::createCommandPool()
 {
 	VulkanTutorial::createCommandPool();
 
+	// 첫 커맨드 버퍼 녹화보다 먼저 준비되어야 한다.
+	QueueFamilyIndices queueFamilyIndices = findQueueFamilies(physicalDevice);
+	commandRecorder.initialize(device, queueFamilyIndices.graphicsFamily.value());
+
 	createImGuiCommandPool();
 }
 
 void VulkanTutorialExtension::onPostInitVulkan()
 {
+	DeferredDeletionQueue::get().initialize(device, MAX_FRAMES_IN_FLIGHT);
+	FrameAllocator::get().initialize(MAX_FRAMES_IN_FLIGHT);
+
+	meshMemoryHeap.initialize(device);
+	// 스왑체인을 다시 만들 때도 불리므로, 진행 중인 조각 모음과 해제 대기 버퍼를 잃지 않도록 한번만 만든다.
+	if (!meshDefragmenter)
+	{
+		meshDefragmenter = std::make_shared<MeshDefragmenter>();
+		meshDefragmenter->initialize(this);
+	}
+
 	textureViewer = std::make_shared<TextureViewer>();
 	textureViewer->initialize(this);
 
 	irradianceCubeMap = std::make_shared<IrradianceCubeMap>(device, descriptorPool);
 	irradianceCubeMap->initialize(this);
 
+	// 라이팅 패스 셋이 누적 타겟을 가리키므로 셋보다 먼저 만든다. 스왑체인을 다시 만들면 새 깊이로 다시 만든다.
+	lightVolumes.initialize(this, physicalDevice, static_cast<uint32_t>(swapChainImages.size()), findDepthFormat(),
+		{ globalDescriptorSetLayout, lightingPass.descriptorSetLayout, clusteredLighting.getDescriptorSetLayout(), pointShadowAtlas.getDescriptorSetLayout() });
+	lightVolumes.createTargets(swapChainExtent, depth->imageView);
 	createLightingPassDescriptorSets(lightingPass.descriptorSets);
+	if (isSinglePassDeferred())
+	{
+		createLightingPassInputAttachmentSets();
+	}
 
 	skybox = std::make_shared<Skybox>();
 	skybox->initialize(this);
 
 	materialTester = std::make_shared<MaterialTester>();
 	materialTester->init(this);
+	occlusionCulling.initialize(this, physicalDevice, MAX_FRAMES_IN_FLIGHT, findDepthFormat(), msaaSamples);
+	occlusionCulling.createPyramid(swapChainExtent, depth->imageView);
+	depthPrepass.initialize(this, MAX_FRAMES_IN_FLIGHT, findDepthFormat(), globalDescriptorSetLayout);
+	depthPrepass.createFramebuffer(swapChainExtent, depth->imageView);
+	// metalRoughMaterial 의 간접 드로우 파이프라인이 만들어진 뒤여야 한다.
+	indirectDrawPass.initialize(this, physicalDevice, MAX_FRAMES_IN_FLIGHT, occlusionCulling);
+	clusteredLighting.initialize(this, physicalDevice, static_cast<uint32_t>(swapChainImages.size()));
+	cascadedShadowMap.initialize(this, physicalDevice, static_cast<uint32_t>(swapChainImages.size()));
+	pointShadowAtlas.initialize(this, physicalDevice, static_cast<uint32_t>(swapChainImages.size()));
+
 	materialTester->createMaterial(this, 
 		"gold",
 		"textures/pbr/gold/albedo.png",
@@ -1127,13 +2147,30 @@ void VulkanTutorialExtension::createCommandBuffers()
 	VulkanTutorial::createCommandBuffers();
 
 	createImGuiCommandBuffers();
-	previousActivePointLightsMask.resize(swapChainImages.size());
 }
 
 void VulkanTutorialExtension::createFrameBuffers()
 {
+	// 라이팅, 포워드 패스 프레임버퍼가 getSceneColorView 로 sceneColor 를 가리키므로 먼저 만든다.
+	if (DynamicResolution::enabled)
+	{
+		dynamicResolution.initialize(this, physicalDevice, MAX_FRAMES_IN_FLIGHT);
+		dynamicResolution.createTargets(swapChainExtent, swapChainImageFormat, swapChainImageViews);
+	}
+
 	VulkanTutorial::createFrameBuffers();
 
+	// 합성 패스가 장면 색에 그리므로 sceneColor 뒤에 만든다.
+	if (WeightedBlendedOIT::enabled)
+	{
+		std::vector<VkImageView> sceneColorViews(swapChainImageViews.size());
+		for (size_t i = 0; i < sceneColorViews.size(); i++)
+		{
+			sceneColorViews[i] = getSceneColorView(i);
+		}
+		weightedBlendedOIT.createTargets(swapChainExtent, swapChainImageFormat, depth->imageView, sceneColorViews);
+	}
+
 	createImGuiFrameBuffers();
 }
 
@@ -1141,6 +2178,9 @@ void VulkanTutorialExtension::createRenderPass()
 {
 	VulkanTutorial::createRenderPass();
 
+	// 반투명 머티리얼 파이프라인이 누적 렌더 패스로 만들어지므로 createGraphicsPipelines 보다 먼저 준비한다.
+	weightedBlendedOIT.initialize(this, findDepthFormat());
+
 	createImGuiRenderPass();
 }
 void VulkanTutorialExtension::cleanUpSwapchain()
@@ -1151,10 +2191,22 @@ void VulkanTutorialExtension::cleanUpSwapchain()
 	vkDestroyPipeline(*device, graphicsPipelinePointLights, nullptr);
 
 	cleanUpImGuiSwapchain();
+	dynamicResolution.destroyTargets();
+	weightedBlendedOIT.destroyTargets();
 
 	VulkanTutorial::cleanUpSwapchain();
 }
 
+VkImage VulkanTutorialExtension::getSceneColorImage(size_t imageIndex)
+{
+	return dynamicResolution.hasTargets() ? dynamicResolution.getSceneColor()->image : VulkanTutorial::getSceneColorImage(imageIndex);
+}
+
+VkImageView VulkanTutorialExtension::getSceneColorView(size_t imageIndex)
+{
+	return dynamicResolution.hasTargets() ? dynamicResolution.getSceneColor()->imageView : VulkanTutorial::getSceneColorView(imageIndex);
+}
+
 void VulkanTutorialExtension::cleanUp()
 {
 	glfwSetWindowUserPointer(window, nullptr);
@@ -1182,31 +2234,66 @@ void VulkanTutorialExtension::cleanUp()
 	vkDeviceWaitIdle(*device);
 
 	loadedScenes.clear();
+	// 큐에 남은 LoadedGLTF 와 조각 모음의 이전 버퍼가 메시 힙을 참조하므로 힙보다 먼저 비운다.
+	DeferredDeletionQueue::get().flushAll();
+	mainDrawContext = DrawContext();
+	shadowCasterContext = DrawContext();
+	indirectFallbackDraws = FrameVector<RenderObject>();
+	drawInstances = FrameVector<Instance>();
+	FrameAllocator::destroyInstance();
+	commandRecorder.cleanup();
+	indirectDrawPass.cleanup();
+	occlusionCulling.cleanup();
+	lightVolumes.cleanup();
+	clusteredLighting.cleanup();
+	cascadedShadowMap.cleanup();
+	pointShadowAtlas.cleanup();
+	dynamicResolution.cleanup();
+	weightedBlendedOIT.cleanup();
+	depthPrepass.cleanup();
+	for (StorageBuffer& buffer : pointLightBuffers)
+	{
+		buffer.Destroy(*device);
+	}
+	for (StorageBuffer& buffer : drawInstanceBuffers)
+	{
+		buffer.Destroy(*device);
+	}
+	meshDefragmenter->cleanup();
+	meshMemoryHeap.cleanup();
 	irradianceCubeMap.reset();
 	skybox->cleanup(*device);
 	materialTester->cleanUp(*device);
+	// 머티리얼 소멸자가 큐에 풀 해제를 예약하므로, 머티리얼을 가진 객체를 먼저 없애고 큐를 비운 뒤 풀을 지운다.
+	materialTester.reset();
+	DeferredDeletionQueue::get().flushAll();
+	DeferredDeletionQueue::destroyInstance();
+	GPUResourcePools::destroyInstance();
 	VulkanTutorial::cleanUp();
 }
 
-bool VulkanTutorialExtension::pointLightSwitchChanged(uint32_t index)
+void VulkanTutorialExtension::addPointLight(const glm::vec3& position, bool enabled)
 {
-	return previousActivePointLightsMask[index] != activePointLightsMask;
+	if (scenePointLights.size() < MAX_POINT_LIGHTS)
+	{
+		scenePointLights.push_back({ position, enabled });
+	}
 }
 
-void VulkanTutorialExtension::clearPointLightsSwitch()
+void VulkanTutorialExtension::uploadPointLights(uint32_t imageIndex)
 {
-	activePointLightsMask = 0;
-}
+	StorageBuffer& pointLightBuffer = pointLightBuffers[imageIndex];
+	PointLightsHeader& header = *static_cast<PointLightsHeader*>(pointLightBuffer.mapped);
+	PointLight* lights = reinterpret_cast<PointLight*>(static_cast<uint8_t*>(pointLightBuffer.mapped) + sizeof(PointLightsHeader));
 
-void VulkanTutorialExtension::turnPointLightOn(int index)
-{
-	if (index >= 0 && index < NR_POINT_LIGHTS)
+	const uint32_t count = static_cast<uint32_t>(std::min<size_t>(scenePointLights.size(), MAX_POINT_LIGHTS));
+	for (uint32_t i = 0; i < count; i++)
 	{
-		activePointLightsMask |= (pointLightsSwitch[index] << index);
+		PointLight& light = lights[i];
+		light.position = scenePointLights[i].position;
+		light.enabled = scenePointLights[i].enabled ? 1 : 0;
+		light.clq = glm::vec3(1.0f, pointLightlinear, pointLightQuadratic);
+		light.colorIntensity = glm::vec4(1.f, 1.f, 1.f, pointLightIntensity);
 	}
-}
-
-bool VulkanTutorialExtension::isLightOn(int index)
-{
-	return activePointLightsMask & (1 << index);
+	header.count = glm::uvec4(count, 0, 0, 0);
 }
\ No newline at end of file
@@ -2,11 +2,27 @@
 
 #include "VulkanTutorial.h"
 #include "UniformBufferTypes.h"
+#include "MeshMemoryHeap.h"
+#include "ParallelCommandRecorder.h"
+#include "IndirectDrawPass.h"
+#include "OcclusionCulling.h"
+#include "ClusteredLighting.h"
+#include "LightVolumes.h"
+#include "CascadedShadowMap.h"
+#include "PointShadowAtlas.h"
+#include "DynamicResolution.h"
+#include "WeightedBlendedOIT.h"
+#include "DepthPrepass.h"
+#include "DrawInstancing.h"
+#include "FrustumCulling.h"
+#include "SceneBVH.h"
+#include "MeshLod.h"
 
 class IrradianceCubeMap;
 class Skybox;
 class MaterialTester;
 class TextureViewer;
+class MeshDefragmenter;
 
 namespace ImGui {
 	class LeftPanelUI;
@@ -15,11 +31,11 @@ namespace ImGui {
 }
 
 /**
-* https://vulkan-tutorial.com/   Ʃ丮 Ʈ VulkanTutorial Ŭ ִ. 
-*  Ʈ   ߰ ڵ ִ VulkanTutorialExtension  иѴ.
+* https://vulkan-tutorial.com/ 에서 진행한 튜토리얼 프로젝트는 VulkanTutorial 클래스에 있다. 
+* 이 프로젝트를 토대로 개인적으로 추가한 코드는 최대한 VulkanTutorialExtension에 구현해 분리한다.
 */
 
-// νϽ  ٲ  ̹  ۸  ʰ ϱ  ۸ Ѵ.
+// 인스턴스 개수를 바꿀 때 이미 사용중인 버퍼를 삭제하지 않게 하기 위해 더블버퍼링을 사용한다.
 #define INSTANCE_BUFFER_COUNT 2
 
 class VulkanTutorialExtension : public VulkanTutorial{
@@ -34,16 +50,22 @@ public:
 	static int debugDisplayTarget;
 	static float exposure;
 	static bool usePointLights;
-	static std::array<bool, NR_POINT_LIGHTS> pointLightsSwitch;
 	static float pointLightlinear;
 	static float pointLightQuadratic;
 	static float pointLightIntensity; 
 	static float directionalLightIntensity;
+	static glm::vec3 directionalLightDirection;
+	static bool useParallelRecording;
+	static bool useAutoInstancing;
+	static bool useFrustumCulling;
+	static bool useSceneBVH;
+	// 바뀌면 postDrawFrame 에서 스왑체인을 다시 만들어 적용한다.
+	static bool useSinglePassDeferred;
 private:
 
 	/**
-	*	Vulkan-Tutorial ߰  ϰ  Լ и Ѵ. 
-	*	VulkanTutorial::initVulkan()  ״ ؾ Ѵ.
+	*	Vulkan-Tutorial에서 추가적인 기능을 구현하고 싶은 함수들을 분리해 구현한다. 
+	*	VulkanTutorial::initVulkan()의 순서는 그대로 유지해야 한다.
 	*/
 	void initVulkan() override;
 	void processInput() override;
@@ -56,9 +78,13 @@ private:
 	void createDescriptorSetLayouts() override;
 	void createGraphicsPipelines() override;
 	void recordCommandBuffer(VkCommandBuffer commandBuffer, size_t index) override;
+	bool recordDepthPrepassCommands(VkCommandBuffer commandBuffer, size_t index) override;
 	void recordRenderPassCommands(VkCommandBuffer commandBuffer, size_t index) override;
+	void recordPostGeometryPassCommands(VkCommandBuffer commandBuffer, size_t index) override;
+	void recordPreLightingPassCommands(VkCommandBuffer commandBuffer, size_t index) override;
 	void recordLightingRenderPassCommands(VkCommandBuffer commandBuffer, size_t index) override;
 	void recordForwardPassCommands(VkCommandBuffer commandBuffer, size_t index) override;
+	VkSubpassContents getDrawPassSubpassContents() override;
 	void loadModels() override;
 	void createBuffers() override;
 	void recreateSwapChain() override;
@@ -72,11 +98,15 @@ private:
 	void createRenderPass() override;
 	void cleanUpSwapchain() override;
 	void cleanUp() override;
+	VkImage getSceneColorImage(size_t imageIndex) override;
+	VkImageView getSceneColorView(size_t imageIndex) override;
 	
 	void createGlobalDescriptorSets();
 	void createDescriptorSetsPointLights(UniformBuffer<Transform>& inUniformBuffer, std::vector<VkDescriptorSet>& outDescriptorSets);
 	void createDescriptorSetsObject(std::vector<VkDescriptorSet>& outDescriptorSets);
 	void createLightingPassDescriptorSets(std::vector<VkDescriptorSet>& outDescriptorSets);
+	// 단일 렌더 패스의 라이팅 서브패스용 셋. G-buffer 와 깊이를 input attachment 로 건다.
+	void createLightingPassInputAttachmentSets();
 	void createGlobalDescriptorSetLayout();
 	void createDescriptorSetLayoutsForObjects();
 	void createLightingPassDescriptorSetLayout();
@@ -85,10 +115,9 @@ private:
 	void setWindowFocused(int inFocused);
 	bool instanceCountChanged();
 	void recreateInstanceBuffer(uint32_t imageIndex);
-	void clearPointLightsSwitch();
-	void turnPointLightOn(int index);
-	bool isLightOn(int index);
-	bool pointLightSwitchChanged(uint32_t index);
+	void addPointLight(const glm::vec3& position, bool enabled = true);
+	// 켜진 라이트만 골라 쓰지 않고 수와 켜짐 여부를 그대로 올린다. 셰이더가 꺼진 라이트를 건너뛴다.
+	void uploadPointLights(uint32_t imageIndex);
 	void removeGltfModel(const std::string& fileName);
 	void removeGltfModelDeferred(const std::string& modelPath);
 	void onChangedGltfModelTransform(const Transform& transform, const std::string& fileName);
@@ -99,7 +128,7 @@ private:
 	static void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
 
 	/**
-	*	GUI õ Լ.
+	*	GUI와 관련된 함수들.
 	*/
 	void initImGui();
 	void createImGui();
@@ -113,13 +142,11 @@ private:
 	void cleanUpImGui();
 
 public:
-	// ƮƮ
+	// 포인트라이트용
 	VkPipeline graphicsPipelinePointLights;
 	VkPipelineLayout pipelineLayoutPointLights;
 	VkDescriptorSetLayout descriptorSetLayoutPointLights;
 	std::array<std::vector<VkDescriptorSet>, NR_POINT_LIGHTS> descriptorSetsPointLights;
-	std::vector<int> previousActivePointLightsMask;
-	int activePointLightsMask = 0;
 
 	int getSwapchainImageNum() { return static_cast<int>(swapChainFrameBuffers.size()); }
 	int getSwapchainFrameBuffer() { return static_cast<int>(swapChainFrameBuffers.size()); }
@@ -129,16 +156,163 @@ public:
 	VkSampler getDefaultTextureSampler() { return textureSampler; }
 	VkRenderPass getDefaultRenderPass() { return renderPass; }
 	std::shared_ptr<TextureViewer> getTextureViewer() { return textureViewer; }
-	void drawRenderObject(VkCommandBuffer commandBuffer, size_t i, const RenderObject& draw);
+	// 연속된 드로우 사이에 바뀌지 않은 상태는 다시 바인딩하지 않는다. 렌더 패스마다 새로 만든다.
+	struct DrawStateCache
+	{
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		VkPipelineLayout layout = VK_NULL_HANDLE;
+		VkDescriptorSet materialSet = VK_NULL_HANDLE;
+		VkBuffer vertexBuffer = VK_NULL_HANDLE;
+		VkBuffer indexBuffer = VK_NULL_HANDLE;
+		VkBuffer instanceBuffer = VK_NULL_HANDLE;
+		// 머티리얼 파이프라인 대신 weightedBlended 변형으로 그린다. OIT 누적 패스에서 켠다.
+		bool weightedBlended = false;
+		// 위치 전용 스트림이 있는 드로우를 depthEqual 변형으로 그린다. 깊이 프리패스 뒤의 지오메트리 패스에서 켠다.
+		bool depthEqual = false;
+	};
+
+	// 마지막으로 녹화한 커맨드 버퍼의 바인딩 수
+	struct DrawBindStats
+	{
+		uint32_t draws = 0;
+		uint32_t bindsIssued = 0;
+		uint32_t bindsSkipped = 0;
+	} lastBindStats;
+
+	struct RecordBenchmarkResult
+	{
+		uint32_t workers = 0;
+		double milliseconds = 0.0;
+	};
+	std::vector<RecordBenchmarkResult> recordBenchmarkResults;
+
+	struct CullingBenchmarkResult
+	{
+		uint32_t objects = 0;
+		uint32_t visible = 0;
+		double linearMilliseconds = 0.0;
+		double bvhBuildMilliseconds = 0.0;
+		double bvhRefitMilliseconds = 0.0;
+		double bvhQueryMilliseconds = 0.0;
+	};
+	std::vector<CullingBenchmarkResult> cullingBenchmarkResults;
+
+	struct TransformBenchmarkResult
+	{
+		uint32_t nodes = 0;
+		// 모든 노드를 refreshTransform 으로 다시 계산
+		double recursiveMilliseconds = 0.0;
+		// TransformHierarchy : 바뀐 것이 없을 때, 인스턴스 하나가 움직였을 때, 모두 움직였을 때(스레드 하나 / 여러 개)
+		double staticMilliseconds = 0.0;
+		double oneInstanceMilliseconds = 0.0;
+		double allSerialMilliseconds = 0.0;
+		double allParallelMilliseconds = 0.0;
+		uint32_t chunks = 0;
+	};
+	std::vector<TransformBenchmarkResult> transformBenchmarkResults;
+
+	// 드로우 목록을 워커 스레드들이 secondary 커맨드 버퍼에 나눠 녹화한다.
+	// 슬롯 0 은 벤치마크용, 1 ~ MAX_FRAMES_IN_FLIGHT 는 매 프레임 녹화용, 그 뒤는 스왑체인 이미지별이다.
+	ParallelCommandRecorder commandRecorder;
+	static constexpr uint32_t BenchmarkRecordSlot = 0;
+	uint32_t recordSlot = 0;
+
+	// 마지막 update_scene 에서 불투명 드로우를 인스턴스 드로우로 합친 결과
+	DrawInstancing::Stats lastInstancingStats;
+	// 마지막 update_scene 에서 CPU 프러스텀 컬링으로 뺀 드로우 수
+	FrustumCulling::Stats lastCullingStats;
+
+	// sceneInstances 의 노드 행렬. 드로우 목록과 sceneBVH 가 여기 월드 행렬을 쓴다.
+	TransformHierarchy transformHierarchy;
+
+	// sceneInstances 의 서피스를 담은 BVH. 프러스텀 컬링, 화면 중앙 광선 선택, 카메라와 가장 가까운 서피스 찾기에 쓴다.
+	SceneBVH sceneBVH;
+	SceneBVH::Hit lastPickHit;
+	SceneBVH::Hit lastNearestHit;
+
+	// 매 프레임 녹화할 때 서피스마다 화면 크기로 LOD 를 고른다.
+	MeshLodSelector meshLodSelector;
+
+	// 매 프레임 녹화할 때 불투명 드로우를 Hi-Z 피라미드로 두 단계에 나눠 가림 컬링한다. indirectDrawPass 보다 먼저 초기화한다.
+	OcclusionCulling occlusionCulling;
+	// 매 프레임 녹화할 때 GLTF 불투명 드로우를 컴퓨트 셰이더로 컬링하고 간접 드로우로 그린다.
+	IndirectDrawPass indirectDrawPass;
+
+	// 포인트 라이트를 froxel 클러스터에 나눠 라이팅 패스가 픽셀에 닿는 라이트만 계산하게 한다.
+	ClusteredLighting clusteredLighting;
+	// 장면의 포인트 라이트. 켜고 끄거나 더하고 빼도 update_scene 이 pointLightBuffers 에 쓰기만 하므로 다시 녹화하지 않는다.
+	struct ScenePointLight
+	{
+		glm::vec3 position{ 0.f };
+		bool enabled = true;
+	};
+	std::vector<ScenePointLight> scenePointLights;
+	// 스왑체인 이미지마다 PointLightsHeader 뒤에 PointLight * MAX_POINT_LIGHTS. 포워드 패스가 전역 셋 binding 1 로 읽는다.
+	// 앞 프레임이 읽는 중에 덮어쓰지 않도록 그 이미지의 전역 셋만 가리킨다.
+	std::vector<StorageBuffer> pointLightBuffers;
+	// 이번 프레임 clusteredLighting 에 넘길 라이트. 켜진 포인트 라이트 뒤에 시험용 라이트가 붙는다.
+	std::vector<GPUClusterLight> clusterLights;
+	// 켜면 포인트 라이트를 클러스터 대신 라이트마다 구를 그려 계산한다. clusterLights 를 그대로 읽는다.
+	LightVolumes lightVolumes;
+
+	// 방향광 그림자. 드리우는 물체는 shadowCasterContext 에 카메라 컬링 없이 모은다.
+	CascadedShadowMap cascadedShadowMap;
+	// 포인트 라이트 그림자. clusterLights 에서 화면에 크게 보이는 라이트를 골라 shadowCasterContext 를 면마다 컬링해 그린다.
+	PointShadowAtlas pointShadowAtlas;
+
+	// 켜져 있으면 장면을 sceneColor 에 내부 해상도로 그리고 스왑체인으로 업스케일한다. renderExtent 는 preDrawFrame 에서 정한다.
+	DynamicResolution dynamicResolution;
+	// 켜져 있으면 반투명 드로우를 포워드 패스 대신 누적 패스에 정렬 없이 그리고 장면 색 위에 합성한다.
+	WeightedBlendedOIT weightedBlendedOIT;
+	// 켜져 있으면 지오메트리 패스 앞에서 불투명 드로우의 깊이를 먼저 그리고, 지오메트리 패스는 깊이 EQUAL 로 그린다.
+	DepthPrepass depthPrepass;
+	DrawContext shadowCasterContext;
+	// 모델을 넣고 빼 배열을 다시 만들었는지 보려고 지난 프레임 값을 들고 있는다.
+	uint32_t shadowStructureVersion = 0;
+
+	// indirectArgs 가 있으면 드로우 인자를 그 버퍼의 indirectArgsOffset 에서 읽는다. (가림 컬링 결과)
+	void drawRenderObject(VkCommandBuffer commandBuffer, size_t i, const RenderObject& draw, DrawStateCache& cache, DrawBindStats& stats,
+		VkBuffer indirectArgs = VK_NULL_HANDLE, VkDeviceSize indirectArgsOffset = 0);
+	// firstDraw 가 있으면 draws 보다 먼저 그린다. 녹화한 버퍼는 secondaryCommandBuffers 에 담긴다.
+	// indirectArgs 가 있으면 d 번째 드로우의 인자는 indirectArgsOffset 에서 d 번째 VkDrawIndexedIndirectCommand 다. firstDraw 와 함께 쓸 수 없다.
+	void recordSecondaryDraws(size_t i, uint32_t slot, const VkCommandBufferInheritanceInfo& inheritance, const RenderObject* firstDraw,
+		const RenderObject* draws, uint32_t drawCount, uint32_t maxWorkers, DrawBindStats& outStats,
+		VkBuffer indirectArgs = VK_NULL_HANDLE, VkDeviceSize indirectArgsOffset = 0);
+	// 불투명 드로우를 drawCount 개로 복제해 워커 수를 늘려가며 녹화 시간을 잰다.
+	void benchmarkCommandRecording(uint32_t drawCount);
+	// 현재 카메라 주변에 임의의 상자 objectCount 개를 뿌리고, 모두 검사하는 컬링과 BVH 컬링의 시간을 잰다.
+	void benchmarkSceneCulling(uint32_t objectCount);
+	// 인스턴스 16 개에 나눈 nodeCount 개의 노드 트리로 재귀 갱신과 TransformHierarchy 갱신 시간을 잰다.
+	void benchmarkTransformUpdate(uint32_t nodeCount);
 	int loadGltfModel(const std::string& modelPath);
 	void onChangedGltfModelTransform(int modelIndex, const ImGui::ModelTransform& transform);
 	void onChangedGltfModelTransform(int modelIndex, const glm::mat4& transform);
+	// moveBelow 가 주어지면 그보다 낮은 위치에 자리가 있을 때만 만든다. 자리가 없으면 VK_NULL_HANDLE 을 반환한다.
+	VkBuffer createMeshHeapBuffer(VkDeviceSize size, VkBufferUsageFlags usage, MeshAllocation& outAllocation, const MeshAllocation* moveBelow = nullptr);
+	void uploadMeshBuffer(const void* data, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& outBuffer, MeshAllocation& outAllocation);
 
 private:
 	std::vector<Instance> instances;
 	std::array<VkBuffer, INSTANCE_BUFFER_COUNT> instanceBuffers;
 	std::array<VkDeviceMemory, INSTANCE_BUFFER_COUNT> instanceBufferMemories;
 	int usingInstanceBufferIndex = 0;
+	std::vector<VkCommandBuffer> secondaryCommandBuffers;
+	// recordCommandBuffer 에서 정한다. 이번 녹화에서 불투명 드로우를 indirectDrawPass 로 그리는지.
+	bool indirectDrawActive = false;
+	// recordCommandBuffer 에서 정한다. 이번 녹화에서 불투명 드로우를 가림 컬링하는지.
+	bool occlusionActive = false;
+	// recordCommandBuffer 에서 정한다. 이번 녹화에서 지오메트리 패스 앞에 깊이 프리패스를 그리는지.
+	bool depthPrepassActive = false;
+	// recordCommandBuffer 에서 정한다. 이번 녹화에서 지오메트리 패스의 프래그먼트 셰이더 실행 수를 재는지.
+	bool geometryStatisticsActive = false;
+	// 지오메트리 패스의 불투명 드로우를 녹화한다. 가림 컬링 중이면 phase 단계 검사 결과로 그린다.
+	void recordGeometryDraws(VkCommandBuffer commandBuffer, size_t i, uint32_t phase);
+	// indirectDrawPass 가 받지 않아 CPU 에서 그리는 불투명 드로우
+	FrameVector<RenderObject> indirectFallbackDraws;
+	// 이번 프레임 인스턴스 드로우의 모델 행렬. 스왑체인 이미지별 버퍼에 올려 binding 1 로 넘긴다.
+	FrameVector<Instance> drawInstances;
+	std::vector<StorageBuffer> drawInstanceBuffers;
+	void uploadDrawInstances(uint32_t imageIndex);
 	int previousInstanceCount = instanceCount;
 
 	std::array<std::shared_ptr<UniformBuffer<Transform>>, NR_POINT_LIGHTS> lightTransformUniformBuffer;
@@ -146,25 +320,24 @@ private:
 	std::shared_ptr<UniformBuffer<ColorUBO>> colorUniformBuffer;
 	std::shared_ptr<UniformBuffer<Material>> materialUniformBuffer;
 	std::shared_ptr<UniformBuffer<DirLight>> dirLightUniformBuffer;
-	std::shared_ptr<UniformBuffer<PointLightsUniform>> pointLightsUniformBuffer;
 
-	// Ʈ
+	// 오브젝트용
 	VkPipeline graphicsPipelineObject;
 	VkPipelineLayout pipelineLayoutObject;
 
 	Camera camera;
 
 	/**
-	*	GUI õ 
+	*	GUI와 관련된 변수들
 	*/
 	VkDescriptorPool imGuiDescriptorPool;
 	VkRenderPass imGuiRenderPass;
 	VkCommandPool imGuiCommandPool;
 	std::vector<VkCommandBuffer> imGuiCommandBuffers;
 	std::vector<VkFramebuffer> imGuiFrameBuffers;
-	// ʿ 𵨰 Ƽ  ִ г
+	// 왼쪽에는 모델과 머티리얼 탭이 있는 패널
 	std::shared_ptr<ImGui::LeftPanelUI> leftPanel;
-	// ʿ  Vulkan Tutorial Extension â
+	// 오른쪽에는 기존 Vulkan Tutorial Extension 창
 	std::shared_ptr<ImGui::RightPanelUI> rightPanel;
 
 	bool focused;
@@ -181,18 +354,23 @@ public:
 	std::unordered_map<std::string, std::shared_ptr<LoadedGLTF>> loadedScenes;
 	std::vector<LoadedGLTFInstance> sceneInstances;
 
-	/** ͸ */
+	/** 메시 메모리 */
+	MeshMemoryHeap meshMemoryHeap;
+	std::shared_ptr<MeshDefragmenter> meshDefragmenter;
+
+	/** 머터리얼 */
 	GLTFMaterial defaultData;
 	GLTFMetallic_Roughness metalRoughMaterial;
-	// ٲ Ƿ  Ӹ ٸ  ۸    .
+	// 바뀌지 않으므로 굳이 프레임마다 다른 유니폼 버퍼를 갖고 있을 이유가 없다.
 	std::shared_ptr<UniformBuffer<GLTFMetallic_Roughness::MaterialConstants>> materialConstants;
 
-	/** ۷ι  */
+	/** 글로벌 데이터 */
 	std::shared_ptr<UniformBuffer<GPUSceneData>> globalSceneData;
-	VkDescriptorSet globalDescriptorSet;
+	// 스왑체인 이미지마다 하나. 장면 유니폼과 포인트 라이트 목록을 그 이미지의 버퍼로 가리킨다.
+	std::vector<VkDescriptorSet> globalDescriptorSets;
 	VkDescriptorSetLayout globalDescriptorSetLayout;
 
-	/**  */
+	/** 디버그 */
 	std::shared_ptr<TextureViewer> textureViewer;
 	std::shared_ptr<MaterialTester> materialTester;
 
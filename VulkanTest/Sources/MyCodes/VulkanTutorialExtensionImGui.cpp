@@ -8,6 +8,9 @@
 #include "imgui_impl_vulkan.h"
 #include "ImGuiFileDialog.h"
 #include "MaterialTester.h"
+#include "MeshDefragmenter.h"
+#include "DeferredDeletionQueue.h"
+#include "FrameAllocator.h"
 
 static void check_vk_result(VkResult err)
 {
@@ -56,7 +59,7 @@ void VulkanTutorialExtension::createImGui()
 
 void VulkanTutorialExtension::createImGuiDescriptorPool()
 {
-	// ImGui DescriptorPool ѹ .
+	// ImGui DescriptorPool은 한번만 만든다.
 	if (imGuiDescriptorPool)
 	{
 		return;
@@ -82,8 +85,8 @@ void VulkanTutorialExtension::createImGuiDescriptorPool()
 	poolInfo.poolSizeCount = static_cast<uint32_t>(sizeof(poolSizes) / sizeof(VkDescriptorPoolSize));
 	poolInfo.pPoolSizes = poolSizes;
 	poolInfo.maxSets = static_cast<uint32_t>(swapChainImages.size()) * 10;
-	// ImGui ο Pool Ҵ DescriptorSet  ޸ Ѵ. ׷  ÷װ ʿϴ. 
-	//  Pool   ش.
+	// ImGui 내부에서 Pool에서 할당된 DescriptorSet 각각을 메모리 해제한다. 그래서 이 플래그가 필요하다. 
+	// 내부적으로 Pool 해제도 같이 해준다.
 	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
 
 	if (vkCreateDescriptorPool(getDevice(), &poolInfo, nullptr, &imGuiDescriptorPool) != VK_SUCCESS)
@@ -94,7 +97,7 @@ void VulkanTutorialExtension::createImGuiDescriptorPool()
 
 void VulkanTutorialExtension::drawImGui(uint32_t imageIndex)
 {
-	// â ũ 
+	// 창 크기 계산
 	ImGuiViewport* viewport = ImGui::GetMainViewport();
 	const float windowWidth = viewport->Size.x;
 	const float windowHeight = viewport->Size.y;
@@ -132,7 +135,7 @@ void VulkanTutorialExtension::drawImGui(uint32_t imageIndex)
 
 	rightPanel->SetTextureViewer(textureViewer);
 
-	//  г 
+	// 오른쪽 패널 렌더링
 	rightPanel->Render(rightPanelX, 0, PanelWidth, windowHeight);
 
 	ImGui::Render();
@@ -230,7 +233,7 @@ void VulkanTutorialExtension::createImGuiRenderPass()
 	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-	// ̷ Ϸ resolve attachment finalLayout present ƴ  ؾߵ ?
+	// 이렇게 하려면 resolve attachment의 finalLayout을 present가 아닌 값으로 수정해야되지 않을까?
 	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
 	VkAttachmentReference colorAttachmentRef{};
@@ -288,7 +291,7 @@ namespace ImGui
 {
 	std::string getFileName(const std::string& path)
 	{
-		// ϸ 
+		// 파일명만 추출
 		std::string fileName = path;
 		size_t lastSlash = fileName.find_last_of("/\\");
 		if (lastSlash != std::string::npos) {
@@ -297,6 +300,13 @@ namespace ImGui
 		return fileName;
 	}
 
+	// 매 프레임 그리는 곳에서 쓴다. 경로 안의 파일명 시작 위치를 돌려주므로 문자열을 새로 만들지 않는다.
+	const char* getFileNamePtr(const std::string& path)
+	{
+		size_t lastSlash = path.find_last_of("/\\");
+		return lastSlash != std::string::npos ? path.c_str() + lastSlash + 1 : path.c_str();
+	}
+
 	std::string ImGui::stringToDebug;
 
 	void ImGui::PrintDebugString()
@@ -309,13 +319,13 @@ namespace ImGui
 	}
 
 	LeftPanelUI::LeftPanelUI() {
-		// ʱȭ ڵ
+		// 초기화 코드
 	}
 
 	LeftPanelUI::~LeftPanelUI() = default;
 
 	void LeftPanelUI::Render(int x, int y, int width, int height, bool enabled) {
-		//  
+		// 윈도우 설정
 		ImGui::SetNextWindowPos(ImVec2(float(x), float(y)));
 		ImGui::SetNextWindowSize(ImVec2(float(width), float(height)));
 
@@ -329,12 +339,12 @@ namespace ImGui
 			window_flags |= ImGuiWindowFlags_NoInputs;
 		}
 
-		// г 
+		// 패널 시작
 		ImGui::Begin("LeftPanel", nullptr, window_flags);
 
-		//   
+		// 탭 바 생성
 		if (ImGui::BeginTabBar("LeftPanelTabs")) {
-			//  
+			// 모델 탭
 			if (ImGui::BeginTabItem("Model")) {
 				m_state.prevSelectedTab = m_state.selectedTab;
 				m_state.selectedTab = LeftPanelState::ModelTab;
@@ -344,7 +354,7 @@ namespace ImGui
 				ImGui::EndTabItem();
 			}
 
-			//  
+			// 재질 탭
 			if (ImGui::BeginTabItem("Material")) {
 				m_state.prevSelectedTab = m_state.selectedTab;
 				m_state.selectedTab = LeftPanelState::MaterialTab;
@@ -367,19 +377,19 @@ namespace ImGui
 
 		m_modelRemoveCallback(m_loadedModels[index]);
 
-		//   Ͽ 
+		// 모델 경로 목록에서 제거
 		m_loadedModels.erase(m_loadedModels.begin() + index);
 
-		// Transform  
+		// Transform 데이터 제거
 		m_modelTransformEditors.erase(index);
 
-		// õ ε 
+		// 선택된 인덱스 조정
 		if (m_selectedModelIndex == index) {
-			// ŵ ׸ õǾ ̸  ʱȭ
+			// 제거된 항목이 선택되었던 것이면 선택 초기화
 			m_selectedModelIndex = (m_loadedModels.empty()) ? -1 : 0;
 		}
 		else if (m_selectedModelIndex > index) {
-			// ŵ ׸񺸴 ڿ ִ  ε 
+			// 제거된 항목보다 뒤에 있던 선택 인덱스 조정
 			m_selectedModelIndex--;
 		}
 
@@ -387,20 +397,20 @@ namespace ImGui
 	}
 
 	void LeftPanelUI::RenderModelTab() {
-		//   Լ - Ʒ м ߰
+		// 헤더 렌더링 함수 - 위아래 구분선 추가
 		auto renderHeaderWithLines = [](const char* label) {
-			//  м ߰
+			// 상단 구분선 추가
 			ImGui::Spacing();
 			ImGui::Separator();
 			ImGui::Spacing();
 
-			//  ؽƮ  
-			ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.9f, 0.95f, 1.0f, 1.0f)); //    迭
+			// 헤더 텍스트 색상 변경
+			ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.9f, 0.95f, 1.0f, 1.0f)); // 더 밝은 흰색 계열
 
-			//  
+			// 헤더 렌더링
 			bool isOpen = ImGui::CollapsingHeader(label, ImGuiTreeNodeFlags_DefaultOpen);
 
-			// ؽƮ  
+			// 텍스트 색상 복원
 			ImGui::PopStyleColor();
 
 			ImGui::Spacing();
@@ -410,8 +420,8 @@ namespace ImGui
 			return isOpen;
 			};
 
-		// ü   ⺻ Ÿ  ( £  Ķ 迭)
-		ImGui::PushStyleColor(ImGuiCol_Header, ImVec4(0.2f, 0.35f, 0.4f, 0.8f));         // ణ   ûϻ
+		// 전체 헤더에 대한 기본 스타일 정의 (더 짙고 선명한 파란색 계열)
+		ImGui::PushStyleColor(ImGuiCol_Header, ImVec4(0.2f, 0.35f, 0.4f, 0.8f));         // 약간 더 밝은 청록색
 		ImGui::PushStyleColor(ImGuiCol_HeaderHovered, ImVec4(0.3f, 0.45f, 0.55f, 0.8f));
 		ImGui::PushStyleColor(ImGuiCol_HeaderActive, ImVec4(0.35f, 0.5f, 0.65f, 0.8f));
 
@@ -419,7 +429,7 @@ namespace ImGui
 			ImGui::Text("Load a 3D model in GLTF format");
 
 			if (ImGui::Button("Browse GLTF Model...", ImVec2(-1, 0))) {
-				// ùٸ FileDialogConfig 
+				// 올바른 FileDialogConfig 사용
 				IGFD::FileDialogConfig config;
 				config.path = ".";
 				config.flags = ImGuiFileDialogFlags_Modal;
@@ -431,13 +441,13 @@ namespace ImGui
 					config);
 			}
 
-			// ⼭ ϴ ũ ǥ
+			// 여기서 원하는 크기로 표시
 			ImVec2 maxSize = ImGui::GetMainViewport()->Size;
 			maxSize.x *= 0.4f;
 			maxSize.y *= 0.4f;
 			ImVec2 minSize = maxSize;
 
-			//  ̾α ǥ   ó
+			// 파일 다이얼로그 표시 및 결과 처리
 			if (ImGuiFileDialog::Instance()->Display(m_fileDialogKey, ImGuiWindowFlags_NoCollapse, minSize, maxSize)) {
 				if (ImGuiFileDialog::Instance()->IsOk()) {
 					std::string filePathName = ImGuiFileDialog::Instance()->GetFilePathName();
@@ -453,35 +463,35 @@ namespace ImGui
 		if (renderHeaderWithLines("Models")) {
 			if (m_loadedModels.empty()) {
 				ImGui::Text("No models loaded yet.");
-				// ⺻ Ÿ 
+				// 기본 스타일 복구
 				ImGui::PopStyleColor(3);
 			}
 			else {
-				// ⺻ Ÿ 
+				// 기본 스타일 복구
 				ImGui::PopStyleColor(3);
 
 				ImGui::BeginChild("ModelsList", ImVec2(0, 200), true);
 
-				//   ε  
+				// 삭제할 모델 인덱스 저장 변수
 				int modelToRemove = -1;
 
 				for (int i = 0; i < m_loadedModels.size(); i++) {
-					// ϸ 
-					std::string fileName = getFileName(m_loadedModels[i]);
+					// 파일명만 추출
+					const char* fileName = getFileNamePtr(m_loadedModels[i]);
 
 					ImGui::PushID(i);
 
-					// ׸ ̿ ʺ 
+					// 항목 높이와 너비 계산
 					float lineHeight = ImGui::GetTextLineHeightWithSpacing();
 					float itemWidth = ImGui::GetContentRegionAvail().x - 30;
 
-					//   
+					// 선택 가능한 영역
 					bool isSelected = (m_selectedModelIndex == i);
-					if (ImGui::Selectable(fileName.c_str(), &isSelected, 0, ImVec2(itemWidth, lineHeight))) {
+					if (ImGui::Selectable(fileName, &isSelected, 0, ImVec2(itemWidth, lineHeight))) {
 						m_selectedModelIndex = i;
 					}
 
-					//  ư
+					// 삭제 버튼
 					ImGui::SameLine(itemWidth + 20);
 					if (ImGui::Button("X", ImVec2(20, lineHeight))) {
 						modelToRemove = i;
@@ -490,7 +500,7 @@ namespace ImGui
 					ImGui::PopID();
 				}
 
-				//    ó
+				// 루프 이후 삭제 처리
 				if (modelToRemove >= 0) {
 					RemoveModel(modelToRemove);
 				}
@@ -529,7 +539,7 @@ namespace ImGui
 	}
 
 	void LeftPanelUI::RenderMaterialTab() {
-		//    (Box/Sphere) -  ư
+		// 프리뷰 모델 선택 (Box/Sphere) - 라디오 버튼
 		ImGui::Text("Preview Model:");
 		if (ImGui::RadioButton("Box", &m_useBoxModel, 0)) {
 			if (m_materialModelChangeCallback)
@@ -547,28 +557,28 @@ namespace ImGui
 
 		ImGui::Separator();
 
-		// PBR ؽó  UI
+		// PBR 텍스처 선택 UI
 		ImGui::Text("Material Textures:");
 
-		// Albedo ؽó (ʼ)
+		// Albedo 텍스처 (필수)
 		DisplayTextureLoadUI("Albedo", m_albedoPath, [this](const std::string& path) { m_albedoPath = path; });
 
-		// Normal ؽó ()
+		// Normal 텍스처 (선택)
 		DisplayTextureLoadUI("Normal", m_normalPath, [this](const std::string& path) { m_normalPath = path; });
 
-		// Metallic ؽó ()
+		// Metallic 텍스처 (선택)
 		DisplayTextureLoadUI("Metallic", m_metallicPath, [this](const std::string& path) { m_metallicPath = path; });
 
-		// Roughness ؽó ()
+		// Roughness 텍스처 (선택)
 		DisplayTextureLoadUI("Roughness", m_roughnessPath, [this](const std::string& path) { m_roughnessPath = path; });
 
-		// AO ؽó ()
+		// AO 텍스처 (선택)
 		DisplayTextureLoadUI("AO", m_aoPath, [this](const std::string& path) { m_aoPath = path; });
 
 		ImGui::Separator();
 
-		//   ư
-		bool canCreateMaterial = !m_albedoPath.empty(); // Albedo ʼ
+		// 재질 생성 버튼
+		bool canCreateMaterial = !m_albedoPath.empty(); // Albedo는 필수
 		if (!canCreateMaterial) {
 			ImGui::BeginDisabled();
 		}
@@ -590,25 +600,25 @@ namespace ImGui
 			ImGui::EndDisabled();
 		}
 
-		//  ̾α ǥ   ó
+		// 파일 다이얼로그 표시 및 결과 처리
 		HandleTextureFileBrowser();
 	}
 
 	void LeftPanelUI::DisplayTextureLoadUI(const char* labelName, std::string& texturePath, std::function<void(const std::string&)> onTextureSelected) {
 		ImGui::Text("%s:", labelName);
-		ImGui::SameLine(120); //  ġ ؽó ̸ 
+		ImGui::SameLine(120); // 고정된 위치에 텍스처 이름 시작
 
-		std::string displayName = texturePath.empty() ? "None" : getFileName(texturePath);
-		ImGui::Text("%s", displayName.c_str());
+		const char* displayName = texturePath.empty() ? "None" : getFileNamePtr(texturePath);
+		ImGui::Text("%s", displayName);
 		ImGui::SameLine();
 
-		// ε ư
-		std::string buttonLabel = "Load##" + std::string(labelName);
-		if (ImGui::Button(buttonLabel.c_str())) {
+		// 로드 버튼
+		FrameAllocator& frameAllocator = FrameAllocator::get();
+		if (ImGui::Button(frameAllocator.format("Load##%s", labelName))) {
 			m_currentSelectingTexturePath = texturePath;
 			m_currentSelectingTextureCallback = onTextureSelected;
 
-			//  ̾α 
+			// 파일 다이얼로그 열기
 			IGFD::FileDialogConfig config;
 			if (!m_lastBrowsedDirectory.empty()) {
 				config.path = m_lastBrowsedDirectory;
@@ -627,11 +637,10 @@ namespace ImGui
 				config);
 		}
 
-		//  õ ؽó  Clear ư ߰
+		// 현재 선택된 텍스처가 있으면 Clear 버튼 추가
 		if (!texturePath.empty()) {
 			ImGui::SameLine();
-			std::string clearLabel = "Clear##" + std::string(labelName);
-			if (ImGui::Button(clearLabel.c_str())) {
+			if (ImGui::Button(frameAllocator.format("Clear##%s", labelName))) {
 				texturePath.clear();
 			}
 		}
@@ -645,14 +654,14 @@ namespace ImGui
 		if (modelIndex < 0 || modelIndex >= m_loadedModels.size())
 			return;
 
-		// ش  TransformEditor ʱȭ
+		// 해당 모델의 TransformEditor 초기화
 		auto it = m_modelTransformEditors.find(modelIndex);
 		if (it == m_modelTransformEditors.end()) {
 			InitializeTransformEditor(modelIndex);
 
 		}
 
-		// Transform  
+		// Transform 값 설정
 		m_modelTransformEditors[modelIndex].SetTransform(transform);
 	}
 
@@ -668,11 +677,11 @@ namespace ImGui
 	}
 
 	void LeftPanelUI::OpenTextureFileBrowser(TextureType type) {
-		//  õ ؽó Ÿ 
+		// 현재 선택된 텍스처 타입 저장
 		m_currentSelectingTextureType = type;
 
 		IGFD::FileDialogConfig config;
-		//   丮  ش ġ 
+		// 이전에 선택한 디렉토리가 있으면 해당 위치에서 시작
 		if (!m_lastBrowsedDirectory.empty()) {
 			config.path = m_lastBrowsedDirectory;
 		}
@@ -691,13 +700,13 @@ namespace ImGui
 	}
 
 	void LeftPanelUI::HandleTextureFileBrowser() {
-		//  ǰ  ũ  
+		// 모델 탭과 동일한 크기 설정 사용
 		ImVec2 maxSize = ImGui::GetMainViewport()->Size;
 		maxSize.x *= 0.4f;
 		maxSize.y *= 0.4f;
 		ImVec2 minSize = maxSize;
 
-		//  ؽó ŸԿ  ̾α Ȯ
+		// 각 텍스처 타입에 대한 다이얼로그 확인
 		const char* textureTypes[] = { "Albedo", "Normal", "Metallic", "Roughness", "AO" };
 
 		for (const char* type : textureTypes) {
@@ -721,7 +730,7 @@ namespace ImGui
 	}
 
 	void LeftPanelUI::LoadCustomTexture(const std::string& path, TextureType type) {
-		//  ̸ 
+		// 파일 이름 추출
 		std::string fileName = getFileName(path);
 
 		std::cout << "load texture " << path << std::endl;
@@ -734,10 +743,10 @@ namespace ImGui
 
 	void RightPanelUI::Render(int x, int y, int width, int height, bool enabled) {
 		if (!m_extension) {
-			return; // VulkanTutorialExtension  ʾ  
+			return; // VulkanTutorialExtension이 설정되지 않았으면 렌더링하지 않음
 		}
 
-		//  
+		// 윈도우 설정
 		ImGui::SetNextWindowPos(ImVec2(float(x), float(y)));
 		ImGui::SetNextWindowSize(ImVec2(float(width), float(height)));
 
@@ -750,13 +759,13 @@ namespace ImGui
 			window_flags |= ImGuiWindowFlags_NoInputs;
 		}
 
-		// г  ( ڵ â  )
+		// 패널 시작 (기존 코드의 창 구조 사용)
 		if (ImGui::Begin("##RightPanel", &m_open, window_flags)) {
 			// Most "big" widgets share a common width settings by default.
 			ImGui::PushItemWidth(ImGui::GetFontSize() * -12);
 			ImGui::Spacing();
 
-			//  
+			// 컨텐츠 렌더링
 			RenderContent();
 
 			ImGui::PopItemWidth();
@@ -765,20 +774,20 @@ namespace ImGui
 	}
 
 	void RightPanelUI::RenderContent() {
-		//   Լ - Ʒ м ߰
-		auto renderHeaderWithLines = [](const char* label) {
-			//  м ߰
+		// 헤더 렌더링 함수 - 위아래 구분선 추가
+		auto renderHeaderWithLines = [](const char* label, ImGuiTreeNodeFlags headerFlags = 0) {
+			// 상단 구분선 추가
 			ImGui::Spacing();
 			ImGui::Separator();
 			ImGui::Spacing();
 
-			//  ؽƮ  
-			ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.9f, 0.95f, 1.0f, 1.0f)); //    迭
+			// 헤더 텍스트 색상 변경
+			ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.9f, 0.95f, 1.0f, 1.0f)); // 더 밝은 흰색 계열
 
-			//  
-			bool isOpen = ImGui::CollapsingHeader(label);
+			// 헤더 렌더링
+			bool isOpen = ImGui::CollapsingHeader(label, headerFlags);
 
-			// ؽƮ  
+			// 텍스트 색상 복원
 			ImGui::PopStyleColor();
 
 			ImGui::Spacing();
@@ -788,39 +797,159 @@ namespace ImGui
 			return isOpen;
 			};
 
-		// ü   ⺻ Ÿ  ( £  Ķ 迭)
-		ImGui::PushStyleColor(ImGuiCol_Header, ImVec4(0.2f, 0.35f, 0.4f, 0.8f));         // ణ   ûϻ
+		// 전체 헤더에 대한 기본 스타일 정의 (더 짙고 선명한 파란색 계열)
+		ImGui::PushStyleColor(ImGuiCol_Header, ImVec4(0.2f, 0.35f, 0.4f, 0.8f));         // 약간 더 밝은 청록색
 		ImGui::PushStyleColor(ImGuiCol_HeaderHovered, ImVec4(0.3f, 0.45f, 0.55f, 0.8f));
 		ImGui::PushStyleColor(ImGuiCol_HeaderActive, ImVec4(0.35f, 0.5f, 0.65f, 0.8f));
 
-		// Directional Light 
+		// Directional Light 섹션
 		if (renderHeaderWithLines("Directional Light"), ImGuiTreeNodeFlags_DefaultOpen) {
 			static ImGuiSliderFlags flags = ImGuiSliderFlags_None;
 			const ImGuiSliderFlags flags_for_sliders = flags & ~ImGuiSliderFlags_WrapAround;
 
 			ImGui::Checkbox("Use Directional Light", &m_extension->useDirectionalLight);
 			ImGui::SliderFloat("DirectionalLightIntensity", &m_extension->directionalLightIntensity, 0.0f, 100.0f, "%.1f", flags_for_sliders);
+			ImGui::SliderFloat3("DirectionalLightDirection", &m_extension->directionalLightDirection.x, -1.0f, 1.0f, "%.2f", flags_for_sliders);
+
+			// 드리우는 물체 목록이 매 프레임 바뀌므로 매 프레임 녹화할 때만 적용된다.
+			ImGui::Checkbox("Cascaded Shadows", &CascadedShadowMap::enabled);
+			ImGui::SameLine();
+			ImGui::Text("(%u x %ux%u)", CascadedShadowMap::CascadeCount, CascadedShadowMap::Resolution, CascadedShadowMap::Resolution);
+			ImGui::SameLine();
+			ImGui::Checkbox("Show Cascades", &CascadedShadowMap::showCascades);
+			ImGui::SliderFloat("Split Lambda", &CascadedShadowMap::splitLambda, 0.0f, 1.0f, "%.2f");
+			ImGui::SliderFloat("Shadow Distance", &CascadedShadowMap::shadowDistance, 5.0f, 100.0f, "%.1f");
+			ImGui::SliderInt("Cached From Cascade", &CascadedShadowMap::firstCachedCascade, 0, CascadedShadowMap::CascadeCount);
+			ImGui::SliderFloat("Cache Margin", &CascadedShadowMap::cacheMargin, 1.0f, 2.0f, "%.2f");
+			ImGui::SliderFloat("Depth Bias", &CascadedShadowMap::depthBiasConstant, 0.0f, 8.0f, "%.2f");
+			ImGui::SliderFloat("Slope Bias", &CascadedShadowMap::depthBiasSlope, 0.0f, 8.0f, "%.2f");
+			ImGui::SliderFloat("Normal Offset", &CascadedShadowMap::normalOffset, 0.0f, 4.0f, "%.2f");
+
+			const CascadedShadowMap::Stats& shadowStats = m_extension->cascadedShadowMap.getStats();
+			if (!CascadedShadowMap::enabled || !m_extension->useDirectionalLight || !m_extension->isRecordingCommandsEveryFrame()) {
+				ImGui::TextDisabled("Shadows : off");
+			}
+			else if (ImGui::BeginTable("shadowCascades", 5)) {
+				ImGui::TableSetupColumn("Cascade");
+				ImGui::TableSetupColumn("Far");
+				ImGui::TableSetupColumn("Draws");
+				ImGui::TableSetupColumn("GPU ms");
+				ImGui::TableSetupColumn("State");
+				ImGui::TableHeadersRow();
+				for (uint32_t c = 0; c < CascadedShadowMap::CascadeCount; c++) {
+					const CascadedShadowMap::CascadeStats& cascadeStats = shadowStats.cascades[c];
+					ImGui::TableNextColumn();
+					ImGui::Text("%u", c);
+					ImGui::TableNextColumn();
+					ImGui::Text("%.1f", cascadeStats.splitFar);
+					ImGui::TableNextColumn();
+					ImGui::Text("%u", cascadeStats.casters);
+					ImGui::TableNextColumn();
+					ImGui::Text("%.3f", cascadeStats.gpuMilliseconds);
+					ImGui::TableNextColumn();
+					if (cascadeStats.cacheable) {
+						ImGui::Text("%s (%u / %u)", cascadeStats.rendered ? "rendered" : "cached", cascadeStats.renderCount, shadowStats.frames);
+					}
+					else {
+						ImGui::Text("every frame");
+					}
+				}
+				ImGui::EndTable();
+				ImGui::Text("Shadow casters : %u candidates, CPU %.3f ms", shadowStats.casterCandidates, shadowStats.cpuMilliseconds);
+			}
 			ImGui::Spacing();
 		}
 
-		// Point Lights 
+		// Point Lights 섹션
 		static ImGuiSliderFlags flags = ImGuiSliderFlags_None;
 		const ImGuiSliderFlags flags_for_sliders = flags & ~ImGuiSliderFlags_WrapAround;
 
 		if (renderHeaderWithLines("Point Lights"), ImGuiTreeNodeFlags_DefaultOpen) {
+			// 라이트 버퍼에 수와 켜짐 여부를 매 프레임 쓰므로 켜고 끄거나 더하고 빼도 다시 녹화하지 않는다.
+			std::vector<VulkanTutorialExtension::ScenePointLight>& scenePointLights = m_extension->scenePointLights;
 			if (ImGui::BeginTable("pointLights", 4)) {
-				for (int i = 0; i < NR_POINT_LIGHTS; i++) {
-					std::stringstream ss;
-					ss << "Point Light " << i;
+				for (size_t i = 0; i < scenePointLights.size(); i++) {
 					ImGui::TableNextColumn();
-					ImGui::Checkbox(ss.str().c_str(), &m_extension->pointLightsSwitch[i]);
+					ImGui::Checkbox(FrameAllocator::get().format("Point Light %d", static_cast<int>(i)), &scenePointLights[i].enabled);
 				}
 				ImGui::EndTable();
 			}
+			ImGui::BeginDisabled(scenePointLights.size() >= MAX_POINT_LIGHTS);
+			if (ImGui::Button("Add Light")) {
+				// 카메라 앞에 둔다.
+				m_extension->addPointLight(m_extension->camera.Position + m_extension->camera.Front * 3.f);
+			}
+			ImGui::EndDisabled();
+			ImGui::SameLine();
+			ImGui::BeginDisabled(scenePointLights.empty());
+			if (ImGui::Button("Remove Light")) {
+				scenePointLights.pop_back();
+			}
+			ImGui::EndDisabled();
+			ImGui::SameLine();
+			ImGui::Text("%zu / %d", scenePointLights.size(), MAX_POINT_LIGHTS);
 
 			ImGui::SliderFloat("pointLightlinear", &m_extension->pointLightlinear, 0.0f, 1.0f, "%.3f", flags_for_sliders);
 			ImGui::SliderFloat("pointLightQuadratic", &m_extension->pointLightQuadratic, 0.0f, 1.0f, "%.3f", flags_for_sliders);
 			ImGui::SliderFloat("pointLightIntensity", &m_extension->pointLightIntensity, 0.0f, 100.0f, "%.1f", flags_for_sliders);
+
+			// 라이트 버퍼를 매 프레임 채우므로 녹화 방식과 상관없이 바로 적용된다.
+			ImGui::Checkbox("Clustered Lighting", &ClusteredLighting::enabled);
+			ImGui::SameLine();
+			ImGui::Text("(%ux%ux%u)", ClusteredLighting::GridX, ClusteredLighting::GridY, ClusteredLighting::GridZ);
+			ImGui::SliderInt("Test Lights", &ClusteredLighting::testLightCount, 0, ClusteredLighting::MaxLights - MAX_POINT_LIGHTS);
+			ImGui::SameLine();
+			ImGui::Checkbox("Animate", &ClusteredLighting::animateTestLights);
+			ImGui::SliderFloat("Light Cutoff", &ClusteredLighting::attenuationCutoff, 0.001f, 0.1f, "%.3f", ImGuiSliderFlags_Logarithmic);
+			const ClusteredLighting::Stats& clusterStats = m_extension->clusteredLighting.getLastStats();
+			if (LightVolumes::enabled && !m_extension->isSinglePassDeferred()) {
+				ImGui::Text("Clusters : unused, %u lights drawn as volumes", m_extension->lightVolumes.getLastVolumeCount());
+			}
+			else if (ClusteredLighting::enabled) {
+				ImGui::Text("Clusters : %u / %u lit, %.1f lights avg, %u max, %u overflowed", clusterStats.occupiedClusters, ClusteredLighting::ClusterCount,
+					clusterStats.occupiedClusters > 0 ? static_cast<float>(clusterStats.assignedLights) / clusterStats.occupiedClusters : 0.f,
+					clusterStats.maxLightsPerCluster, clusterStats.overflowedClusters);
+			}
+			else {
+				ImGui::Text("Clusters : off, %u lights per pixel", clusterStats.lights);
+			}
+			// 켜면 클러스터 대신 라이트마다 구를 그려 닿는 픽셀만 계산한다. 인스턴스 수를 매 프레임 쓰므로 다시 녹화하지 않는다.
+			ImGui::Checkbox("Light Volumes", &LightVolumes::enabled);
+			ImGui::SameLine();
+			ImGui::Text("(%u triangles per light)", LightVolumes::SphereSegments * (LightVolumes::SphereRings - 1) * 2);
+			// 지오메트리, 라이팅, 포워드를 서브패스로 가진 렌더 패스 하나로 그린다. 스왑체인을 다시 만들어 적용한다.
+			ImGui::Checkbox("Single Render Pass", &VulkanTutorialExtension::useSinglePassDeferred);
+			if (m_extension->isSinglePassDeferred()) {
+				ImGui::SameLine();
+				ImGui::TextDisabled("(G-buffer not stored, light volumes and occlusion culling off)");
+			}
+
+			// 화면에 크게 보이는 라이트부터 아틀라스 타일을 받는다. 바뀐 면만 프레임당 예산 안에서 다시 그린다.
+			ImGui::Checkbox("Point Light Shadows", &PointShadowAtlas::enabled);
+			ImGui::SameLine();
+			ImGui::Text("(%ux%u atlas, %u lights max)", PointShadowAtlas::AtlasSize, PointShadowAtlas::AtlasSize, PointShadowAtlas::MaxShadowedLights);
+			ImGui::SliderInt("Face Updates / Frame", &PointShadowAtlas::maxFaceUpdatesPerFrame, 1, 96);
+			ImGui::SliderFloat("Shadow Resolution Scale", &PointShadowAtlas::resolutionScale, 0.1f, 2.0f, "%.2f");
+			ImGui::SliderFloat("Point Depth Bias", &PointShadowAtlas::depthBiasConstant, 0.0f, 8.0f, "%.2f");
+			ImGui::SliderFloat("Point Slope Bias", &PointShadowAtlas::depthBiasSlope, 0.0f, 8.0f, "%.2f");
+			ImGui::SliderFloat("Point Normal Offset", &PointShadowAtlas::normalOffset, 0.0f, 4.0f, "%.2f");
+
+			const PointShadowAtlas::Stats& pointShadowStats = m_extension->pointShadowAtlas.getStats();
+			if (!m_extension->pointShadowAtlas.isSupported()) {
+				ImGui::TextDisabled("Point shadows : not supported (maxBoundDescriptorSets < 5)");
+			}
+			else if (!PointShadowAtlas::enabled || !m_extension->isRecordingCommandsEveryFrame()) {
+				ImGui::TextDisabled("Point shadows : off");
+			}
+			else {
+				ImGui::Text("Point shadows : %u / %u lights (%u ready), tiles 128/256/512 : %u/%u/%u, atlas %.1f%%",
+					pointShadowStats.shadowedLights, pointShadowStats.candidateLights, pointShadowStats.readyLights,
+					pointShadowStats.lightsPerTileSize[0], pointShadowStats.lightsPerTileSize[1], pointShadowStats.lightsPerTileSize[2],
+					pointShadowStats.atlasUsage * 100.f);
+				ImGui::Text("Faces : %u rendered, %u pending, %u draws, %u allocation failures",
+					pointShadowStats.faceUpdates, pointShadowStats.pendingFaces, pointShadowStats.casterDraws, pointShadowStats.allocationFailures);
+				ImGui::Text("GPU %.3f ms, CPU %.3f ms", pointShadowStats.gpuMilliseconds, pointShadowStats.cpuMilliseconds);
+			}
 			ImGui::Spacing();
 		}
 
@@ -834,16 +963,259 @@ namespace ImGui
 			ImGui::Spacing();
 		}
 
-		// Post Processing 
+		// Post Processing 섹션
 		if (renderHeaderWithLines("Post Processing"), ImGuiTreeNodeFlags_DefaultOpen) {
 			ImGui::SliderFloat("Exposure", &m_extension->exposure, 0.0f, 10.0f, "%.01f", flags_for_sliders);
 			ImGui::Spacing();
 		}
 
-		// ⺻ Ÿ 
+		// Dynamic Resolution 섹션
+		if (renderHeaderWithLines("Dynamic Resolution", ImGuiTreeNodeFlags_DefaultOpen)) {
+			// 켜고 끄면 다음 프레임 끝에 스왑체인을 다시 만든다.
+			ImGui::Checkbox("Dynamic Resolution", &DynamicResolution::enabled);
+			ImGui::SameLine();
+			ImGui::Checkbox("Adaptive", &DynamicResolution::adaptive);
+			if (DynamicResolution::adaptive) {
+				ImGui::SliderFloat("Target GPU ms", &DynamicResolution::targetMilliseconds, 2.0f, 50.0f, "%.1f");
+				ImGui::SliderFloat("Min Scale", &DynamicResolution::minScale, 0.25f, 1.0f, "%.2f");
+				ImGui::SliderFloat("Max Scale", &DynamicResolution::maxScale, 0.25f, 1.0f, "%.2f");
+			}
+			else {
+				ImGui::SliderFloat("Scale", &DynamicResolution::fixedScale, 0.25f, 1.0f, "%.2f");
+			}
+			ImGui::SliderFloat("Sharpness", &DynamicResolution::sharpness, 0.0f, 1.0f, "%.2f");
+
+			const DynamicResolution::Stats& resolutionStats = m_extension->dynamicResolution.getStats();
+			if (!m_extension->dynamicResolution.hasTargets()) {
+				ImGui::TextDisabled("Dynamic resolution : off");
+			}
+			else {
+				ImGui::Text("Render %ux%u (%.0f%%)", resolutionStats.renderExtent.width, resolutionStats.renderExtent.height, resolutionStats.scale * 100.0f);
+				ImGui::Text("GPU %.2f ms (avg %.2f ms), %u scale changes", resolutionStats.gpuMilliseconds, resolutionStats.smoothedMilliseconds, resolutionStats.scaleChanges);
+				if (!m_extension->isRecordingCommandsEveryFrame()) {
+					ImGui::TextDisabled("Scale is fixed at 100%% unless recording every frame");
+				}
+			}
+			ImGui::Spacing();
+		}
+
+		// Transparency 섹션
+		if (renderHeaderWithLines("Transparency", ImGuiTreeNodeFlags_DefaultOpen)) {
+			// 켜고 끄면 다음 프레임 끝에 스왑체인을 다시 만든다.
+			ImGui::Checkbox("Weighted Blended OIT", &WeightedBlendedOIT::enabled);
+			ImGui::SameLine();
+			ImGui::Text("(RGBA16F + R16F)");
+			const uint32_t translucentCount = static_cast<uint32_t>(m_extension->mainDrawContext.TranslucentSurfaces.size());
+			if (m_extension->weightedBlendedOIT.hasTargets()) {
+				ImGui::Text("Translucent : %u draws, unsorted (batched by material)", translucentCount);
+			}
+			else {
+				ImGui::Text("Translucent : %u draws, sorted back to front", translucentCount);
+			}
+			ImGui::Spacing();
+		}
+
+		// Mesh Memory 섹션
+		if (renderHeaderWithLines("Mesh Memory", ImGuiTreeNodeFlags_DefaultOpen)) {
+			char reportText[256];
+			m_extension->meshMemoryHeap.report().format(reportText, sizeof(reportText));
+			ImGui::Text("Current : %s", reportText);
+
+			const DeferredDeletionQueue& deletionQueue = DeferredDeletionQueue::get();
+			ImGui::Text("Pending deletion : %llu objects, %llu KB (last freed %llu KB)",
+				static_cast<unsigned long long>(deletionQueue.getPendingCount()),
+				static_cast<unsigned long long>(deletionQueue.getPendingBytes() / 1024),
+				static_cast<unsigned long long>(deletionQueue.getLastFreedBytes() / 1024));
+
+			const std::shared_ptr<MeshDefragmenter>& defragmenter = m_extension->meshDefragmenter;
+			if (defragmenter) {
+				ImGui::SliderInt("Defrag Budget (KB/frame)", &MeshDefragmenter::budgetKBPerFrame, 64, 64 * 1024);
+				if (ImGui::Button("Defragment")) {
+					defragmenter->requestDefragment();
+				}
+				ImGui::SameLine();
+				ImGui::Text("%s", defragmenter->isRunning() ? "running..." : "idle");
+
+				if (defragmenter->getReportAfter().blockCount > 0) {
+					defragmenter->getReportBefore().format(reportText, sizeof(reportText));
+					ImGui::Text("Before : %s", reportText);
+					defragmenter->getReportAfter().format(reportText, sizeof(reportText));
+					ImGui::Text("After  : %s", reportText);
+					ImGui::Text("Moved  : %llu KB", static_cast<unsigned long long>(defragmenter->getMovedBytesTotal() / 1024));
+				}
+			}
+			ImGui::Spacing();
+		}
+
+		// Draw Calls 섹션
+		if (renderHeaderWithLines("Draw Calls", ImGuiTreeNodeFlags_DefaultOpen)) {
+			const VulkanTutorialExtension::DrawBindStats& stats = m_extension->lastBindStats;
+			ImGui::Text("Draws : %u", stats.draws);
+			ImGui::Text("Binds : %u issued, %u skipped", stats.bindsIssued, stats.bindsSkipped);
+
+			bool recordEveryFrame = m_extension->isRecordingCommandsEveryFrame();
+			if (ImGui::Checkbox("Record Every Frame", &recordEveryFrame)) {
+				m_extension->setRecordCommandsEveryFrame(recordEveryFrame);
+			}
+			ImGui::Text("Recording : %.3f ms %s", m_extension->getLastRecordMilliseconds(), recordEveryFrame ? "/ frame" : "(on change)");
+
+			if (ImGui::Checkbox("Parallel Recording", &VulkanTutorialExtension::useParallelRecording)) {
+				m_extension->markCommandBufferRecreation();
+			}
+			ImGui::SameLine();
+			ImGui::Text("(%u workers)", m_extension->commandRecorder.getWorkerCount());
+
+			if (ImGui::Checkbox("Auto Instancing", &VulkanTutorialExtension::useAutoInstancing)) {
+				m_extension->markCommandBufferRecreation();
+			}
+			const DrawInstancing::Stats& instancingStats = m_extension->lastInstancingStats;
+			ImGui::Text("Instancing : %u opaque -> %u draws (%u instanced, %u instances)",
+				instancingStats.sourceDraws, instancingStats.mergedDraws, instancingStats.instancedDraws, instancingStats.instances);
+
+			// 매 프레임 녹화할 때만 적용된다.
+			ImGui::Checkbox("Frustum Culling", &VulkanTutorialExtension::useFrustumCulling);
+			ImGui::SameLine();
+			ImGui::Text("(%u wide)", FrustumCulling::getBatchWidth());
+			const FrustumCulling::Stats& cullingStats = m_extension->lastCullingStats;
+			ImGui::Text("Culled : %u / %u", cullingStats.culled, cullingStats.tested);
+
+			ImGui::Checkbox("Scene BVH", &VulkanTutorialExtension::useSceneBVH);
+			const SceneBVH::Stats& bvhStats = m_extension->sceneBVH.getStats();
+			ImGui::Text("BVH : %u surfaces, %u nodes (%u builds, %u refits)", bvhStats.items, bvhStats.nodes, bvhStats.rebuilds, bvhStats.refits);
+			const SceneBVH::Hit& pickHit = m_extension->lastPickHit;
+			if (pickHit.instanceIndex >= 0 && pickHit.instanceIndex < static_cast<int>(m_extension->sceneInstances.size())) {
+				ImGui::Text("Pick : %s surface %u (%.2f)", m_extension->sceneInstances[pickHit.instanceIndex].modelName.c_str(), pickHit.surface, pickHit.distance);
+			}
+			const SceneBVH::Hit& nearestHit = m_extension->lastNearestHit;
+			if (nearestHit.instanceIndex >= 0 && nearestHit.instanceIndex < static_cast<int>(m_extension->sceneInstances.size())) {
+				ImGui::Text("Nearest : %s surface %u (%.2f)", m_extension->sceneInstances[nearestHit.instanceIndex].modelName.c_str(), nearestHit.surface, nearestHit.distance);
+			}
+
+			// 매 프레임 녹화할 때만 적용된다. LOD 는 로드할 때 만들므로 끄고 로드한 모델은 LOD 가 없다.
+			ImGui::Checkbox("Mesh LOD", &MeshLodSelector::enabled);
+			ImGui::SameLine();
+			ImGui::Checkbox("Generate On Load", &MeshLod::generateOnLoad);
+			if (MeshLodSelector::enabled) {
+				ImGui::SliderFloat("LOD Pixel Error", &MeshLodSelector::pixelError, 0.25f, 16.f, "%.2f px");
+				ImGui::SliderFloat("LOD Hysteresis", &MeshLodSelector::hysteresis, 0.f, 0.9f, "%.2f");
+				const MeshLodSelector::Stats& lodStats = m_extension->meshLodSelector.getStats();
+				for (uint32_t level = 0; level < MeshLod::MaxLevels; level++) {
+					ImGui::Text("LOD %u : %5u draws, %9llu tris", level, lodStats.draws[level], static_cast<unsigned long long>(lodStats.triangles[level]));
+				}
+				ImGui::Text("LOD Triangles : %llu / %llu (%.1f%%)", static_cast<unsigned long long>(lodStats.selectedTriangles),
+					static_cast<unsigned long long>(lodStats.sourceTriangles),
+					lodStats.sourceTriangles > 0 ? 100.0 * lodStats.selectedTriangles / lodStats.sourceTriangles : 100.0);
+			}
+
+			if (m_extension->indirectDrawPass.isSupported()) {
+				// 매 프레임 녹화할 때만 적용된다.
+				ImGui::Checkbox("GPU Driven", &IndirectDrawPass::enabled);
+				const IndirectDrawPass::Stats& indirectStats = m_extension->indirectDrawPass.getLastStats();
+				ImGui::Text("Indirect : %u draws in %u calls (%s), %u on CPU", indirectStats.drawCount, indirectStats.groupCount,
+					m_extension->indirectDrawPass.isCompacting() ? "count" : "no count", indirectStats.fallbackCount);
+			}
+			else {
+				ImGui::TextDisabled("GPU Driven : multi draw indirect not supported");
+			}
+
+			if (m_extension->occlusionCulling.isSupported()) {
+				// 매 프레임 녹화할 때만 적용된다.
+				ImGui::Checkbox("Occlusion Culling", &OcclusionCulling::enabled);
+				ImGui::SameLine();
+				const VkExtent2D pyramidExtent = m_extension->occlusionCulling.getPyramidExtent();
+				ImGui::Text("(Hi-Z %ux%u, %u levels)", pyramidExtent.width, pyramidExtent.height, m_extension->occlusionCulling.getPyramidLevelCount());
+				const OcclusionCulling::Stats& occlusionStats = m_extension->occlusionCulling.getLastStats();
+				ImGui::Text("Occluded : %u / %u (%u early, %u drawn late)", occlusionStats.occluded, occlusionStats.tested,
+					occlusionStats.occludedEarly, occlusionStats.recovered);
+			}
+			else {
+				ImGui::TextDisabled("Occlusion Culling : depth sampling not supported");
+			}
+
+			// 한번 녹화해 둔 버퍼도 프리패스를 넣고 빼야 하므로 다시 녹화한다. GPU Driven, 가림 컬링, 단일 렌더 패스와는 같이 쓰지 않는다.
+			if (ImGui::Checkbox("Depth Prepass", &DepthPrepass::enabled)) {
+				m_extension->markCommandBufferRecreation();
+			}
+			const DepthPrepass::Stats& prepassStats = m_extension->depthPrepass.getStats();
+			if (DepthPrepass::enabled) {
+				ImGui::SameLine();
+				ImGui::Text("(%u draws, %u without position stream)", prepassStats.draws, prepassStats.skipped);
+			}
+			if (m_extension->depthPrepass.isStatisticsSupported()) {
+				// 매 프레임 녹화할 때만 잰다. 켜고 끈 값은 각각 마지막으로 잰 값이라 같은 시점이 아닐 수 있다.
+				ImGui::Text("FS invocations : %llu with prepass, %llu without",
+					static_cast<unsigned long long>(prepassStats.invocationsWithPrepass),
+					static_cast<unsigned long long>(prepassStats.invocationsWithoutPrepass));
+				if (prepassStats.invocationsWithPrepass > 0 && prepassStats.invocationsWithoutPrepass > 0) {
+					const double saved = static_cast<double>(prepassStats.invocationsWithoutPrepass) - static_cast<double>(prepassStats.invocationsWithPrepass);
+					ImGui::Text("Saved : %.0f (%.1f%%)", saved, 100.0 * saved / prepassStats.invocationsWithoutPrepass);
+				}
+				if (VulkanTutorialExtension::useParallelRecording && !m_extension->getOptionalDeviceFeatures().inheritedQueries) {
+					ImGui::TextDisabled("(not measured with parallel recording : inheritedQueries not supported)");
+				}
+			}
+			else {
+				ImGui::TextDisabled("FS invocations : pipeline statistics not supported");
+			}
+
+			if (ImGui::Button("Benchmark 50k Draws")) {
+				m_extension->benchmarkCommandRecording(50000);
+			}
+			const std::vector<VulkanTutorialExtension::RecordBenchmarkResult>& results = m_extension->recordBenchmarkResults;
+			for (const VulkanTutorialExtension::RecordBenchmarkResult& result : results) {
+				ImGui::Text("%2u workers : %7.2f ms (x%.2f)", result.workers, result.milliseconds, results[0].milliseconds / result.milliseconds);
+			}
+
+			if (ImGui::Button("Benchmark 100k Culling")) {
+				m_extension->benchmarkSceneCulling(100000);
+			}
+			for (const VulkanTutorialExtension::CullingBenchmarkResult& result : m_extension->cullingBenchmarkResults) {
+				ImGui::Text("%u objects, %u visible", result.objects, result.visible);
+				ImGui::Text("Linear : %7.3f ms", result.linearMilliseconds);
+				ImGui::Text("BVH    : %7.3f ms (x%.2f), build %.2f ms, refit %.2f ms", result.bvhQueryMilliseconds,
+					result.linearMilliseconds / result.bvhQueryMilliseconds, result.bvhBuildMilliseconds, result.bvhRefitMilliseconds);
+			}
+
+			const TransformHierarchy::Stats& transformStats = m_extension->transformHierarchy.getStats();
+			ImGui::Text("Transforms : %u nodes (%u meshes), %u updated this frame", transformStats.nodes, transformStats.meshNodes, transformStats.updatedNodes);
+			if (ImGui::Button("Benchmark 200k Transforms")) {
+				m_extension->benchmarkTransformUpdate(200000);
+			}
+			for (const VulkanTutorialExtension::TransformBenchmarkResult& result : m_extension->transformBenchmarkResults) {
+				ImGui::Text("%u nodes", result.nodes);
+				ImGui::Text("Recursive    : %7.3f ms", result.recursiveMilliseconds);
+				ImGui::Text("Static       : %7.4f ms", result.staticMilliseconds);
+				ImGui::Text("One instance : %7.3f ms", result.oneInstanceMilliseconds);
+				ImGui::Text("All moved    : %7.3f ms, %7.3f ms parallel (%u chunks)", result.allSerialMilliseconds, result.allParallelMilliseconds, result.chunks);
+			}
+			ImGui::Spacing();
+		}
+
+		// Frame Allocator 섹션
+		if (renderHeaderWithLines("Frame Allocator", ImGuiTreeNodeFlags_DefaultOpen)) {
+			const FrameAllocator& frameAllocator = FrameAllocator::get();
+			ImGui::Checkbox("Use Frame Arena", &FrameAllocator::enabled);
+			ImGui::Text("Heap allocations : %llu / frame", static_cast<unsigned long long>(frameAllocator.getLastFrameHeapAllocations()));
+			ImGui::Text("Arena : %llu KB used (capacity %llu KB)",
+				static_cast<unsigned long long>(frameAllocator.getLastFrameArenaBytes() / 1024),
+				static_cast<unsigned long long>(frameAllocator.getArenaCapacity() / 1024));
+			ImGui::Spacing();
+		}
+
+		// Render Target Memory 섹션
+		if (renderHeaderWithLines("Render Target Memory", ImGuiTreeNodeFlags_DefaultOpen)) {
+			const TransientAttachmentHeap::Stats stats = m_extension->transientAttachmentHeap.getStats();
+			ImGui::Text("Requested : %llu KB", static_cast<unsigned long long>(stats.requestedBytes / 1024));
+			ImGui::Text("Allocated : %llu KB in %u blocks (lazy %llu KB)",
+				static_cast<unsigned long long>(stats.allocatedBytes / 1024), stats.blockCount,
+				static_cast<unsigned long long>(stats.lazyBytes / 1024));
+			ImGui::Spacing();
+		}
+
+		// 기본 스타일 복구
 		ImGui::PopStyleColor(3);
 
-		//  ڿ 
+		// 디버그 문자열 출력
 		if (!ImGui::stringToDebug.empty()) {
 			ImGui::Text("%s", ImGui::stringToDebug.c_str());
 			ImGui::Spacing();
@@ -855,20 +1227,20 @@ namespace ImGui
 			return;
 		}
 
-		//  м ߰
+		// 상단 구분선 추가
 		ImGui::Spacing();
 		ImGui::Separator();
 		ImGui::Spacing();
 
-		// ؽó   ( )
-		ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.9f, 0.95f, 1.0f, 1.0f)); //    迭
+		// 텍스처 뷰어 헤더 (색상만 변경)
+		ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.9f, 0.95f, 1.0f, 1.0f)); // 더 밝은 흰색 계열
 
 		bool isOpen = ImGui::CollapsingHeader("Texture Viewer", ImGuiTreeNodeFlags_DefaultOpen);
 
-		//  
+		// 색상 복원
 		ImGui::PopStyleColor();
 
-		//    ϴ м ߰
+		// 헤더가 접혀있을 때는 하단 구분선 추가
 		if (!isOpen) {
 			ImGui::Spacing();
 			ImGui::Separator();
@@ -880,17 +1252,17 @@ namespace ImGui
 
 		const auto& textures = m_textureViewer->getTextures();
 
-		// õ ؽó 
+		// 선택된 텍스처 정보
 		bool hasSelectedTexture = (m_selectedTextureIndex >= 0 && m_selectedTextureIndex < textures.size());
 		bool isCubemap = hasSelectedTexture && textures[m_selectedTextureIndex].cubeMap != nullptr;
 		bool hasImage = hasSelectedTexture && textures[m_selectedTextureIndex].image != nullptr;
 
-		// MIP  
+		// MIP 레벨 선택
 		static int mipLevel = 0;
 		int maxMipLevels = isCubemap ? textures[m_selectedTextureIndex].cubeMap->imageViews.size() : 1;
 
 		if (hasImage) {
-			//  ̹ MIP    (  )
+			// 실제 이미지의 MIP 레벨 수 가져오기 (아직 구현되지 않음)
 			// maxMipLevels = textures[m_selectedTextureIndex].image->mipLevels;
 		}
 
@@ -902,7 +1274,7 @@ namespace ImGui
 		}
 		ImGui::EndDisabled();
 
-		// Cubemap Face 
+		// Cubemap Face 선택
 		static const char* cubemapFaces[] = {
 			"Right (+X)", "Left (-X)",
 			"Up (+Y)", "Down (-Y)",
@@ -918,8 +1290,8 @@ namespace ImGui
 		}
 		ImGui::EndDisabled();
 
-		// 
-		ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.75f, 0.85f, 1.0f, 1.0f)); //  Ķ 迭
+		// 서브헤더
+		ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.75f, 0.85f, 1.0f, 1.0f)); // 연한 파란색 계열
 		ImGui::Text("Available Textures:");
 		ImGui::PopStyleColor();
 
@@ -931,7 +1303,7 @@ namespace ImGui
 				m_selectedTextureIndex = i;
 				m_textureViewer->selectTexture(i);
 
-				//  ؽó   MIP/Face   ʱȭ
+				// 새 텍스처 선택 시 MIP/Face 관련 상태 초기화
 				if (textures[i].cubeMap) {
 					cubemapFace = 0;
 					m_textureViewer->selectCubeMapFace(cubemapFace);
@@ -940,29 +1312,29 @@ namespace ImGui
 				m_textureViewer->selectMipLevel(mipLevel);
 			}
 
-			// õ ׸ 
+			// 선택된 항목 강조
 			if (isSelected) {
 				ImGui::SetItemDefaultFocus();
 			}
 		}
 
 		if (textures.empty()) {
-			ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "ؽó ϴ");
+			ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "텍스처가 없습니다");
 		}
 
 		ImGui::EndChild();
 
-		// õ ؽó   ǥ
+		// 선택된 텍스처에 대한 정보 표시
 		if (hasSelectedTexture) {
 			const auto& selectedTexture = textures[m_selectedTextureIndex];
 			ImGui::Separator();
 
-			//  Ÿ
+			// 서브헤더 스타일
 			ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.75f, 0.85f, 1.0f, 1.0f));
 			ImGui::Text("Selected Texture: %s", selectedTexture.name.c_str());
 			ImGui::PopStyleColor();
 
-			// ؽó Ÿ ǥ
+			// 텍스처 타입 표시
 			const char* textureType = "Unknown";
 			if (selectedTexture.cubeMap) textureType = "Cubemap";
 			else if (selectedTexture.image) textureType = "2D Texture";
@@ -985,7 +1357,7 @@ namespace ImGui
 				confirmed = true;
 			}
 
-			// ȸ
+			// 회전
 			ImGui::Text("Rotation (degrees)");
 			ImGui::InputFloat3("##Rotation", m_transform.rotation, "%.3f");
 
@@ -993,7 +1365,7 @@ namespace ImGui
 				confirmed = true;
 			}
 
-			// ũ
+			// 크기
 			ImGui::Text("Scale");
 			ImGui::InputFloat3("##Scale", m_transform.scale, "%.3f");
 
@@ -1001,13 +1373,13 @@ namespace ImGui
 				confirmed = true;
 			}
 
-			//  ư
+			// 리셋 버튼
 			if (ImGui::Button("Reset Transform", ImVec2(-1, 0))) {
 				Reset();
 				confirmed = true;
 			}
 
-			// Ȯ   ݹ ȣ
+			// 확정된 변경사항이 있으면 콜백 호출
 			if (confirmed) {
 				if (auto sharedParent = m_parent.lock()) {
 					sharedParent->getModelTransformChangeCallback()(selectedIndex, m_transform);
@@ -1018,7 +1390,7 @@ namespace ImGui
 		return confirmed;
 	}
 
-	// Transform ʱȭ
+	// Transform 초기화
 	void TransformEditor::Reset() {
 		m_transform.position[0] = m_transform.position[1] = m_transform.position[2] = 0.0f;
 		m_transform.rotation[0] = m_transform.rotation[1] = m_transform.rotation[2] = 0.0f;
@@ -1029,24 +1401,24 @@ namespace ImGui
 
 	ModelTransform::ModelTransform(glm::mat4 mat)
 	{
-		// ġ  (   )
+		// 위치 추출 (행렬의 마지막 열 사용)
 		position[0] = mat[3][0];
 		position[1] = mat[3][1];
 		position[2] = mat[3][2];
 
-		// ũ  ( ⺻  )
+		// 크기 추출 (각 기본 벡터의 길이)
 		scale[0] = glm::length(glm::vec3(mat[0]));
 		scale[1] = glm::length(glm::vec3(mat[1]));
 		scale[2] = glm::length(glm::vec3(mat[2]));
 
-		// ȸ   ( )
+		// 회전 행렬 추출 (스케일 제거)
 		glm::mat3 rotMat(
 			glm::vec3(mat[0]) / scale[0],
 			glm::vec3(mat[1]) / scale[1],
 			glm::vec3(mat[2]) / scale[2]
 		);
 
-		// ȸ  Ϸ  ȯ
+		// 회전 행렬을 오일러 각으로 변환
 		glm::vec3 eulerAngles = glm::degrees(glm::eulerAngles(glm::quat(rotMat)));
 		rotation[0] = eulerAngles.x;
 		rotation[1] = eulerAngles.y;
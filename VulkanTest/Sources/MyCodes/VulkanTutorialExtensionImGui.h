@@ -21,7 +21,7 @@ namespace ImGui
 
 	extern std::string stringToDebug;
 
-	//  г  ü
+	// 왼쪽 패널 상태 구조체
 	struct LeftPanelState {
 		enum Tab {
 			ModelTab = 0,
@@ -31,7 +31,7 @@ namespace ImGui
 		Tab selectedTab = ModelTab;
 		Tab prevSelectedTab = ModelTab;
 
-		// ũ 
+		// 스크롤 상태
 		float modelScroll = 0.0f;
 		float materialScroll = 0.0f;
 
@@ -52,7 +52,7 @@ namespace ImGui
 		glm::mat4 matrix() const;
 	};
 
-	// Transform  Ŭ
+	// Transform 편집 클래스
 	class TransformEditor {
 	public:
 
@@ -63,12 +63,12 @@ namespace ImGui
 			m_parent = parent;
 		}
 
-		// Transform  
+		// Transform 값 설정
 		void SetTransform(const ModelTransform& transform) {
 			m_transform = transform;
 		}
 
-		//  Transform  
+		// 현재 Transform 값 가져오기
 		const ModelTransform& GetTransform() const {
 			return m_transform;
 		}
@@ -82,7 +82,7 @@ namespace ImGui
 		ModelTransform m_transform;
 	};
 
-	// TextureType  
+	// TextureType 열거형 정의
 	enum class TextureType {
 		Albedo = 0,
 		Normal = 1,
@@ -91,26 +91,26 @@ namespace ImGui
 		AO = 4
 	};
 
-	//  ؽó  ü
+	// 재질 텍스처 정보 구조체
 	struct MaterialTextureInfo {
-		std::string path;          // ؽó  
-		std::string displayName;   // UI ǥ ̸
-		TextureType type;          // ؽó Ÿ
-		int viewerIndex;           // TextureViewer ε
+		std::string path;          // 텍스처 파일 경로
+		std::string displayName;   // UI에 표시할 이름
+		TextureType type;          // 텍스처 타입
+		int viewerIndex;           // TextureViewer에서의 인덱스
 	};
 
-	//  г UI 
+	// 왼쪽 패널 UI 관리자
 	class LeftPanelUI : public std::enable_shared_from_this<LeftPanelUI> {
 	public:
 		LeftPanelUI();
 		~LeftPanelUI();
 
-		// г  Լ
+		// 패널 렌더링 함수
 		void Render(int x, int y, int width, int height, bool enabled = true);
 
 		bool RemoveModel(int index);
 
-		//  
+		// 상태 접근
 		LeftPanelState& GetState() { return m_state; }
 
 		using ModelLoadCallback = std::function<void(const std::string&)>;
@@ -134,7 +134,7 @@ namespace ImGui
 		void SetMaterialModelChangeCallback(MaterialModelChangeCallback callback) { m_materialModelChangeCallback = callback; }
 
 	private:
-		//    Լ ( cpp Ͽ)
+		// 탭 컨텐츠 렌더링 함수 (구현은 cpp 파일에서)
 		void RenderModelTab();
 		void RenderMaterialTab();
 		void DisplayTextureLoadUI(const char* labelName, std::string& texturePath, std::function<void(const std::string&)> onTextureSelected);
@@ -143,7 +143,7 @@ namespace ImGui
 		void HandleTextureFileBrowser();
 		void LoadCustomTexture(const std::string& path, TextureType type);
 
-		//  
+		// 상태 정보
 		LeftPanelState m_state;
 		ModelLoadCallback m_modelLoadCallback;
 		ModelLoadCallback m_modelRemoveCallback;
@@ -155,7 +155,7 @@ namespace ImGui
 		const char* m_fileDialogKey = "ChooseGLTFModelDlgKey";
 		TextureType m_currentSelectingTextureType = TextureType::Albedo;
 
-		// Material   
+		// Material 탭 멤버 변수들
 		VulkanTutorialExtension* m_extension = nullptr;
 		std::string m_fileDialogKeyMaterial = "MaterialTextureDialog";
 
@@ -166,10 +166,10 @@ namespace ImGui
 		std::string m_aoPath = "";
 		std::string m_materialName = "viewer";
 
-		//   ݹ
+		// 재질 생성 콜백
 		CreateMaterialCallback m_createMaterialCallback = nullptr;
 		MaterialModelChangeCallback m_materialModelChangeCallback = nullptr;
-		//    
+		// 모델 선택 관련 변수
 		int m_useBoxModel = 1; // 0 = Box, 1 = Sphere
 
 		using TextureSelectedCallback = std::function<void(const std::string&)>;
@@ -178,16 +178,16 @@ namespace ImGui
 		std::string m_currentSelectingTexturePath = "";
 	};
 
-	//  г UI 
+	// 오른쪽 패널 UI 관리자
 	class RightPanelUI : public std::enable_shared_from_this<RightPanelUI> {
 	public:
 		RightPanelUI(VulkanTutorialExtension* extension);
 		~RightPanelUI();
 
-		// г  Լ
+		// 패널 렌더링 함수
 		void Render(int x, int y, int width, int height, bool enabled = true);
 
-		// VulkanTutorialExtension  
+		// VulkanTutorialExtension 참조 설정
 		void SetTextureViewer(const std::shared_ptr<TextureViewer>& textureViewer)
 		{
 			if (m_textureViewer != textureViewer)
@@ -197,17 +197,17 @@ namespace ImGui
 		}
 
 	private:
-		//   Լ
+		// 컨텐츠 렌더링 함수
 		void RenderContent();
 
-		// ؽó      ޼
+		// 텍스처 뷰어 섹션 렌더링을 위한 새 메서드
 		void RenderTextureViewer();
 
-		// Vulkan Extension 
+		// Vulkan Extension 참조
 		VulkanTutorialExtension* m_extension = nullptr;
 		std::shared_ptr<TextureViewer> m_textureViewer;
 
-		// â  
+		// 창 관련 상태
 		bool m_open = true;
 
 		int m_selectedTextureIndex = -1;
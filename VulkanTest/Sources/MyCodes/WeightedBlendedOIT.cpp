@@ -0,0 +1,350 @@
+#include "WeightedBlendedOIT.h"
+#include "VulkanTutorialExtension.h"
+#include "GPUMarker.h"
+#include "vk_descriptor.h"
+#include "vk_initializers.h"
+#include "vk_resource_utils.h"
+#include "vk_log.h"
+
+#include <array>
+
+bool WeightedBlendedOIT::enabled = false;
+
+void WeightedBlendedOIT::initialize(VulkanTutorialExtension* inEngine, VkFormat depthFormat)
+{
+	// 렌더 패스를 다시 만들 때마다 불린다. 포맷이 바뀌지 않으므로 한번만 만든다.
+	if (isInitialized())
+	{
+		return;
+	}
+
+	engine = inEngine;
+	device = engine->getDevicePtr();
+
+	createAccumulationRenderPass(depthFormat);
+
+	std::vector<VkDescriptorSetLayoutBinding> bindings;
+	vk::desc::createDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, bindings);
+	vk::desc::createDescriptorSetLayoutBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, bindings);
+	setLayout = vk::desc::createDescriptorSetLayout(*device, bindings);
+
+	std::vector<VkDescriptorPoolSize> sizes = { vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2) };
+	VkDescriptorPoolCreateInfo poolInfo = vkb::initializers::descriptor_pool_create_info(sizes, 1);
+	VK_CHECK_RESULT(vkCreateDescriptorPool(*device, &poolInfo, nullptr, &descriptorPool));
+	VkDescriptorSetAllocateInfo allocInfo = vkb::initializers::descriptor_set_allocate_info(descriptorPool, &setLayout, 1);
+	VK_CHECK_RESULT(vkAllocateDescriptorSets(*device, &allocInfo, &set));
+
+	VkPipelineLayoutCreateInfo layoutInfo = vkb::initializers::pipeline_layout_create_info(&setLayout, 1);
+	VK_CHECK_RESULT(vkCreatePipelineLayout(*device, &layoutInfo, nullptr, &resolvePipelineLayout));
+
+	// 합성은 같은 픽셀을 texelFetch 로 읽기만 한다.
+	VkSamplerCreateInfo samplerInfo = vkb::initializers::sampler_create_info();
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.maxLod = 1.f;
+	samplerInfo.maxAnisotropy = 1.f;
+	VK_CHECK_RESULT(vkCreateSampler(*device, &samplerInfo, nullptr, &sampler));
+}
+
+void WeightedBlendedOIT::createAccumulationRenderPass(VkFormat depthFormat)
+{
+	// 0 누적 색 + 투과율, 1 가중치 합, 2 깊이. 누적 타겟은 합성 패스가 샘플링하도록 SHADER_READ_ONLY 로 끝낸다.
+	std::array<VkAttachmentDescription, 3> attachments = {};
+	const std::array<VkFormat, 2> colorFormats = { AccumulationFormat, WeightFormat };
+	for (size_t a = 0; a < colorFormats.size(); a++)
+	{
+		VkAttachmentDescription& attachment = attachments[a];
+		attachment.format = colorFormats[a];
+		attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		attachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	}
+
+	// 포워드 패스가 남긴 깊이로 테스트만 한다. 뒤의 디버그 패스가 이어 읽으므로 내용과 레이아웃을 그대로 둔다.
+	VkAttachmentDescription& depthAttachment = attachments[2];
+	depthAttachment.format = depthFormat;
+	depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	const std::array<VkAttachmentReference, 2> colorRefs = { {
+		{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
+		{1, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL}
+	} };
+	const VkAttachmentReference depthRef = { 2, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL };
+
+	VkSubpassDescription subpass{};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = static_cast<uint32_t>(colorRefs.size());
+	subpass.pColorAttachments = colorRefs.data();
+	subpass.pDepthStencilAttachment = &depthRef;
+
+	std::array<VkSubpassDependency, 2> dependencies = {};
+
+	// 포워드 패스의 깊이 쓰기가 끝난 뒤 테스트한다. 지난 프레임 합성 패스가 누적 타겟을 다 읽은 뒤 지운다.
+	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[0].dstSubpass = 0;
+	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	dependencies[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependencies[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+	// 합성 패스가 누적 타겟을 샘플링한다.
+	dependencies[1].srcSubpass = 0;
+	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	VkRenderPassCreateInfo renderPassInfo = vkb::initializers::render_pass_create_info();
+	renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+	renderPassInfo.pAttachments = attachments.data();
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+	renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+	renderPassInfo.pDependencies = dependencies.data();
+	VK_CHECK_RESULT(vkCreateRenderPass(*device, &renderPassInfo, nullptr, &accumulationRenderPass));
+}
+
+void WeightedBlendedOIT::createTargets(VkExtent2D extent, VkFormat sceneColorFormat, VkImageView depthView, const std::vector<VkImageView>& sceneColorViews)
+{
+	destroyTargets();
+
+	const VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	accumulation = engine->createImage(extent.width, extent.height, 1, VK_SAMPLE_COUNT_1_BIT, AccumulationFormat, VK_IMAGE_TILING_OPTIMAL,
+		usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, "OIT_Accumulation");
+	accumulation->imageView = engine->createImageView(accumulation->image, AccumulationFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+	weight = engine->createImage(extent.width, extent.height, 1, VK_SAMPLE_COUNT_1_BIT, WeightFormat, VK_IMAGE_TILING_OPTIMAL,
+		usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, "OIT_Weight");
+	weight->imageView = engine->createImageView(weight->image, WeightFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+
+	std::array<VkDescriptorImageInfo, 2> imageInfos = {
+		vkb::initializers::descriptor_image_info(sampler, accumulation->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+		vkb::initializers::descriptor_image_info(sampler, weight->imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+	};
+	std::array<VkWriteDescriptorSet, 2> writes = {
+		vkb::initializers::write_descriptor_set(set, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 0, &imageInfos[0]),
+		vkb::initializers::write_descriptor_set(set, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, &imageInfos[1])
+	};
+	vkUpdateDescriptorSets(*device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+	std::array<VkImageView, 3> accumulationAttachments = { accumulation->imageView, weight->imageView, depthView };
+	VkFramebufferCreateInfo framebufferInfo = vkb::initializers::framebuffer_create_info();
+	framebufferInfo.renderPass = accumulationRenderPass;
+	framebufferInfo.attachmentCount = static_cast<uint32_t>(accumulationAttachments.size());
+	framebufferInfo.pAttachments = accumulationAttachments.data();
+	framebufferInfo.width = extent.width;
+	framebufferInfo.height = extent.height;
+	framebufferInfo.layers = 1;
+	VK_CHECK_RESULT(vkCreateFramebuffer(*device, &framebufferInfo, nullptr, &accumulationFramebuffer));
+
+	createResolveRenderPass(sceneColorFormat);
+	createResolvePipeline();
+
+	resolveFramebuffers.resize(sceneColorViews.size());
+	for (size_t i = 0; i < sceneColorViews.size(); i++)
+	{
+		framebufferInfo.renderPass = resolveRenderPass;
+		framebufferInfo.attachmentCount = 1;
+		framebufferInfo.pAttachments = &sceneColorViews[i];
+		VK_CHECK_RESULT(vkCreateFramebuffer(*device, &framebufferInfo, nullptr, &resolveFramebuffers[i]));
+	}
+
+	LOG(Log, "Weighted blended OIT : {}x{} accumulation targets", extent.width, extent.height);
+}
+
+void WeightedBlendedOIT::createResolveRenderPass(VkFormat sceneColorFormat)
+{
+	// 라이팅, 포워드 패스가 그린 장면 색 위에 블렌딩한다. 뒤의 패스들을 위해 COLOR_ATTACHMENT_OPTIMAL 로 둔다.
+	VkAttachmentDescription colorAttachment{};
+	colorAttachment.format = sceneColorFormat;
+	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference colorRef{ 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+
+	VkSubpassDescription subpass{};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &colorRef;
+
+	VkSubpassDependency dependency{};
+	dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependency.dstSubpass = 0;
+	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+	VkRenderPassCreateInfo renderPassInfo = vkb::initializers::render_pass_create_info();
+	renderPassInfo.attachmentCount = 1;
+	renderPassInfo.pAttachments = &colorAttachment;
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+	renderPassInfo.dependencyCount = 1;
+	renderPassInfo.pDependencies = &dependency;
+	VK_CHECK_RESULT(vkCreateRenderPass(*device, &renderPassInfo, nullptr, &resolveRenderPass));
+}
+
+void WeightedBlendedOIT::createResolvePipeline()
+{
+	// 화면을 덮는 삼각형 하나. 라이팅 패스의 버텍스 셰이더를 그대로 쓴다.
+	VkPipelineVertexInputStateCreateInfo vertexInputState = vkb::initializers::pipeline_vertex_input_state_create_info();
+	VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = vkb::initializers::pipeline_input_assembly_state_create_info(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, 0, VK_FALSE);
+	VkPipelineRasterizationStateCreateInfo rasterizationState = vkb::initializers::pipeline_rasterization_state_create_info(VK_POLYGON_MODE_FILL, VK_CULL_MODE_NONE, VK_FRONT_FACE_COUNTER_CLOCKWISE, 0);
+	VkPipelineMultisampleStateCreateInfo multisampleState = vkb::initializers::pipeline_multisample_state_create_info(VK_SAMPLE_COUNT_1_BIT, 0);
+	VkPipelineViewportStateCreateInfo viewportState = vkb::initializers::pipeline_viewport_state_create_info(1, 1, 0);
+	std::vector<VkDynamicState> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	VkPipelineDynamicStateCreateInfo dynamicState = vkb::initializers::pipeline_dynamic_state_create_info(dynamicStates);
+	VkPipelineDepthStencilStateCreateInfo depthStencilState = vkb::initializers::pipeline_depth_stencil_state_create_info(VK_FALSE, VK_FALSE, VK_COMPARE_OP_ALWAYS);
+
+	// 평균 색을 (1 - 투과율) 만큼 덮는다. 장면 색의 알파는 건드리지 않는다.
+	VkPipelineColorBlendAttachmentState blendAttachmentState = vkb::initializers::pipeline_color_blend_attachment_state(0xf, VK_TRUE);
+	blendAttachmentState.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+	blendAttachmentState.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	blendAttachmentState.colorBlendOp = VK_BLEND_OP_ADD;
+	blendAttachmentState.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+	blendAttachmentState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	blendAttachmentState.alphaBlendOp = VK_BLEND_OP_ADD;
+	VkPipelineColorBlendStateCreateInfo colorBlendState = vkb::initializers::pipeline_color_blend_state_create_info(1, &blendAttachmentState);
+
+	VkShaderModule vertexShader = Utils::loadShader("shaders/LightingPassvert.spv", *device);
+	VkShaderModule fragmentShader = Utils::loadShader("shaders/OITResolvefrag.spv", *device);
+	std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages{};
+	shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	shaderStages[0].module = vertexShader;
+	shaderStages[0].pName = "main";
+	shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	shaderStages[1].module = fragmentShader;
+	shaderStages[1].pName = "main";
+
+	VkGraphicsPipelineCreateInfo pipelineInfo = vkb::initializers::pipeline_create_info(resolvePipelineLayout, resolveRenderPass);
+	pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+	pipelineInfo.pStages = shaderStages.data();
+	pipelineInfo.pVertexInputState = &vertexInputState;
+	pipelineInfo.pInputAssemblyState = &inputAssemblyState;
+	pipelineInfo.pRasterizationState = &rasterizationState;
+	pipelineInfo.pMultisampleState = &multisampleState;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pDepthStencilState = &depthStencilState;
+	pipelineInfo.pColorBlendState = &colorBlendState;
+	pipelineInfo.pDynamicState = &dynamicState;
+	VK_CHECK_RESULT(vkCreateGraphicsPipelines(*device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &resolvePipeline));
+
+	vkDestroyShaderModule(*device, vertexShader, nullptr);
+	vkDestroyShaderModule(*device, fragmentShader, nullptr);
+}
+
+void WeightedBlendedOIT::destroyTargets()
+{
+	if (!hasTargets())
+	{
+		return;
+	}
+
+	for (VkFramebuffer framebuffer : resolveFramebuffers)
+	{
+		vkDestroyFramebuffer(*device, framebuffer, nullptr);
+	}
+	resolveFramebuffers.clear();
+	vkDestroyPipeline(*device, resolvePipeline, nullptr);
+	vkDestroyRenderPass(*device, resolveRenderPass, nullptr);
+	vkDestroyFramebuffer(*device, accumulationFramebuffer, nullptr);
+	resolvePipeline = VK_NULL_HANDLE;
+	resolveRenderPass = VK_NULL_HANDLE;
+	accumulationFramebuffer = VK_NULL_HANDLE;
+	accumulation.reset();
+	weight.reset();
+}
+
+void WeightedBlendedOIT::cleanup()
+{
+	if (!isInitialized())
+	{
+		return;
+	}
+
+	destroyTargets();
+	vkDestroySampler(*device, sampler, nullptr);
+	vkDestroyPipelineLayout(*device, resolvePipelineLayout, nullptr);
+	vkDestroyDescriptorPool(*device, descriptorPool, nullptr);
+	vkDestroyDescriptorSetLayout(*device, setLayout, nullptr);
+	vkDestroyRenderPass(*device, accumulationRenderPass, nullptr);
+	sampler = VK_NULL_HANDLE;
+	resolvePipelineLayout = VK_NULL_HANDLE;
+	descriptorPool = VK_NULL_HANDLE;
+	setLayout = VK_NULL_HANDLE;
+	set = VK_NULL_HANDLE;
+	accumulationRenderPass = VK_NULL_HANDLE;
+}
+
+void WeightedBlendedOIT::beginAccumulation(VkCommandBuffer commandBuffer, VkExtent2D renderExtent)
+{
+	// 누적 색은 0, 투과율은 1 (아무것도 가리지 않음), 가중치 합은 0 에서 시작한다.
+	std::array<VkClearValue, 3> clearValues{};
+	clearValues[0].color = { { 0.f, 0.f, 0.f, 1.f } };
+	clearValues[1].color = { { 0.f, 0.f, 0.f, 0.f } };
+	clearValues[2].depthStencil = { 1.f, 0 };
+
+	VkRenderPassBeginInfo renderPassInfo = vkb::initializers::render_pass_begin_info();
+	renderPassInfo.renderPass = accumulationRenderPass;
+	renderPassInfo.framebuffer = accumulationFramebuffer;
+	renderPassInfo.renderArea.offset = { 0, 0 };
+	renderPassInfo.renderArea.extent = renderExtent;
+	renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+	renderPassInfo.pClearValues = clearValues.data();
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+	VkViewport viewport = vkb::initializers::viewport(static_cast<float>(renderExtent.width), static_cast<float>(renderExtent.height), 0.f, 1.f);
+	VkRect2D scissor = vkb::initializers::rect2D(renderExtent.width, renderExtent.height, 0, 0);
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+}
+
+void WeightedBlendedOIT::endAccumulation(VkCommandBuffer commandBuffer)
+{
+	vkCmdEndRenderPass(commandBuffer);
+}
+
+void WeightedBlendedOIT::recordResolve(VkCommandBuffer commandBuffer, uint32_t imageIndex, VkExtent2D renderExtent)
+{
+	GPUMarker Marker(commandBuffer, "OIT Resolve");
+
+	VkRenderPassBeginInfo renderPassInfo = vkb::initializers::render_pass_begin_info();
+	renderPassInfo.renderPass = resolveRenderPass;
+	renderPassInfo.framebuffer = resolveFramebuffers[imageIndex];
+	renderPassInfo.renderArea.offset = { 0, 0 };
+	renderPassInfo.renderArea.extent = renderExtent;
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+	VkViewport viewport = vkb::initializers::viewport(static_cast<float>(renderExtent.width), static_cast<float>(renderExtent.height), 0.f, 1.f);
+	VkRect2D scissor = vkb::initializers::rect2D(renderExtent.width, renderExtent.height, 0, 0);
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, resolvePipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, resolvePipelineLayout, 0, 1, &set, 0, nullptr);
+	vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+
+	vkCmdEndRenderPass(commandBuffer);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "vk_types.h"
+
+#include <vector>
+
+class VulkanTutorialExtension;
+
+/**
+ * 반투명 드로우를 정렬하지 않고 그리는 Weighted Blended Order-Independent Transparency. (McGuire & Bavoil 2013)
+ *
+ * 포워드 패스가 끝난 뒤 누적 패스에서 반투명 면마다 깊이 가중치를 곱한 프리멀티플라이 색과 알파를 더하고, 투과율을 곱한다.
+ * 깊이는 읽기만 하므로 불투명 면 뒤의 반투명은 걸러지고 반투명끼리는 순서와 상관없이 섞인다. 합성 패스가 평균 색을
+ * (1 - 투과율) 만큼 장면 색 위에 블렌딩한다. 결과가 드로우 순서와 무관하므로 반투명 목록은 깊이 대신 머티리얼로 묶는다.
+ *
+ * 누적 타겟 두 장이 같은 블렌딩 상태를 쓰도록 투과율은 누적 색의 알파 채널에, 가중치 합은 두 번째 타겟에 담는다.
+ * 그래서 independentBlend 기능이 필요 없다. 타겟은 스왑체인 크기로 만들고 renderExtent 만큼만 쓴다.
+ */
+class WeightedBlendedOIT
+{
+public:
+	static constexpr VkFormat AccumulationFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+	static constexpr VkFormat WeightFormat = VK_FORMAT_R16_SFLOAT;
+
+	// 켜고 끄면 스왑체인을 다시 만들 때 누적 타겟을 만들거나 지운다.
+	static bool enabled;
+
+	// 누적 렌더 패스와 합성 파이프라인 레이아웃을 한번 만든다. 반투명 머티리얼 파이프라인보다 먼저 불러야 한다.
+	void initialize(VulkanTutorialExtension* inEngine, VkFormat depthFormat);
+	// 스왑체인 크기의 누적 타겟과 합성 렌더 패스, 파이프라인, 프레임버퍼를 만든다.
+	// sceneColorViews 는 스왑체인 이미지마다 합성할 장면 색이다.
+	void createTargets(VkExtent2D extent, VkFormat sceneColorFormat, VkImageView depthView, const std::vector<VkImageView>& sceneColorViews);
+	void destroyTargets();
+	void cleanup();
+
+	// 깊이는 DEPTH_STENCIL_ATTACHMENT_OPTIMAL 이어야 하고 그대로 돌려놓는다. 사이에 반투명 드로우를 기록한다.
+	void beginAccumulation(VkCommandBuffer commandBuffer, VkExtent2D renderExtent);
+	void endAccumulation(VkCommandBuffer commandBuffer);
+	// 장면 색은 COLOR_ATTACHMENT_OPTIMAL 이어야 하고 그대로 남는다.
+	void recordResolve(VkCommandBuffer commandBuffer, uint32_t imageIndex, VkExtent2D renderExtent);
+
+	VkRenderPass getAccumulationRenderPass() const { return accumulationRenderPass; }
+	bool hasTargets() const { return accumulation != nullptr; }
+	bool isInitialized() const { return accumulationRenderPass != VK_NULL_HANDLE; }
+
+private:
+	void createAccumulationRenderPass(VkFormat depthFormat);
+	void createResolveRenderPass(VkFormat sceneColorFormat);
+	void createResolvePipeline();
+
+	VulkanTutorialExtension* engine = nullptr;
+	DevicePtr device;
+
+	VkRenderPass accumulationRenderPass = VK_NULL_HANDLE;
+	VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+	VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+	VkDescriptorSet set = VK_NULL_HANDLE;
+	VkPipelineLayout resolvePipelineLayout = VK_NULL_HANDLE;
+	VkSampler sampler = VK_NULL_HANDLE;
+
+	// 스왑체인을 다시 만들 때마다 다시 만든다.
+	std::shared_ptr<AllocatedImage> accumulation;
+	std::shared_ptr<AllocatedImage> weight;
+	VkFramebuffer accumulationFramebuffer = VK_NULL_HANDLE;
+	VkRenderPass resolveRenderPass = VK_NULL_HANDLE;
+	VkPipeline resolvePipeline = VK_NULL_HANDLE;
+	std::vector<VkFramebuffer> resolveFramebuffers;
+};
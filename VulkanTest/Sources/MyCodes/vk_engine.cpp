@@ -4,6 +4,8 @@
 #include "VulkanTools.h"
 #include "VulkanTutorialExtension.h"
 #include "vk_resource_utils.h"
+#include "GPUResourcePools.h"
+#include "MeshLod.h"
 
 namespace vkinit = vkb::initializers;
 
@@ -11,8 +13,6 @@ void GLTFMetallic_Roughness::build_pipelines(VulkanTutorialExtension* extendedEn
 {
 	/** Opaque Pipeline - deferred shading */
 
-	const VkExtent2D swapchainExtent = extendedEngine->getSwapchainExtent();
-
 	VkPushConstantRange matrixRange{};
 	matrixRange.offset = 0;
 	matrixRange.size = sizeof(GPUDrawPushConstants);
@@ -51,27 +51,31 @@ void GLTFMetallic_Roughness::build_pipelines(VulkanTutorialExtension* extendedEn
 	VkPipelineRasterizationStateCreateInfo rasterizationState = vkinit::pipeline_rasterization_state_create_info(VK_POLYGON_MODE_FILL, VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE, 0);
 	VkPipelineMultisampleStateCreateInfo multisampleState = vkinit::pipeline_multisample_state_create_info(VK_SAMPLE_COUNT_1_BIT, 0);
 	VkPipelineDepthStencilStateCreateInfo depthStencilState = vkinit::pipeline_depth_stencil_state_create_info(VK_TRUE, VK_TRUE, VK_COMPARE_OP_LESS_OR_EQUAL);
+	// 불투명 파이프라인은 그린 픽셀에 스텐실을 남긴다. 라이팅 패스가 스텐실로 배경을 건너뛴다.
+	VkPipelineDepthStencilStateCreateInfo geometryDepthStencilState = depthStencilState;
+	VulkanTutorial::GeometryPass::writeStencil(geometryDepthStencilState);
 	
 	VkGraphicsPipelineCreateInfo pipelineCI = vkinit::pipeline_create_info(newLayout, extendedEngine->geometry.renderPass);
+	pipelineCI.subpass = extendedEngine->geometry.subpass;
 	pipelineCI.pInputAssemblyState = &inputAssemblyState;
 	pipelineCI.pRasterizationState = &rasterizationState;
 	pipelineCI.pMultisampleState = &multisampleState;
 	pipelineCI.pViewportState = &viewportState;
-	pipelineCI.pDepthStencilState = &depthStencilState;
+	pipelineCI.pDepthStencilState = &geometryDepthStencilState;
 
 	// Viewport
-	VkViewport viewport = vkinit::viewport((float)swapchainExtent.width, (float)swapchainExtent.height, 0.f, 1.f);
-	VkRect2D scissor = vkinit::rect2D(swapchainExtent.width, swapchainExtent.height, 0, 0);
-	viewportState.pViewports = &viewport;
-	viewportState.pScissors = &scissor;
+	// 동적 해상도에서 그리는 영역이 매 프레임 바뀌므로 드로우를 녹화할 때 정한다.
+	std::vector<VkDynamicState> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	VkPipelineDynamicStateCreateInfo dynamicState = vkinit::pipeline_dynamic_state_create_info(dynamicStates);
+	pipelineCI.pDynamicState = &dynamicState;
 
 	// ColorBlending
+	// G-buffer : normal, albedo + ao, roughness + metallic, emissive
 	std::vector<VkPipelineColorBlendAttachmentState> blendAttachmentStates =
 	{
 		vkinit::pipeline_color_blend_attachment_state(0xf, VK_FALSE),
 		vkinit::pipeline_color_blend_attachment_state(0xf, VK_FALSE),
 		vkinit::pipeline_color_blend_attachment_state(0xf, VK_FALSE),
-		vkinit::pipeline_color_blend_attachment_state(0xf, VK_FALSE),
 		vkinit::pipeline_color_blend_attachment_state(0xf, VK_FALSE)
 	};
 
@@ -114,24 +118,97 @@ void GLTFMetallic_Roughness::build_pipelines(VulkanTutorialExtension* extendedEn
 
 	VK_CHECK_RESULT(vkCreateGraphicsPipelines(extendedEngine->getDevice(), VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &opaquePipeline.pipeline));
 
+	/** Opaque Pipeline - GPU driven (IndirectDrawPass) */
+
+	{
+		// 드로우마다 push constant 를 넣을 수 없으므로 모델 행렬은 firstInstance 로 드로우 레코드에서 찾는다.
+		std::vector<VkDescriptorSetLayoutBinding> drawDataBindings;
+		vk::desc::createDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, drawDataBindings);
+		drawDataLayout = vk::desc::createDescriptorSetLayout(extendedEngine->getDevice(), drawDataBindings);
+
+		std::array<VkDescriptorSetLayout, 3> indirectLayouts = { extendedEngine->getGlobalDescriptorSetLayout(), materialLayout, drawDataLayout };
+		VkPipelineLayoutCreateInfo indirectLayoutInfo = vkinit::pipeline_layout_create_info(indirectLayouts.size());
+		indirectLayoutInfo.pSetLayouts = indirectLayouts.data();
+		VK_CHECK_RESULT(vkCreatePipelineLayout(extendedEngine->getDevice(), &indirectLayoutInfo, nullptr, &indirectOpaquePipeline.layout));
+
+		VkShaderModule indirectVertexShader = Utils::loadShader("shaders/shaderIndirectvert.spv", extendedEngine->getDevice());
+		shaderStages[0].module = indirectVertexShader;
+		pipelineCI.layout = indirectOpaquePipeline.layout;
+
+		VK_CHECK_RESULT(vkCreateGraphicsPipelines(extendedEngine->getDevice(), VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &indirectOpaquePipeline.pipeline));
+
+		shaderStages[0].module = meshVertexShader;
+		vkDestroyShaderModule(extendedEngine->getDevice(), indirectVertexShader, nullptr);
+	}
+
+	/** Opaque Pipeline - instanced (DrawInstancing) */
+
+	{
+		// 버텍스 속성 뒤에 binding 1 의 인스턴스 행렬을 붙인다. 레이아웃은 opaquePipeline 과 같다.
+		std::vector<VkVertexInputBindingDescription> instancedBindings = bindingDescriptions;
+		Instance::getBindingDescriptions(instancedBindings);
+
+		std::vector<VkVertexInputAttributeDescription> instancedAttributes = attributeDescriptions;
+		Instance::getAttributeDescriptions(instancedAttributes, static_cast<uint32_t>(attributeDescriptions.size()));
+
+		VkPipelineVertexInputStateCreateInfo instancedVertexInput = vertexInputInfo;
+		instancedVertexInput.vertexBindingDescriptionCount = static_cast<uint32_t>(instancedBindings.size());
+		instancedVertexInput.vertexAttributeDescriptionCount = static_cast<uint32_t>(instancedAttributes.size());
+		instancedVertexInput.pVertexBindingDescriptions = instancedBindings.data();
+		instancedVertexInput.pVertexAttributeDescriptions = instancedAttributes.data();
+
+		VkShaderModule instancedVertexShader = Utils::loadShader("shaders/shaderInstancedvert.spv", extendedEngine->getDevice());
+		shaderStages[0].module = instancedVertexShader;
+		pipelineCI.pVertexInputState = &instancedVertexInput;
+		pipelineCI.layout = newLayout;
+
+		VK_CHECK_RESULT(vkCreateGraphicsPipelines(extendedEngine->getDevice(), VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &instancedOpaquePipeline.pipeline));
+		instancedOpaquePipeline.layout = newLayout;
+		opaquePipeline.instanced = &instancedOpaquePipeline;
+
+		/** Opaque Pipeline - depth equal (DepthPrepass) */
+
+		// 프리패스가 같은 식(invariant gl_Position)으로 깊이를 채웠으므로 EQUAL 로 맨 앞 면만 셰이딩한다. 스텐실은 그대로 남긴다.
+		VkPipelineDepthStencilStateCreateInfo depthEqualState = geometryDepthStencilState;
+		depthEqualState.depthWriteEnable = VK_FALSE;
+		depthEqualState.depthCompareOp = VK_COMPARE_OP_EQUAL;
+		pipelineCI.pDepthStencilState = &depthEqualState;
+
+		VK_CHECK_RESULT(vkCreateGraphicsPipelines(extendedEngine->getDevice(), VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &depthEqualInstancedPipeline.pipeline));
+		depthEqualInstancedPipeline.layout = newLayout;
+		instancedOpaquePipeline.depthEqual = &depthEqualInstancedPipeline;
+
+		shaderStages[0].module = meshVertexShader;
+		pipelineCI.pVertexInputState = &vertexInputInfo;
+
+		VK_CHECK_RESULT(vkCreateGraphicsPipelines(extendedEngine->getDevice(), VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &depthEqualOpaquePipeline.pipeline));
+		depthEqualOpaquePipeline.layout = newLayout;
+		opaquePipeline.depthEqual = &depthEqualOpaquePipeline;
+
+		pipelineCI.pDepthStencilState = &geometryDepthStencilState;
+		vkDestroyShaderModule(extendedEngine->getDevice(), instancedVertexShader, nullptr);
+	}
+
 	/** Translucent Pipeline - forward shading */
 
 	pipelineCI = vkinit::pipeline_create_info(newLayout, extendedEngine->forward.renderPass);
+	pipelineCI.subpass = extendedEngine->forward.subpass;
 	pipelineCI.pInputAssemblyState = &inputAssemblyState;
 	pipelineCI.pRasterizationState = &rasterizationState;
 	pipelineCI.pMultisampleState = &multisampleState;
 	pipelineCI.pViewportState = &viewportState;
 	pipelineCI.pDepthStencilState = &depthStencilState;
 	pipelineCI.pVertexInputState = &vertexInputInfo;
+	pipelineCI.pDynamicState = &dynamicState;
 
 	{
 		VkPipelineColorBlendAttachmentState blendAttachmentState = vkinit::pipeline_color_blend_attachment_state(VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT, VK_TRUE);
-		blendAttachmentState.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;  // ҽ   
-		blendAttachmentState.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;  //    
-		blendAttachmentState.colorBlendOp = VK_BLEND_OP_ADD;  //   
-		blendAttachmentState.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;  // ҽ   
-		blendAttachmentState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;  //    
-		blendAttachmentState.alphaBlendOp = VK_BLEND_OP_ADD;  //   
+		blendAttachmentState.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;  // 소스 색상 블렌딩 팩터
+		blendAttachmentState.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;  // 대상 색상 블렌딩 팩터
+		blendAttachmentState.colorBlendOp = VK_BLEND_OP_ADD;  // 색상 블렌딩 연산
+		blendAttachmentState.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;  // 소스 알파 블렌딩 팩터
+		blendAttachmentState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;  // 대상 알파 블렌딩 팩터
+		blendAttachmentState.alphaBlendOp = VK_BLEND_OP_ADD;  // 알파 블렌딩 연산
 		
 		VkPipelineColorBlendStateCreateInfo colorBlendState = vkinit::pipeline_color_blend_state_create_info(1, &blendAttachmentState);
 		pipelineCI.pColorBlendState = &colorBlendState;
@@ -147,6 +224,39 @@ void GLTFMetallic_Roughness::build_pipelines(VulkanTutorialExtension* extendedEn
 
 	VK_CHECK_RESULT(vkCreateGraphicsPipelines(extendedEngine->getDevice(), VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &transparentPipeline.pipeline));
 
+	/** Translucent Pipeline - weighted blended OIT */
+
+	{
+		pipelineCI.renderPass = extendedEngine->weightedBlendedOIT.getAccumulationRenderPass();
+		pipelineCI.subpass = 0;
+
+		// 불투명 깊이로 테스트만 한다. 반투명끼리는 서로 가리지 않고 모두 더해진다.
+		VkPipelineDepthStencilStateCreateInfo oitDepthStencilState = vkinit::pipeline_depth_stencil_state_create_info(VK_TRUE, VK_FALSE, VK_COMPARE_OP_LESS_OR_EQUAL);
+		pipelineCI.pDepthStencilState = &oitDepthStencilState;
+
+		// 두 첨부물이 같은 상태를 쓴다. 색은 더하고, 알파(누적 타겟의 투과율)는 (1 - alpha) 를 곱한다.
+		VkPipelineColorBlendAttachmentState blendAttachmentState = vkinit::pipeline_color_blend_attachment_state(VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT, VK_TRUE);
+		blendAttachmentState.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+		blendAttachmentState.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+		blendAttachmentState.colorBlendOp = VK_BLEND_OP_ADD;
+		blendAttachmentState.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+		blendAttachmentState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+		blendAttachmentState.alphaBlendOp = VK_BLEND_OP_ADD;
+		std::array<VkPipelineColorBlendAttachmentState, 2> oitBlendAttachmentStates = { blendAttachmentState, blendAttachmentState };
+		VkPipelineColorBlendStateCreateInfo oitColorBlendState = vkinit::pipeline_color_blend_state_create_info(oitBlendAttachmentStates.size(), oitBlendAttachmentStates.data());
+		pipelineCI.pColorBlendState = &oitColorBlendState;
+
+		VkShaderModule oitFragShader = Utils::loadShader("shaders/ForwardPassOITfrag.spv", extendedEngine->getDevice());
+		shaderStages[1].module = oitFragShader;
+
+		VK_CHECK_RESULT(vkCreateGraphicsPipelines(extendedEngine->getDevice(), VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &weightedBlendedPipeline.pipeline));
+		weightedBlendedPipeline.layout = newLayout;
+		transparentPipeline.weightedBlended = &weightedBlendedPipeline;
+
+		shaderStages[1].module = meshFragShader;
+		vkDestroyShaderModule(extendedEngine->getDevice(), oitFragShader, nullptr);
+	}
+
 	vkDestroyShaderModule(extendedEngine->getDevice(), meshFragShader, nullptr);
 	vkDestroyShaderModule(extendedEngine->getDevice(), meshVertexShader, nullptr);
 }
@@ -155,29 +265,41 @@ void GLTFMetallic_Roughness::clear_resources(VkDevice device)
 {	
 	vkDestroyPipeline(device, opaquePipeline.pipeline, nullptr);
 	vkDestroyPipeline(device, transparentPipeline.pipeline, nullptr);
+	vkDestroyPipeline(device, weightedBlendedPipeline.pipeline, nullptr);
+	vkDestroyPipeline(device, indirectOpaquePipeline.pipeline, nullptr);
+	vkDestroyPipeline(device, instancedOpaquePipeline.pipeline, nullptr);
+	vkDestroyPipeline(device, depthEqualOpaquePipeline.pipeline, nullptr);
+	vkDestroyPipeline(device, depthEqualInstancedPipeline.pipeline, nullptr);
 
 	vkDestroyPipelineLayout(device, opaquePipeline.layout, nullptr);
+	vkDestroyPipelineLayout(device, indirectOpaquePipeline.layout, nullptr);
 
 	vkDestroyDescriptorSetLayout(device, materialLayout, nullptr);
+	vkDestroyDescriptorSetLayout(device, drawDataLayout, nullptr);
+}
+
+GLTFMetallic_Roughness::Material::~Material()
+{
+	GPUResourcePools::get().releaseMaterial(materialInstances);
 }
 
-std::shared_ptr<MaterialInstance> GLTFMetallic_Roughness::write_material(VulkanTutorialExtension* engine, MaterialPass pass, const MaterialResources& resources, VkDescriptorPool descriptorPool)
+MaterialHandle GLTFMetallic_Roughness::write_material(VulkanTutorialExtension* engine, MaterialPass pass, const MaterialResources& resources, VkDescriptorPool descriptorPool)
 {
-	std::shared_ptr<MaterialInstance> matData = std::make_shared<MaterialInstance>();
-	matData->passType = pass;
+	MaterialInstance matData;
+	matData.passType = pass;
 	if (pass == MaterialPass::Transparent) {
-		matData->pipeline = &transparentPipeline;
+		matData.pipeline = &transparentPipeline;
 	}
 	else {
-		matData->pipeline = &opaquePipeline;
+		matData.pipeline = &opaquePipeline;
 	}
 
 	int swapChainImageNum = engine->getSwapchainImageNum();
 
 	std::vector<VkDescriptorSetLayout> layouts(swapChainImageNum, materialLayout);
 	VkDescriptorSetAllocateInfo allocInfo = vkinit::descriptor_set_allocate_info(descriptorPool, layouts.data(), layouts.size());
-	matData->materialSet.resize(swapChainImageNum);
-	VK_CHECK_RESULT(vkAllocateDescriptorSets(engine->getDevice(), &allocInfo, matData->materialSet.data()));
+	matData.materialSet.resize(swapChainImageNum);
+	VK_CHECK_RESULT(vkAllocateDescriptorSets(engine->getDevice(), &allocInfo, matData.materialSet.data()));
 
 	std::vector<VkWriteDescriptorSet> writeDescriptorSets;
 
@@ -232,20 +354,20 @@ std::shared_ptr<MaterialInstance> GLTFMetallic_Roughness::write_material(VulkanT
 	for (size_t i = 0; i < swapChainImageNum; i++)
 	{
 		writeDescriptorSets = {
-			vkinit::write_descriptor_set(matData->materialSet[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &bufDescriptor),
-			vkinit::write_descriptor_set(matData->materialSet[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, &texDescriptorColor),
-			vkinit::write_descriptor_set(matData->materialSet[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2, &texDescriptorMetalRough),
-			vkinit::write_descriptor_set(matData->materialSet[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 3, &NormalTexDescriptor),
-			vkinit::write_descriptor_set(matData->materialSet[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4, &MetallicTexDescriptor),
-			vkinit::write_descriptor_set(matData->materialSet[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 5, &RoughnessTexDescriptor),
-			vkinit::write_descriptor_set(matData->materialSet[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 6, &AOTexDescriptor),
-			vkinit::write_descriptor_set(matData->materialSet[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 7, &emissiveTexDescriptor),
+			vkinit::write_descriptor_set(matData.materialSet[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &bufDescriptor),
+			vkinit::write_descriptor_set(matData.materialSet[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, &texDescriptorColor),
+			vkinit::write_descriptor_set(matData.materialSet[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2, &texDescriptorMetalRough),
+			vkinit::write_descriptor_set(matData.materialSet[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 3, &NormalTexDescriptor),
+			vkinit::write_descriptor_set(matData.materialSet[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4, &MetallicTexDescriptor),
+			vkinit::write_descriptor_set(matData.materialSet[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 5, &RoughnessTexDescriptor),
+			vkinit::write_descriptor_set(matData.materialSet[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 6, &AOTexDescriptor),
+			vkinit::write_descriptor_set(matData.materialSet[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 7, &emissiveTexDescriptor),
 		};
 
 		vkUpdateDescriptorSets(engine->getDevice(), static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, nullptr);
 	}
 
-	return matData;
+	return GPUResourcePools::get().materials.create(std::move(matData));
 }
 
 std::shared_ptr<GLTFMetallic_Roughness::Material> GLTFMetallic_Roughness::create_material_resources(VulkanTutorialExtension* engine,
@@ -273,30 +395,78 @@ std::shared_ptr<GLTFMetallic_Roughness::Material> GLTFMetallic_Roughness::create
 	return resourcesPtr;
 }
 
-void MeshNode::Draw(const glm::mat4& topMatrix, DrawContext& ctx)
+void DrawContext::reset(FrameArena* arena)
 {
-	glm::mat4 nodeMatrix = topMatrix * worldTransform;
+	const size_t opaqueCount = OpaqueSurfaces.size();
+	const size_t translucentCount = TranslucentSurfaces.size();
+
+	OpaqueSurfaces = FrameVector<RenderObject>(ArenaAllocator<RenderObject>(arena));
+	TranslucentSurfaces = FrameVector<RenderObject>(ArenaAllocator<RenderObject>(arena));
+	OpaqueSurfaces.reserve(opaqueCount);
+	TranslucentSurfaces.reserve(translucentCount);
+}
 
-	for (auto& s : mesh->surfaces) {
-		RenderObject def;
-		def.indexCount = s.count;
-		def.firstIndex = s.startIndex;
-		def.vertexBuffer = mesh->meshBuffers.vertexBuffer.Buffer;
-		def.indexBuffer = mesh->meshBuffers.indexBuffer.Buffer;
-		def.material = s.material->data;
-		def.transform = nodeMatrix;
+bool DrawContext::addSurface(const MeshAsset<Vertex>& mesh, const GeoSurface& surface, const glm::mat4& transform, uint64_t lodKey)
+{
+	const MaterialInstance* material = GPUResourcePools::get().materials.get(surface.material);
+	if (!material)
+	{
+		return false;
+	}
 
-		if (s.material->data->passType == MaterialPass::MainColor)
-		{
-			ctx.OpaqueSurfaces.push_back(def);
-		}
-		else if (s.material->data->passType == MaterialPass::Transparent)
+	RenderObject def;
+	def.indexCount = surface.count;
+	def.firstIndex = surface.startIndex;
+	def.vertexBuffer = mesh.meshBuffers.vertexBuffer.Buffer;
+	def.indexBuffer = mesh.meshBuffers.indexBuffer.Buffer;
+	def.positionBuffer = mesh.positionBuffer;
+	def.material = surface.material;
+	def.transform = transform;
+	def.bounds = surface.bounds;
+
+	// LOD 는 같은 버퍼 안의 인덱스 구간만 다르다.
+	if (lodSelector)
+	{
+		if (const SurfaceLod* lod = lodSelector->select(lodKey, surface, transform))
 		{
-			ctx.TranslucentSurfaces.push_back(def);
+			def.indexCount = lod->count;
+			def.firstIndex = lod->startIndex;
 		}
-		else
+	}
+
+	if (material->passType == MaterialPass::MainColor)
+	{
+		OpaqueSurfaces.push_back(def);
+	}
+	else if (material->passType == MaterialPass::Transparent)
+	{
+		TranslucentSurfaces.push_back(def);
+	}
+	else
+	{
+		std::runtime_error("cannot be in here!");
+	}
+	return true;
+}
+
+void MeshNode::Draw(const glm::mat4& topMatrix, DrawContext& ctx)
+{
+	glm::mat4 nodeMatrix = topMatrix * worldTransform;
+
+	GPUResourcePools& pools = GPUResourcePools::get();
+	const MeshAsset<Vertex>* meshAsset = pools.meshes.get(mesh);
+	if (!meshAsset)
+	{
+		LOG(Warning, "MeshNode has a stale mesh handle (index {}, generation {})", mesh.index, mesh.generation);
+		Node::Draw(topMatrix, ctx);
+		return;
+	}
+
+	for (uint32_t s = 0; s < meshAsset->surfaces.size(); s++) {
+		const uint64_t lodKey = ctx.lodSelector ? MeshLod::makeSelectionKey(ctx.instanceIndex, static_cast<const Node*>(this), s) : 0;
+		if (!ctx.addSurface(*meshAsset, meshAsset->surfaces[s], nodeMatrix, lodKey))
 		{
-			std::runtime_error("cannot be in here!");
+			LOG(Warning, "surface of mesh {} has a stale material handle", meshAsset->name);
 		}
 	}
 
@@ -3,17 +3,32 @@
 #include "vk_types.h"
 #include "Vertex.h"
 #include "UniformBuffer.h"
+#include "FrameAllocator.h"
 
 #include <unordered_map>
 
 template<typename T>
 struct MeshAsset;
+struct GeoSurface;
+class MeshLodSelector;
+
+using MeshHandle = Handle<MeshAsset<Vertex>>;
 
 struct GLTFMetallic_Roughness {
 	MaterialPipeline opaquePipeline;
 	MaterialPipeline transparentPipeline;
+	// opaquePipeline 과 같지만 모델 행렬을 set 2 의 드로우 레코드에서 읽는다. (IndirectDrawPass)
+	MaterialPipeline indirectOpaquePipeline;
+	// opaquePipeline 의 인스턴싱 변형. 모델 행렬을 binding 1 의 Instance 에서 읽는다. (DrawInstancing)
+	MaterialPipeline instancedOpaquePipeline;
+	// transparentPipeline 의 OIT 변형. 깊이를 쓰지 않고 누적 타겟 두 장에 더한다. (WeightedBlendedOIT)
+	MaterialPipeline weightedBlendedPipeline;
+	// opaquePipeline, instancedOpaquePipeline 의 깊이 EQUAL 변형. 깊이 프리패스 뒤의 지오메트리 패스가 쓴다. (DepthPrepass)
+	MaterialPipeline depthEqualOpaquePipeline;
+	MaterialPipeline depthEqualInstancedPipeline;
 
 	VkDescriptorSetLayout materialLayout;
+	VkDescriptorSetLayout drawDataLayout;
 
 	struct MaterialConstants {
 		glm::vec4 colorFactors = glm::vec4(1.f);
@@ -25,7 +40,7 @@ struct GLTFMetallic_Roughness {
 	};
 
 
-	//  
+	// 소유권 없음
 	struct MaterialResources {
 		std::shared_ptr<AllocatedImage> colorImage;
 		std::shared_ptr<AllocatedImage> metalRoughImage;
@@ -48,37 +63,72 @@ struct GLTFMetallic_Roughness {
 			constants = UniformBuffer<GLTFMetallic_Roughness::MaterialConstants>::create();
 			resources = {};
 		}
+		~Material();
+
 		std::shared_ptr<UniformBuffer<GLTFMetallic_Roughness::MaterialConstants>> constants;
 		GLTFMetallic_Roughness::MaterialResources resources;
-		std::shared_ptr<MaterialInstance> materialInstances;
+		MaterialHandle materialInstances;
 	};
 
 	void build_pipelines(class VulkanTutorialExtension* engine);
 	void clear_resources(VkDevice device);
 
-	std::shared_ptr<MaterialInstance> write_material(VulkanTutorialExtension* engine, MaterialPass pass, const MaterialResources& resources, VkDescriptorPool descriptorPool);
+	MaterialHandle write_material(VulkanTutorialExtension* engine, MaterialPass pass, const MaterialResources& resources, VkDescriptorPool descriptorPool);
 	std::shared_ptr<GLTFMetallic_Roughness::Material> create_material_resources(VulkanTutorialExtension* engine, std::shared_ptr<AllocatedImage>& color, std::shared_ptr<AllocatedImage>& normal, std::shared_ptr<AllocatedImage>& metallic, std::shared_ptr<AllocatedImage>& roughness, std::shared_ptr<AllocatedImage>& AO, glm::vec4 textureFlags);
 };
 
+// 메시 로컬 공간의 경계. sphereRadius 가 음수면 경계를 모르는 것이므로 컬링하지 않는다.
+struct Bounds {
+	glm::vec3 origin = glm::vec3(0.f);
+	float sphereRadius = -1.f;
+	glm::vec3 extents = glm::vec3(0.f);
+};
+
 struct RenderObject {
 	uint32_t indexCount;
 	uint32_t firstIndex;
 	VkBuffer vertexBuffer;
 	VkBuffer indexBuffer;
 
-	std::shared_ptr<MaterialInstance> material;
+	// 위치만 담은 정점 스트림. 그림자 패스가 쓰며 VK_NULL_HANDLE 이면 그림자를 드리우지 않는다.
+	VkBuffer positionBuffer = VK_NULL_HANDLE;
+
+	// 핸들만 복사하므로 드로우 리스트를 만들 때 참조 카운트를 건드리지 않는다.
+	MaterialHandle material;
 
 	glm::mat4 transform;
+	Bounds bounds;
+
+	// 2 이상이면 DrawInstancing 이 합친 드로우다. 모델 행렬은 프레임 인스턴스 버퍼의 [firstInstance, firstInstance + instanceCount) 에 있고,
+	// transform 은 첫 인스턴스의 것이다.
+	uint32_t instanceCount = 1;
+	uint32_t firstInstance = 0;
+
+	// DrawSorting 이 채운다. 작은 키부터 그린다.
+	uint64_t sortKey = 0;
 };
 
 struct DrawContext {
-	std::vector<RenderObject> OpaqueSurfaces;
-	std::vector<RenderObject> TranslucentSurfaces;
+	// 매 프레임 다시 만드는 목록이라 프레임 arena 에서 받는다.
+	FrameVector<RenderObject> OpaqueSurfaces;
+	FrameVector<RenderObject> TranslucentSurfaces;
+
+	// 목록을 arena 위에 새로 만든다. 지난 프레임 개수만큼 미리 잡아 두어 채우는 도중 다시 할당하지 않게 한다.
+	void reset(FrameArena* arena);
+
+	// 있으면 addSurface 가 서피스 LOD 를 고른다. reset 으로 지워지지 않는다.
+	MeshLodSelector* lodSelector = nullptr;
+	// 지금 그리는 LoadedGLTFInstance 번호. LOD 선택 키에 들어간다.
+	uint32_t instanceIndex = 0;
+
+	// 서피스 하나를 머티리얼 패스에 맞는 목록에 넣는다. 머티리얼이 없어졌으면 넣지 않고 false 를 반환한다.
+	// lodKey 는 MeshLod::makeSelectionKey 로 만든 값이고, 0 이면 지난 프레임 LOD 를 보지 않고 고른다.
+	bool addSurface(const MeshAsset<Vertex>& mesh, const GeoSurface& surface, const glm::mat4& transform, uint64_t lodKey = 0);
 };
 
 struct MeshNode : public Node {
 
-	std::shared_ptr<MeshAsset<Vertex>> mesh;
+	MeshHandle mesh;
 
 	virtual void Draw(const glm::mat4& topMatrix, DrawContext& ctx) override;
 };
\ No newline at end of file
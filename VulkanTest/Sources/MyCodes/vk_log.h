@@ -6,7 +6,7 @@
 enum LogLevel { Log, Display, Warning, Error };
 extern LogLevel currentLevel;
 
-// Լ 
+// 함수 선언
 void SetConsoleColor(unsigned short color);
 void OutputToDebugConsole(const std::string& message);
 
@@ -31,21 +31,21 @@ void LogMessage(LogLevel level, const char* fmt, Args&&... args) {
     std::string message = FormatString(fmt, std::forward<Args>(args)...);
     std::string fullMessage = "[" + std::string(levelNames[level]) + "] " + message;
 
-    // Visual Studio Output â 
+    // Visual Studio Output 창에 출력
     OutputToDebugConsole(fullMessage);
 
-    // DISPLAY  ̻ ֿܼ 
+    // DISPLAY 레벨 이상은 콘솔에도 출력
     if (level >= Display) {
-        //  
+        // 색상 설정
         if (level == Warning) {
-            SetConsoleColor(6); //  (Windows.h  )
+            SetConsoleColor(6); // 노란색 (Windows.h 상수 없이)
         }
         else if (level == Error) {
-            SetConsoleColor(4); //  (Windows.h  )
+            SetConsoleColor(4); // 빨간색 (Windows.h 상수 없이)
         }
         std::cout << fullMessage << std::endl;
-        //  
-        SetConsoleColor(7); // ⺻ 
+        // 색상 원래대로
+        SetConsoleColor(7); // 기본 색상
     }
 }
 
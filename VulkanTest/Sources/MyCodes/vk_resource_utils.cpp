@@ -35,7 +35,7 @@ namespace Utils {
     fastgltf::Expected<fastgltf::GltfDataBuffer> loadModel(const std::string_view& filePath)
     {
         std::filesystem::path modelPath = Utils::GetProjectRoot() / std::string(filePath);
-        // std::filesystem::path::preferred_separator Ͽ ý ⺻ ڷ ȯ
+        // std::filesystem::path::preferred_separator를 사용하여 시스템 기본 구분자로 변환
         std::string pathStr = modelPath.string();
         for (char& c : pathStr) {
             if (c == '\\') c = '/';
@@ -13,6 +13,8 @@
 #include <vector>
 #include <memory>
 
+#include "ResourcePool.h"
+
 class DeviceWrapper {
 public:
 	DeviceWrapper(VkDevice device, VkInstance instance, VkDebugUtilsMessengerEXT debugMessenger, VkSurfaceKHR surface, GLFWwindow* window) 
@@ -25,8 +27,8 @@ public:
 
 	~DeviceWrapper();
 
-	// ٽ:  ȯ ڰ VkDevice ϴ   
-	// DeviceWrapper ڵ VkDevice ȯǵ մϴ
+	// 핵심: 이 변환 연산자가 VkDevice를 기대하는 모든 곳에서 
+	// DeviceWrapper가 자동으로 VkDevice로 변환되도록 합니다
 	operator VkDevice() const { return device; }
 
 private:
@@ -50,15 +52,23 @@ struct MaterialPipeline
 {
 	VkPipeline pipeline;
 	VkPipelineLayout layout;
+	// 같은 레이아웃으로 binding 1 의 Instance 행렬을 읽는 변형. 없으면 인스턴싱하지 않는다.
+	MaterialPipeline* instanced = nullptr;
+	// 같은 레이아웃으로 WeightedBlendedOIT 누적 패스에 그리는 변형. 반투명 파이프라인만 가진다.
+	MaterialPipeline* weightedBlended = nullptr;
+	// 같은 레이아웃으로 깊이 프리패스가 채운 깊이에 EQUAL 로 테스트하고 깊이를 쓰지 않는 변형. 불투명 파이프라인만 가진다.
+	MaterialPipeline* depthEqual = nullptr;
 };
 
 struct MaterialInstance
 {
-	MaterialPipeline* pipeline; //  
+	MaterialPipeline* pipeline; // 소유권 없음
 	std::vector<VkDescriptorSet> materialSet;
 	MaterialPass passType;
 };
 
+using MaterialHandle = Handle<MaterialInstance>;
+
 struct DrawContext;
 
 // base class for a renderable dynamic object
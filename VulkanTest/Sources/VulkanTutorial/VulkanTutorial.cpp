@@ -79,6 +79,7 @@ VulkanTutorial::VulkanTutorial()
 		setupSurface();
 		pickPhysicalDevice();
 		createLogicalDevice();
+		transientAttachmentHeap.initialize(device, physicalDevice);
 		createSwapchain();
 		createImageViews();
 		createRenderPass();
@@ -393,8 +394,41 @@ VulkanTutorial::VulkanTutorial()
 			queueCreateInfos.push_back(queueCreateInfo);
 		}
 
+		VkPhysicalDeviceFeatures supportedFeatures;
+		vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
 		VkPhysicalDeviceFeatures deviceFeatures{};
 		deviceFeatures.samplerAnisotropy = VK_TRUE;
+		deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+		deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+		optionalDeviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect == VK_TRUE;
+		optionalDeviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance == VK_TRUE;
+		deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+		optionalDeviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery == VK_TRUE;
+		deviceFeatures.inheritedQueries = supportedFeatures.inheritedQueries;
+		optionalDeviceFeatures.inheritedQueries = supportedFeatures.inheritedQueries == VK_TRUE;
+
+		uint32_t extensionCount;
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+		std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+
+		std::vector<const char*> enabledExtensions = deviceExtensions;
+		for (const char* optionalExtension : optionalDeviceExtensions)
+		{
+			for (const VkExtensionProperties& extension : availableExtensions)
+			{
+				if (strcmp(extension.extensionName, optionalExtension) == 0)
+				{
+					enabledExtensions.push_back(optionalExtension);
+					if (strcmp(optionalExtension, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME) == 0)
+					{
+						optionalDeviceFeatures.drawIndirectCount = true;
+					}
+					break;
+				}
+			}
+		}
 
 		VkDeviceCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -410,8 +444,8 @@ VulkanTutorial::VulkanTutorial()
 			createInfo.enabledLayerCount = 0;
 		}
 
-		createInfo.enabledExtensionCount = static_cast<int32_t>(deviceExtensions.size());
-		createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+		createInfo.enabledExtensionCount = static_cast<int32_t>(enabledExtensions.size());
+		createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
 		VkDevice newDevice;
 
@@ -484,6 +518,7 @@ VulkanTutorial::VulkanTutorial()
 		vkGetSwapchainImagesKHR(*device, swapChain, &imageCount, swapChainImages.data());
 
 		swapChainExtent = surfaceExtent;
+		renderExtent = surfaceExtent;
 		swapChainImageFormat = surfaceFormat.format;
 	}
 
@@ -518,7 +553,9 @@ VulkanTutorial::VulkanTutorial()
 	{
 		updateUniformBuffer(imageIndex);
 		clearCommandBuffers();
-		addCommandBuffer(commandBuffers[imageIndex]);
+		// 매 프레임 녹화하는 경우 버퍼는 drawFrame 에서 제출 직전에 채운다.
+		submitFrameCommandBuffer = recordCommandsEveryFrame;
+		addCommandBuffer(submitFrameCommandBuffer ? frameCommandBuffers[currentFrame] : commandBuffers[imageIndex]);
 	}
 
 	void VulkanTutorial::postDrawFrame(uint32_t imageIndex)
@@ -712,6 +749,18 @@ VulkanTutorial::VulkanTutorial()
 		colorAttachmentResolveRef.attachment = 2;
 		colorAttachmentResolveRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
+		// 지오메트리 패스의 깊이를 읽기 전용으로 붙인다. 스텐실 테스트로 배경 픽셀을 건너뛰고, 셰이더도 같은 깊이를 샘플링한다.
+		VkAttachmentDescription lightingDepthAttachment = depthAttachment;
+		lightingDepthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		lightingDepthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		lightingDepthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+		lightingDepthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		lightingDepthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+		VkAttachmentReference lightingDepthAttachmentRef{};
+		lightingDepthAttachmentRef.attachment = 1;
+		lightingDepthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
 		VkSubpassDescription subpass{};
 		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 		subpass.colorAttachmentCount = 1;
@@ -719,6 +768,8 @@ VulkanTutorial::VulkanTutorial()
 		/*subpass.pDepthStencilAttachment = &depthAttachmentRef;*/
 #if USE_MSAA
 		subpass.pResolveAttachments = &colorAttachmentResolveRef;
+#else
+		subpass.pDepthStencilAttachment = &lightingDepthAttachmentRef;
 #endif
 		VkSubpassDependency dependency{};
 		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
@@ -731,7 +782,7 @@ VulkanTutorial::VulkanTutorial()
 #if USE_MSAA
 		std::array<VkAttachmentDescription, 3> attachments = { colorAttachment, depthAttachment, colorAttachmentResolve };
 #else
-		std::array<VkAttachmentDescription, 1/*2*/> attachments = { colorAttachment/*, depthAttachment*/ };
+		std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, lightingDepthAttachment };
 #endif
 		VkRenderPassCreateInfo renderPassInfo{};
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -746,6 +797,16 @@ VulkanTutorial::VulkanTutorial()
 			throw std::runtime_error("failed to create render pass!");
 		}
 
+		// 라이팅 렌더 패스는 디버그 패스와 텍스처 뷰어가 계속 쓴다. 나머지 둘은 단일 렌더 패스의 서브패스가 대신한다.
+		if (singlePass.enabled && msaaSamples == VK_SAMPLE_COUNT_1_BIT)
+		{
+			createSinglePassRenderPass();
+			return;
+		}
+		geometry.subpass = 0;
+		lightingPass.subpass = 0;
+		forward.subpass = 0;
+
 		/*
 		 * Create a render pass for forward rendering
 		 */
@@ -771,8 +832,16 @@ VulkanTutorial::VulkanTutorial()
 		 * Create a render pass for deferred rendering (Basepass)
 		 */ 
 
-		// pos, normal, albedo, arm
-		std::array<VkAttachmentDescription, 5> colorAttachments = {};
+		/*
+		 * 픽셀당 바이트 (깊이 D32 포함)
+		 * 이전: position RGBA16F 8 + normal RGBA16F 8 + albedo 4 + arm 4 + emissive 4 + depth 4 = 32
+		 * 지금: normal RG16F 4 + albedo/ao 4 + roughness/metallic RG8 2 + emissive R11G11B10 4 + depth 4 = 18
+		 * 월드 위치는 깊이에서 복원하고, 법선은 팔면체 인코딩으로 두 채널에 담는다.
+		 */
+		geometry.emissiveFormat = findEmissiveFormat();
+
+		// normal, albedo + ao, roughness + metallic, emissive
+		std::array<VkAttachmentDescription, 4> colorAttachments = {};
 		for (VkAttachmentDescription& colorAttachment : colorAttachments)
 		{
 			colorAttachment.samples = msaaSamples;
@@ -784,22 +853,23 @@ VulkanTutorial::VulkanTutorial()
 			colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 		}
 
-		colorAttachments[0].format = VK_FORMAT_R16G16B16A16_SFLOAT;
-		colorAttachments[1].format = VK_FORMAT_R16G16B16A16_SFLOAT;
-		colorAttachments[2].format = VK_FORMAT_R8G8B8A8_UNORM;
-		colorAttachments[3].format = VK_FORMAT_R8G8B8A8_UNORM;
-		colorAttachments[4].format = VK_FORMAT_R8G8B8A8_UNORM;
+		colorAttachments[0].format = VK_FORMAT_R16G16_SFLOAT;
+		colorAttachments[1].format = VK_FORMAT_R8G8B8A8_UNORM;
+		colorAttachments[2].format = VK_FORMAT_R8G8_UNORM;
+		colorAttachments[3].format = geometry.emissiveFormat;
 
-		std::array<VkAttachmentReference, 5> colorAttachmentRefs = { {
+		std::array<VkAttachmentReference, 4> colorAttachmentRefs = { {
 			{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
 			{1, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
 			{2, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
-			{3, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
-			{4, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL}
+			{3, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL}
 		} };
 
 		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
 		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		// 그린 픽셀의 스텐실을 남겨 라이팅 패스가 배경을 건너뛰게 한다.
+		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
 
 		depthAttachmentRef.attachment = colorAttachments.size();
 
@@ -808,8 +878,8 @@ VulkanTutorial::VulkanTutorial()
 		subpass.pDepthStencilAttachment = &depthAttachmentRef;
 		subpass.pResolveAttachments = nullptr;
 
-		std::array<VkAttachmentDescription, 6> DeferredAttachments =
-		{ colorAttachments[0], colorAttachments[1], colorAttachments[2], colorAttachments[3], colorAttachments[4], depthAttachment };
+		std::array<VkAttachmentDescription, 5> DeferredAttachments =
+		{ colorAttachments[0], colorAttachments[1], colorAttachments[2], colorAttachments[3], depthAttachment };
 
 		renderPassInfo.attachmentCount = static_cast<uint32_t>(DeferredAttachments.size());
 		renderPassInfo.pAttachments = DeferredAttachments.data();
@@ -818,6 +888,168 @@ VulkanTutorial::VulkanTutorial()
 		if (vkCreateRenderPass(*device, &renderPassInfo, nullptr, &geometry.renderPass) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create geometry render pass!");
 		}
+
+		// 같은 프레임버퍼에 이어 그리는 지오메트리 패스. 첨부물을 지우지 않고 불러온다.
+		for (VkAttachmentDescription& attachment : DeferredAttachments)
+		{
+			attachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+			if (attachment.stencilLoadOp == VK_ATTACHMENT_LOAD_OP_CLEAR)
+			{
+				attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+			}
+			attachment.initialLayout = attachment.finalLayout;
+		}
+
+		if (vkCreateRenderPass(*device, &renderPassInfo, nullptr, &geometry.loadRenderPass) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create geometry load render pass!");
+		}
+
+		// 깊이 프리패스 뒤의 지오메트리 패스. G-buffer 는 처음처럼 지우고 깊이와 스텐실만 불러온다.
+		for (uint32_t attachment = 0; attachment < colorAttachments.size(); attachment++)
+		{
+			DeferredAttachments[attachment] = colorAttachments[attachment];
+		}
+
+		if (vkCreateRenderPass(*device, &renderPassInfo, nullptr, &geometry.depthLoadRenderPass) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create geometry depth load render pass!");
+		}
+	}
+
+	void VulkanTutorial::createSinglePassRenderPass()
+	{
+		geometry.emissiveFormat = findEmissiveFormat();
+
+		// 0~3 G-buffer, 4 깊이, 5 스왑체인. G-buffer 순서는 지오메트리 렌더 패스와 같다.
+		std::array<VkAttachmentDescription, 6> attachments = {};
+		const std::array<VkFormat, 4> gbufferFormats = { VK_FORMAT_R16G16_SFLOAT, VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_R8G8_UNORM, geometry.emissiveFormat };
+		for (size_t a = 0; a < gbufferFormats.size(); a++)
+		{
+			// 라이팅 서브패스가 읽고 나면 필요 없으므로 저장하지 않는다. 레이아웃만 분리된 패스와 같게 끝낸다.
+			VkAttachmentDescription& attachment = attachments[a];
+			attachment.format = gbufferFormats[a];
+			attachment.samples = msaaSamples;
+			attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+			attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			attachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		}
+
+		// 디버그 패스가 깊이를 읽으므로 저장한다.
+		VkAttachmentDescription& depthAttachment = attachments[4];
+		depthAttachment.format = findDepthFormat();
+		depthAttachment.samples = msaaSamples;
+		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentDescription& colorAttachment = attachments[5];
+		colorAttachment.format = swapChainImageFormat;
+		colorAttachment.samples = msaaSamples;
+		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+		const std::array<VkAttachmentReference, 4> gbufferOutputRefs = { {
+			{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
+			{1, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
+			{2, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
+			{3, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL}
+		} };
+		const VkAttachmentReference depthWriteRef = { 4, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+		// 깊이는 스텐실 테스트용 첨부물이면서 input attachment 다. 둘 다 읽기 전용 레이아웃이어야 한다.
+		const VkAttachmentReference depthReadRef = { 4, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL };
+		const VkAttachmentReference colorRef = { 5, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+
+		// input_attachment_index 순서. deferred.glsl 의 GBUFFER_SUBPASS_INPUT 선언과 같아야 한다.
+		const std::array<VkAttachmentReference, 5> gbufferInputRefs = { {
+			depthReadRef,
+			{0, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
+			{1, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
+			{2, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
+			{3, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL}
+		} };
+
+		std::array<VkSubpassDescription, 3> subpasses = {};
+		for (VkSubpassDescription& subpass : subpasses)
+		{
+			subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		}
+
+		VkSubpassDescription& geometrySubpass = subpasses[SinglePass::GeometrySubpass];
+		geometrySubpass.colorAttachmentCount = static_cast<uint32_t>(gbufferOutputRefs.size());
+		geometrySubpass.pColorAttachments = gbufferOutputRefs.data();
+		geometrySubpass.pDepthStencilAttachment = &depthWriteRef;
+
+		VkSubpassDescription& lightingSubpass = subpasses[SinglePass::LightingSubpass];
+		lightingSubpass.inputAttachmentCount = static_cast<uint32_t>(gbufferInputRefs.size());
+		lightingSubpass.pInputAttachments = gbufferInputRefs.data();
+		lightingSubpass.colorAttachmentCount = 1;
+		lightingSubpass.pColorAttachments = &colorRef;
+		lightingSubpass.pDepthStencilAttachment = &depthReadRef;
+
+		// 반투명 드로우가 깊이를 쓰므로 다시 쓰기 레이아웃으로 붙인다.
+		VkSubpassDescription& forwardSubpass = subpasses[SinglePass::ForwardSubpass];
+		forwardSubpass.colorAttachmentCount = 1;
+		forwardSubpass.pColorAttachments = &colorRef;
+		forwardSubpass.pDepthStencilAttachment = &depthWriteRef;
+
+		std::array<VkSubpassDependency, 3> dependencies = {};
+
+		dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[0].dstSubpass = SinglePass::GeometrySubpass;
+		dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		dependencies[0].srcAccessMask = 0;
+		dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+		// 같은 픽셀만 읽으므로 BY_REGION 으로 충분하다. 타일 기반 GPU 는 이 의존성을 타일 안에서 처리한다.
+		dependencies[1].srcSubpass = SinglePass::GeometrySubpass;
+		dependencies[1].dstSubpass = SinglePass::LightingSubpass;
+		dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		dependencies[1].dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+		dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+		// 라이팅 결과 위에 블렌딩하고, 읽기 전용이던 깊이에 다시 쓴다.
+		dependencies[2].srcSubpass = SinglePass::LightingSubpass;
+		dependencies[2].dstSubpass = SinglePass::ForwardSubpass;
+		dependencies[2].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		dependencies[2].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		dependencies[2].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[2].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[2].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+		VkRenderPassCreateInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+		renderPassInfo.pAttachments = attachments.data();
+		renderPassInfo.subpassCount = static_cast<uint32_t>(subpasses.size());
+		renderPassInfo.pSubpasses = subpasses.data();
+		renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+		renderPassInfo.pDependencies = dependencies.data();
+
+		if (vkCreateRenderPass(*device, &renderPassInfo, nullptr, &singlePass.renderPass) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create single deferred render pass!");
+		}
+
+		// 지오메트리, 포워드 파이프라인은 이 렌더 패스의 서브패스로 만들어진다. 이어 그리는 지오메트리 패스는 없다.
+		geometry.renderPass = singlePass.renderPass;
+		geometry.loadRenderPass = VK_NULL_HANDLE;
+		geometry.depthLoadRenderPass = VK_NULL_HANDLE;
+		forward.renderPass = singlePass.renderPass;
+		geometry.subpass = SinglePass::GeometrySubpass;
+		lightingPass.subpass = SinglePass::LightingSubpass;
+		forward.subpass = SinglePass::ForwardSubpass;
 	}
 
 	void VulkanTutorial::createDescriptorSetLayout(std::vector<VkDescriptorSetLayoutBinding>& bindings, VkDescriptorSetLayout* outDescriptorSetLayout)
@@ -897,7 +1129,7 @@ VulkanTutorial::VulkanTutorial()
 #if USE_MSAA
 			std::array<VkImageView, 3> attachments = { colorImageView, depthImageView, swapChainImageViews[i] };
 #else
-			std::array<VkImageView, 1> attachments = { swapChainImageViews[i] };
+			std::array<VkImageView, 2> attachments = { getSceneColorView(i), depth->imageView };
 #endif
 
 			framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
@@ -909,12 +1141,35 @@ VulkanTutorial::VulkanTutorial()
 			}
 		}
 
+		if (isSinglePassDeferred())
+		{
+			singlePass.frameBuffers.resize(swapChainImageViews.size());
+			geometry.frameBuffer = VK_NULL_HANDLE;
+			forward.frameBuffers.clear();
+
+			for (size_t i = 0; i < swapChainImageViews.size(); i++)
+			{
+				std::array<VkImageView, 6> singlePassAttachments =
+				{ geometry.normal->imageView, geometry.albedo->imageView, geometry.material->imageView, geometry.emissive->imageView, depth->imageView, getSceneColorView(i) };
+
+				framebufferInfo.renderPass = singlePass.renderPass;
+				framebufferInfo.attachmentCount = static_cast<uint32_t>(singlePassAttachments.size());
+				framebufferInfo.pAttachments = singlePassAttachments.data();
+
+				if (vkCreateFramebuffer(*device, &framebufferInfo, nullptr, &singlePass.frameBuffers[i]) != VK_SUCCESS)
+				{
+					throw std::runtime_error("failed to create single pass framebuffer!");
+				}
+			}
+			return;
+		}
+
 		/**
 		* For GeometryPass
 		*/
 
-		std::array<VkImageView, 6> attachments = 
-		{ geometry.position->imageView, geometry.normal->imageView, geometry.albedo->imageView, geometry.arm->imageView, geometry.emissive->imageView, depth->imageView };
+		std::array<VkImageView, 5> attachments = 
+		{ geometry.normal->imageView, geometry.albedo->imageView, geometry.material->imageView, geometry.emissive->imageView, depth->imageView };
 
 		framebufferInfo.renderPass = geometry.renderPass;
 		framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
@@ -933,7 +1188,7 @@ VulkanTutorial::VulkanTutorial()
 
 		for (size_t i = 0; i < swapChainImageViews.size(); i++)
 		{
-			std::array<VkImageView, 2> forwardAttachments = { swapChainImageViews[i],depth->imageView };
+			std::array<VkImageView, 2> forwardAttachments = { getSceneColorView(i),depth->imageView };
 
 			framebufferInfo.renderPass = forward.renderPass;
 			framebufferInfo.attachmentCount = static_cast<uint32_t>(forwardAttachments.size());
@@ -959,46 +1214,91 @@ VulkanTutorial::VulkanTutorial()
 		{
 			throw std::runtime_error("failed to create command pool");
 		}
+
+		// 매 프레임 다시 녹화하는 버퍼는 개별 리셋 대신 풀을 통째로 리셋한다.
+		createInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		frameCommandPools.resize(MAX_FRAMES_IN_FLIGHT);
+		frameCommandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			if (vkCreateCommandPool(*device, &createInfo, nullptr, &frameCommandPools[i]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create frame command pool");
+			}
+
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = frameCommandPools[i];
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandBufferCount = 1;
+
+			if (vkAllocateCommandBuffers(*device, &allocInfo, &frameCommandBuffers[i]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to allocate frame command buffer.");
+			}
+		}
 	}
 
 	void VulkanTutorial::createColorResources()
 	{
 		VkFormat colorFormat = swapChainImageFormat;
 
-		//   Ÿ ǰ (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT)
-		// ߿ ̴ ø˴ϴ(VK_IMAGE_USAGE_SAMPLED_BIT)
-		// VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT Ư 뵵, ̹ Ͱ  н  Ͻ ʿϰ ߿  ʿ䰡   ˴ϴ. 
-		geometry.position = createImage(swapChainExtent.width, swapChainExtent.height, 1, msaaSamples, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, "Gbuffer_Position");
-		geometry.position->imageView = createImageView(geometry.position->image, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, 1);
-
-		geometry.normal = createImage(swapChainExtent.width, swapChainExtent.height, 1, msaaSamples, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, "Gbuffer_Normal");
-		geometry.normal->imageView = createImageView(geometry.normal->image, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, 1);
-
-		geometry.albedo = createImage(swapChainExtent.width, swapChainExtent.height, 1, msaaSamples, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, "Gbuffer_Albedo");
+		// 먼저 렌더 타겟으로 사용되고 (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT)
+		// 나중에 쉐이더에서 샘플링됩니다(VK_IMAGE_USAGE_SAMPLED_BIT)
+		// VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT는 특별한 용도로, 이미지 데이터가 렌더 패스 내에서만 일시적으로 필요하고 나중에 접근할 필요가 없을 때 사용됩니다. 
+		// 분리된 렌더 패스에서는 라이팅 패스가 샘플링하므로 TRANSIENT 를 붙일 수 없다. 대신 G-buffer 네 장을 한 블록에 모아
+		// 첫 프레임 전에만 쓰이는 이미지(IBL 베이크 소스)와 메모리를 겹쳐 쓴다. 포맷은 createRenderPass 와 같아야 한다.
+		// 단일 렌더 패스에서는 input attachment 로만 읽고 저장하지 않으므로 TRANSIENT 로 만들어 lazily allocated 메모리를 받는다.
+		const VkImageUsageFlags gbufferUsage = isSinglePassDeferred()
+			? VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT
+			: VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		const TransientAttachmentHeap::AliasGroup group = TransientAttachmentHeap::AliasGroup::GBuffer;
+
+		geometry.normal = createAliasedImage(group, swapChainExtent.width, swapChainExtent.height, 1, msaaSamples, VK_FORMAT_R16G16_SFLOAT, gbufferUsage, "Gbuffer_Normal");
+		geometry.albedo = createAliasedImage(group, swapChainExtent.width, swapChainExtent.height, 1, msaaSamples, VK_FORMAT_R8G8B8A8_UNORM, gbufferUsage, "Gbuffer_AlbedoAO");
+		geometry.material = createAliasedImage(group, swapChainExtent.width, swapChainExtent.height, 1, msaaSamples, VK_FORMAT_R8G8_UNORM, gbufferUsage, "Gbuffer_RoughnessMetallic");
+		geometry.emissive = createAliasedImage(group, swapChainExtent.width, swapChainExtent.height, 1, msaaSamples, geometry.emissiveFormat, gbufferUsage, "Gbuffer_Emissive");
+		transientAttachmentHeap.commit(group);
+
+		geometry.normal->imageView = createImageView(geometry.normal->image, VK_FORMAT_R16G16_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, 1);
 		geometry.albedo->imageView = createImageView(geometry.albedo->image, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, 1);
-
-		geometry.arm = createImage(swapChainExtent.width, swapChainExtent.height, 1, msaaSamples, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, "Gbuffer_ARM");
-		geometry.arm->imageView = createImageView(geometry.arm->image, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, 1);
-
-		geometry.emissive = createImage(swapChainExtent.width, swapChainExtent.height, 1, msaaSamples, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, "Gbuffer_Emissive");
-		geometry.emissive->imageView = createImageView(geometry.emissive->image, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+		geometry.material->imageView = createImageView(geometry.material->image, VK_FORMAT_R8G8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+		geometry.emissive->imageView = createImageView(geometry.emissive->image, geometry.emissiveFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
 	}
 
 	void VulkanTutorial::createDepthResources()
 	{
 		VkFormat depthFormat = findDepthFormat();
 
-		depth = createImage(swapChainExtent.width, swapChainExtent.height, 1, msaaSamples, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, "DepthStencil");
+		// 라이팅 패스가 깊이에서 월드 위치를 복원하고, Hi-Z 도 깊이를 읽는다. findDepthFormat 이 샘플링할 수 있는 포맷만 고른다.
+		const VkImageUsageFlags usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+
+		depth = createImage(swapChainExtent.width, swapChainExtent.height, 1, msaaSamples, depthFormat, VK_IMAGE_TILING_OPTIMAL, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, "DepthStencil");
 		depth->imageView = createImageView(depth->image, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
 		transitionImageLayout(depth->image, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, 1);
 	}
 
 	VkFormat VulkanTutorial::findDepthFormat()
 	{
+		// 스텐실이 있는 포맷을 먼저 고른다. 라이팅 패스가 스텐실로 배경 픽셀을 건너뛰고, 없으면 셰이더가 깊이로 거른다.
 		return findSupportedFormat(
-			{ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
+			{ VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT, VK_FORMAT_D32_SFLOAT },
 			VK_IMAGE_TILING_OPTIMAL,
-			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+	}
+
+	VkFormat VulkanTutorial::findEmissiveFormat()
+	{
+		// R11G11B10 은 렌더 타겟 지원이 필수가 아니다. 1 을 넘는 emissive 를 담아야 하므로 RGBA8 대신 RGBA16F 로 물러선다.
+		VkFormat format = findSupportedFormat(
+			{ VK_FORMAT_B10G11R11_UFLOAT_PACK32, VK_FORMAT_R16G16B16A16_SFLOAT },
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+		if (format != VK_FORMAT_B10G11R11_UFLOAT_PACK32)
+		{
+			LOG(Warning, "B10G11R11_UFLOAT is not a color attachment format on this device. Emissive G-buffer falls back to RGBA16F.");
+		}
+		return format;
 	}
 
 	VkFormat VulkanTutorial::findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features)
@@ -1026,12 +1326,38 @@ VulkanTutorial::VulkanTutorial()
 		return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
 	}
 
+	void VulkanTutorial::GeometryPass::writeStencil(VkPipelineDepthStencilStateCreateInfo& state)
+	{
+		state.stencilTestEnable = VK_TRUE;
+		state.front.failOp = VK_STENCIL_OP_KEEP;
+		state.front.passOp = VK_STENCIL_OP_REPLACE;
+		state.front.depthFailOp = VK_STENCIL_OP_KEEP;
+		state.front.compareOp = VK_COMPARE_OP_ALWAYS;
+		state.front.compareMask = 0xff;
+		state.front.writeMask = 0xff;
+		state.front.reference = stencilReference;
+		state.back = state.front;
+	}
+
+	void VulkanTutorial::GeometryPass::testStencil(VkPipelineDepthStencilStateCreateInfo& state)
+	{
+		state.stencilTestEnable = VK_TRUE;
+		state.front.failOp = VK_STENCIL_OP_KEEP;
+		state.front.passOp = VK_STENCIL_OP_KEEP;
+		state.front.depthFailOp = VK_STENCIL_OP_KEEP;
+		state.front.compareOp = VK_COMPARE_OP_EQUAL;
+		state.front.compareMask = 0xff;
+		state.front.writeMask = 0;
+		state.front.reference = stencilReference;
+		state.back = state.front;
+	}
+
 	void VulkanTutorial::createTextureImage()
 	{
-		//  ä Ͱ . 
-		//  -> (¡) ->    -> ε.
-		// ̹ -> ¡     -> ̹ -> ε.
-		// ̹ εؼ ¡ ۿ äִ´. 
+		// 버퍼 채우는 것과 같다. 
+		// 데이터 -> (스테이징데이터) -> 버퍼   -> 바인딩.
+		// 이미지 -> 스테이징버퍼     -> 이미지 -> 바인딩.
+		// 이미지를 로드해서 스테이징 버퍼에 채워넣는다. 
 		int texWidth, texHeight, texChannels;
 		stbi_uc* pixels = Utils::loadImage(TEXTURE_PATH.c_str(), &texWidth, &texHeight, &texChannels, Utils::STBI_rgb_alpha);
 		VkDeviceSize imageSize = texWidth * texHeight * 4;
@@ -1053,7 +1379,7 @@ VulkanTutorial::VulkanTutorial()
 
 		Utils::freeImage(pixels);
 
-		// VK_IMAGE_LAYOUT  ̹ Access mask Pipeline Stage Ѵ. 
+		// VK_IMAGE_LAYOUT에 따라서 이미지 Access mask와 Pipeline Stage를 결정한다. 
 		defaultTexture = createImage(texWidth, texHeight, mipLevels, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT /* for blit */ | VK_IMAGE_USAGE_TRANSFER_DST_BIT /* for staging buffer*/ | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, "DefaultTexture");
 		transitionImageLayout(defaultTexture->image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels);
 		copyBufferToImage(stagingBuffer, defaultTexture->image, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
@@ -1091,14 +1417,14 @@ VulkanTutorial::VulkanTutorial()
 		return createTexture2D(data, VkExtent3D{ (uint32_t)width, (uint32_t)height, 1 }, inFormat, VK_IMAGE_USAGE_SAMPLED_BIT, filePath.c_str(), 4);
 	}
 
-	std::shared_ptr<AllocatedImage> VulkanTutorial::createTexture2D(stbi_uc* inData, VkExtent3D inImageSize, VkFormat inFormat, VkImageUsageFlagBits inUsageFlag, const char* name, int channelNum)
+	std::shared_ptr<AllocatedImage> VulkanTutorial::createTexture2D(stbi_uc* inData, VkExtent3D inImageSize, VkFormat inFormat, VkImageUsageFlagBits inUsageFlag, const char* name, int channelNum, std::optional<TransientAttachmentHeap::AliasGroup> aliasGroup)
 	{
 		if (!inData)
 		{
 			return nullptr;
 		}
 
-		// Sampler maxLOD ؽ mipLevels ִ. 
+		// Sampler의 maxLOD는 텍스쳐의 mipLevels와 관련있다. 
 
 		const int bytesPerChennel = inFormat == VK_FORMAT_R32G32B32A32_SFLOAT ? sizeof(float) : 1;
 		const int bytesPerPixel = bytesPerChennel * channelNum;
@@ -1118,8 +1444,19 @@ VulkanTutorial::VulkanTutorial()
 
 		Utils::freeImage(inData);
 
-		// VK_IMAGE_LAYOUT  ̹ Access mask Pipeline Stage Ѵ. 
-		std::shared_ptr<AllocatedImage> allocatedImage = createImage(texWidth, texHeight, mipLevels, VK_SAMPLE_COUNT_1_BIT, inFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT /* for blit */ | VK_IMAGE_USAGE_TRANSFER_DST_BIT /* for staging buffer*/ | inUsageFlag, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, name);
+		// VK_IMAGE_LAYOUT에 따라서 이미지 Access mask와 Pipeline Stage를 결정한다. 
+		const VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT /* for blit */ | VK_IMAGE_USAGE_TRANSFER_DST_BIT /* for staging buffer*/ | inUsageFlag;
+		std::shared_ptr<AllocatedImage> allocatedImage;
+		if (aliasGroup)
+		{
+			// 잠깐 쓰고 버릴 텍스쳐는 다른 그룹의 렌더 타겟 메모리를 빌려 쓴다.
+			allocatedImage = createAliasedImage(*aliasGroup, texWidth, texHeight, mipLevels, VK_SAMPLE_COUNT_1_BIT, inFormat, usage, name);
+			transientAttachmentHeap.commit(*aliasGroup);
+		}
+		else
+		{
+			allocatedImage = createImage(texWidth, texHeight, mipLevels, VK_SAMPLE_COUNT_1_BIT, inFormat, VK_IMAGE_TILING_OPTIMAL, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, name);
+		}
 		transitionImageLayout(allocatedImage->image, inFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels);
 		copyBufferToImage(stagingBuffer, allocatedImage->image, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
 		//transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, mipLevels);
@@ -1146,20 +1483,20 @@ VulkanTutorial::VulkanTutorial()
 	void VulkanTutorial::transitionImageLayout(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels, uint32_t layerCount, uint32_t baseMipLevel)
 	{
 		/**
-		* ̹ ̾ƿ  ȯϴ° ?
-		* ̹ 뵵  ٸ ޸ ̾ƿ մϴ.
-		* ̾ƿ ȯ GPU ޸ 籸 ʿմϴ.
-		* 踮  ۾ Ϸ  ٸ  ̾ƿ ϰ,    ۾ ϵ մϴ.
+		* 이미지 레이아웃을 왜 전환하는가 ?
+		* 이미지는 용도에 따라 다른 메모리 레이아웃을 사용합니다.
+		* 레이아웃 전환은 GPU에서 메모리 재구성이 필요합니다.
+		* 배리어는 이전 작업이 완료될 때까지 기다린 후 레이아웃을 변경하고, 그 다음 새 작업을 시작하도록 합니다.
 		*/
 
 		VkImageMemoryBarrier barrier{};
 		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		barrier.oldLayout = oldLayout; // undefine ɾ
+		barrier.oldLayout = oldLayout; // undefine은 돈케어
 		barrier.newLayout = newLayout;
 		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 		barrier.image = image;
-		if (newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
+		if (newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL || newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL)
 		{
 			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
 			if (hasStencilComponent(format))
@@ -1177,16 +1514,16 @@ VulkanTutorial::VulkanTutorial()
 		barrier.subresourceRange.layerCount = layerCount;
 
 		/**
-		* srcAccessMask:  ̾ƿ ̹  ߴ
-		* dstAccessMask:  ̾ƿ ̹   
-		* srcStage:  ۾ Ͼ  ܰ
-		* dstStage:  ۾ Ͼ  ܰ
+		* srcAccessMask: 이전 레이아웃에서 이미지에 어떻게 접근했는지
+		* dstAccessMask: 새 레이아웃에서 이미지에 어떻게 접근할 것인지
+		* srcStage: 이전 작업이 일어나는 파이프라인 단계
+		* dstStage: 새 작업이 일어날 파이프라인 단계
 		*
-		* VK_PIPELINE_STAGE_TRANSFER_BIT̶ PipelineStage   Transfer  Ͼ psuedo stage̴.
-		* VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT ɾ.     ݵ ۵Ǿϴ  ƴϱ  ù  ִ´.
+		* VK_PIPELINE_STAGE_TRANSFER_BIT이라는 PipelineStage는 실제로 없지만 Transfer 동작이 일어나는 psuedo stage이다.
+		* VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT는 돈케어다. 동작 전에 어떤 스테이지가 반드시 시작되어야하는 것은 아니기 때문에 첫 스테이지를 넣는다.
 		*/
-		VkPipelineStageFlagBits srcStage;
-		VkPipelineStageFlagBits dstStage;
+		VkPipelineStageFlags srcStage;
+		VkPipelineStageFlags dstStage;
 		if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL ||
 			(oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL))
 		{
@@ -1209,6 +1546,21 @@ VulkanTutorial::VulkanTutorial()
 			barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 			dstStage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
 		}
+		else if (oldLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL)
+		{
+			// 라이팅 패스는 깊이를 샘플링하고, 읽기 전용 첨부물로 붙여 깊이/스텐실 테스트도 한다.
+			barrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			srcStage = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+			dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		}
+		else if (oldLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
+		{
+			barrier.srcAccessMask = 0;
+			srcStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			dstStage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		}
 		else if (oldLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
 		{
 			barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
@@ -1256,7 +1608,7 @@ VulkanTutorial::VulkanTutorial()
 		region.imageExtent = { width, height, 1 };
 
 		{
-			// VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL  ̹  ̾ƿ. ̷ ̸  ־Ѵ. 
+			// VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL는 현재 이미지가 사용중인 레이아웃. 이렇게 미리 설정 돼있어야한다. 
 			vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
 		}
 
@@ -1273,14 +1625,14 @@ VulkanTutorial::VulkanTutorial()
 			throw std::runtime_error("texture image format does not support linear blitting!");
 		}
 
-		// ׷ϱ ñѰ.. 
-		// Ŀǵ Ŀǵ ۾ȿ  ׿ Եǰ  Ǵµ..  Ŀǵ ť   ȵݾ.  . 
-		// ׷    Ŀǵ尡  ƴġ   Ŀǵ Transfer  ⸦ ٸ ִ´. 
-		// ׷  ,   Ŀǵ 鵵  ٸ Ŀǵ Transfer  ⸦ ٸ ִ´. 
-		// ׷  ù° Ŀǵ   ȵż  ɸ° ƴѰ?
+		// 그러니까 궁금한게.. 
+		// 커맨드들이 커맨드 버퍼안에 차곡차곡 쌓여서 서브밋되고 실행이 되는데.. 이 커맨드 큐잉 순서가 보장이 안되잖아. 병렬적으로 실행되지. 
+		// 그런데 만약 마지막 블릿 커맨드가 실행이 됐다치면 그 모든 커맨드들이 Transfer 스테이지 끝내기를 기다리고 있는다. 
+		// 그런데 그 전, 그 전전 커맨드 들도 마찬가지로 다른 커맨드들이 Transfer 스테이지 끝내기를 기다리고 있는다. 
+		// 그럼 그 첫번째 커맨드 또한 실행이 안돼서 데드락에 걸리는게 아닌가?
 
-		// 踮 ߰ڴٴ  ߴ
-		// n° ̹  n-1° ̹ Blit   ִٴ ͺ̴. 
+		// 배리어를 써야겠다는 생각의 발단은
+		// n번째 이미지가 써져야지 n-1번째 이미지로 Blit을 할 수 있다는 것부터이다. 
 		VkImageMemoryBarrier barrier{};
 		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
@@ -1305,20 +1657,20 @@ VulkanTutorial::VulkanTutorial()
 
 			/**
 			*  Cmd0    Cmd1    Cmd2    Cmd3    Cmd4    Cmd5    ... 
-			*	|		|		|		|		|				|		|
-			*	|		|		|		|				|		|		|
-			*	|		|		|				|		|		|		|
-			*							|		|		|		|		| Transfer Stage
+			*	|		|		|		|		|		★		|		|
+			*	|		|		|		|		★		|		|		|
+			*	|		|		|		★		|		|		|		|
+			*	★		★		★		|		|		|		|		| Transfer Stage
 			*	|		|		|		|		|		|		|		|
 			*	|		|		|		|		|		|		|		| Fragment Shader Stage	
 			*	|		|		|		|		|		|		|		|
 			* 
-			*	Ŀǵ   Ŀǵ  ǳ      ִ. 
+			*	커맨드 버퍼 안 커맨드는 순차적으로 실행되나 파이프라인 스테이지에선 병렬적으로 실행될 수 있다. 
 			* 
 			*/
 
-			//   VK_PIPELINE_STAGE_TRANSFER_BIT ܰ     GPU    Ŀǵ  VK_PIPELINE_STAGE_TRANSFER_BIT  
-			// VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT VK_ACCESS_TRANSFER_READ_BIT ٲش. 
+			// 현재 파이프라인을 VK_PIPELINE_STAGE_TRANSFER_BIT 단계 전에서 막아 놓고 현재 GPU에서 실행 중인 모든 커맨드 들이 VK_PIPELINE_STAGE_TRANSFER_BIT를 끝낼 때
+			// VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL를 VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL로, VK_ACCESS_TRANSFER_WRITE_BIT를 VK_ACCESS_TRANSFER_READ_BIT로 바꿔준다. 
 
 			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
 				0, nullptr,
@@ -1341,7 +1693,7 @@ VulkanTutorial::VulkanTutorial()
 				blit.dstSubresource.baseArrayLayer = layer;
 				blit.dstSubresource.layerCount = 1;
 
-				// Blit VK_PIPELINE_STAGE_TRANSFER_BIT ۷̴̼. Src ̹ VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL 踮 ̿ ٲ, Dst ̹ ؽ ̹   ٲ. 
+				// Blit은 VK_PIPELINE_STAGE_TRANSFER_BIT 오퍼레이션이다. Src 이미지는 VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL로 배리어 이용해 바뀌었고, Dst 이미지는 텍스쳐 이미지 만들 때 바뀌었다. 
 				vkCmdBlitImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
 			}
 			
@@ -1350,11 +1702,11 @@ VulkanTutorial::VulkanTutorial()
 			barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
 			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
-			//   VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT ܰ     GPU    Ŀǵ  VK_PIPELINE_STAGE_TRANSFER_BIT  
-			// VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_READ_BIT VK_ACCESS_SHADER_READ_BIT ٲش. 
+			// 현재 파이프라인을 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT 단계 전에서 막아 놓고 현재 GPU에서 실행 중인 모든 커맨드 들이 VK_PIPELINE_STAGE_TRANSFER_BIT를 끝낼 때
+			// VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL를 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL로, VK_ACCESS_TRANSFER_READ_BIT를 VK_ACCESS_SHADER_READ_BIT로 바꿔준다. 
 
-			// ٸ  ø ۷̼  Transition ⸦ ٸ.  Ŀǵ ƴ϶ VkImageMemoryBarrier ̹ ҽ  ɸ  Ѵ. 
-			//  ߿ barrier.subresourceRange.baseMipLevel ⿡  ɸµ.
+			// 다른 모든 샘플링 오퍼레이션은 이 Transition이 끝나기를 기다린다. 모든 커맨드들이 아니라 VkImageMemoryBarrier라면 이미지 리소스에서만 락이 걸리지 않을까 추측한다. 
+			// 그 중에서 barrier.subresourceRange.baseMipLevel 여기에 락이 걸리는듯.
 			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
 				0, nullptr,
 				0, nullptr,
@@ -1364,20 +1716,20 @@ VulkanTutorial::VulkanTutorial()
 			if (mipHeight > 1) mipHeight /= 2;
 
 			/*
-				//  ΰ vkCmdPipelineBarrier ϳ VkCmdBlitImage Ŀǵ   Ǵµ,
-				// ù° vkCmdPipelineBarrier VK_PIPELINE_STAGE_TRANSFER_BIT ְ,
-				// ι° VkCmdBlitImage (i - 1 image VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) & (i image VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)   ְ,
-				// ° vkCmdPipelineBarrier VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT ִ.
-				// ȭ    ǰԲ .
-				// ƴѵ.
+				// 이 두개의 vkCmdPipelineBarrier과 하나의 VkCmdBlitImage 커맨드는 다 각각 실행되는데,
+				// 첫번째 vkCmdPipelineBarrier는 VK_PIPELINE_STAGE_TRANSFER_BIT에서 막혀있고,
+				// 두번째 VkCmdBlitImage는 (i - 1 image가 VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) & (i image가 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) 될 때까지 막혀있고,
+				// 세번째 vkCmdPipelineBarrier는 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT에서 막혀있다.
+				// 동기화 때문에 저 순서대로 진행되게끔 만들어졌다.
+				// 아닌듯.
 
-				// Ŀǵ ΰ  ϱ?
-				//  ̹  ? ư   ׷VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT ٸٴ   Դٴ Ű
-				// ׷  ̹ ̹ VK_PIPELINE_STAGE_TRANSFER_BITܰ踦 Ѿ ̹Ƿ ̹ Blit  Ŷ   ִ°;ƴѰ?
+				// 커맨드와 파이프라인과의 관계는 무엇일까?
+				// 같은 이미지라면 같은 파이프라인?에서 돌아갈 것 같은데 그럼VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT에서 기다린다는 것은 여기까지 왔다는 거고
+				// 그럼 이 이미지는 이미 VK_PIPELINE_STAGE_TRANSFER_BIT단계를 넘었을 것이므로 이미 Blit은 진행된 거라 볼 수 있는것아닌가?
 
-				//   ̹ ٸ ο ưٸ ϳ ̹ VK_PIPELINE_STAGE_TRANSFER_BIT VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT ٸ ο ȴٴ°Ű,
-				// ׷  ο VK_PIPELINE_STAGE_TRANSFER_BIT  VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT   ִٴ ǰ?
-				//    鼭 ϴ° ƴѰ?
+				// 만약 같은 이미지가 다른 파이프라인에서 돌아간다면 하나의 이미지에 VK_PIPELINE_STAGE_TRANSFER_BIT와 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT는 다른 파이프라인에서 진행된다는거고,
+				// 그럼 한 파이프라인에 VK_PIPELINE_STAGE_TRANSFER_BIT 나 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT가 생략될 수도 있다는 건가?
+				// 파이프라인이 모든 스테이지들을 지나면서 실행하는게 아닌가?
 
 
 				 Barriers are synchronization commands; as such, they have a source scope and a destination scope, between which the barrier apples.
@@ -1388,18 +1740,18 @@ VulkanTutorial::VulkanTutorial()
 				 Again, these may be commands in the same command buffer, in subsequently submitted CBs within the same batch, or in CBs submitted in subsequent calls to vkQueueSubmit.
 
 
-				 // ù° vkCmdPipelineBarrier  Ŀǵ带 Ű  VK_PIPELINE_STAGE_TRANSFER_BIT شϴ Ŀǵ ī Ŀǵ Ȥ   Ӹ   Ŀǵ ۿ .
+				 // 첫번째 vkCmdPipelineBarrier 이 커맨드를 실행시키기 전까지 VK_PIPELINE_STAGE_TRANSFER_BIT에 해당하는 커맨드는 카피 커맨드 혹은 그 전 밉맵 레벨의 블릿 커맨드 밖에 없다.
 
-				 // ι° vkCmdPipelineBarrier Ŀǵ ۿ ִ   VK_PIPELINE_STAGE_TRANSFER_BIT   ٸ 
-				 //   Ӹ  ù° vkCmdPipelineBarrier ʿ   ƴѰ? ̰ ׳ Transition ΰ?
+				 // 두번째 vkCmdPipelineBarrier가 커맨드 버퍼에 있는 모든 파이프라인의 VK_PIPELINE_STAGE_TRANSFER_BIT이 끝날 때까지 기다리게 했으면
+				 // 그 다음 밉맵 레벨의 첫번째 vkCmdPipelineBarrier는 필요 없는 것 아닌가? 이건 그냥 Transition 용인가?
 
 				 // https://stackoverflow.com/questions/65944292/how-vulkan-pipeline-barrier-is-implemented-in-terms-of-gpu-or-its-driver
-				 // 
-				 //  Ŀǵ    µ Ư  Եȴ. ׸ Ŀǵ ۾ȿ ִ  Ŀǵ   ġ° Ǿ ִ. ׷ ȭ ʿϴ.
-				 // ù° vkCmdPipelineBarrier      ο VK_PIPELINE_STAGE_TRANSFER_BIT  ٸ,
-				 // vkCmdBlitImage Ѵ.
-				 // ׸ ι° vkCmdPipelineBarrier      ο VK_PIPELINE_STAGE_TRANSFER_BIT  ٸ.
-				 //   ù° vkCmdPipelineBarrier Blit   Ӹ ̹ ĳø Flushϰ Invalidateϱ  ġ   .
+				 // 결론
+				 // 모든 커맨드들은 각자 파이프라인의 스테이지를 지나는데 특정 스테이지만 지나게된다. 그리고 커맨드 버퍼안에 있는 각 커맨드의 스테이지들은 서로 겹치는게 허용되어 있다. 그래서 동기화가 필요하다.
+				 // 첫번째 vkCmdPipelineBarrier를 실행할 때 그 전 모든 파이프라인에서 VK_PIPELINE_STAGE_TRANSFER_BIT가 지나가길 기다리고,
+				 // vkCmdBlitImage를 실행한다.
+				 // 그리고 두번째 vkCmdPipelineBarrier를 실행할 때 그 전 모든 파이프라인에서 VK_PIPELINE_STAGE_TRANSFER_BIT가 지나가길 기다린다.
+				 // 그 다음 첫번째 vkCmdPipelineBarrier는 Blit 시작 전에 밉맵 이미지의 캐시를 Flush하고 Invalidate하기 위한 장치라고 보면될 것 같다.
 			*/
 		}
 
@@ -1415,11 +1767,8 @@ VulkanTutorial::VulkanTutorial()
 			1, &barrier);
 	}
 
-	std::shared_ptr<AllocatedImage> VulkanTutorial::createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, const char* name, uint32_t arrayLayers, VkImageViewCreateFlags flags)
+	static VkImageCreateInfo makeImageCreateInfo(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, uint32_t arrayLayers, VkImageViewCreateFlags flags)
 	{
-		std::shared_ptr<AllocatedImage> image = std::make_shared<AllocatedImage>(device);
-
-		//   ͷ ̹ . 
 		VkImageCreateInfo imageInfo{};
 		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
 		imageInfo.imageType = VK_IMAGE_TYPE_2D;
@@ -1430,11 +1779,20 @@ VulkanTutorial::VulkanTutorial()
 		imageInfo.arrayLayers = arrayLayers;
 		imageInfo.format = format;
 		imageInfo.tiling = tiling;
-		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED; // ¡ ̹ ߿ ҽ ״ ù° ƮǶ ؼ ؾѴ.  Destination.
-		imageInfo.usage = usage; // VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT; // ߿ ̴ ϴ (ø žϴ)  Ʈ ִ´. 
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED; // 스테이징 이미지라면 나중에 소스로 쓸테니 첫번째 트랜지션때 텍셀들을 보존해야한다. 지금은 Destination.
+		imageInfo.usage = usage; // VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT; // 나중에 쉐이더에서 써야하니 (샘플링 돼야하니) 샘플 비트 넣는다. 
 		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-		imageInfo.samples = numSamples; // Ƽ ø 
+		imageInfo.samples = numSamples; // 멀티 샘플링 관려
 		imageInfo.flags = flags;
+		return imageInfo;
+	}
+
+	std::shared_ptr<AllocatedImage> VulkanTutorial::createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, const char* name, uint32_t arrayLayers, VkImageViewCreateFlags flags)
+	{
+		std::shared_ptr<AllocatedImage> image = std::make_shared<AllocatedImage>(device);
+
+		// 가져온 버퍼 데이터로 이미지를 만든다. 
+		VkImageCreateInfo imageInfo = makeImageCreateInfo(width, height, mipLevels, numSamples, format, tiling, usage, arrayLayers, flags);
 
 		if (vkCreateImage(*device, &imageInfo, nullptr, &image->image) != VK_SUCCESS)
 		{
@@ -1461,6 +1819,12 @@ VulkanTutorial::VulkanTutorial()
 
 		return image;
 	}
+
+	std::shared_ptr<AllocatedImage> VulkanTutorial::createAliasedImage(TransientAttachmentHeap::AliasGroup group, uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageUsageFlags usage, const char* name)
+	{
+		VkImageCreateInfo imageInfo = makeImageCreateInfo(width, height, mipLevels, numSamples, format, VK_IMAGE_TILING_OPTIMAL, usage, 1, 0);
+		return transientAttachmentHeap.createImage(group, imageInfo, name);
+	}
 	
 	void VulkanTutorial::loadModels()
 	{
@@ -1548,11 +1912,17 @@ VulkanTutorial::VulkanTutorial()
 
 	void VulkanTutorial::createDescriptorPool()
 	{
-		std::array<VkDescriptorPoolSize, 2> poolSizes{};
+		std::array<VkDescriptorPoolSize, 4> poolSizes{};
 		poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 		poolSizes[0].descriptorCount = static_cast<uint32_t>(swapChainImages.size()) * 20;
 		poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 		poolSizes[1].descriptorCount = static_cast<uint32_t>(swapChainImages.size()) * 100;
+		// 단일 렌더 패스의 라이팅 서브패스가 G-buffer 와 깊이를 읽는다.
+		poolSizes[2].type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+		poolSizes[2].descriptorCount = static_cast<uint32_t>(swapChainImages.size()) * 5;
+		// 전역 셋의 포인트 라이트 목록. 이미지마다 하나
+		poolSizes[3].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		poolSizes[3].descriptorCount = static_cast<uint32_t>(swapChainImages.size());
 
 		VkDescriptorPoolCreateInfo poolInfo{};
 		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -1728,6 +2098,8 @@ VulkanTutorial::VulkanTutorial()
 	{
 		LOG(Log, "creating command buffer... {} ", i);
 
+		const auto start = std::chrono::steady_clock::now();
+
 		VkCommandBufferBeginInfo beginInfo{};
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 		beginInfo.flags = 0;
@@ -1745,58 +2117,128 @@ VulkanTutorial::VulkanTutorial()
 			throw std::runtime_error("failed to record command buffer!");
 		}
 
+		const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		lastRecordMilliseconds = elapsed.count();
+
 		LOG(Log, "created command buffer... {} ", i);
 	}
 
+	void VulkanTutorial::recordFrameCommandBuffer(uint32_t imageIndex)
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		// drawFrame 에서 inFlightFences[currentFrame] 을 기다렸으므로 이 슬롯의 버퍼는 GPU 에서 끝났다.
+		if (vkResetCommandPool(*device, frameCommandPools[currentFrame], 0) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to reset frame command pool!");
+		}
+
+		VkCommandBuffer commandBuffer = frameCommandBuffers[currentFrame];
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfo.pInheritanceInfo = nullptr;
+
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to begin recording command buffer!");
+		}
+
+		recordingFrameCommandBuffer = true;
+		recordCommandBuffer(commandBuffer, imageIndex);
+		recordingFrameCommandBuffer = false;
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to record command buffer!");
+		}
+
+		const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		lastRecordMilliseconds = elapsed.count();
+	}
+
+	void VulkanTutorial::setRecordCommandsEveryFrame(bool enable)
+	{
+		if (recordCommandsEveryFrame == enable)
+		{
+			return;
+		}
+		recordCommandsEveryFrame = enable;
+
+		// 매 프레임 녹화하는 동안에는 이미지별 버퍼를 갱신하지 않았으므로, 지워진 리소스를 가리킬 수 있다. 모두 다시 녹화한다.
+		// 지금 드로우 목록은 카메라로 컬링한 것이고 인스턴스도 이번 이미지에만 올렸으므로 여기서 바로 녹화하지 않는다.
+		// 이후 프레임마다 컬링 없이 만든 목록과 그 이미지의 인스턴스로 녹화되도록 예약만 한다.
+		// 한번 녹화한 버퍼는 내부 해상도를 따라갈 수 없으므로 전체 해상도로 되돌린다.
+		if (!enable)
+		{
+			renderExtent = swapChainExtent;
+			markCommandBufferRecreation();
+		}
+	}
+
 	void VulkanTutorial::markCommandBufferRecreation()
 	{
 		targetFrameForCmdBufRecreation = totalFrame + swapChainFrameBuffers.size();
 	}
 
-	void VulkanTutorial::tryRecreateCommandBuffer(int32_t imageIndex)
+	bool VulkanTutorial::tryRecreateCommandBuffer(int32_t imageIndex)
 	{
 		if (totalFrame <= targetFrameForCmdBufRecreation)
 		{
 			createCommandBuffer(imageIndex);
+			return true;
 		}
+		return false;
 	}
 
 	void VulkanTutorial::recordCommandBuffer(VkCommandBuffer commandBuffer, size_t i)
 	{
+		if (isSinglePassDeferred())
+		{
+			recordSinglePassCommands(commandBuffer, i);
+			return;
+		}
+
 		/**
 		* GeometryPass
 		*/
 
 		VkRenderPassBeginInfo renderPassInfo{};
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassInfo.renderPass = geometry.renderPass;
+		renderPassInfo.renderPass = recordDepthPrepassCommands(commandBuffer, i) ? geometry.depthLoadRenderPass : geometry.renderPass;
 		renderPassInfo.framebuffer = geometry.frameBuffer;
 		renderPassInfo.renderArea.offset = { 0,0 };
-		renderPassInfo.renderArea.extent = swapChainExtent;
+		renderPassInfo.renderArea.extent = renderExtent;
 
 		// define the clear values for vk_attachment_load_op_clear.
-		std::array<VkClearValue, 6> clearValues{};
+		std::array<VkClearValue, 5> clearValues{};
 		clearValues[0].color = { { 0.f, 0.f, 0.f, 0.f } };
 		clearValues[1].color = { { 0.f, 0.f, 0.f, 0.f } };
 		clearValues[2].color = { { 0.f, 0.f, 0.f, 0.f } };
 		clearValues[3].color = { { 0.f, 0.f, 0.f, 0.f } };
-		clearValues[4].color = { { 0.f, 0.f, 0.f, 0.f } };
-		clearValues[5].depthStencil = { 1.f, 0 };
+		clearValues[4].depthStencil = { 1.f, 0 };
 		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 		renderPassInfo.pClearValues = clearValues.data();
 
 		{
 			GPUMarker Marker(commandBuffer, "Geometry Pass");
-			vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+			vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, getDrawPassSubpassContents());
 			recordRenderPassCommands(commandBuffer, i);
 			vkCmdEndRenderPass(commandBuffer);
 		}
 
-		transitionImageLayout(commandBuffer, geometry.position->image, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1);
-		transitionImageLayout(commandBuffer, geometry.normal->image, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1);
+		recordPostGeometryPassCommands(commandBuffer, i);
+
+		transitionImageLayout(commandBuffer, geometry.normal->image, VK_FORMAT_R16G16_SFLOAT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1);
 		transitionImageLayout(commandBuffer, geometry.albedo->image, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1);
-		transitionImageLayout(commandBuffer, geometry.arm->image, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1);
-		transitionImageLayout(commandBuffer, geometry.emissive->image, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1);
+		transitionImageLayout(commandBuffer, geometry.material->image, VK_FORMAT_R8G8_UNORM, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1);
+		transitionImageLayout(commandBuffer, geometry.emissive->image, geometry.emissiveFormat, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1);
+		// 라이팅 패스가 깊이에서 월드 위치를 복원한다.
+		const VkFormat depthFormat = findDepthFormat();
+		transitionImageLayout(commandBuffer, depth->image, depthFormat, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, 1);
+
+		recordPreLightingPassCommands(commandBuffer, i);
 
 		/**
 		* LightingPass
@@ -1823,7 +2265,8 @@ VulkanTutorial::VulkanTutorial()
 		* ForwardPass
 		*/
 
-		transitionImageLayout(commandBuffer, swapChainImages[i], swapChainImageFormat, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, 1);
+		transitionImageLayout(commandBuffer, getSceneColorImage(i), swapChainImageFormat, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, 1);
+		transitionImageLayout(commandBuffer, depth->image, depthFormat, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, 1);
 
 		{
 			GPUMarker Marker(commandBuffer, "Forward Pass");
@@ -1832,16 +2275,64 @@ VulkanTutorial::VulkanTutorial()
 			renderPassInfo.clearValueCount = 0;
 			renderPassInfo.pClearValues = nullptr;
 
-			vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+			vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, getDrawPassSubpassContents());
 			recordForwardPassCommands(commandBuffer, i);
 			vkCmdEndRenderPass(commandBuffer);
 		}
 	}
 
+	void VulkanTutorial::recordSinglePassCommands(VkCommandBuffer commandBuffer, size_t i)
+	{
+		VkRenderPassBeginInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassInfo.renderPass = singlePass.renderPass;
+		renderPassInfo.framebuffer = singlePass.frameBuffers[i];
+		renderPassInfo.renderArea.offset = { 0,0 };
+		renderPassInfo.renderArea.extent = renderExtent;
+
+		// G-buffer 넷, 깊이, 스왑체인
+		std::array<VkClearValue, 6> clearValues{};
+		clearValues[0].color = { { 0.f, 0.f, 0.f, 0.f } };
+		clearValues[1].color = { { 0.f, 0.f, 0.f, 0.f } };
+		clearValues[2].color = { { 0.f, 0.f, 0.f, 0.f } };
+		clearValues[3].color = { { 0.f, 0.f, 0.f, 0.f } };
+		clearValues[4].depthStencil = { 1.f, 0 };
+		clearValues[5].color = { { 0.f, 0.f, 0.f, 0.f } };
+		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+		renderPassInfo.pClearValues = clearValues.data();
+
+		// secondary 커맨드 버퍼로 녹화하는 서브패스 안에는 마커를 넣을 수 없으므로 렌더 패스 전체에 하나만 둔다.
+		GPUMarker Marker(commandBuffer, "Single Pass Deferred");
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, getDrawPassSubpassContents());
+		recordRenderPassCommands(commandBuffer, i);
+
+		vkCmdNextSubpass(commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+		recordLightingRenderPassCommands(commandBuffer, i);
+
+		vkCmdNextSubpass(commandBuffer, getDrawPassSubpassContents());
+		recordForwardPassCommands(commandBuffer, i);
+		vkCmdEndRenderPass(commandBuffer);
+	}
+
+	bool VulkanTutorial::recordDepthPrepassCommands(VkCommandBuffer commandBuffer, size_t index)
+	{
+		return false;
+	}
+
 	void VulkanTutorial::recordRenderPassCommands(VkCommandBuffer commandBuffer, size_t index) {
 		
 	}
 
+	void VulkanTutorial::recordPostGeometryPassCommands(VkCommandBuffer commandBuffer, size_t index)
+	{
+
+	}
+
+	void VulkanTutorial::recordPreLightingPassCommands(VkCommandBuffer commandBuffer, size_t index)
+	{
+
+	}
+
 	void VulkanTutorial::recordLightingRenderPassCommands(VkCommandBuffer commandBuffer, size_t index)
 	{
 
@@ -1893,7 +2384,7 @@ VulkanTutorial::VulkanTutorial()
 	{
 		vkWaitForFences(*device, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
 
-		/** 1 - 2  ImageAvailableSemaphore, 2-3  renderFinishedSemaphore ³? */
+		/** 1 - 2 사이 ImageAvailableSemaphore, 2-3 사이 renderFinishedSemaphore 맞나? */
 		/** 1. Acquire an image from the swap chain */
 		uint32_t imageIndex;
 		VkResult result = vkAcquireNextImageKHR(*device, swapChain, UINT64_MAX, imageAvailableSemaphore[currentFrame], VK_NULL_HANDLE, &imageIndex);
@@ -1907,18 +2398,24 @@ VulkanTutorial::VulkanTutorial()
 			throw std::runtime_error("failed to acquire next image!");
 		}
 
-		preDrawFrame(imageIndex);
-
+		// 이미지별 버퍼(유니폼, 라이트 목록 등)는 preDrawFrame 에서 호스트가 쓰므로, 이 이미지를 쓰던 프레임이 끝난 뒤에 부른다.
 		if (imagesInFlight[imageIndex] != VK_NULL_HANDLE)
 		{
 			vkWaitForFences(*device, 1, &imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
 		}
 
+		preDrawFrame(imageIndex);
+
 		imagesInFlight[imageIndex] = inFlightFences[currentFrame];
 
+		if (submitFrameCommandBuffer)
+		{
+			recordFrameCommandBuffer(imageIndex);
+		}
+
 		VkSubmitInfo submitInfo{};
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		// Color attachment    ٸٰ  ñ׳εǸ (ImageIndex ) о Ѵ. 
+		// Color attachment에 쓰기 직전 스테이지까지 기다리다가 세마포어가 시그널되면 (ImageIndex를 얻으면) 렌더패쓰를 진행한다. 
 		VkSemaphore waitSemaphore[]{ imageAvailableSemaphore[currentFrame] };
 		// VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT specifies the stage of the pipeline after blending where the final color values are output from the pipeline. 
 		VkPipelineStageFlags waitStage[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
@@ -1993,13 +2490,19 @@ VulkanTutorial::VulkanTutorial()
 		vkDestroySampler(*device, textureSampler, nullptr);
 		vkDestroyDescriptorSetLayout(*device, descriptorSetLayout, nullptr);
 		vkDestroyDescriptorSetLayout(*device, lightingPass.descriptorSetLayout, nullptr);
+		vkDestroyDescriptorSetLayout(*device, lightingPass.inputAttachmentSetLayout, nullptr);
 		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
 		{
 			vkDestroySemaphore(*device, renderFinishedSemaphore[i], nullptr);
 			vkDestroySemaphore(*device, imageAvailableSemaphore[i], nullptr);
 			vkDestroyFence(*device, inFlightFences[i], nullptr);
 		}
+		for (VkCommandPool frameCommandPool : frameCommandPools)
+		{
+			vkDestroyCommandPool(*device, frameCommandPool, nullptr);
+		}
 		vkDestroyCommandPool(*device, commandPool, nullptr);
+		transientAttachmentHeap.cleanup();
 		/*
 		vkDestroyDevice(*device, nullptr);
 
@@ -2042,9 +2545,9 @@ VulkanTutorial::VulkanTutorial()
 
 		vkDestroyPipelineLayout(*device, forward.pipelineLayout, nullptr);
 		vkDestroyPipeline(*device, forward.pipeline, nullptr);
-		for (size_t i = 0; i < swapChainFrameBuffers.size(); i++)
+		for (VkFramebuffer frameBuffer : forward.frameBuffers)
 		{
-			vkDestroyFramebuffer(*device, forward.frameBuffers[i], nullptr);
+			vkDestroyFramebuffer(*device, frameBuffer, nullptr);
 		}
 
 		for (size_t i = 0; i < swapChainFrameBuffers.size(); i++)
@@ -2055,8 +2558,24 @@ VulkanTutorial::VulkanTutorial()
 		vkFreeCommandBuffers(*device, commandPool, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
 		//vkDestroyPipeline(*device, graphicsPipeline, nullptr);
 		vkDestroyRenderPass(*device, renderPass, nullptr);
-		vkDestroyRenderPass(*device, geometry.renderPass, nullptr);
-		vkDestroyRenderPass(*device, forward.renderPass, nullptr);
+		// 단일 렌더 패스이면 geometry.renderPass 와 forward.renderPass 가 singlePass.renderPass 를 가리킨다.
+		if (isSinglePassDeferred())
+		{
+			for (VkFramebuffer frameBuffer : singlePass.frameBuffers)
+			{
+				vkDestroyFramebuffer(*device, frameBuffer, nullptr);
+			}
+			singlePass.frameBuffers.clear();
+			vkDestroyRenderPass(*device, singlePass.renderPass, nullptr);
+			singlePass.renderPass = VK_NULL_HANDLE;
+		}
+		else
+		{
+			vkDestroyRenderPass(*device, geometry.renderPass, nullptr);
+			vkDestroyRenderPass(*device, geometry.loadRenderPass, nullptr);
+			vkDestroyRenderPass(*device, geometry.depthLoadRenderPass, nullptr);
+			vkDestroyRenderPass(*device, forward.renderPass, nullptr);
+		}
 		for (auto imageView : swapChainImageViews)
 		{
 			vkDestroyImageView(*device, imageView, nullptr);
@@ -22,6 +22,7 @@
 
 #include "vk_engine.h"
 #include "Vk_loader.h"
+#include "TransientAttachmentHeap.h"
 
 #ifndef DEBUG_MODEL 
 #define DEBUG_MODEL 0
@@ -64,19 +65,60 @@ public:
 
 	struct GeometryPass
 	{
-		std::shared_ptr<AllocatedImage> position, normal, albedo, arm /* ao, roughness, metallic */ , emissive;
+		// 월드 위치는 두지 않고 라이팅 패스가 깊이와 inverseViewProj 로 복원한다.
+		std::shared_ptr<AllocatedImage> normal /* 팔면체 인코딩 */, albedo /* rgb albedo, a ao */, material /* roughness, metallic */, emissive;
+		// R11G11B10 을 렌더 타겟으로 쓸 수 없는 장치에서는 RGBA16F 로 바뀐다.
+		VkFormat emissiveFormat = VK_FORMAT_B10G11R11_UFLOAT_PACK32;
 		VkRenderPass renderPass;
+		// renderPass 와 호환되고, 첨부물을 지우지 않고 이어 그린다.
+		VkRenderPass loadRenderPass;
+		// renderPass 와 호환되고, G-buffer 는 지우되 깊이와 스텐실은 깊이 프리패스가 남긴 값을 불러온다.
+		VkRenderPass depthLoadRenderPass;
 		VkFramebuffer frameBuffer;
+		// 파이프라인과 secondary 커맨드 버퍼가 쓸 서브패스 번호. 단일 렌더 패스에서만 0 이 아니다.
+		uint32_t subpass = 0;
+
+		// 지오메트리 패스가 그린 픽셀에 남기는 스텐실 값. 라이팅 패스는 이 값인 픽셀만 칠하고 배경은 건너뛴다.
+		static constexpr uint32_t stencilReference = 1;
+		// 깊이 테스트를 통과한 픽셀의 스텐실을 stencilReference 로 바꾼다. G-buffer 에 쓰는 파이프라인이 쓴다.
+		static void writeStencil(VkPipelineDepthStencilStateCreateInfo& state);
+		// 스텐실이 stencilReference 인 픽셀만 통과시키고 스텐실은 건드리지 않는다.
+		static void testStencil(VkPipelineDepthStencilStateCreateInfo& state);
 	} geometry;
 
+	// G-buffer 처럼 프레임 안에서만 쓰는 렌더 타겟과, 수명이 겹치지 않는 임시 이미지가 메모리를 나눠 쓴다.
+	TransientAttachmentHeap transientAttachmentHeap;
+
 	struct ForwardPass
 	{
 		VkRenderPass renderPass;
 		std::vector<VkFramebuffer> frameBuffers;
 		VkPipeline pipeline;
 		VkPipelineLayout pipelineLayout;
+		uint32_t subpass = 0;
 	} forward;
 
+	/**
+	 * 지오메트리, 라이팅, 포워드 패스를 서브패스 셋으로 가진 렌더 패스 하나.
+	 *
+	 * 라이팅 서브패스는 G-buffer 와 깊이를 input attachment(subpassInput) 로 읽는다. G-buffer 는 렌더 패스 밖으로 저장하지
+	 * 않으므로 타일 기반 GPU 에서는 타일 메모리를 떠나지 않고, 패스 사이의 레이아웃 전환도 서브패스 의존성이 대신한다.
+	 * 켜져 있으면 geometry.renderPass 와 forward.renderPass 가 이 렌더 패스를 가리키고, 각 패스의 subpass 가 서브패스 번호다.
+	 * 패스 사이에 끼어드는 작업(recordPostGeometryPassCommands, recordPreLightingPassCommands)은 불리지 않는다.
+	 */
+	struct SinglePass
+	{
+		static constexpr uint32_t GeometrySubpass = 0;
+		static constexpr uint32_t LightingSubpass = 1;
+		static constexpr uint32_t ForwardSubpass = 2;
+
+		// 다음에 렌더 패스를 만들 때 적용된다.
+		bool enabled = false;
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		// 스왑체인 이미지마다 하나
+		std::vector<VkFramebuffer> frameBuffers;
+	} singlePass;
+
 	VkDescriptorPool descriptorPool;
 
 	template<typename T>
@@ -101,9 +143,11 @@ public:
 	void createIndexBuffer(const std::vector<uint32_t>& indices, VkBuffer& outIndexBuffer, VkDeviceMemory& outIndexBufferMemory);
 	std::shared_ptr<AllocatedImage> createTexture2D(const char* filePath, VkFormat inFormat, VkImageUsageFlagBits inUsageFlag = VK_IMAGE_USAGE_SAMPLED_BIT, const char* name = "texture");
 	std::shared_ptr<AllocatedImage> createTexture2D(const std::string& filePath, VkFormat inFormat, VkImageUsageFlagBits inUsageFlag = VK_IMAGE_USAGE_SAMPLED_BIT, const char* name = "texture");
-	std::shared_ptr<AllocatedImage> createTexture2D(stbi_uc* data, VkExtent3D imageSize, VkFormat format, VkImageUsageFlagBits usageFlag = VK_IMAGE_USAGE_SAMPLED_BIT, const char* name = "texture", int channelNum = 4);
+	std::shared_ptr<AllocatedImage> createTexture2D(stbi_uc* data, VkExtent3D imageSize, VkFormat format, VkImageUsageFlagBits usageFlag = VK_IMAGE_USAGE_SAMPLED_BIT, const char* name = "texture", int channelNum = 4, std::optional<TransientAttachmentHeap::AliasGroup> aliasGroup = std::nullopt);
 	std::shared_ptr<AllocatedImage> createTexture2Df(float* inData, VkExtent3D inImageSize, VkFormat inFormat, VkImageUsageFlagBits inUsageFlag, const char* name, int channelNum);
 	std::shared_ptr<AllocatedImage> createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, const char* name = "none", uint32_t arrayLayers = 1, VkImageViewCreateFlags flags = 0);
+	// transientAttachmentHeap 에서 메모리를 받는 이미지. 같은 그룹의 이미지를 모두 만든 뒤 commit 해야 뷰를 만들 수 있다.
+	std::shared_ptr<AllocatedImage> createAliasedImage(TransientAttachmentHeap::AliasGroup group, uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageUsageFlags usage, const char* name = "none");
 	VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels, uint32_t baseArrayLayer = 0, uint32_t baseMipLevel = 0);
 	VkImageView createImageViewCube(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels, uint32_t baseArrayLayer = 0);
 	VkCommandBuffer beginSingleTimeCommands();
@@ -111,12 +155,38 @@ public:
 	void generateMipmaps(VkCommandBuffer commandBuffer, VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels, uint32_t layerCount);
 	void transitionImageLayout(VkCommandBuffer CommandBuffer, VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels, uint32_t layerCount = 1, uint32_t baseMipLevel = 0);
 	void markCommandBufferRecreation();
+	// 켜면 스왑체인 이미지별로 한번 녹화해 둔 커맨드 버퍼 대신, 매 프레임 프레임 슬롯의 TRANSIENT 풀을 리셋하고 새로 녹화한다.
+	void setRecordCommandsEveryFrame(bool enable);
+	bool isRecordingCommandsEveryFrame() const { return recordCommandsEveryFrame; }
+	// 지오메트리, 라이팅, 포워드 패스를 렌더 패스 하나로 묶는다. 렌더 패스와 파이프라인을 다시 만들어야 하므로 스왑체인을 다시 만들 때 적용된다.
+	void setSinglePassDeferred(bool enable) { singlePass.enabled = enable; }
+	bool isSinglePassDeferred() const { return singlePass.renderPass != VK_NULL_HANDLE; }
+	// 지오메트리, 라이팅, 포워드 패스가 그리는 영역. 렌더 타겟은 스왑체인 크기이고 그 왼쪽 위 이만큼만 쓴다.
+	VkExtent2D getRenderExtent() const { return renderExtent; }
+	VkFramebuffer getGeometryFrameBuffer(size_t imageIndex) const { return isSinglePassDeferred() ? singlePass.frameBuffers[imageIndex] : geometry.frameBuffer; }
+	VkFramebuffer getForwardFrameBuffer(size_t imageIndex) const { return isSinglePassDeferred() ? singlePass.frameBuffers[imageIndex] : forward.frameBuffers[imageIndex]; }
+	// 마지막으로 primary 커맨드 버퍼 하나를 녹화하는 데 걸린 시간
+	double getLastRecordMilliseconds() const { return lastRecordMilliseconds; }
 
 	VkDevice getDevice() const { return *device; }
 	DevicePtr getDevicePtr() const { return device; }
 
+	// 있으면 켜고, 없어도 실행은 되는 기능들. 이 기능을 쓰는 코드는 꺼져 있을 때의 대안을 가져야 한다.
+	struct OptionalDeviceFeatures
+	{
+		bool multiDrawIndirect = false;
+		bool drawIndirectFirstInstance = false;
+		bool drawIndirectCount = false;		// VK_KHR_draw_indirect_count
+		bool pipelineStatisticsQuery = false;
+		bool inheritedQueries = false;		// secondary 커맨드 버퍼를 쿼리 안에서 실행
+	};
+	const OptionalDeviceFeatures& getOptionalDeviceFeatures() const { return optionalDeviceFeatures; }
+
 protected:
 	virtual VkDescriptorSetLayout getGlobalDescriptorSetLayout() { return nullptr; }
+	// 라이팅, 포워드 패스가 그리는 색 타겟. 기본은 스왑체인 이미지이고, 따로 두면 프레젠트 전에 스왑체인으로 옮겨야 한다.
+	virtual VkImage getSceneColorImage(size_t imageIndex) { return swapChainImages[imageIndex]; }
+	virtual VkImageView getSceneColorView(size_t imageIndex) { return swapChainImageViews[imageIndex]; }
 	virtual void initWindow();
 	virtual void initVulkan();
 	virtual void processInput();
@@ -130,12 +200,22 @@ protected:
 	virtual void createDescriptorSetLayouts();
 	virtual void createGraphicsPipelines();
 	virtual void recordCommandBuffer(VkCommandBuffer commandbuffer, size_t index); 
+	// 지오메트리 패스 직전에 불린다. 깊이를 채웠으면 true 를 반환하고, 지오메트리 패스는 geometry.depthLoadRenderPass 로 시작한다.
+	// 단일 렌더 패스로 그릴 때는 불리지 않는다.
+	virtual bool recordDepthPrepassCommands(VkCommandBuffer commandBuffer, size_t index);
 	virtual void recordRenderPassCommands(VkCommandBuffer commandBuffer, size_t index);
+	// 지오메트리 패스가 끝난 직후, G-buffer 를 셰이더 읽기 레이아웃으로 바꾸기 전에 불린다. geometry.loadRenderPass 로 이어 그릴 수 있다.
+	// 단일 렌더 패스로 그릴 때는 불리지 않는다.
+	virtual void recordPostGeometryPassCommands(VkCommandBuffer commandBuffer, size_t index);
+	// G-buffer 와 깊이를 셰이더 읽기 레이아웃으로 바꾼 뒤, 라이팅 패스 직전에 불린다. 라이팅 패스가 읽을 타겟을 여기서 채운다.
+	// 단일 렌더 패스로 그릴 때는 불리지 않는다.
+	virtual void recordPreLightingPassCommands(VkCommandBuffer commandBuffer, size_t index);
 	virtual void recordLightingRenderPassCommands(VkCommandBuffer commandBuffer, size_t index);
 	virtual void cleanUpSwapchain();
 	virtual void loadModels();
 	virtual void createBuffers();
 	virtual void recreateSwapChain();
+	// inFlightFences[currentFrame] 와 imagesInFlight[imageIndex] 를 모두 기다린 뒤에 불린다. 이 이미지의 버퍼를 써도 된다.
 	virtual void preDrawFrame(uint32_t imageIndex);
 	virtual void drawFrame();
 	virtual void postDrawFrame(uint32_t imageIndex);
@@ -144,6 +224,8 @@ protected:
 	virtual void createFrameBuffers();
 	virtual void cleanUp();
 	virtual void recordForwardPassCommands(VkCommandBuffer commandBuffer, size_t index);
+	// 지오메트리 패스와 포워드 패스를 secondary 커맨드 버퍼로 녹화하면 VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS 를 반환한다.
+	virtual VkSubpassContents getDrawPassSubpassContents() { return VK_SUBPASS_CONTENTS_INLINE; }
 
 protected:
 	bool checkValidationLayerSupport();
@@ -172,6 +254,7 @@ protected:
 	void createColorResources();
 	void createDepthResources();
 	VkFormat findDepthFormat();
+	VkFormat findEmissiveFormat();
 	VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 	bool hasStencilComponent(VkFormat format);
 	void createTextureImage();
@@ -179,7 +262,10 @@ protected:
 	void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
 	void loadModel(const std::string& modelPath, std::vector<Vertex>& outVertices, std::vector<uint32_t>& outIndices);
 	void createCommandBuffer(int32_t i);
-	void tryRecreateCommandBuffer(int32_t imageIndex);
+	// 다시 녹화했으면 true
+	bool tryRecreateCommandBuffer(int32_t imageIndex);
+	void recordFrameCommandBuffer(uint32_t imageIndex);
+	bool isRecordingFrameCommandBuffer() const { return recordingFrameCommandBuffer; }
 	VkDescriptorBufferInfo createDescriptorBufferInfo(VkBuffer& buffer, VkDeviceSize bufferSize);
 	VkDescriptorImageInfo CreateDescriptorImageInfo(VkImageView& imageView, VkSampler& sampler, VkImageLayout layout);
 	void CreateWriteDescriptorSet(VkDescriptorType type, VkDescriptorSet& DescriptorSet, VkDescriptorImageInfo* ImageInfo, VkDescriptorBufferInfo* BufferInfo, std::vector<VkWriteDescriptorSet>& descriptorWrites);
@@ -194,6 +280,8 @@ protected:
 	const VkCommandBuffer* getCommandBufferData();
 	void clearCommandBuffers();
 	void createDescriptorSetLayout(std::vector<VkDescriptorSetLayoutBinding>& bindings, VkDescriptorSetLayout* outDescriptorSetLayout);
+	void createSinglePassRenderPass();
+	void recordSinglePassCommands(VkCommandBuffer commandBuffer, size_t index);
 
 	static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity, VkDebugUtilsMessageTypeFlagsEXT messageType, const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData, void* pUserData) {
 		std::cerr << "validation layer: " << pCallbackData->pMessage << std::endl;
@@ -219,6 +307,8 @@ protected:
 	std::vector<VkImage> swapChainImages;
 	VkFormat swapChainImageFormat;
 	VkExtent2D swapChainExtent;
+	// 스왑체인을 만들면 swapChainExtent 로 돌아간다. 매 프레임 녹화할 때만 바꿔야 한다.
+	VkExtent2D renderExtent{};
 	std::vector<VkImageView> swapChainImageViews;
 	VkRenderPass renderPass;
 	VkDescriptorSetLayout descriptorSetLayout;
@@ -226,6 +316,14 @@ protected:
 	VkCommandPool commandPool;
 	std::vector<VkCommandBuffer> commandBuffers;
 	std::vector<VkCommandBuffer> commandBuffersToSubmit;
+	// 프레임 슬롯(MAX_FRAMES_IN_FLIGHT)마다 TRANSIENT 풀과 primary 버퍼 하나. 슬롯의 펜스를 기다린 뒤 풀째로 리셋한다.
+	std::vector<VkCommandPool> frameCommandPools;
+	std::vector<VkCommandBuffer> frameCommandBuffers;
+	bool recordCommandsEveryFrame = true;
+	// 이번 프레임에 frameCommandBuffers 를 제출하는지. 프레임 도중에 모드가 바뀌어도 preDrawFrame 의 선택을 따른다.
+	bool submitFrameCommandBuffer = false;
+	bool recordingFrameCommandBuffer = false;
+	double lastRecordMilliseconds = 0.0;
 
 	std::vector<VkDescriptorSet> descriptorSets;
 
@@ -235,13 +333,17 @@ protected:
 
 	std::shared_ptr<AllocatedImage> whiteTexture;
 
-	//  н
+	// 라이팅 패스
 	struct LightingPass
 	{
 		VkPipeline pipeline;
 		VkPipelineLayout pipelineLayout;
 		VkDescriptorSetLayout descriptorSetLayout;
 		std::vector<VkDescriptorSet> descriptorSets;
+		// 단일 렌더 패스의 라이팅 서브패스용. G-buffer 와 깊이 자리가 input attachment 다.
+		VkDescriptorSetLayout inputAttachmentSetLayout = VK_NULL_HANDLE;
+		std::vector<VkDescriptorSet> inputAttachmentSets;
+		uint32_t subpass = 0;
 	} lightingPass;
 	
 	std::shared_ptr<AllocatedImage> depth;
@@ -265,10 +367,10 @@ protected:
 	std::vector<VkSemaphore> imageAvailableSemaphore; // before rendering
 	std::vector<VkSemaphore> renderFinishedSemaphore; // after rendering
 	std::vector<VkFence> inFlightFences;
-	//  ȭ  ̹ ȭ Ѵ. 
-	// MAX_FRAMES_IN_FLIGHT ̹   ų,  Swapchain ִ ̹  ׹̶ 
-	//  Inflight   ȴ. ׷ ̹  ȭ ν  ȭ Ǯ  ̹    
-	// ߰ Ѵ. 
+	// 프레임 동기화에 더해 이미지 동기화까지 한다. 
+	// MAX_FRAMES_IN_FLIGHT가 이미지 수보다 더 많거나, 만약 Swapchain에서 주는 이미지 순서가 뒤죽박죽이라면 
+	// 파이프라인이 Inflight일 때 쓰게 된다. 그래서 이미지 또한 동기화를 함으로써 프레임 동기화가 풀려도 같은 이미지를 쓰게 될 경우 
+	// 멈추게 한다. 
 	std::vector<VkFence> imagesInFlight;
 
 	bool frameBufferResized = false;
@@ -279,6 +381,10 @@ protected:
 	const std::vector<const char*> deviceExtensions = {
 		"VK_KHR_swapchain"
 	};
+	const std::vector<const char*> optionalDeviceExtensions = {
+		VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME
+	};
+	OptionalDeviceFeatures optionalDeviceFeatures;
 
 	std::string ProgramName;
 	DevicePtr device;
@@ -0,0 +1,20 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+#include "global.glsl"
+
+// DepthPrepass 의 깊이 전용 패스. 위치 전용 스트림만 읽는다.
+// 지오메트리 패스가 EQUAL 로 테스트하므로 shader.vert 와 같은 식으로 같은 깊이를 내야 한다.
+layout( push_constant ) uniform constants
+{
+	mat4 model;
+} PushConstants;
+
+layout(location = 0) in vec3 inPosition;
+
+invariant gl_Position;
+
+void main()
+{
+    gl_Position = sceneData.proj * sceneData.view * PushConstants.model * vec4(inPosition, 1.0);
+}
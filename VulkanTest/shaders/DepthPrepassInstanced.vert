@@ -0,0 +1,18 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+#include "global.glsl"
+
+// DepthPrepass 의 인스턴싱 변형. shaderInstanced.vert 와 같은 식으로 같은 깊이를 내야 한다.
+layout(location = 0) in vec3 inPosition;
+// binding 1, 인스턴스마다 바뀐다. (Vertex.h 의 Instance)
+layout(location = 1) in mat4 inInstanceModel;
+
+invariant gl_Position;
+
+void main()
+{
+    mat4 model = inInstanceModel;
+
+    gl_Position = sceneData.proj * sceneData.view * model * vec4(inPosition, 1.0);
+}
@@ -0,0 +1,28 @@
+#version 450
+
+#include "forward_shading.glsl"
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) in vec3 fragNormal;
+layout(location = 3) in vec3 fragPos;
+
+// WeightedBlendedOIT 의 누적 타겟. 두 첨부물이 같은 블렌딩(색 ONE + ONE, 알파 ZERO + ONE_MINUS_SRC_ALPHA)을 쓴다.
+// outAccumulation : rgb 가중치를 곱한 프리멀티플라이 색의 합, a 투과율(revealage)의 곱
+// outWeight : r 가중치를 곱한 알파의 합
+layout(location = 0) out vec4 outAccumulation;
+layout(location = 1) out vec4 outWeight;
+
+void main()
+{
+	vec4 color = shadeForward(fragTexCoord, fragNormal, fragPos);
+	float alpha = clamp(color.a, 0.0, 1.0);
+
+	// McGuire & Bavoil 2013 의 깊이 가중치 (식 9). 가까운 면일수록 크게 잡아 순서 없이 더해도 앞쪽 색이 이긴다.
+	// 16 비트 float 범위를 넘지 않도록 자른다.
+	float viewDepth = -(sceneData.view * vec4(fragPos, 1.0)).z;
+	float weight = alpha * clamp(10.0 / (1e-5 + pow(viewDepth / 5.0, 2.0) + pow(viewDepth / 200.0, 6.0)), 1e-2, 3e3);
+
+	outAccumulation = vec4(color.rgb * alpha * weight, alpha);
+	outWeight = vec4(alpha * weight, 0.0, 0.0, 0.0);
+}
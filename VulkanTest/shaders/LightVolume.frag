@@ -0,0 +1,44 @@
+#version 450
+
+// 전역, 라이팅 패스, 클러스터 셋 다음이다.
+#define POINT_SHADOW_SET 3
+#include "deferred.glsl"
+#include "point_shadow.glsl"
+
+layout(location = 0) flat in uint lightIndex;
+
+layout(location = 0) out vec4 outRadiance;
+
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	float depth = texelFetch(depthMap, pixel, 0).r;
+	// 스텐실이 없는 깊이 포맷에서는 배경 픽셀도 깊이 테스트를 통과할 수 있다.
+	if (depth >= 1.0)
+	{
+		outRadiance = vec4(0.0);
+		return;
+	}
+
+	// 동적 해상도에서는 타겟의 일부만 쓰므로 텍스처 크기가 아닌 내부 해상도로 나눈다.
+	vec2 uv = gl_FragCoord.xy * sceneData.renderExtent.zw;
+	vec3 worldPos = reconstructWorldPosition(uv, depth);
+	vec3 N = decodeOctahedral(texelFetch(normal, pixel, 0).rg);
+	vec3 albedoColor = pow(texelFetch(albedo, pixel, 0).rgb, vec3(2.2));
+	vec2 roughnessMetallic = texelFetch(material, pixel, 0).rg;
+	float roughness = roughnessMetallic.r;
+	float metallic = roughnessMetallic.g;
+
+	// Pbr.frag 와 같은 디버그 표시
+	int debugDisplay = int(sceneData.exposureDisplay.y);
+	float diffuseEnable = debugDisplay == 7 ? 0.0 : 1.0;
+	float specularEnable = debugDisplay == 8 ? 0.0 : 1.0;
+
+	vec3 V = normalize(sceneData.viewPos - worldPos);
+	vec3 F0 = mix(vec3(0.04), albedoColor, metallic);
+
+	// 구 앞에 있는 표면도 깊이 테스트를 통과하므로 CalcClusterLight 가 반지름으로 거른다.
+	ClusterLight light = clusterLights[lightIndex];
+	vec3 radiance = CalcClusterLight(light, worldPos, N, V, albedoColor, roughness, metallic, F0, diffuseEnable, specularEnable) * getPointShadow(light, worldPos, N);
+	outRadiance = vec4(radiance, 0.0);
+}
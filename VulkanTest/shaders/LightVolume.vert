@@ -0,0 +1,28 @@
+#version 450
+
+#include "global.glsl"
+#include "clustered_lighting.glsl"
+
+layout(location = 0) in vec3 inPosition;
+
+// LightVolumes.cpp 의 VolumePushConstants 와 같다.
+layout(push_constant) uniform VolumeParams
+{
+	float volumeScale;	// 다면체가 반지름 구를 감싸도록 키운다
+} volume;
+
+layout(location = 0) flat out uint outLightIndex;
+
+void main()
+{
+	// 인스턴스 하나가 라이트 하나다.
+	ClusterLight light = clusterLights[gl_InstanceIndex];
+	vec3 worldPosition = light.positionRadius.xyz + inPosition * light.positionRadius.w * volume.volumeScale;
+	gl_Position = sceneData.proj * sceneData.view * vec4(worldPosition, 1.0);
+	// far 평면 뒤로 나간 뒷면은 far 평면에 붙인다. 잘려 나가면 그 뒤의 픽셀이 빛을 받지 못한다.
+	if (gl_Position.w > 0.0)
+	{
+		gl_Position.z = min(gl_Position.z, gl_Position.w);
+	}
+	outLightIndex = gl_InstanceIndex;
+}
@@ -52,21 +52,21 @@ void main()
     uint displayDebugTarget = colorUbo.debug.x;
     if(displayDebugTarget == 1)
     {
-         // ؽó ǥ 2 Ű ( ȭ)
+         // 텍스처 좌표를 2배로 키움 (사분할 화면)
         vec2 quadTexCoords = texCoords * 2.0;
 
-        //  и 
+        // 각 사분면을 계산
          vec3 fragPos_Debug = texture(position, quadTexCoords).rgb;
          vec3 fragNormal_Debug = texture(normal, quadTexCoords).rgb;
          vec3 fragColor_Debug = texture(colorSpecular, quadTexCoords).rgb;
          vec3 fragSpecular_Debug = texture(colorSpecular, quadTexCoords).aaa;
 
-        // и鸶 ٸ  
-        // и ϴ  ǥ
+        // 사분면마다 다른 계산을 수행
+        // 사분면을 구분하는 수학적 표현
         float xInFirstHalf = step(quadTexCoords.x, 1.0);
         float yInFirstHalf = step(quadTexCoords.y, 1.0);
     
-        //  и鿡  ؽó ǥ 
+        // 각 사분면에 대해 텍스처 좌표 계산
         fragPos_Debug *= xInFirstHalf * yInFirstHalf;
         fragNormal_Debug *= xInFirstHalf * (1.0 - yInFirstHalf);
         fragColor_Debug *= (1.0 - xInFirstHalf) * yInFirstHalf;
@@ -0,0 +1,33 @@
+#version 450
+
+// WeightedBlendedOIT 의 누적 타겟을 평균 내 장면 색 위에 합성한다. 블렌딩은 SRC_ALPHA, ONE_MINUS_SRC_ALPHA.
+layout(set = 0, binding = 0) uniform sampler2D accumulationTex;
+layout(set = 0, binding = 1) uniform sampler2D weightTex;
+
+layout(location = 0) in vec2 inUV;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	vec4 accumulation = texelFetch(accumulationTex, pixel, 0);
+
+	// 투과율이 1 이면 반투명 면이 하나도 없다.
+	float revealage = accumulation.a;
+	if (revealage >= 1.0)
+	{
+		discard;
+	}
+
+	// 16 비트 float 이 넘쳤으면 넘친 채널을 최댓값으로 자르고 가장 큰 채널이 1 이 되도록 줄여 색의 비율만이라도 살린다.
+	float weightSum = texelFetch(weightTex, pixel, 0).r;
+	if (any(isinf(accumulation.rgb)))
+	{
+		vec3 clamped = min(accumulation.rgb, vec3(65504.0));
+		accumulation.rgb = clamped / max(max(clamped.r, clamped.g), clamped.b) * weightSum;
+	}
+
+	vec3 averageColor = accumulation.rgb / max(weightSum, 1e-5);
+	outColor = vec4(averageColor, 1.0 - revealage);
+}
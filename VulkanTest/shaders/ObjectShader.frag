@@ -9,16 +9,26 @@ layout(location = 3) in vec3 fragPos;
 layout(location = 4) in vec3 fragTangent;
 layout(location = 5) in vec3 fragBitangent;
 
-layout(location = 0) out vec3 outPosition;
-layout(location = 1) out vec3 outNormal;
-layout(location = 2) out vec3 outAlbedo;
-layout(location = 3) out vec4 outARM;
-layout(location = 4) out vec4 outEmissive;
+// 월드 위치는 쓰지 않는다. 라이팅 패스가 깊이에서 복원한다.
+layout(location = 0) out vec2 outNormal;		// 팔면체 인코딩, RG16F
+layout(location = 1) out vec4 outAlbedo;		// rgb albedo, a ao
+layout(location = 2) out vec2 outMaterial;		// roughness, metallic
+layout(location = 3) out vec3 outEmissive;		// R11G11B10F
+
+// 단위 벡터 -> [-1, 1]^2. 아래 반구는 모서리 쪽으로 접는다. deferred.glsl 의 decodeOctahedral 과 짝이다.
+vec2 encodeOctahedral(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 e = n.xy;
+    if (n.z < 0.0)
+    {
+        e = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return e;
+}
 
 void main()
 {
-    outPosition = fragPos;
-    
     vec3 N = normalize(fragNormal);
     
     //if (materialData.textureFlags.x > 0.5) {
@@ -30,16 +40,16 @@ void main()
        // );
      //   N = normalize(TBN * tangentNormal);
    // }
-    outNormal = N * 0.5 + 0.5;
+    outNormal = encodeOctahedral(N);
 
-    outAlbedo = texture(colorTex, fragTexCoord).rgb * materialData.colorFactors.rgb;
+    vec3 albedo = texture(colorTex, fragTexCoord).rgb * materialData.colorFactors.rgb;
     
     float roughness = 0.5;
     float metallic = 0.0;
     float ao = 1.0;
     
     if (materialData.textureFlags.y > 0.5 || materialData.textureFlags.z > 0.5) {
-        //  metallic/roughness ؽó 
+        // 개별 metallic/roughness 텍스처 사용
         if (materialData.textureFlags.y > 0.5) {
             metallic = texture(metallicTex, fragTexCoord).r;
         }
@@ -48,8 +58,8 @@ void main()
             roughness = texture(roughnessTex, fragTexCoord).r;
         }
     } else {
-        //    ؽó   
-        // metalRoughTex  (ִٸ)
+        // 이 경우는 개별 텍스처가 없을 때만 실행됨
+        // metalRoughTex를 사용 (있다면)
         vec4 metallicRoughness = texture(metalRoughTex, fragTexCoord);
         roughness = metallicRoughness.g * materialData.metal_rough_factors.g;
         metallic = metallicRoughness.b * materialData.metal_rough_factors.r;
@@ -59,8 +69,9 @@ void main()
         ao = texture(aoTex, fragTexCoord).r;
     }
     
-    outARM = vec4(ao, roughness, metallic, 1.0);
+    outAlbedo = vec4(albedo, ao);
+    outMaterial = vec2(roughness, metallic);
 
     vec3 emissive = texture(emissiveTex, fragTexCoord).rgb * materialData.emissiveFactors.rgb;
-    outEmissive = vec4(emissive, 1.0);
+    outEmissive = emissive;
 }
\ No newline at end of file
@@ -0,0 +1,5 @@
+#version 450
+
+// 디스크립터 셋을 4 개까지만 묶을 수 있는 장치용. 포인트 라이트 그림자 셋(set 4)을 쓰지 않는다.
+#define NO_POINT_SHADOW
+#include "pbr_lighting.glsl"
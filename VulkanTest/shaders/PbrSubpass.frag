@@ -0,0 +1,5 @@
+#version 450
+
+// 단일 렌더 패스의 라이팅 서브패스. G-buffer 와 깊이를 subpassInput 으로 읽는다.
+#define GBUFFER_SUBPASS_INPUT
+#include "pbr_lighting.glsl"
@@ -0,0 +1,6 @@
+#version 450
+
+// PbrSubpass.frag 에서 포인트 라이트 그림자 셋(set 4)을 뺀 변형
+#define GBUFFER_SUBPASS_INPUT
+#define NO_POINT_SHADOW
+#include "pbr_lighting.glsl"
@@ -0,0 +1,16 @@
+#version 450
+
+// CascadedShadowMap 의 깊이 전용 패스. 위치 전용 스트림만 읽는다.
+layout(location = 0) in vec3 inPosition;
+
+// CascadedShadowMap.cpp 의 ShadowPushConstants 와 같다.
+layout(push_constant) uniform ShadowPushConstants
+{
+	mat4 lightViewProjection;
+	mat4 model;
+} pushConstants;
+
+void main()
+{
+	gl_Position = pushConstants.lightViewProjection * pushConstants.model * vec4(inPosition, 1.0);
+}
@@ -49,7 +49,7 @@ vec3 ImportanceSampleGGX(vec2 Xi, vec3 N, float roughness)
     return normalize(sampleVec);
 }  
 
-//  Li(p,i)di, ܼ Prefiltered ʸ . ŧ BRDF   ʾҴ. 
+// ∫ Li(p,ωi)dωi, 단순히 Prefiltered 맵만 생성. 스페큘러 BRDF는 아직 사용하지 않았다. 
 void main()
 {		
     vec3 N = normalize(localPos);    
@@ -61,18 +61,18 @@ void main()
     vec3 prefilteredColor = vec3(0.0);     
     for(uint i = 0u; i < SAMPLE_COUNT; ++i)
     {
-        //  յ ǥ , ū  Ģ   ϸ Ȯ ö󰣴. 
+        // 랜덤하지만 균등한 표본 검출, 큰 수의 법칙에 따라 샘플을 많이하면 정확도가 올라간다. 
         vec2 Xi = Hammersley(i, SAMPLE_COUNT);
         // When it comes to the microsurface model, 
         // we can imagine the specular lobe as the reflection orientation about the microfacet halfway vectors 
         // given some incoming light direction. Seeing as most light rays end up in a specular lobe 
         // reflected around the microfacet halfway vectors, 
-        // H ͸ roughness   ̾   
+        // H 벡터를 roughness 값에 따라 뽑아 내는 과정 
         vec3 H  = ImportanceSampleGGX(Xi, N, pushConstants.roughness);
-        // H  , ⸦ Ѵ. 
+        // H로 빛의 방향, 세기를 구한다. 
         vec3 L  = normalize(2.0 * dot(V, H) * H - V);
 
-        //   ⸦ ؼ  . ׷ 󸶳    Դ   ִ?
+        // 이 빛의 세기를 누적해서 평균을 낸다. 그럼 얼마나 빛이 이 지점에 들어왔는지 알 수 있다?
         float NdotL = max(dot(N, L), 0.0);
         if(NdotL > 0.0)
         {
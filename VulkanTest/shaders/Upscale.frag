@@ -0,0 +1,73 @@
+#version 450
+
+// DynamicResolution 이 sceneColor 의 왼쪽 위 내부 해상도 영역을 스왑체인 크기로 늘린다.
+layout(set = 0, binding = 0) uniform sampler2D sceneColor;
+
+layout(push_constant) uniform UpscaleParams
+{
+	vec4 region;	// xy 내부 해상도(픽셀), zw sceneColor 크기의 역수
+	vec4 settings;	// x 샤프닝 세기
+} params;
+
+layout(location = 0) in vec2 inUV;
+
+layout(location = 0) out vec4 outColor;
+
+// 내부 해상도 영역 밖의 텍셀이 섞이지 않도록 탭 중심을 영역 안 텍셀 중심으로 자른다.
+vec3 sampleRegion(vec2 pixel)
+{
+	pixel = clamp(pixel, vec2(0.5), params.region.xy - 0.5);
+	return textureLod(sceneColor, pixel * params.region.zw, 0.0).rgb;
+}
+
+void main()
+{
+	// 출력 픽셀 중심에 해당하는 원본 픽셀 좌표
+	vec2 position = inUV * params.region.xy;
+
+	// Catmull-Rom 4x4 필터. 가운데 두 줄의 가중치를 바이리니어 한 번으로 합쳐 모서리 네 탭을 뺀 다섯 번만 읽는다.
+	vec2 center = floor(position - 0.5) + 0.5;
+	vec2 f = position - center;
+	vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+	vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+	vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+	vec2 w3 = f * f * (-0.5 + 0.5 * f);
+	vec2 w12 = w1 + w2;
+	vec2 offset12 = w2 / w12;
+
+	vec2 p0 = center - 1.0;
+	vec2 p3 = center + 2.0;
+	vec2 p12 = center + offset12;
+
+	float weight0 = w12.x * w0.y;
+	float weight1 = w0.x * w12.y;
+	float weight2 = w12.x * w12.y;
+	float weight3 = w3.x * w12.y;
+	float weight4 = w12.x * w3.y;
+
+	vec3 color = sampleRegion(vec2(p12.x, p0.y)) * weight0
+		+ sampleRegion(vec2(p0.x, p12.y)) * weight1
+		+ sampleRegion(p12) * weight2
+		+ sampleRegion(vec2(p3.x, p12.y)) * weight3
+		+ sampleRegion(vec2(p12.x, p3.y)) * weight4;
+	color /= weight0 + weight1 + weight2 + weight3 + weight4;
+
+	// 가장 가까운 2x2 텍셀 범위로 자른다. Catmull-Rom 의 음수 로브가 밝은 가장자리에 만드는 링잉을 없앤다.
+	ivec2 maxTexel = ivec2(params.region.xy) - 1;
+	ivec2 base = ivec2(center);
+	vec3 t00 = texelFetch(sceneColor, clamp(base, ivec2(0), maxTexel), 0).rgb;
+	vec3 t10 = texelFetch(sceneColor, clamp(base + ivec2(1, 0), ivec2(0), maxTexel), 0).rgb;
+	vec3 t01 = texelFetch(sceneColor, clamp(base + ivec2(0, 1), ivec2(0), maxTexel), 0).rgb;
+	vec3 t11 = texelFetch(sceneColor, clamp(base + ivec2(1, 1), ivec2(0), maxTexel), 0).rgb;
+	vec3 minColor = min(min(t00, t10), min(t01, t11));
+	vec3 maxColor = max(max(t00, t10), max(t01, t11));
+
+	// 바이리니어보다 선명한 만큼을 더 밀어 준다. 범위 밖으로는 나가지 않는다.
+	if (params.settings.x > 0.0)
+	{
+		vec3 bilinear = mix(mix(t00, t10, f.x), mix(t01, t11, f.x), f.y);
+		color += (color - bilinear) * params.settings.x;
+	}
+
+	outColor = vec4(clamp(color, minColor, maxColor), 1.0);
+}
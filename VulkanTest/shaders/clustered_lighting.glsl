@@ -0,0 +1,65 @@
+// ClusteredLighting 의 버퍼. 컴퓨트 패스는 set 0, 라이팅 패스는 set 2 로 바인딩한다.
+#ifndef CLUSTER_SET
+#define CLUSTER_SET 2
+#endif
+// 프래그먼트 셰이더에서 쓰는 스토리지 버퍼는 fragmentStoresAndAtomics 없이는 readonly 여야 한다. 목록을 만드는 컴퓨트 셰이더만 비운다.
+#ifndef CLUSTER_LIST_ACCESS
+#define CLUSTER_LIST_ACCESS readonly
+#endif
+
+// ClusteredLighting.h 의 GPUClusterLight 와 배치가 같아야 한다. (std430)
+struct ClusterLight
+{
+	vec4 positionRadius;	// 월드 위치, w 는 빛이 닿는 반지름
+	vec4 color;				// rgb 세기를 곱한 색, w 는 PointShadowAtlas 슬롯 + 1 (0 이면 그림자 없음)
+};
+
+// ClusteredLighting.h 의 GPUClusterParams 와 배치가 같아야 한다.
+layout(set = CLUSTER_SET, binding = 0) uniform ClusterParams
+{
+	mat4 view;
+	mat4 inverseProjection;
+	uvec4 gridSize;		// xyz 클러스터 수, w 라이트 수
+	vec4 screen;		// 너비, 높이, near, far
+	uvec4 flags;		// x 가 0 이면 클러스터를 쓰지 않는다. y 클러스터당 최대 라이트 수, z 가 1 이면 라이트 볼륨이 계산한다
+} clusterParams;
+
+layout(std430, set = CLUSTER_SET, binding = 1) readonly buffer ClusterLights { ClusterLight clusterLights[]; };
+// 클러스터마다 (1 + flags.y) 개씩. 첫 값이 라이트 수이고 뒤가 라이트 번호다.
+layout(std430, set = CLUSTER_SET, binding = 2) CLUSTER_LIST_ACCESS buffer ClusterLightLists { uint clusterLightLists[]; };
+
+uint getClusterStride()
+{
+	return 1 + clusterParams.flags.y;
+}
+
+uint getClusterIndex(uvec3 cluster)
+{
+	return (cluster.z * clusterParams.gridSize.y + cluster.y) * clusterParams.gridSize.x + cluster.x;
+}
+
+// 깊이 방향은 near 에서 far 까지 지수로 나눈다. 가까운 곳의 클러스터가 얇아서 화면에서 보이는 크기가 고르다.
+float getSliceDepth(uint slice)
+{
+	float nearPlane = clusterParams.screen.z;
+	float farPlane = clusterParams.screen.w;
+	return nearPlane * pow(farPlane / nearPlane, float(slice) / float(clusterParams.gridSize.z));
+}
+
+uvec3 getCluster(vec2 fragCoord, float viewDepth)
+{
+	float nearPlane = clusterParams.screen.z;
+	float farPlane = clusterParams.screen.w;
+	vec2 tile = fragCoord / clusterParams.screen.xy * vec2(clusterParams.gridSize.xy);
+	float slice = log(max(viewDepth, nearPlane) / nearPlane) * float(clusterParams.gridSize.z) / log(farPlane / nearPlane);
+	return uvec3(clamp(uvec2(tile), uvec2(0), clusterParams.gridSize.xy - 1),
+		min(uint(max(slice, 0.0)), clusterParams.gridSize.z - 1));
+}
+
+// 1/d^2 에 반지름에서 0 이 되는 창을 곱한다. 반지름 밖 라이트를 빼도 경계가 보이지 않는다.
+float getClusterLightAttenuation(float distance, float radius)
+{
+	float ratio = distance / radius;
+	float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+	return window * window / max(distance * distance, 0.0001);
+}
@@ -9,4 +9,9 @@ echo %%~ni
 %VULKAN_SDK%\Bin\glslc.exe -g %%~ni.frag -o %%~nifrag.spv
 )
 
+for /r %%i in (*.comp) do (
+echo %%~ni
+%VULKAN_SDK%\Bin\glslc.exe -g %%~ni.comp -o %%~nicomp.spv
+)
+
 pause
\ No newline at end of file
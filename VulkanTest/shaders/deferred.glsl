@@ -1,10 +1,84 @@
 #include "global.glsl"
+#include "clustered_lighting.glsl"
 
-layout(set = 1, binding = 0) uniform sampler2D position;
-layout(set = 1, binding = 1) uniform sampler2D normal;
-layout(set = 1, binding = 2) uniform sampler2D albedo;
-layout(set = 1, binding = 3) uniform sampler2D arm;
+#ifdef GBUFFER_SUBPASS_INPUT
+// 단일 렌더 패스의 라이팅 서브패스. input_attachment_index 는 VulkanTutorial::createSinglePassRenderPass 의 순서와 같다.
+layout(input_attachment_index = 0, set = 1, binding = 0) uniform subpassInput depthMap;
+layout(input_attachment_index = 1, set = 1, binding = 1) uniform subpassInput normal;		// 팔면체 인코딩
+layout(input_attachment_index = 2, set = 1, binding = 2) uniform subpassInput albedo;		// rgb albedo, a ao
+layout(input_attachment_index = 3, set = 1, binding = 3) uniform subpassInput material;	// r roughness, g metallic
+layout(input_attachment_index = 4, set = 1, binding = 7) uniform subpassInput emissive;
+// 서브패스 입력은 지금 픽셀만 읽을 수 있다.
+#define LOAD_GBUFFER(target, pixel) subpassLoad(target)
+#else
+// 지오메트리 패스의 깊이. 선형 필터를 쓸 수 없는 포맷일 수 있으므로 texelFetch 로 읽는다.
+layout(set = 1, binding = 0) uniform sampler2D depthMap;
+layout(set = 1, binding = 1) uniform sampler2D normal;		// 팔면체 인코딩
+layout(set = 1, binding = 2) uniform sampler2D albedo;		// rgb albedo, a ao
+layout(set = 1, binding = 3) uniform sampler2D material;	// r roughness, g metallic
+layout(set = 1, binding = 7) uniform sampler2D emissive;
+#define LOAD_GBUFFER(target, pixel) texelFetch(target, pixel, 0)
+#endif
 layout(set = 1, binding = 4) uniform samplerCube diffuseMap;
 layout(set = 1, binding = 5) uniform samplerCube prefilterMap;
 layout(set = 1, binding = 6) uniform sampler2D brdfLUT;
-layout(set = 1, binding = 7) uniform sampler2D emissive;
\ No newline at end of file
+
+// 깊이와 화면 uv 로 월드 위치를 복원한다. 투영 행렬의 y 가 뒤집혀 있으므로 uv 를 그대로 NDC 로 옮긴다.
+vec3 reconstructWorldPosition(vec2 uv, float depth)
+{
+	vec4 world = sceneData.inverseViewProj * vec4(uv * 2.0 - 1.0, depth, 1.0);
+	return world.xyz / world.w;
+}
+
+// 팔면체 인코딩 [-1, 1]^2 -> 단위 벡터. ObjectShader.frag 의 encodeOctahedral 과 짝이다.
+vec3 decodeOctahedral(vec2 e)
+{
+	vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
+// 포인트 라이트 하나의 Cook-Torrance 반사. 반지름 밖이면 0 이다. 라이팅 패스와 라이트 볼륨이 같이 쓴다.
+vec3 CalcClusterLight(ClusterLight light, vec3 worldPos, vec3 N, vec3 V, vec3 albedo, float roughness, float metallic, vec3 F0, float diffuseEnable, float specularEnable)
+{
+	// calculate per-light radiance
+	vec3 toLight = light.positionRadius.xyz - worldPos;
+	float distance = length(toLight);
+	if (distance >= light.positionRadius.w)
+	{
+		return vec3(0.0);
+	}
+	vec3 L = toLight / max(distance, 0.0001);
+	vec3 H = normalize(V + L);
+	float attenuation = getClusterLightAttenuation(distance, light.positionRadius.w);
+	vec3 radiance = light.color.rgb * attenuation;
+
+	// Cook-Torrance BRDF
+	float NDF = DistributionGGX(N, H, roughness);
+	float G   = GeometrySmith(N, V, L, roughness);
+	vec3 F    = fresnelSchlick(max(dot(H, V), 0.0), F0);
+
+	vec3 numerator    = NDF * G * F;
+	float denominator = 4.0 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0) + 0.0001; // + 0.0001 to prevent divide by zero
+	vec3 specular = numerator / denominator;
+
+	// kS is equal to Fresnel
+	vec3 kS = F;
+	// for energy conservation, the diffuse and specular light can't
+	// be above 1.0 (unless the surface emits light); to preserve this
+	// relationship the diffuse component (kD) should equal 1.0 - kS.
+	vec3 kD = vec3(1.0) - kS;
+	// multiply kD by the inverse metalness such that only non-metals
+	// have diffuse lighting, or a linear blend if partly metal (pure metals
+	// have no diffuse light).
+	kD *= 1.0 - metallic;
+
+	// scale light by NdotL
+	// 광원과 현재 위치의 각도에 따라 빛의 세기가 달라진다.
+	float NdotL = max(dot(N, L), 0.0);
+
+	// note that we already multiplied the BRDF by the Fresnel (kS) so we won't multiply by kS again
+	return (kD * albedo / PI * diffuseEnable + specular * specularEnable) * radiance * NdotL;
+}
@@ -12,5 +12,13 @@ layout(set = 0, binding = 0) uniform  SceneData{
 	vec4 exposureDisplay;
 
 	DirLight dirLight;
-	ActivePointLights activePointLights;
-} sceneData;
\ No newline at end of file
+	mat4 inverseViewProj;	// 깊이에서 월드 위치를 복원한다.
+	vec4 renderExtent;		// xy 이번 프레임 내부 해상도, zw 그 역수. 렌더 타겟의 왼쪽 위 xy 만큼만 그린다.
+} sceneData;
+
+// 포인트 라이트 목록. 라이트 수와 켜짐 여부를 매 프레임 매핑된 메모리에 쓰므로 라이트를 바꿔도 다시 녹화하지 않는다.
+layout(std430, set = 0, binding = 1) readonly buffer PointLights
+{
+	uvec4 pointLightCount;	// x 라이트 수
+	PointLight pointLights[];
+};
\ No newline at end of file
@@ -0,0 +1,36 @@
+// IndirectDrawPass.h 의 GPUDrawRecord 와 배치가 같아야 한다. (std430)
+struct DrawRecord
+{
+	mat4 transform;
+	vec4 boundingSphere; // xyz = 로컬 중심, w = 반지름. 음수면 컬링하지 않는다.
+	uint firstIndex;
+	uint indexCount;
+	uint groupIndex;
+	uint groupFirstCommand;
+};
+
+// VkDrawIndexedIndirectCommand
+struct DrawIndexedIndirectCommand
+{
+	uint indexCount;
+	uint instanceCount;
+	uint firstIndex;
+	int vertexOffset;
+	uint firstInstance;
+};
+
+// viewProjection 에서 프러스텀 평면을 뽑는다. (Frustum::fromViewProjection 과 같은 순서, 법선은 안쪽)
+void extractFrustumPlanes(mat4 viewProjection, out vec4 planes[6])
+{
+	mat4 m = transpose(viewProjection);
+	planes[0] = m[3] + m[0];
+	planes[1] = m[3] - m[0];
+	planes[2] = m[3] + m[1];
+	planes[3] = m[3] - m[1];
+	planes[4] = m[2];			// 깊이 범위가 [0, 1] 이다.
+	planes[5] = m[3] - m[2];
+	for (int i = 0; i < 6; i++)
+	{
+		planes[i] /= length(planes[i].xyz);
+	}
+}
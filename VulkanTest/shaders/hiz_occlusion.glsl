@@ -0,0 +1,41 @@
+// Hi-Z 피라미드의 텍셀은 아래 단계에서 자기가 덮는 텍셀들의 가장 먼 깊이다. (깊이 1 이 가장 멀다)
+// 월드 AABB 의 꼭짓점 여덟 개를 투영해 화면 사각형과 가장 가까운 깊이를 구하고,
+// 사각형이 2x2 텍셀 안에 들어오는 단계에서 네 텍셀의 가장 먼 깊이보다도 멀면 가려진 것이다.
+bool isOccludedByHiZ(sampler2D pyramid, mat4 viewProjection, vec3 boundsMin, vec3 boundsMax)
+{
+	vec2 minUV = vec2(1.0);
+	vec2 maxUV = vec2(0.0);
+	float nearestDepth = 1.0;
+	for (int i = 0; i < 8; i++)
+	{
+		vec3 corner = vec3((i & 1) != 0 ? boundsMax.x : boundsMin.x,
+			(i & 2) != 0 ? boundsMax.y : boundsMin.y,
+			(i & 4) != 0 ? boundsMax.z : boundsMin.z);
+		vec4 clip = viewProjection * vec4(corner, 1.0);
+		// 카메라 뒤로 넘어가는 꼭짓점이 있으면 사각형을 믿을 수 없으므로 보이는 것으로 친다.
+		if (clip.w <= 0.0)
+		{
+			return false;
+		}
+		vec3 ndc = clip.xyz / clip.w;
+		vec2 uv = ndc.xy * 0.5 + 0.5;
+		minUV = min(minUV, uv);
+		maxUV = max(maxUV, uv);
+		nearestDepth = min(nearestDepth, ndc.z);
+	}
+	minUV = clamp(minUV, vec2(0.0), vec2(1.0));
+	maxUV = clamp(maxUV, vec2(0.0), vec2(1.0));
+
+	// 단계마다 크기가 반 이하로 줄어드므로 이 단계에서 사각형은 한 텍셀 폭을 넘지 않는다.
+	vec2 rectSize = (maxUV - minUV) * vec2(textureSize(pyramid, 0));
+	int lod = int(ceil(log2(max(max(rectSize.x, rectSize.y), 1.0))));
+	lod = clamp(lod, 0, textureQueryLevels(pyramid) - 1);
+
+	ivec2 levelSize = textureSize(pyramid, lod);
+	ivec2 p0 = clamp(ivec2(minUV * vec2(levelSize)), ivec2(0), levelSize - 1);
+	ivec2 p1 = clamp(ivec2(maxUV * vec2(levelSize)), ivec2(0), levelSize - 1);
+	float farthestDepth = max(
+		max(texelFetch(pyramid, p0, lod).r, texelFetch(pyramid, ivec2(p1.x, p0.y), lod).r),
+		max(texelFetch(pyramid, ivec2(p0.x, p1.y), lod).r, texelFetch(pyramid, p1, lod).r));
+	return nearestDepth > farthestDepth;
+}
@@ -0,0 +1,129 @@
+// Pbr.frag 와 PbrSubpass.frag 의 본문. G-buffer 는 LOAD_GBUFFER 로 읽으므로 샘플러와 subpassInput 둘 다에서 컴파일된다.
+#include "deferred.glsl"
+#include "shadow.glsl"
+#include "point_shadow.glsl"
+
+#ifndef GBUFFER_SUBPASS_INPUT
+// LightVolumes 가 포인트 라이트를 더해 둔 HDR 타겟. 라이트 볼륨을 켰을 때만 읽는다.
+layout(set = 1, binding = 8) uniform sampler2D lightAccumulation;
+#endif
+
+layout(location = 0) in vec2 texCoords;
+
+layout(location = 0) out vec4 FragColor;
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = LOAD_GBUFFER(depthMap, pixel).r;
+    // 아무것도 그리지 않은 픽셀. 스카이박스가 포워드 패스에서 채운다.
+    // 스텐실이 있는 깊이 포맷이면 스텐실 테스트가 먼저 거르고, 없는 장치에서만 여기까지 온다.
+    if (depth >= 1.0)
+    {
+        FragColor = vec4(0.0);
+        return;
+    }
+
+    vec3 WorldPos = reconstructWorldPosition(texCoords, depth);
+    vec3 N = decodeOctahedral(LOAD_GBUFFER(normal, pixel).rg);
+    vec4 albedoAO = LOAD_GBUFFER(albedo, pixel);
+    vec3 albedo = pow(albedoAO.rgb, vec3(2.2));
+    vec3 ao = vec3(albedoAO.a);
+    vec3 emissive = LOAD_GBUFFER(emissive, pixel).rgb;
+	vec2 material = LOAD_GBUFFER(material, pixel).rg;
+	float metallic = material.g;
+	float roughness = material.r;
+
+    float diffuseEnable = 1.0;
+    float specularEnable = 1.0;
+
+    int DebugDisplay = int(sceneData.exposureDisplay.y);
+
+    if(DebugDisplay > 0)
+	{
+		switch (DebugDisplay) {
+        case 7:
+            diffuseEnable = 0.0;
+            break;
+        case 8:
+            specularEnable= 0.0;
+            break;
+		}
+	}
+
+    // input lighting data
+    //vec3 N = getNormalFromMap();
+    vec3 V = normalize(sceneData.viewPos - WorldPos);
+    vec3 R = reflect(-V, N); 
+
+    // 프리넬은 Diffuse 반사와 Specular 반사의 비율을 내포하고 있다.
+ 	// 비금속은 물체를 수직으로 바라봤을 때 0.04 정도의 반사율을 보이고,
+ 	// 금속은 높은 반사율을 보이며 색상(tint) 또한 나타나기 때문에 albedo를 F0로 쓴다.
+ 	vec3 F0 = vec3(0.04);
+ 	F0      = mix(F0, albedo, metallic);
+ 
+ 	vec3 Lo = vec3(0.0);
+
+    // 포인트 라이트는 픽셀이 든 클러스터의 목록만 본다. 클러스터를 끄면 비교용으로 모든 라이트를 계산한다.
+    uint lightCount = clusterParams.gridSize.w;
+    uint listBase = 0;
+    if (clusterParams.flags.x != 0)
+    {
+        float viewDepth = -(clusterParams.view * vec4(WorldPos, 1.0)).z;
+        listBase = getClusterIndex(getCluster(gl_FragCoord.xy, viewDepth)) * getClusterStride();
+        lightCount = clusterLightLists[listBase];
+        listBase += 1;
+    }
+#ifndef GBUFFER_SUBPASS_INPUT
+    // 라이트 볼륨이 라이트가 닿는 픽셀에만 미리 더해 두었다. 톤매핑 전에 합친다.
+    if (clusterParams.flags.z != 0)
+    {
+        lightCount = 0;
+        Lo = texelFetch(lightAccumulation, pixel, 0).rgb;
+    }
+#endif
+
+ 	for (uint i = 0; i < lightCount; i++)
+    {
+        uint lightIndex = clusterParams.flags.x != 0 ? clusterLightLists[listBase + i] : i;
+        ClusterLight light = clusterLights[lightIndex];
+        Lo += CalcClusterLight(light, WorldPos, N, V, albedo, roughness, metallic, F0, diffuseEnable, specularEnable) * getPointShadow(light, WorldPos, N);
+    }   
+    
+    float viewDepth = -(sceneData.view * vec4(WorldPos, 1.0)).z;
+    {
+ 		Lo += CalcDirLight(sceneData.dirLight, N, V, albedo, roughness, metallic, diffuseEnable, specularEnable) * getDirectionalShadow(WorldPos, N, viewDepth);
+ 	}
+
+    // ambient lighting (we now use IBL as the ambient term)
+    vec3 F = fresnelSchlickRoughness(max(dot(N, V), 0.0), F0, roughness);
+    
+    vec3 kS = F;
+    vec3 kD = 1.0 - kS;
+    kD *= 1.0 - metallic;	  
+    
+    vec3 irradiance = texture(diffuseMap, N).rgb;
+    vec3 diffuse      = irradiance * albedo;
+    
+    // sample both the pre-filter map and the BRDF lut and combine them together as per the Split-Sum approximation to get the IBL specular part.
+    const float MAX_REFLECTION_LOD = 4.0;
+    vec3 prefilteredColor = textureLod(prefilterMap, R,  roughness * MAX_REFLECTION_LOD).rgb;    
+    vec2 brdf  = texture(brdfLUT, vec2(max(dot(N, V), 0.0), roughness)).rg;
+    vec3 specular = prefilteredColor * (F * brdf.x + brdf.y);
+
+    vec3 ambient = (kD * diffuse * diffuseEnable + specular * specularEnable) * ao;
+    
+    vec3 color = ambient + Lo;
+    
+    // emissive
+    color.rgb += emissive;
+
+    color *= getCascadeDebugTint(viewDepth);
+
+    // HDR tonemapping
+    color = color / (color + vec3(1.0));
+    // gamma correct
+    color = pow(color, vec3(1.0/2.2)); 
+
+    FragColor = vec4(color, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+// PointShadowAtlas 의 그림자 버퍼와 깊이 아틀라스. 라이팅 패스는 set 4, 라이트 볼륨은 set 3 으로 바인딩한다.
+// NO_POINT_SHADOW 를 정의하면 셋을 선언하지 않고 그림자 없이 그린다. (maxBoundDescriptorSets 가 5 보다 작은 장치)
+#ifndef POINT_SHADOW_SET
+#define POINT_SHADOW_SET 4
+#endif
+
+#ifdef NO_POINT_SHADOW
+
+float getPointShadow(ClusterLight light, vec3 worldPos, vec3 N)
+{
+	return 1.0;
+}
+
+#else
+
+// PointShadowAtlas.h 의 GPUPointShadow 와 배치가 같아야 한다. (std430)
+struct PointShadow
+{
+	mat4 faceViewProjection[6];	// 그 면을 마지막으로 그릴 때 쓴 행렬
+	vec4 faceRects[6];			// 아틀라스 uv 로 xy 시작, z 크기
+};
+
+layout(std430, set = POINT_SHADOW_SET, binding = 0) readonly buffer PointShadows
+{
+	vec4 pointShadowSettings;	// x 노멀 방향으로 미는 거리(텍셀 단위), y 아틀라스 크기
+	PointShadow pointShadows[];
+};
+
+// 비교 샘플러라 texture 가 깊이 비교 결과(1 이 빛을 받음)를 돌려준다.
+layout(set = POINT_SHADOW_SET, binding = 1) uniform sampler2DShadow pointShadowAtlas;
+
+// +X, -X, +Y, -Y, +Z, -Z. 가장 긴 축이 면을 정한다.
+uint getCubeFace(vec3 direction)
+{
+	vec3 absolute = abs(direction);
+	if (absolute.x >= absolute.y && absolute.x >= absolute.z)
+	{
+		return direction.x > 0.0 ? 0 : 1;
+	}
+	if (absolute.y >= absolute.z)
+	{
+		return direction.y > 0.0 ? 2 : 3;
+	}
+	return direction.z > 0.0 ? 4 : 5;
+}
+
+// 포인트 라이트를 받는 비율. color.w 가 0 이면 그림자를 그리지 않은 라이트다.
+// 90 도 투영이라 거리 d 에서 텍셀 크기는 2d / 타일 픽셀 수다. 그만큼 노멀 방향으로 밀고, 다른 타일을 읽지 않게 타일 안으로 좁혀 샘플링한다.
+float getPointShadow(ClusterLight light, vec3 worldPos, vec3 N)
+{
+	uint slot = uint(light.color.w);
+	if (slot == 0)
+	{
+		return 1.0;
+	}
+	slot -= 1;
+
+	vec3 lightPos = light.positionRadius.xyz;
+	uint face = getCubeFace(worldPos - lightPos);
+	float tilePixels = pointShadows[slot].faceRects[face].z * pointShadowSettings.y;
+	vec3 offsetPos = worldPos + N * (2.0 * length(worldPos - lightPos) / tilePixels) * pointShadowSettings.x;
+
+	face = getCubeFace(offsetPos - lightPos);
+	vec4 rect = pointShadows[slot].faceRects[face];
+	vec4 lightClip = pointShadows[slot].faceViewProjection[face] * vec4(offsetPos, 1.0);
+	vec3 shadowCoord = lightClip.xyz / lightClip.w;
+	vec2 uv = rect.xy + (shadowCoord.xy * 0.5 + 0.5) * rect.z;
+
+	float texelSize = 1.0 / pointShadowSettings.y;
+	vec2 minUV = rect.xy + 0.5 * texelSize;
+	vec2 maxUV = rect.xy + rect.z - 0.5 * texelSize;
+	float lit = 0.0;
+	for (int y = 0; y < 2; y++)
+	{
+		for (int x = 0; x < 2; x++)
+		{
+			vec2 tapUV = clamp(uv + (vec2(x, y) - 0.5) * texelSize, minUV, maxUV);
+			lit += texture(pointShadowAtlas, vec3(tapUV, shadowCoord.z));
+		}
+	}
+	return lit / 4.0;
+}
+
+#endif
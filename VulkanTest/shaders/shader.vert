@@ -23,6 +23,9 @@ layout(location = 3) out vec3 fragPos;
 layout(location = 4) out vec3 fragTangent;
 layout(location = 5) out vec3 fragBitangent;
 
+// 깊이 프리패스(DepthPrepass.vert)와 깊이가 비트 단위로 같아야 EQUAL 테스트를 통과한다.
+invariant gl_Position;
+
 void main()
 {
     gl_Position = sceneData.proj * sceneData.view * PushConstants.model * vec4(inPosition, 1.0);
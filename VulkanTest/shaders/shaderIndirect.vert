@@ -0,0 +1,35 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+#include "input_structures.glsl"
+#include "gpu_driven.glsl"
+
+// DrawCompaction.comp 가 firstInstance 에 드로우 번호를 넣어 둔다.
+layout(std430, set = 2, binding = 0) readonly buffer DrawRecords { DrawRecord draws[]; };
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inTexCoord;
+layout(location = 3) in vec3 inNormal;
+layout(location = 4) in vec3 inTangent;
+layout(location = 5) in vec3 inBitangent;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) out vec3 fragNormal;
+layout(location = 3) out vec3 fragPos;
+layout(location = 4) out vec3 fragTangent;
+layout(location = 5) out vec3 fragBitangent;
+
+void main()
+{
+    mat4 model = draws[gl_InstanceIndex].transform;
+
+    gl_Position = sceneData.proj * sceneData.view * model * vec4(inPosition, 1.0);
+    fragColor = inColor;
+    fragTexCoord = inTexCoord;
+    fragNormal = mat3(transpose(inverse(model))) * inNormal;
+    fragPos = vec3(model * vec4(inPosition, 1.0));
+    fragTangent = mat3(model) * inTangent;
+    fragBitangent = mat3(model) * inBitangent;
+}
\ No newline at end of file
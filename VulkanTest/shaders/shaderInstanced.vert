@@ -0,0 +1,36 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+#include "input_structures.glsl"
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inTexCoord;
+layout(location = 3) in vec3 inNormal;
+layout(location = 4) in vec3 inTangent;
+layout(location = 5) in vec3 inBitangent;
+// binding 1, 인스턴스마다 바뀐다. (Vertex.h 의 Instance)
+layout(location = 6) in mat4 inInstanceModel;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) out vec3 fragNormal;
+layout(location = 3) out vec3 fragPos;
+layout(location = 4) out vec3 fragTangent;
+layout(location = 5) out vec3 fragBitangent;
+
+// 깊이 프리패스(DepthPrepassInstanced.vert)와 깊이가 비트 단위로 같아야 EQUAL 테스트를 통과한다.
+invariant gl_Position;
+
+void main()
+{
+    mat4 model = inInstanceModel;
+
+    gl_Position = sceneData.proj * sceneData.view * model * vec4(inPosition, 1.0);
+    fragColor = inColor;
+    fragTexCoord = inTexCoord;
+    fragNormal = mat3(transpose(inverse(model))) * inNormal;
+    fragPos = vec3(model * vec4(inPosition, 1.0));
+    fragTangent = mat3(model) * inTangent;
+    fragBitangent = mat3(model) * inBitangent;
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+// CascadedShadowMap 의 파라미터와 그림자 맵 배열. 라이팅 패스가 set 3 으로 바인딩한다.
+#define SHADOW_SET 3
+#define SHADOW_CASCADE_COUNT 4
+
+// CascadedShadowMap.h 의 GPUShadowParams 와 배치가 같아야 한다.
+layout(set = SHADOW_SET, binding = 0) uniform ShadowParams
+{
+	mat4 lightViewProjection[SHADOW_CASCADE_COUNT];
+	vec4 splitDepths;	// 캐스케이드마다 뷰 공간 far 거리
+	vec4 texelSizes;	// 캐스케이드마다 월드 단위 텍셀 크기
+	uvec4 flags;		// x 가 0 이면 그림자를 쓰지 않는다. y 가 1 이면 캐스케이드마다 색을 입힌다
+	vec4 bias;			// x 노멀 방향으로 미는 거리(텍셀 단위)
+} shadowParams;
+
+// 비교 샘플러라 texture 가 깊이 비교 결과(1 이 빛을 받음)를 선형 보간해 돌려준다.
+layout(set = SHADOW_SET, binding = 1) uniform sampler2DArrayShadow shadowMap;
+
+// 뷰 깊이가 든 캐스케이드. 그림자 거리 밖이면 SHADOW_CASCADE_COUNT 다.
+uint getShadowCascade(float viewDepth)
+{
+	for (uint i = 0; i < SHADOW_CASCADE_COUNT; i++)
+	{
+		if (viewDepth < shadowParams.splitDepths[i])
+		{
+			return i;
+		}
+	}
+	return SHADOW_CASCADE_COUNT;
+}
+
+// 방향광을 받는 비율. 노멀 방향으로 텍셀 크기만큼 밀어 자기 그림자를 줄이고 3x3 PCF 로 가장자리를 부드럽게 한다.
+float getDirectionalShadow(vec3 worldPos, vec3 N, float viewDepth)
+{
+	if (shadowParams.flags.x == 0)
+	{
+		return 1.0;
+	}
+
+	uint cascade = getShadowCascade(viewDepth);
+	if (cascade == SHADOW_CASCADE_COUNT)
+	{
+		return 1.0;
+	}
+
+	vec3 offsetPos = worldPos + N * shadowParams.texelSizes[cascade] * shadowParams.bias.x;
+	vec4 lightClip = shadowParams.lightViewProjection[cascade] * vec4(offsetPos, 1.0);
+	vec3 shadowCoord = lightClip.xyz / lightClip.w;
+	vec2 uv = shadowCoord.xy * 0.5 + 0.5;
+
+	vec2 texelSize = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+	float lit = 0.0;
+	for (int y = -1; y <= 1; y++)
+	{
+		for (int x = -1; x <= 1; x++)
+		{
+			lit += texture(shadowMap, vec4(uv + vec2(x, y) * texelSize, float(cascade), shadowCoord.z));
+		}
+	}
+	return lit / 9.0;
+}
+
+// showCascades 를 켰을 때 캐스케이드마다 곱할 색
+vec3 getCascadeDebugTint(float viewDepth)
+{
+	if (shadowParams.flags.x == 0 || shadowParams.flags.y == 0)
+	{
+		return vec3(1.0);
+	}
+
+	const vec3 tints[SHADOW_CASCADE_COUNT + 1] = vec3[](
+		vec3(1.0, 0.4, 0.4), vec3(0.4, 1.0, 0.4), vec3(0.4, 0.4, 1.0), vec3(1.0, 1.0, 0.4), vec3(1.0));
+	return tints[getShadowCascade(viewDepth)];
+}